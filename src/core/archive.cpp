@@ -221,6 +221,19 @@ int64 cArchive::Copy(cArchive* pFrom, int64 amt)
     return (amt - amtLeft);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// class cBidirArchive
+///////////////////////////////////////////////////////////////////////////////
+
+int8* cBidirArchive::MapShared(int64 len) // throw(eArchive)
+{
+    return 0;
+}
+
+void cBidirArchive::SyncMap() // throw(eArchive)
+{
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // class cMemMappedArchive -- Archive that can be memory mapped.
 ///////////////////////////////////////////////////////////////////////////////
@@ -638,6 +651,11 @@ int64 cFileArchive::Length(void) const
 // OpenRead -- Opens the file to be read only.
 /////////////////////////////////////////////////////////////////////////
 void cFileArchive::OpenRead(const TCHAR* filename, uint32 openFlags)
+{
+    OpenRead(0, filename, openFlags);
+}
+
+void cFileArchive::OpenRead(const cFSDirHandle* pDir, const TCHAR* filename, uint32 openFlags)
 {
     try
     {
@@ -649,8 +667,8 @@ void cFileArchive::OpenRead(const TCHAR* filename, uint32 openFlags)
         flags |= ((openFlags & FA_DIRECT)        ? cFile::OPEN_DIRECT   : 0);
 
         mOpenFlags       = openFlags;
-        mCurrentFilename = filename;
-        mCurrentFile.Open(filename, flags);
+        mCurrentFilename = pDir ? pDir->GetPath(filename) : filename;
+        mCurrentFile.Open(filename, flags, pDir);
         isWritable = false;
 
         mFileSize = mCurrentFile.GetSize();
@@ -675,6 +693,7 @@ void cFileArchive::OpenReadWrite(const TCHAR* filename, uint32 openFlags)
         flags |= ((openFlags & FA_OPEN_TEXT)     ? cFile::OPEN_TEXT     : 0);
         flags |= ((openFlags & FA_SCANNING)      ? cFile::OPEN_SCANNING : 0);
         flags |= ((openFlags & FA_DIRECT)        ? cFile::OPEN_DIRECT   : 0);
+        flags |= ((openFlags & FA_OPEN_EXCLUSIVE) ? cFile::OPEN_EXCLUSIVE : 0);
 
         mOpenFlags       = openFlags;
         mCurrentFilename = filename;
@@ -828,6 +847,89 @@ void cFileArchive::Truncate() // throw(eArchive)
     mFileSize = mReadHead;
 }
 
+/////////////////////////////////////////////////////////////////////////
+// Map -- Maps the start of the file into memory for reading
+/////////////////////////////////////////////////////////////////////////
+const void* cFileArchive::Map(int64 len)
+{
+    ASSERT(mCurrentFile.IsOpen());
+    return mCurrentFile.Map(len);
+}
+
+/////////////////////////////////////////////////////////////////////////
+// MapShared -- Maps the start of the file to be changed in place
+/////////////////////////////////////////////////////////////////////////
+int8* cFileArchive::MapShared(int64 len) // throw(eArchive)
+{
+    ASSERT(mCurrentFile.IsOpen());
+    if (!mCurrentFile.isWritable)
+        return 0;
+
+    try
+    {
+        return static_cast<int8*>(mCurrentFile.MapShared(len));
+    }
+    catch (eFile& fileError)
+    {
+        throw(eArchiveWrite(mCurrentFilename, fileError.GetDescription()));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////
+// SyncMap
+/////////////////////////////////////////////////////////////////////////
+void cFileArchive::SyncMap() // throw(eArchive)
+{
+    ASSERT(mCurrentFile.IsOpen());
+    if (!mCurrentFile.SyncMap())
+        throw eArchiveWrite(mCurrentFilename, iFSServices::GetInstance()->GetErrString());
+}
+
+/////////////////////////////////////////////////////////////////////////
+// WillNeed -- Gets the start of the file read ahead of time
+/////////////////////////////////////////////////////////////////////////
+void cFileArchive::WillNeed(int64 len) const
+{
+    ASSERT(mCurrentFile.IsOpen());
+    mCurrentFile.WillNeed(len);
+}
+
+/////////////////////////////////////////////////////////////////////////
+// ReadAt -- Reads from anywhere in the file without moving the read head
+/////////////////////////////////////////////////////////////////////////
+int cFileArchive::ReadAt(int64 offset, void* pDest, int count) const
+{
+    ASSERT(mCurrentFile.IsOpen());
+    try
+    {
+        return static_cast<int>(mCurrentFile.ReadAt(pDest, count, offset));
+    }
+    catch (eFile& fileError)
+    {
+        throw(eArchiveRead(mCurrentFilename, fileError.GetDescription()));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////
+// FindData -- Finds the next part of a sparse file that isn't a hole
+/////////////////////////////////////////////////////////////////////////
+bool cFileArchive::FindData(int64 offset, int64& dataStart, int64& dataEnd) const
+{
+    ASSERT(mCurrentFile.IsOpen());
+    try
+    {
+        cFile::File_t start = 0, end = 0;
+        bool          bFound = mCurrentFile.FindData(offset, start, end);
+        dataStart            = start;
+        dataEnd              = end;
+        return bFound;
+    }
+    catch (eFile& fileError)
+    {
+        throw(eArchiveSeek(mCurrentFilename, fileError.GetDescription()));
+    }
+}
+
 
 /////////////////////////////////////////////////////////////////////////
 // OpenReadWrite -- Opens the file to be read or written to
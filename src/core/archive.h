@@ -67,6 +67,7 @@ TSS_FILE_EXCEPTION(eArchiveOutOfMem, eArchive);
 TSS_FILE_EXCEPTION(eArchiveInvalidOp, eArchive);
 TSS_FILE_EXCEPTION(eArchiveFormat, eArchive);
 TSS_FILE_EXCEPTION(eArchiveNotRegularFile, eArchive);
+TSS_FILE_EXCEPTION(eArchiveIntegrity, eArchive);
 TSS_BEGIN_EXCEPTION(eArchiveCrypto, eArchive)
 
 virtual TSTRING GetMsg() const;
@@ -149,6 +150,15 @@ public:
     virtual void  Seek(int64 offset, SeekFrom from) = 0; // throw(eArchive);
     virtual int64 CurrentPos() const                = 0;
     virtual int64 Length() const                    = 0;
+
+    virtual int8* MapShared(int64 len); // throw(eArchive)
+        // maps the first len bytes of the archive to be read and written in place, and returns
+        // null if the archive can't be mapped that way, which is all this version does. The
+        // length may run past the end of the archive, but only the part before it may be
+        // touched; it is grown by writing to it, after which MapShared() must be called again
+        // before the new part is touched. The mapping stays valid until the next call.
+    virtual void SyncMap(); // throw(eArchive)
+        // makes what was changed through MapShared() visible to Read()
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -269,7 +279,8 @@ public:
         FA_OPEN_TEXT     = 0x1,
         FA_OPEN_TRUNCATE = 0x2,
         FA_SCANNING      = 0x4,
-        FA_DIRECT        = 0x8
+        FA_DIRECT        = 0x8,
+        FA_OPEN_EXCLUSIVE = 0x10 // OpenReadWrite() fails if the file is already there
     };
 
     // TODO: Open should throw
@@ -277,9 +288,25 @@ public:
     virtual void OpenReadWrite(const TCHAR* filename, uint32 openFlags = FA_OPEN_TRUNCATE);
     // opens a file for reading or writing; the file is always created if it doesn't exist,
     // and is truncated to zero length if truncateFile is set to true;
+    void OpenRead(const cFSDirHandle* pDir, const TCHAR* filename, uint32 openFlags = 0);
+    // opens filename for reading relative to the directory pDir (see cFile::Open)
     TSTRING      GetCurrentFilename(void) const;
     virtual void Close(void);
     void         Truncate(); // throw(eArchive) // set the length to the current pos
+    const void*  Map(int64 len);
+    // maps the first len bytes of the file for reading, as cFile::Map() does, and returns
+    // null if it can't. The mapping is released by Close().
+    virtual int8* MapShared(int64 len); // throw(eArchive)
+    virtual void  SyncMap();            // throw(eArchive)
+    // mapping the file with cFile::MapShared(), for a file opened for writing
+    void WillNeed(int64 len) const;
+    // asks for the first len bytes to be read ahead, as cFile::WillNeed() does
+    int ReadAt(int64 offset, void* pDest, int count) const; // throw(eArchive)
+    // reads up to count bytes from offset, as cFile::ReadAt() does, leaving the read head alone.
+    // Returns the number of bytes read, which is less than count only at the end of the file.
+    bool FindData(int64 offset, int64& dataStart, int64& dataEnd) const; // throw(eArchive)
+    // finds the next stretch of the file at or after offset that isn't a hole, as
+    // cFile::FindData() does; false if there is only a hole left
 
     //-----------------------------------
     // cBidirArchive interface
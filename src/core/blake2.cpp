@@ -0,0 +1,184 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// blake2.cpp -- BLAKE2b (RFC 7693), unkeyed, with a 512 bit digest
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdcore.h"
+#include <string.h>
+#include "blake2.h"
+
+static const uint64 IV[ 8 ] = { 0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+                                0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+                                0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL };
+
+static const uint8 SIGMA[ 12 ][ 16 ] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 }, { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+    { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 }, { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+    { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 }, { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+    { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 }, { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+    { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 }, { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 }, { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+};
+
+#define ROR64(x, n) ( ( ( x ) >> ( n ) ) | ( ( x ) << ( 64 - ( n ) ) ) )
+
+#define G(r, i, a, b, c, d) \
+    { \
+    a = a + b + m[ SIGMA[ r ][ 2 * i ] ]; \
+    d = ROR64( d ^ a, 32 ); \
+    c = c + d; \
+    b = ROR64( b ^ c, 24 ); \
+    a = a + b + m[ SIGMA[ r ][ 2 * i + 1 ] ]; \
+    d = ROR64( d ^ a, 16 ); \
+    c = c + d; \
+    b = ROR64( b ^ c, 63 ); \
+    }
+
+#define ROUND(r) \
+    { \
+    G( r, 0, v[ 0 ], v[ 4 ], v[ 8 ], v[ 12 ] ); \
+    G( r, 1, v[ 1 ], v[ 5 ], v[ 9 ], v[ 13 ] ); \
+    G( r, 2, v[ 2 ], v[ 6 ], v[ 10 ], v[ 14 ] ); \
+    G( r, 3, v[ 3 ], v[ 7 ], v[ 11 ], v[ 15 ] ); \
+    G( r, 4, v[ 0 ], v[ 5 ], v[ 10 ], v[ 15 ] ); \
+    G( r, 5, v[ 1 ], v[ 6 ], v[ 11 ], v[ 12 ] ); \
+    G( r, 6, v[ 2 ], v[ 7 ], v[ 8 ], v[ 13 ] ); \
+    G( r, 7, v[ 3 ], v[ 4 ], v[ 9 ], v[ 14 ] ); \
+    }
+
+static inline uint64 load64le(const uint8* p)
+{
+#ifdef WORDS_BIGENDIAN
+    uint64 x = 0;
+    for( int i = 7; i >= 0; i-- )
+        x = ( x << 8 ) | p[ i ];
+    return x;
+#else
+    uint64 x;
+    memcpy( &x, p, sizeof( x ) );
+    return x;
+#endif
+}
+
+static void blake2bCompress(BLAKE2B_INFO* info, const uint8* block, bool bLast)
+{
+    uint64 m[ 16 ], v[ 16 ];
+    int    i;
+
+    for( i = 0; i < 16; i++ )
+        m[ i ] = load64le( block + 8 * i );
+    for( i = 0; i < 8; i++ )
+    {
+        v[ i ]     = info->h[ i ];
+        v[ i + 8 ] = IV[ i ];
+    }
+    v[ 12 ] ^= info->count[ 0 ];
+    v[ 13 ] ^= info->count[ 1 ];
+    if( bLast )
+        v[ 14 ] = ~v[ 14 ];
+
+    /* written out in full, so that SIGMA is folded into the code and v stays in registers */
+    ROUND( 0 );
+    ROUND( 1 );
+    ROUND( 2 );
+    ROUND( 3 );
+    ROUND( 4 );
+    ROUND( 5 );
+    ROUND( 6 );
+    ROUND( 7 );
+    ROUND( 8 );
+    ROUND( 9 );
+    ROUND( 10 );
+    ROUND( 11 );
+
+    for( i = 0; i < 8; i++ )
+        info->h[ i ] ^= v[ i ] ^ v[ i + 8 ];
+}
+
+static void blake2bAddCount(BLAKE2B_INFO* info, uint64 n)
+{
+    info->count[ 0 ] += n;
+    if( info->count[ 0 ] < n )
+        info->count[ 1 ]++;
+}
+
+void blake2bInit(BLAKE2B_INFO* info)
+{
+    memcpy( info->h, IV, sizeof( IV ) );
+    info->h[ 0 ] ^= 0x01010000 | BLAKE2B_DIGESTSIZE; /* no key, fanout 1, depth 1 */
+    info->count[ 0 ] = info->count[ 1 ] = 0;
+    info->used = 0;
+}
+
+/* The last block has to be compressed with the final flag set, and there's
+   no telling which block is the last until blake2bFinal, so a full block is
+   only compressed once there's more input after it. */
+
+void blake2bUpdate(BLAKE2B_INFO* info, const uint8* buffer, int count)
+{
+    if( count <= 0 )
+        return;
+
+    if( info->used + count > BLAKE2B_BLOCKSIZE )
+    {
+        int fill = BLAKE2B_BLOCKSIZE - info->used;
+        memcpy( info->data + info->used, buffer, fill );
+        blake2bAddCount( info, BLAKE2B_BLOCKSIZE );
+        blake2bCompress( info, info->data, false );
+        info->used = 0;
+        buffer += fill;
+        count -= fill;
+
+        while( count > BLAKE2B_BLOCKSIZE )
+        {
+            blake2bAddCount( info, BLAKE2B_BLOCKSIZE );
+            blake2bCompress( info, buffer, false );
+            buffer += BLAKE2B_BLOCKSIZE;
+            count -= BLAKE2B_BLOCKSIZE;
+        }
+    }
+
+    memcpy( info->data + info->used, buffer, count );
+    info->used += count;
+}
+
+void blake2bFinal(BLAKE2B_INFO* info, uint8 digest[ BLAKE2B_DIGESTSIZE ])
+{
+    blake2bAddCount( info, info->used );
+    memset( info->data + info->used, 0, BLAKE2B_BLOCKSIZE - info->used );
+    blake2bCompress( info, info->data, true );
+
+    for( int i = 0; i < BLAKE2B_DIGESTSIZE; i++ )
+        digest[ i ] = ( uint8 ) ( info->h[ i / 8 ] >> ( 8 * ( i % 8 ) ) );
+}
@@ -0,0 +1,556 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// blake3.cpp -- BLAKE3, in its plain hashing mode, with a 256 bit digest
+//
+// Follows the reference implementation: a chunk state that takes the input
+// a block at a time, and a stack of chaining values for subtrees that are
+// complete.  Runs of whole chunks are handed to a "hash many" kernel that,
+// with AVX2, hashes eight of them at once.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdcore.h"
+#include <string.h>
+#include "blake3.h"
+
+#if HAVE_GCC && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#    define BLAKE3_USES_AVX2 1
+#    include <immintrin.h>
+#else
+#    define BLAKE3_USES_AVX2 0
+#endif
+
+enum
+{
+    CHUNK_START = 1 << 0,
+    CHUNK_END   = 1 << 1,
+    PARENT      = 1 << 2,
+    ROOT        = 1 << 3
+};
+
+static const uint32 IV[ 8 ] = { 0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+                                0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19 };
+
+/* the message words each round uses; round r is the permutation applied r times */
+static const uint8 MSG_SCHEDULE[ 7 ][ 16 ] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8 },
+    { 3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1 },
+    { 10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6 },
+    { 12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4 },
+    { 9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7 },
+    { 11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13 }
+};
+
+#define ROR32(x, n) ( ( ( x ) >> ( n ) ) | ( ( x ) << ( 32 - ( n ) ) ) )
+
+#define G(a, b, c, d, mx, my) \
+    { \
+    a = a + b + ( mx ); \
+    d = ROR32( d ^ a, 16 ); \
+    c = c + d; \
+    b = ROR32( b ^ c, 12 ); \
+    a = a + b + ( my ); \
+    d = ROR32( d ^ a, 8 ); \
+    c = c + d; \
+    b = ROR32( b ^ c, 7 ); \
+    }
+
+#define ROUND(r) \
+    { \
+    G( v[ 0 ], v[ 4 ], v[ 8 ], v[ 12 ], m[ MSG_SCHEDULE[ r ][ 0 ] ], m[ MSG_SCHEDULE[ r ][ 1 ] ] ); \
+    G( v[ 1 ], v[ 5 ], v[ 9 ], v[ 13 ], m[ MSG_SCHEDULE[ r ][ 2 ] ], m[ MSG_SCHEDULE[ r ][ 3 ] ] ); \
+    G( v[ 2 ], v[ 6 ], v[ 10 ], v[ 14 ], m[ MSG_SCHEDULE[ r ][ 4 ] ], m[ MSG_SCHEDULE[ r ][ 5 ] ] ); \
+    G( v[ 3 ], v[ 7 ], v[ 11 ], v[ 15 ], m[ MSG_SCHEDULE[ r ][ 6 ] ], m[ MSG_SCHEDULE[ r ][ 7 ] ] ); \
+    G( v[ 0 ], v[ 5 ], v[ 10 ], v[ 15 ], m[ MSG_SCHEDULE[ r ][ 8 ] ], m[ MSG_SCHEDULE[ r ][ 9 ] ] ); \
+    G( v[ 1 ], v[ 6 ], v[ 11 ], v[ 12 ], m[ MSG_SCHEDULE[ r ][ 10 ] ], m[ MSG_SCHEDULE[ r ][ 11 ] ] ); \
+    G( v[ 2 ], v[ 7 ], v[ 8 ], v[ 13 ], m[ MSG_SCHEDULE[ r ][ 12 ] ], m[ MSG_SCHEDULE[ r ][ 13 ] ] ); \
+    G( v[ 3 ], v[ 4 ], v[ 9 ], v[ 14 ], m[ MSG_SCHEDULE[ r ][ 14 ] ], m[ MSG_SCHEDULE[ r ][ 15 ] ] ); \
+    }
+
+static inline uint32 load32le(const uint8* p)
+{
+#ifdef WORDS_BIGENDIAN
+    return ( uint32 ) p[ 0 ] | ( ( uint32 ) p[ 1 ] << 8 ) | ( ( uint32 ) p[ 2 ] << 16 ) | ( ( uint32 ) p[ 3 ] << 24 );
+#else
+    uint32 x;
+    memcpy( &x, p, sizeof( x ) );
+    return x;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// blake3Compress -- the compression function; cv is replaced with the first
+//      eight words of the output
+///////////////////////////////////////////////////////////////////////////////
+static void blake3Compress(uint32 cv[ 8 ], const uint8 block[ BLAKE3_BLOCKSIZE ], uint64 counter, uint32 blockLen, uint32 flags)
+{
+    uint32 m[ 16 ], v[ 16 ];
+    int    i;
+
+    for( i = 0; i < 16; i++ )
+        m[ i ] = load32le( block + 4 * i );
+
+    for( i = 0; i < 8; i++ )
+        v[ i ] = cv[ i ];
+    v[ 8 ]  = IV[ 0 ];
+    v[ 9 ]  = IV[ 1 ];
+    v[ 10 ] = IV[ 2 ];
+    v[ 11 ] = IV[ 3 ];
+    v[ 12 ] = ( uint32 ) counter;
+    v[ 13 ] = ( uint32 ) ( counter >> 32 );
+    v[ 14 ] = blockLen;
+    v[ 15 ] = flags;
+
+    /* written out in full, so that the schedule is folded into the code and v stays in registers */
+    ROUND( 0 );
+    ROUND( 1 );
+    ROUND( 2 );
+    ROUND( 3 );
+    ROUND( 4 );
+    ROUND( 5 );
+    ROUND( 6 );
+
+    for( i = 0; i < 8; i++ )
+        cv[ i ] = v[ i ] ^ v[ i + 8 ];
+}
+
+// the chaining value of a parent node whose children have chaining values left and right
+static void blake3Parent(uint32 cv[ 8 ], const uint32 left[ 8 ], const uint32 right[ 8 ])
+{
+    uint8 block[ BLAKE3_BLOCKSIZE ];
+    for( int i = 0; i < 8; i++ )
+    {
+        for( int j = 0; j < 4; j++ )
+        {
+            block[ 4 * i + j ]      = ( uint8 ) ( left[ i ] >> ( 8 * j ) );
+            block[ 32 + 4 * i + j ] = ( uint8 ) ( right[ i ] >> ( 8 * j ) );
+        }
+    }
+    memcpy( cv, IV, sizeof( IV ) );
+    blake3Compress( cv, block, 0, BLAKE3_BLOCKSIZE, PARENT );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// hash many -- chaining values for nChunks whole chunks laid end to end in
+//      input, the first of which is chunk number counter
+///////////////////////////////////////////////////////////////////////////////
+static void blake3HashManyGeneric(const uint8* input, int nChunks, uint64 counter, uint32 cvs[][ 8 ])
+{
+    for( int c = 0; c < nChunks; c++, input += BLAKE3_CHUNKSIZE )
+    {
+        memcpy( cvs[ c ], IV, sizeof( IV ) );
+        for( int b = 0; b < BLAKE3_CHUNKSIZE / BLAKE3_BLOCKSIZE; b++ )
+        {
+            uint32 flags = ( b == 0 ? CHUNK_START : 0 ) | ( b == BLAKE3_CHUNKSIZE / BLAKE3_BLOCKSIZE - 1 ? CHUNK_END : 0 );
+            blake3Compress( cvs[ c ], input + b * BLAKE3_BLOCKSIZE, counter + c, BLAKE3_BLOCKSIZE, flags );
+        }
+    }
+}
+
+#if BLAKE3_USES_AVX2
+/* Eight chunks at once, one per 32 bit lane.  Each block's message words are
+   loaded a chunk at a time and transposed so that vector j holds word j of
+   every chunk; the chaining values are transposed back at the end. */
+
+__attribute__(( target( "avx2" ) ))
+static inline void blake3Transpose8(__m256i v[ 8 ])
+{
+    __m256i ab0145 = _mm256_unpacklo_epi32( v[ 0 ], v[ 1 ] );
+    __m256i ab2367 = _mm256_unpackhi_epi32( v[ 0 ], v[ 1 ] );
+    __m256i cd0145 = _mm256_unpacklo_epi32( v[ 2 ], v[ 3 ] );
+    __m256i cd2367 = _mm256_unpackhi_epi32( v[ 2 ], v[ 3 ] );
+    __m256i ef0145 = _mm256_unpacklo_epi32( v[ 4 ], v[ 5 ] );
+    __m256i ef2367 = _mm256_unpackhi_epi32( v[ 4 ], v[ 5 ] );
+    __m256i gh0145 = _mm256_unpacklo_epi32( v[ 6 ], v[ 7 ] );
+    __m256i gh2367 = _mm256_unpackhi_epi32( v[ 6 ], v[ 7 ] );
+
+    __m256i abcd04 = _mm256_unpacklo_epi64( ab0145, cd0145 );
+    __m256i abcd15 = _mm256_unpackhi_epi64( ab0145, cd0145 );
+    __m256i abcd26 = _mm256_unpacklo_epi64( ab2367, cd2367 );
+    __m256i abcd37 = _mm256_unpackhi_epi64( ab2367, cd2367 );
+    __m256i efgh04 = _mm256_unpacklo_epi64( ef0145, gh0145 );
+    __m256i efgh15 = _mm256_unpackhi_epi64( ef0145, gh0145 );
+    __m256i efgh26 = _mm256_unpacklo_epi64( ef2367, gh2367 );
+    __m256i efgh37 = _mm256_unpackhi_epi64( ef2367, gh2367 );
+
+    v[ 0 ] = _mm256_permute2x128_si256( abcd04, efgh04, 0x20 );
+    v[ 1 ] = _mm256_permute2x128_si256( abcd15, efgh15, 0x20 );
+    v[ 2 ] = _mm256_permute2x128_si256( abcd26, efgh26, 0x20 );
+    v[ 3 ] = _mm256_permute2x128_si256( abcd37, efgh37, 0x20 );
+    v[ 4 ] = _mm256_permute2x128_si256( abcd04, efgh04, 0x31 );
+    v[ 5 ] = _mm256_permute2x128_si256( abcd15, efgh15, 0x31 );
+    v[ 6 ] = _mm256_permute2x128_si256( abcd26, efgh26, 0x31 );
+    v[ 7 ] = _mm256_permute2x128_si256( abcd37, efgh37, 0x31 );
+}
+
+#define ADD8(a, b) _mm256_add_epi32( a, b )
+#define XOR8(a, b) _mm256_xor_si256( a, b )
+#define ROR8_BY(x, n) _mm256_or_si256( _mm256_srli_epi32( x, n ), _mm256_slli_epi32( x, 32 - ( n ) ) )
+
+#define G8(a, b, c, d, mx, my) \
+    { \
+    a = ADD8( ADD8( a, b ), mx ); \
+    d = _mm256_shuffle_epi8( XOR8( d, a ), rot16 ); \
+    c = ADD8( c, d ); \
+    b = ROR8_BY( XOR8( b, c ), 12 ); \
+    a = ADD8( ADD8( a, b ), my ); \
+    d = _mm256_shuffle_epi8( XOR8( d, a ), rot8 ); \
+    c = ADD8( c, d ); \
+    b = ROR8_BY( XOR8( b, c ), 7 ); \
+    }
+
+#define ROUND8(r) \
+    { \
+    G8( v[ 0 ], v[ 4 ], v[ 8 ], v[ 12 ], m[ MSG_SCHEDULE[ r ][ 0 ] ], m[ MSG_SCHEDULE[ r ][ 1 ] ] ); \
+    G8( v[ 1 ], v[ 5 ], v[ 9 ], v[ 13 ], m[ MSG_SCHEDULE[ r ][ 2 ] ], m[ MSG_SCHEDULE[ r ][ 3 ] ] ); \
+    G8( v[ 2 ], v[ 6 ], v[ 10 ], v[ 14 ], m[ MSG_SCHEDULE[ r ][ 4 ] ], m[ MSG_SCHEDULE[ r ][ 5 ] ] ); \
+    G8( v[ 3 ], v[ 7 ], v[ 11 ], v[ 15 ], m[ MSG_SCHEDULE[ r ][ 6 ] ], m[ MSG_SCHEDULE[ r ][ 7 ] ] ); \
+    G8( v[ 0 ], v[ 5 ], v[ 10 ], v[ 15 ], m[ MSG_SCHEDULE[ r ][ 8 ] ], m[ MSG_SCHEDULE[ r ][ 9 ] ] ); \
+    G8( v[ 1 ], v[ 6 ], v[ 11 ], v[ 12 ], m[ MSG_SCHEDULE[ r ][ 10 ] ], m[ MSG_SCHEDULE[ r ][ 11 ] ] ); \
+    G8( v[ 2 ], v[ 7 ], v[ 8 ], v[ 13 ], m[ MSG_SCHEDULE[ r ][ 12 ] ], m[ MSG_SCHEDULE[ r ][ 13 ] ] ); \
+    G8( v[ 3 ], v[ 4 ], v[ 9 ], v[ 14 ], m[ MSG_SCHEDULE[ r ][ 14 ] ], m[ MSG_SCHEDULE[ r ][ 15 ] ] ); \
+    }
+
+__attribute__(( target( "avx2" ) ))
+static void blake3HashMany8AVX2(const uint8* input, uint64 counter, uint32 cvs[][ 8 ])
+{
+    const __m256i rot16 = _mm256_setr_epi8( 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                            2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 );
+    const __m256i rot8  = _mm256_setr_epi8( 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+                                            1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12 );
+    uint32 lo[ 8 ], hi[ 8 ];
+    for( int i = 0; i < 8; i++ )
+    {
+        lo[ i ] = ( uint32 ) ( counter + i );
+        hi[ i ] = ( uint32 ) ( ( counter + i ) >> 32 );
+    }
+    const __m256i counterLo = _mm256_loadu_si256( ( const __m256i* ) lo );
+    const __m256i counterHi = _mm256_loadu_si256( ( const __m256i* ) hi );
+
+    __m256i h[ 8 ];
+    for( int i = 0; i < 8; i++ )
+        h[ i ] = _mm256_set1_epi32( ( int ) IV[ i ] );
+
+    for( int b = 0; b < BLAKE3_CHUNKSIZE / BLAKE3_BLOCKSIZE; b++ )
+    {
+        __m256i m[ 16 ], v[ 16 ];
+        for( int i = 0; i < 8; i++ )
+        {
+            const uint8* p = input + i * BLAKE3_CHUNKSIZE + b * BLAKE3_BLOCKSIZE;
+            m[ i ]     = _mm256_loadu_si256( ( const __m256i* ) p );
+            m[ i + 8 ] = _mm256_loadu_si256( ( const __m256i* ) ( p + 32 ) );
+        }
+        blake3Transpose8( m );
+        blake3Transpose8( m + 8 );
+
+        uint32 flags = ( b == 0 ? CHUNK_START : 0 ) | ( b == BLAKE3_CHUNKSIZE / BLAKE3_BLOCKSIZE - 1 ? CHUNK_END : 0 );
+        for( int i = 0; i < 8; i++ )
+            v[ i ] = h[ i ];
+        v[ 8 ]  = _mm256_set1_epi32( ( int ) IV[ 0 ] );
+        v[ 9 ]  = _mm256_set1_epi32( ( int ) IV[ 1 ] );
+        v[ 10 ] = _mm256_set1_epi32( ( int ) IV[ 2 ] );
+        v[ 11 ] = _mm256_set1_epi32( ( int ) IV[ 3 ] );
+        v[ 12 ] = counterLo;
+        v[ 13 ] = counterHi;
+        v[ 14 ] = _mm256_set1_epi32( BLAKE3_BLOCKSIZE );
+        v[ 15 ] = _mm256_set1_epi32( ( int ) flags );
+
+        ROUND8( 0 );
+        ROUND8( 1 );
+        ROUND8( 2 );
+        ROUND8( 3 );
+        ROUND8( 4 );
+        ROUND8( 5 );
+        ROUND8( 6 );
+
+        for( int i = 0; i < 8; i++ )
+            h[ i ] = XOR8( v[ i ], v[ i + 8 ] );
+    }
+
+    blake3Transpose8( h );
+    for( int i = 0; i < 8; i++ )
+        _mm256_storeu_si256( ( __m256i* ) cvs[ i ], h[ i ] );
+}
+
+#undef ROUND8
+#undef G8
+#undef ROR8_BY
+#undef XOR8
+#undef ADD8
+#endif /* BLAKE3_USES_AVX2 */
+
+static int s_kernel = -1;
+
+static int blake3BestKernel()
+{
+#if BLAKE3_USES_AVX2
+    static const bool bHaveAVX2 = ( __builtin_cpu_init(), __builtin_cpu_supports( "avx2" ) );
+    if( bHaveAVX2 )
+        return BLAKE3_KERNEL_AVX2;
+#endif
+    return BLAKE3_KERNEL_GENERIC;
+}
+
+static void blake3HashMany(const uint8* input, int nChunks, uint64 counter, uint32 cvs[][ 8 ])
+{
+#if BLAKE3_USES_AVX2
+    if( ( s_kernel < 0 ? blake3BestKernel() : s_kernel ) == BLAKE3_KERNEL_AVX2 )
+    {
+        for( ; nChunks >= 8; nChunks -= 8, counter += 8, cvs += 8, input += 8 * BLAKE3_CHUNKSIZE )
+            blake3HashMany8AVX2( input, counter, cvs );
+    }
+#endif
+    blake3HashManyGeneric( input, nChunks, counter, cvs );
+}
+
+bool blake3SetKernel(BLAKE3_KERNEL kernel)
+{
+    if( kernel < 0 || kernel >= BLAKE3_KERNEL_NUMITEMS )
+        return false;
+    if( kernel == BLAKE3_KERNEL_AVX2 && blake3BestKernel() != BLAKE3_KERNEL_AVX2 )
+        return false;
+
+    s_kernel = kernel;
+    return true;
+}
+
+BLAKE3_KERNEL blake3GetKernel()
+{
+    return ( BLAKE3_KERNEL ) ( s_kernel < 0 ? blake3BestKernel() : s_kernel );
+}
+
+const char* blake3KernelName(BLAKE3_KERNEL kernel)
+{
+    switch( kernel )
+    {
+    case BLAKE3_KERNEL_GENERIC: return "generic";
+    case BLAKE3_KERNEL_AVX2:    return "avx2";
+    default:                    return "unknown";
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// the chunk state
+///////////////////////////////////////////////////////////////////////////////
+static void blake3ChunkInit(BLAKE3_CHUNK* chunk, uint64 chunkCounter)
+{
+    memcpy( chunk->cv, IV, sizeof( IV ) );
+    chunk->chunkCounter     = chunkCounter;
+    chunk->blockLen         = 0;
+    chunk->blocksCompressed = 0;
+}
+
+static int blake3ChunkLen(const BLAKE3_CHUNK* chunk)
+{
+    return chunk->blocksCompressed * BLAKE3_BLOCKSIZE + chunk->blockLen;
+}
+
+static uint32 blake3ChunkStartFlag(const BLAKE3_CHUNK* chunk)
+{
+    return chunk->blocksCompressed == 0 ? CHUNK_START : 0;
+}
+
+// a full block is only compressed once more input turns up, since the
+// chunk's last block has to be compressed with CHUNK_END set
+static void blake3ChunkUpdate(BLAKE3_CHUNK* chunk, const uint8* buffer, int count)
+{
+    while( count > 0 )
+    {
+        if( chunk->blockLen == BLAKE3_BLOCKSIZE )
+        {
+            blake3Compress( chunk->cv, chunk->block, chunk->chunkCounter, BLAKE3_BLOCKSIZE, blake3ChunkStartFlag( chunk ) );
+            chunk->blocksCompressed++;
+            chunk->blockLen = 0;
+        }
+
+        int take = BLAKE3_BLOCKSIZE - chunk->blockLen;
+        if( take > count )
+            take = count;
+        memcpy( chunk->block + chunk->blockLen, buffer, take );
+        chunk->blockLen += take;
+        buffer += take;
+        count -= take;
+    }
+}
+
+// the chunk's last block, set up for blake3Compress; the caller adds ROOT if need be
+static void blake3ChunkOutput(const BLAKE3_CHUNK* chunk, uint32 cv[ 8 ], uint8 block[ BLAKE3_BLOCKSIZE ], uint32& flags)
+{
+    memcpy( cv, chunk->cv, sizeof( chunk->cv ) );
+    memcpy( block, chunk->block, chunk->blockLen );
+    memset( block + chunk->blockLen, 0, BLAKE3_BLOCKSIZE - chunk->blockLen );
+    flags = blake3ChunkStartFlag( chunk ) | CHUNK_END;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// blake3PushCV -- adds the chaining value of the chunk that makes
+//      totalChunks, merging it with every subtree it completes.  Only called
+//      when there's more input to come, so none of these can be the root.
+///////////////////////////////////////////////////////////////////////////////
+static void blake3PushCV(BLAKE3_INFO* info, const uint32 chunkCV[ 8 ], uint64 totalChunks)
+{
+    uint32 cv[ 8 ];
+    memcpy( cv, chunkCV, sizeof( cv ) );
+
+    while( ( totalChunks & 1 ) == 0 )
+    {
+        blake3Parent( cv, info->stack[ --info->stackLen ], cv );
+        totalChunks >>= 1;
+    }
+    memcpy( info->stack[ info->stackLen++ ], cv, sizeof( cv ) );
+}
+
+void blake3Init(BLAKE3_INFO* info)
+{
+    blake3InitAt( info, 0 );
+}
+
+void blake3InitAt(BLAKE3_INFO* info, uint64 chunkCounter)
+{
+    blake3ChunkInit( &info->chunk, chunkCounter );
+    info->stackLen = 0;
+}
+
+void blake3Update(BLAKE3_INFO* info, const uint8* buffer, int count)
+{
+    // top up a chunk left over from last time
+    if( blake3ChunkLen( &info->chunk ) > 0 )
+    {
+        int take = BLAKE3_CHUNKSIZE - blake3ChunkLen( &info->chunk );
+        if( take > count )
+            take = count;
+        blake3ChunkUpdate( &info->chunk, buffer, take );
+        buffer += take;
+        count -= take;
+        if( count == 0 )
+            return;
+
+        // it's full, and it isn't the last one
+        uint32 cv[ 8 ];
+        uint8  block[ BLAKE3_BLOCKSIZE ];
+        uint32 flags;
+        blake3ChunkOutput( &info->chunk, cv, block, flags );
+        blake3Compress( cv, block, info->chunk.chunkCounter, info->chunk.blockLen, flags );
+        blake3PushCV( info, cv, info->chunk.chunkCounter + 1 );
+        blake3ChunkInit( &info->chunk, info->chunk.chunkCounter + 1 );
+    }
+
+    // whole chunks with more input after them go straight to the kernel
+    while( count > BLAKE3_CHUNKSIZE )
+    {
+        enum { BATCH = 16 };
+        uint32 cvs[ BATCH ][ 8 ];
+        uint64 counter = info->chunk.chunkCounter;
+        int    n       = ( count - 1 ) / BLAKE3_CHUNKSIZE;
+        if( n > BATCH )
+            n = BATCH;
+
+        blake3HashMany( buffer, n, counter, cvs );
+        for( int i = 0; i < n; i++ )
+            blake3PushCV( info, cvs[ i ], counter + i + 1 );
+
+        blake3ChunkInit( &info->chunk, counter + n );
+        buffer += n * BLAKE3_CHUNKSIZE;
+        count -= n * BLAKE3_CHUNKSIZE;
+    }
+
+    blake3ChunkUpdate( &info->chunk, buffer, count );
+}
+
+void blake3Final(const BLAKE3_INFO* info, uint8 digest[ BLAKE3_DIGESTSIZE ])
+{
+    uint32 cv[ 8 ];
+    uint8  block[ BLAKE3_BLOCKSIZE ];
+    uint32 flags;
+    uint64 counter  = info->chunk.chunkCounter;
+    uint32 blockLen = info->chunk.blockLen;
+
+    blake3ChunkOutput( &info->chunk, cv, block, flags );
+
+    // fold the subtrees on the stack in, right to left; the last node is the root
+    for( int i = info->stackLen - 1; i >= 0; i-- )
+    {
+        blake3Compress( cv, block, counter, blockLen, flags );
+
+        for( int w = 0; w < 8; w++ )
+        {
+            for( int j = 0; j < 4; j++ )
+            {
+                block[ 4 * w + j ]      = ( uint8 ) ( info->stack[ i ][ w ] >> ( 8 * j ) );
+                block[ 32 + 4 * w + j ] = ( uint8 ) ( cv[ w ] >> ( 8 * j ) );
+            }
+        }
+        memcpy( cv, IV, sizeof( IV ) );
+        counter  = 0;
+        blockLen = BLAKE3_BLOCKSIZE;
+        flags    = PARENT;
+    }
+
+    blake3Compress( cv, block, 0, blockLen, flags | ROOT );
+
+    for( int i = 0; i < BLAKE3_DIGESTSIZE; i++ )
+        digest[ i ] = ( uint8 ) ( cv[ i / 4 ] >> ( 8 * ( i % 4 ) ) );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// subtrees -- since a subtree starts on a multiple of its own size, the
+//      merges blake3PushCV() does inside it never reach past its first
+//      chunk, and what is left on the stack at the end is its left spine
+///////////////////////////////////////////////////////////////////////////////
+void blake3FinalSubtree(const BLAKE3_INFO* info, uint32 cv[ 8 ])
+{
+    uint8  block[ BLAKE3_BLOCKSIZE ];
+    uint32 flags;
+
+    ASSERT( blake3ChunkLen( &info->chunk ) == BLAKE3_CHUNKSIZE );
+
+    blake3ChunkOutput( &info->chunk, cv, block, flags );
+    blake3Compress( cv, block, info->chunk.chunkCounter, info->chunk.blockLen, flags );
+
+    for( int i = info->stackLen - 1; i >= 0; i-- )
+        blake3Parent( cv, info->stack[ i ], cv );
+}
+
+void blake3AddSubtree(BLAKE3_INFO* info, const uint32 cv[ 8 ], uint64 nChunks)
+{
+    uint64 counter = info->chunk.chunkCounter;
+
+    ASSERT( blake3ChunkLen( &info->chunk ) == 0 );
+    ASSERT( nChunks > 0 && ( nChunks & ( nChunks - 1 ) ) == 0 && counter % nChunks == 0 );
+
+    // everything on the stack covers at least as many chunks as this does,
+    // so it merges the way a single chunk would one level up
+    blake3PushCV( info, cv, ( counter + nChunks ) / nChunks );
+    blake3ChunkInit( &info->chunk, counter + nChunks );
+}
@@ -0,0 +1,93 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// blake3.h -- BLAKE3, in its plain hashing mode, with a 256 bit digest
+//
+// The input is split into 1 KiB chunks that are hashed independently and
+// then combined pairwise up a binary tree, so several chunks can be hashed
+// side by side in SIMD lanes.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef __BLAKE3_H
+#define __BLAKE3_H
+
+#ifndef __TYPES_H
+#include "types.h"
+#endif
+
+#define BLAKE3_BLOCKSIZE  64
+#define BLAKE3_CHUNKSIZE  1024
+#define BLAKE3_DIGESTSIZE 32
+#define BLAKE3_MAX_DEPTH  54 /* enough for 2^64 bytes */
+
+typedef struct {
+    uint32 cv[ 8 ];                   /* chaining value of the chunk so far */
+    uint64 chunkCounter;              /* which chunk of the input this is */
+    uint8  block[ BLAKE3_BLOCKSIZE ]; /* the block not compressed yet */
+    int    blockLen;
+    int    blocksCompressed;
+} BLAKE3_CHUNK;
+
+typedef struct {
+    BLAKE3_CHUNK chunk;                         /* the chunk being filled */
+    int          stackLen;
+    uint32       stack[ BLAKE3_MAX_DEPTH ][ 8 ]; /* chaining values of finished subtrees */
+} BLAKE3_INFO;
+
+void blake3Init(BLAKE3_INFO* info);
+void blake3Update(BLAKE3_INFO* info, const uint8* buffer, int count);
+void blake3Final(const BLAKE3_INFO* info, uint8 digest[ BLAKE3_DIGESTSIZE ]);
+
+/* A run of 2^k whole chunks starting at a chunk number that is a multiple
+   of 2^k is a subtree of its own, and can be hashed apart from the rest of
+   the input: start it with blake3InitAt(), Update() it with exactly that
+   many bytes, and get its chaining value from blake3FinalSubtree().  Then
+   blake3AddSubtree() stands in for updating the whole input's state with
+   those bytes, provided the state has had everything before them and the
+   input doesn't end with them. */
+void blake3InitAt(BLAKE3_INFO* info, uint64 chunkCounter);
+void blake3FinalSubtree(const BLAKE3_INFO* info, uint32 cv[ 8 ]);
+void blake3AddSubtree(BLAKE3_INFO* info, const uint32 cv[ 8 ], uint64 nChunks);
+
+/* The ways whole chunks can be hashed; they all give the same answer.  The
+   fastest one this cpu can run is used unless told otherwise. */
+typedef enum {
+    BLAKE3_KERNEL_GENERIC,            /* portable C, a chunk at a time */
+    BLAKE3_KERNEL_AVX2,               /* x86 AVX2, eight chunks at a time */
+    BLAKE3_KERNEL_NUMITEMS
+} BLAKE3_KERNEL;
+
+bool          blake3SetKernel(BLAKE3_KERNEL kernel); /* false if this cpu can't run it */
+BLAKE3_KERNEL blake3GetKernel();
+const char*   blake3KernelName(BLAKE3_KERNEL kernel);
+
+#endif /* __BLAKE3_H */
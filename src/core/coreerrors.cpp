@@ -79,6 +79,7 @@ TSS_REGISTER_ERROR(eArchiveOutOfMem(), _T("Archive ran out of memory."))
 TSS_REGISTER_ERROR(eArchiveInvalidOp(), _T("Archive logic error."))
 TSS_REGISTER_ERROR(eArchiveFormat(), _T("Archive file format invalid."))
 TSS_REGISTER_ERROR(eArchiveNotRegularFile(), _T("File is not a regular file."))
+TSS_REGISTER_ERROR(eArchiveIntegrity(), _T("File failed its integrity check."))
 TSS_REGISTER_ERROR(eArchiveCrypto(), _T("File could not be decrypted."))
 TSS_REGISTER_ERROR(eArchiveStringTooLong(), _T("String was too long."))
 
@@ -82,6 +82,15 @@
 #include "archive.h"
 #endif
 
+#if HAVE_GCC && (defined(__x86_64__) || defined(__i386__))
+#   define CRC_USES_CLMUL 1
+#   include <emmintrin.h>
+#   include <tmmintrin.h>
+#   include <wmmintrin.h>
+#else
+#   define CRC_USES_CLMUL 0
+#endif
+
 #define BUFSIZE 4096
 
 static uint32 crctab[] = {
@@ -148,6 +157,131 @@ static uint32 crctab[] = {
 #define COMPUTE(var, ch)    (var) = ((var) << 8) ^ \
                 crctab[0xff & (unsigned)((var) >> 24 ^ (ch))]
 
+///////////////////////////////////////////////////////////////////////////////
+// cCRCTables -- crctab, plus the seven tables derived from it that slicing by
+//      eight uses: sliceTab[k][b] is the crc of the byte b followed by k
+//      zero bytes. Built the first time they're needed.
+///////////////////////////////////////////////////////////////////////////////
+struct cCRCTables
+{
+    cCRCTables();
+
+    uint32      sliceTab[8][256];
+    CRC_KERNEL  best;
+};
+
+cCRCTables::cCRCTables()
+{
+    for( int b = 0; b < 256; b++ )
+        sliceTab[0][b] = crctab[b];
+
+    for( int k = 1; k < 8; k++ )
+    {
+        for( int b = 0; b < 256; b++ )
+        {
+            uint32 c = sliceTab[k - 1][b];
+            sliceTab[k][b] = ( c << 8 ) ^ crctab[c >> 24];
+        }
+    }
+
+    best = CRC_KERNEL_SLICE8;
+#if CRC_USES_CLMUL
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "pclmul" ) && __builtin_cpu_supports( "ssse3" ) )
+        best = CRC_KERNEL_CLMUL;
+#endif
+}
+
+static const cCRCTables& util_GetTables()
+{
+    static const cCRCTables tables;
+    return tables;
+}
+
+static int s_kernel = -1; // until set, util_GetTables().best
+
+static uint32 util_UpdateByte( uint32 crc, const uint8* pbData, int cbDataLen )
+{
+    for( int i = 0; i < cbDataLen; i++, pbData++ )
+    {
+        COMPUTE( crc, *pbData );
+    }
+    return crc;
+}
+
+static uint32 util_UpdateSlice8( const cCRCTables& t, uint32 crc, const uint8* pbData, int cbDataLen )
+{
+    // the first four bytes of each eight meet the crc, which is msb first; the
+    // bytes are put together one at a time so this doesn't care about byte order
+    for( ; cbDataLen >= 8; cbDataLen -= 8, pbData += 8 )
+    {
+        uint32 x = crc ^ ( ( (uint32)pbData[0] << 24 ) | ( (uint32)pbData[1] << 16 ) |
+                           ( (uint32)pbData[2] << 8 )  |   (uint32)pbData[3] );
+        crc = t.sliceTab[7][x >> 24] ^ t.sliceTab[6][( x >> 16 ) & 0xff] ^
+              t.sliceTab[5][( x >> 8 ) & 0xff] ^ t.sliceTab[4][x & 0xff] ^
+              t.sliceTab[3][pbData[4]] ^ t.sliceTab[2][pbData[5]] ^
+              t.sliceTab[1][pbData[6]] ^ t.sliceTab[0][pbData[7]];
+    }
+    return util_UpdateByte( crc, pbData, cbDataLen );
+}
+
+#if CRC_USES_CLMUL
+///////////////////////////////////////////////////////////////////////////////
+// util_FoldCLMUL -- the crc with no initial value and no length appended is
+//      the data, as a polynomial with the first byte's top bit highest, times
+//      x^32 mod P. So a 128 bit block A followed by D bits more can be swapped
+//      for the 96 bit A's high half * (x^(64+D) mod P) ^ its low half * (x^D
+//      mod P), lined up with the next block. This folds four blocks at a time
+//      into four accumulators, then those into one, and then works out the crc
+//      of what's left with the tables. The incoming crc lines up with the top
+//      of the first block. cbDataLen must be at least 64; whatever doesn't
+//      make a whole block is left for the caller, and the number of bytes done
+//      is returned in cbDone.
+///////////////////////////////////////////////////////////////////////////////
+__attribute__(( target( "pclmul,ssse3" ) ))
+static uint32 util_FoldCLMUL( const cCRCTables& t, uint32 crc, const uint8* pbData, int cbDataLen, int& cbDone )
+{
+    const __m128i byteSwap = _mm_set_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 );
+    const __m128i k512     = _mm_set_epi64x( 0x8833794c, 0xe6228b11 ); // x^576, x^512 mod P
+    const __m128i k128     = _mm_set_epi64x( 0xc5b9cd4c, 0xe8a45605 ); // x^192, x^128 mod P
+
+#   define CRC_LOAD( p )        _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)( p ) ), byteSwap )
+#   define CRC_FOLD( a, k, b )  _mm_xor_si128( _mm_xor_si128( _mm_clmulepi64_si128( a, k, 0x11 ), \
+                                                             _mm_clmulepi64_si128( a, k, 0x00 ) ), b )
+
+    const uint8* p = pbData;
+    __m128i a0 = _mm_xor_si128( CRC_LOAD( p ), _mm_set_epi32( (int)crc, 0, 0, 0 ) );
+    __m128i a1 = CRC_LOAD( p + 16 );
+    __m128i a2 = CRC_LOAD( p + 32 );
+    __m128i a3 = CRC_LOAD( p + 48 );
+    p += 64;
+
+    const uint8* pEnd = pbData + cbDataLen;
+    for( ; pEnd - p >= 64; p += 64 )
+    {
+        a0 = CRC_FOLD( a0, k512, CRC_LOAD( p ) );
+        a1 = CRC_FOLD( a1, k512, CRC_LOAD( p + 16 ) );
+        a2 = CRC_FOLD( a2, k512, CRC_LOAD( p + 32 ) );
+        a3 = CRC_FOLD( a3, k512, CRC_LOAD( p + 48 ) );
+    }
+
+    a0 = CRC_FOLD( a0, k128, a1 );
+    a0 = CRC_FOLD( a0, k128, a2 );
+    a0 = CRC_FOLD( a0, k128, a3 );
+    for( ; pEnd - p >= 16; p += 16 )
+        a0 = CRC_FOLD( a0, k128, CRC_LOAD( p ) );
+
+#   undef CRC_LOAD
+#   undef CRC_FOLD
+
+    uint8 rest[16];
+    _mm_storeu_si128( (__m128i*)rest, _mm_shuffle_epi8( a0, byteSwap ) );
+
+    cbDone = (int)( p - pbData );
+    return util_UpdateSlice8( t, 0, rest, sizeof( rest ) );
+}
+#endif
+
 void crcInit( CRC_INFO& crcInfo )
 {    
     crcInfo.cbTotalLen  = 0;
@@ -156,12 +290,88 @@ void crcInit( CRC_INFO& crcInfo )
 
 void crcUpdate( CRC_INFO& crcInfo, const uint8* pbData, int cbDataLen )
 {    
-    for( int i = 0; i < cbDataLen; i++, pbData++ )
+    const cCRCTables& t = util_GetTables();
+    int kernel = ( s_kernel < 0 ) ? t.best : s_kernel;
+    uint32 crc = crcInfo.crc;
+
+    crcInfo.cbTotalLen += cbDataLen;
+
+#if CRC_USES_CLMUL
+    // the folding only pays for itself on more than a few blocks
+    if( kernel == CRC_KERNEL_CLMUL && cbDataLen >= 256 )
     {
-        COMPUTE( crcInfo.crc, *pbData );
+        int cbDone = 0;
+        crc = util_FoldCLMUL( t, crc, pbData, cbDataLen, cbDone );
+        pbData    += cbDone;
+        cbDataLen -= cbDone;
     }
+#endif
 
-    crcInfo.cbTotalLen += cbDataLen;
+    if( kernel == CRC_KERNEL_BYTE )
+        crcInfo.crc = util_UpdateByte( crc, pbData, cbDataLen );
+    else
+        crcInfo.crc = util_UpdateSlice8( t, crc, pbData, cbDataLen );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_MulMod -- a * b mod the crc polynomial, both of them being polynomials
+//      over GF(2) with the highest power in the top bit, as the crc is
+///////////////////////////////////////////////////////////////////////////////
+static uint32 util_MulMod( uint32 a, uint32 b )
+{
+    uint32 prod = 0;
+    for( int i = 31; i >= 0; i-- )
+    {
+        prod = ( prod << 1 ) ^ ( ( prod & 0x80000000 ) ? crctab[1] : 0 );
+        if( ( b >> i ) & 1 )
+            prod ^= a;
+    }
+    return prod;
+}
+
+// since the crc starts at zero and nothing is xored in until the end, running
+// n zero bytes through it just multiplies it by x^(8n)
+void crcUpdateZeros( CRC_INFO& crcInfo, int64 cbZeros )
+{
+    ASSERT( cbZeros >= 0 );
+    crcInfo.cbTotalLen += (uint32)cbZeros;
+
+    uint32 power = 0x100; // x^8, then x^16, x^32, ...
+    uint32 crc   = crcInfo.crc;
+    for( uint64 n = (uint64)cbZeros; n != 0; n >>= 1 )
+    {
+        if( n & 1 )
+            crc = util_MulMod( crc, power );
+        power = util_MulMod( power, power );
+    }
+    crcInfo.crc = crc;
+}
+
+bool crcSetKernel( CRC_KERNEL kernel )
+{
+    if( kernel < 0 || kernel >= CRC_KERNEL_NUMITEMS )
+        return false;
+    if( kernel == CRC_KERNEL_CLMUL && util_GetTables().best != CRC_KERNEL_CLMUL )
+        return false;
+
+    s_kernel = kernel;
+    return true;
+}
+
+CRC_KERNEL crcGetKernel()
+{
+    return (CRC_KERNEL)( ( s_kernel < 0 ) ? util_GetTables().best : s_kernel );
+}
+
+const char* crcKernelName( CRC_KERNEL kernel )
+{
+    switch( kernel )
+    {
+    case CRC_KERNEL_BYTE:   return "byte";
+    case CRC_KERNEL_SLICE8: return "slice-by-8";
+    case CRC_KERNEL_CLMUL:  return "pclmulqdq";
+    default:                return "unknown";
+    }
 }
 
 void crcFinit( CRC_INFO& crcInfo )
@@ -45,8 +45,25 @@ CRC_INFO;
 // must have 8-bit bytes
 void crcInit  ( CRC_INFO& crcInfo );
 void crcUpdate( CRC_INFO& crcInfo, const uint8* pbData, int cbDataLen );
+void crcUpdateZeros( CRC_INFO& crcInfo, int64 cbZeros );
+    // the same as crcUpdate with cbZeros zero bytes, in time that grows with log( cbZeros )
 void crcFinit ( CRC_INFO& crcInfo );
 
+// the ways crcUpdate can do its work; they all give the same answer.
+// crcUpdate uses the fastest one this cpu can run, unless told otherwise.
+enum CRC_KERNEL
+{
+    CRC_KERNEL_BYTE,    // the table driven loop, a byte at a time
+    CRC_KERNEL_SLICE8,  // eight tables, eight bytes at a time
+    CRC_KERNEL_CLMUL,   // carry-less multiply folding, 16 bytes at a time (x86 with PCLMULQDQ)
+    CRC_KERNEL_NUMITEMS
+};
+
+bool       crcSetKernel( CRC_KERNEL kernel );
+    // returns false, and changes nothing, if this cpu can't run kernel
+CRC_KERNEL crcGetKernel();
+const char* crcKernelName( CRC_KERNEL kernel );
+
 
     // calculates the crc for len bytes starting at pBuf
 //Wrapper function for CRC32 in crc32.cpp
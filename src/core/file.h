@@ -71,6 +71,7 @@ TSS_FILE_EXCEPTION(eFileRewind, eFile);
 // cFile
 //=============================================================================
 struct cFile_i;
+class cFSDirHandle;
 class cFile
 {
 public:
@@ -106,8 +107,10 @@ public:
     /************ User Interface **************************/
 
     // Both Open methods ALWAYS open files in BINARY mode!
-    void Open(const TSTRING& sFileName, uint32 flags = OPEN_READ); //throw(eFile)
-    void Close(void);                                              //throw(eFile)
+    void Open(const TSTRING& sFileName, uint32 flags = OPEN_READ, const cFSDirHandle* pDir = 0); //throw(eFile)
+        // if pDir is non-null, sFileName is a name within that directory; it is looked up relative
+        // to the directory's open descriptor if it has one, and must not be a symlink
+    void Close(void); //throw(eFile)
     bool IsOpen(void) const;
 
     File_t Seek(File_t offset, SeekFrom From) const; //throw(eFile)
@@ -116,6 +119,14 @@ public:
         // Read returns the number of bytes that are actually read.  If the nBytes
         // parameter is 0, 0 bytes will be read and buffer will remain untouched.
         // If the read head is at EOF, no bytes will be read and 0 will be returned.
+    File_t ReadAt(void* buffer, File_t nBytes, File_t offset) const; //throw(eFile)
+        // Reads like Read(), but from offset, without using or moving the read head,
+        // so several threads can read different parts of the file at once.
+    bool FindData(File_t offset, File_t& dataStart, File_t& dataEnd) const;
+        // Finds the first stretch of the file at or after offset that holds data, rather
+        // than being a hole that reads back as zeros, and returns false if there is none
+        // before the end. Where holes can't be found, the rest of the file is data. May
+        // move the read head, so it is meant to go along with ReadAt().
     File_t Write(const void* buffer, File_t nBytes); //throw(eFile)
         // Write returns the number of bytes that are actually written.
     File_t Tell(void) const;
@@ -128,6 +139,28 @@ public:
     // Returns the size of the current file in bytes.  Returns -1 if no file is defined.
     void Truncate(File_t offset); // throw(eFile)
 
+    const void* Map(File_t nBytes);
+    // Maps the first nBytes of a file opened for reading, privately and read-only, and
+    // returns the address of the mapping, which stays valid until Unmap() or Close().
+    // Returns null if the file can't be mapped, in which case Read() should be used.
+    // Touching the mapping past the end of a file that has shrunk since raises SIGBUS;
+    // see tw_CatchBusError().
+    void Unmap(void);
+    void* MapShared(File_t nBytes); //throw(eFile)
+        // Maps the first nBytes of a file opened for writing, shared and writable, so that
+        // changing the mapping changes the file. nBytes may run past the end of the file, but
+        // only the part before the end may be touched. Anything written with Write() is
+        // flushed first, and if the file is already mapped with this length, that mapping is
+        // returned. Returns null if the file can't be mapped.
+    bool SyncMap(void);
+    // Starts writing what has been changed through MapShared()'s mapping back to the file,
+    // so that Read() sees it. Returns false if that fails.
+    void WillNeed(File_t nBytes) const;
+    // Asks for the first nBytes of the file to be read into the page cache in the
+    // background, so that reading it later doesn't have to wait as long. Does
+    // nothing where the system has no way to ask. Close() doesn't then tell the
+    // system the file's pages are no longer needed, as it otherwise does.
+
 private:
     cFile(const cFile& rhs);            //not impl.
     cFile& operator=(const cFile& rhs); //not impl.
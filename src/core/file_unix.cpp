@@ -53,6 +53,10 @@
 #include <fcntl.h>
 #include <errno.h>
 
+#if SUPPORTS_MAPPED_HASHING || SUPPORTS_MAPPED_DATABASE
+#include <sys/mman.h>
+#endif
+
 #if HAVE_SYS_FS_VX_IOCTL_H
 #include <sys/fs/vx_ioctl.h>
 #endif
@@ -76,19 +80,41 @@ struct cFile_i
     ~cFile_i();
 
     int     m_fd;         //underlying file descriptor
-    FILE*   mpCurrStream; //currently defined file stream
+    FILE*   mpCurrStream; //currently defined file stream; null for scanning reads, which use m_fd directly
     TSTRING mFileName;    //the name of the file we are currently referencing.
     uint32  mFlags;       //Flags used to open the file
+    void*   mpMap;        //the file's contents, if Map() or MapShared() has been called
+    size_t  mMapLen;      //the length of that mapping
+    bool    mbMapShared;  //was it MapShared()?
+    bool    mbWillNeed;   //has WillNeed() been called? if so, Close() leaves the page cache alone
+
+    void Unmap();
 };
 
 //Ctor
-cFile_i::cFile_i() : m_fd(-1), mpCurrStream(NULL), mFlags(0)
+cFile_i::cFile_i() : m_fd(-1), mpCurrStream(NULL), mFlags(0), mpMap(NULL), mMapLen(0), mbMapShared(false), mbWillNeed(false)
+{
+}
+
+void cFile_i::Unmap()
 {
+#if SUPPORTS_MAPPED_HASHING || SUPPORTS_MAPPED_DATABASE
+    if (mpMap != NULL)
+        munmap(mpMap, mMapLen);
+#endif
+    mpMap       = NULL;
+    mMapLen     = 0;
+    mbMapShared = false;
 }
 
 //Dtor
 cFile_i::~cFile_i()
 {
+    Unmap();
+
+    if (mpCurrStream == NULL && m_fd >= 0)
+        close(m_fd);
+
     if (mpCurrStream != NULL)
     {
         fclose(mpCurrStream);
@@ -132,15 +158,16 @@ cFile::~cFile()
 ///////////////////////////////////////////////////////////////////////////////
 
 #if !USES_DEVICE_PATH
-void cFile::Open(const TSTRING& sFileName, uint32 flags)
+void cFile::Open(const TSTRING& sFileNameC, uint32 flags, const cFSDirHandle* pDir)
 {
+    TSTRING sFileName = pDir ? pDir->GetPath(sFileNameC) : sFileNameC;
 #else
-void cFile::Open(const TSTRING& sFileNameC, uint32 flags)
+void cFile::Open(const TSTRING& sFileNameC, uint32 flags, const cFSDirHandle* pDir)
 {
-    TSTRING sFileName = cDevicePath::AsNative(sFileNameC);
+    TSTRING sFileName = cDevicePath::AsNative(pDir ? pDir->GetPath(sFileNameC) : sFileNameC);
 #endif
     mode_t openmode = 0664;
-    if (mpData->mpCurrStream != NULL)
+    if (IsOpen())
         Close();
 
     mpData->mFlags = flags;
@@ -199,10 +226,21 @@ void cFile::Open(const TSTRING& sFileNameC, uint32 flags)
         perm |= O_DIRECT;
 #endif
 
+#if SUPPORTS_DIR_FDS
+    //
+    // actually open the file, relative to its directory if we have one
+    //
+    int fh;
+    if (pDir && pDir->GetFd() >= 0)
+        fh = openat(pDir->GetFd(), sFileNameC.c_str(), perm | O_NOFOLLOW, openmode);
+    else
+        fh = _topen(sFileName.c_str(), perm, openmode);
+#else
     //
     // actually open the file
     //
     int fh = _topen(sFileName.c_str(), perm, openmode);
+#endif
     if (fh == -1)
     {
         throw(eFileOpen(sFileName, iFSServices::GetInstance()->GetErrString()));
@@ -223,9 +261,20 @@ void cFile::Open(const TSTRING& sFileNameC, uint32 flags)
 #endif
 
     //
-    // turn the file handle into a FILE*
+    // turn the file handle into a FILE*, unless we are only going to be scanning
+    // it; those reads go straight into the caller's buffer, which saves a copy
+    // through the stdio buffer
     //
-    mpData->mpCurrStream = _tfdopen(fh, mode.c_str());
+    if (!(flags & OPEN_SCANNING) || (flags & OPEN_WRITE))
+    {
+        mpData->mpCurrStream = _tfdopen(fh, mode.c_str());
+        if (mpData->mpCurrStream == NULL)
+        {
+            close(fh);
+            mpData->m_fd = -1;
+            throw(eFileOpen(sFileName, iFSServices::GetInstance()->GetErrString()));
+        }
+    }
 
     mpData->mFileName = sFileName; //Set mFileName to the newly opened file.
 
@@ -265,14 +314,24 @@ void cFile::Open(const TSTRING& sFileNameC, uint32 flags)
 ///////////////////////////////////////////////////////////////////////////
 void cFile::Close() //throw(eFile)
 {
-    if (mpData->mpCurrStream != NULL)
+    mpData->Unmap();
+
+    if (IsOpen())
     {
 #ifdef HAVE_POSIX_FADVISE
-        posix_fadvise(fileno(mpData->mpCurrStream), 0, 0, POSIX_FADV_DONTNEED);
+        // what was asked to be read ahead is wanted by whoever opens the file next
+        if (!mpData->mbWillNeed)
+            posix_fadvise(mpData->m_fd, 0, 0, POSIX_FADV_DONTNEED);
 #endif
+        mpData->mbWillNeed = false;
+
+        if (mpData->mpCurrStream != NULL)
+            fclose(mpData->mpCurrStream);
+        else
+            close(mpData->m_fd);
 
-        fclose(mpData->mpCurrStream);
         mpData->mpCurrStream = NULL;
+        mpData->m_fd         = -1;
     }
 
 
@@ -281,7 +340,98 @@ void cFile::Close() //throw(eFile)
 
 bool cFile::IsOpen(void) const
 {
-    return (mpData->mpCurrStream != NULL);
+    return (mpData->m_fd >= 0);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// Map -- Maps the start of the file into memory for reading.  Returns null
+//      if that can't be done; nothing is thrown, since the caller can
+//      always fall back to Read().
+///////////////////////////////////////////////////////////////////////////
+const void* cFile::Map(File_t nBytes)
+{
+    ASSERT(IsOpen());
+    mpData->Unmap();
+
+#if SUPPORTS_MAPPED_HASHING
+    // a mapping can't be empty, or bigger than the address space
+    if (nBytes <= 0 || static_cast<File_t>(static_cast<size_t>(nBytes)) != nBytes)
+        return NULL;
+
+    void* pMap = mmap(NULL, static_cast<size_t>(nBytes), PROT_READ, MAP_PRIVATE, mpData->m_fd, 0);
+    if (pMap == MAP_FAILED)
+        return NULL;
+
+#    ifdef HAVE_MADVISE
+    // we read each mapping front to back exactly once
+    madvise(pMap, static_cast<size_t>(nBytes), MADV_SEQUENTIAL);
+#    endif
+
+    mpData->mpMap   = pMap;
+    mpData->mMapLen = static_cast<size_t>(nBytes);
+    return pMap;
+#else
+    (void)nBytes;
+    return NULL;
+#endif
+}
+
+void cFile::Unmap()
+{
+    mpData->Unmap();
+}
+
+///////////////////////////////////////////////////////////////////////////
+// MapShared -- Maps the start of the file into memory for reading and
+//      writing in place.  Returns null if that can't be done.
+///////////////////////////////////////////////////////////////////////////
+void* cFile::MapShared(File_t nBytes) //throw(eFile)
+{
+    ASSERT(mpData->mpCurrStream != NULL);
+    ASSERT(isWritable);
+
+    // the mapping has to see everything written so far, and writing it now is
+    // where a full disk shows up, rather than as a SIGBUS from the mapping later
+    if (fflush(mpData->mpCurrStream) != 0)
+        throw eFileWrite(mpData->mFileName, iFSServices::GetInstance()->GetErrString());
+
+    if (mpData->mpMap != NULL && mpData->mbMapShared && static_cast<File_t>(mpData->mMapLen) == nBytes)
+        return mpData->mpMap;
+
+    mpData->Unmap();
+
+#if SUPPORTS_MAPPED_DATABASE
+    if (nBytes <= 0 || static_cast<File_t>(static_cast<size_t>(nBytes)) != nBytes)
+        return NULL;
+
+    void* pMap = mmap(NULL, static_cast<size_t>(nBytes), PROT_READ | PROT_WRITE, MAP_SHARED, mpData->m_fd, 0);
+    if (pMap == MAP_FAILED)
+        return NULL;
+
+    mpData->mpMap       = pMap;
+    mpData->mMapLen     = static_cast<size_t>(nBytes);
+    mpData->mbMapShared = true;
+    return pMap;
+#else
+    return NULL;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////
+// SyncMap -- Writes back the changes made through MapShared()
+///////////////////////////////////////////////////////////////////////////
+bool cFile::SyncMap()
+{
+#if SUPPORTS_MAPPED_DATABASE
+    if (mpData->mpMap == NULL || !mpData->mbMapShared)
+        return true;
+
+    // MS_ASYNC is all it takes for read() to see the changes; there's no need
+    // to wait for them to reach the disk
+    return (msync(mpData->mpMap, mpData->mMapLen, MS_ASYNC) == 0);
+#else
+    return true;
+#endif
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -291,7 +441,7 @@ bool cFile::IsOpen(void) const
 cFile::File_t cFile::Seek(File_t offset, SeekFrom From) const //throw(eFile)
 {
     //Check to see if a file as been opened yet...
-    ASSERT(mpData->mpCurrStream != 0);
+    ASSERT(IsOpen());
 
     int apiFrom;
 
@@ -323,6 +473,14 @@ cFile::File_t cFile::Seek(File_t offset, SeekFrom From) const //throw(eFile)
     fprintf(stderr, "%d\n", blowupCount);
 #endif
 
+    if (mpData->mpCurrStream == NULL)
+    {
+        off_t ret = lseek(mpData->m_fd, offset, apiFrom);
+        if (ret == (off_t)-1)
+            throw eFileSeek();
+        return ret;
+    }
+
     if (fseeko(mpData->mpCurrStream, offset, apiFrom) != 0)
     {
 #ifdef DEBUG
@@ -344,7 +502,7 @@ cFile::File_t cFile::Read(void* buffer, File_t nBytes) const //throw(eFile)
     File_t iBytesRead;
 
     // Has a file been opened?
-    ASSERT(mpData->mpCurrStream != NULL);
+    ASSERT(IsOpen());
 
     // Is the nBytes parameter 0?  If so, return without touching buffer:
     if (nBytes == 0)
@@ -352,12 +510,32 @@ cFile::File_t cFile::Read(void* buffer, File_t nBytes) const //throw(eFile)
 
     if (mpData->mFlags & OPEN_DIRECT)
     {
+        // a short read means we're at the end; reading again from there
+        // would not be block aligned
         iBytesRead = read(mpData->m_fd, buffer, nBytes);
         if (iBytesRead < 0)
         {
             throw eFileRead(mpData->mFileName, iFSServices::GetInstance()->GetErrString());
         }
     }
+    else if (mpData->mpCurrStream == NULL)
+    {
+        // fill the buffer like fread() would
+        iBytesRead = 0;
+        while (iBytesRead < nBytes)
+        {
+            ssize_t cb = read(mpData->m_fd, static_cast<byte*>(buffer) + iBytesRead, nBytes - iBytesRead);
+            if (cb < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw eFileRead(mpData->mFileName, iFSServices::GetInstance()->GetErrString());
+            }
+            if (cb == 0)
+                break;
+            iBytesRead += cb;
+        }
+    }
     else
     {
         iBytesRead = fread(buffer, sizeof(byte), nBytes, mpData->mpCurrStream);
@@ -370,6 +548,84 @@ cFile::File_t cFile::Read(void* buffer, File_t nBytes) const //throw(eFile)
     return iBytesRead;
 }
 
+///////////////////////////////////////////////////////////////////////////
+// ReadAt -- Reads nBytes from offset into buffer with pread(), filling it
+//      unless the end of the file gets in the way.  Returns the number of
+//      bytes actually read.
+///////////////////////////////////////////////////////////////////////////
+cFile::File_t cFile::ReadAt(void* buffer, File_t nBytes, File_t offset) const //throw(eFile)
+{
+    File_t iBytesRead = 0;
+
+    ASSERT(IsOpen());
+
+    while (iBytesRead < nBytes)
+    {
+        ssize_t cb = pread(mpData->m_fd, static_cast<byte*>(buffer) + iBytesRead, nBytes - iBytesRead, offset + iBytesRead);
+        if (cb < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw eFileRead(mpData->mFileName, iFSServices::GetInstance()->GetErrString());
+        }
+        if (cb == 0)
+            break;
+        iBytesRead += cb;
+
+        // a short direct read means the end of the file; going on from there wouldn't be aligned
+        if (mpData->mFlags & OPEN_DIRECT)
+            break;
+    }
+
+    return iBytesRead;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// WillNeed -- Starts the start of the file on its way into the page cache
+///////////////////////////////////////////////////////////////////////////
+void cFile::WillNeed(File_t nBytes) const
+{
+    ASSERT(IsOpen());
+
+#if HAVE_POSIX_FADVISE
+    posix_fadvise(mpData->m_fd, 0, nBytes, POSIX_FADV_WILLNEED);
+    mpData->mbWillNeed = true;
+#else
+    (void)nBytes;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////
+// FindData -- Finds the next data in a sparse file with SEEK_DATA and
+//      SEEK_HOLE.  Anything that goes wrong, including the file system not
+//      knowing about holes, just means the rest of the file is read.
+///////////////////////////////////////////////////////////////////////////
+bool cFile::FindData(File_t offset, File_t& dataStart, File_t& dataEnd) const
+{
+    ASSERT(IsOpen());
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    off_t start = lseek(mpData->m_fd, offset, SEEK_DATA);
+    if (start < 0 && errno == ENXIO)
+        return false; // nothing but a hole from here to the end
+
+    if (start >= 0)
+    {
+        off_t end = lseek(mpData->m_fd, start, SEEK_HOLE);
+        if (end > start)
+        {
+            dataStart = start;
+            dataEnd   = end;
+            return true;
+        }
+    }
+#endif
+
+    dataStart = offset;
+    dataEnd   = GetSize();
+    return dataEnd > offset;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // Write -- Returns the actual number of bytes written to mpCurrStream
 //      Returns 0 if no file has been opened.
@@ -394,7 +650,10 @@ cFile::File_t cFile::Write(const void* buffer, File_t nBytes) //throw(eFile)
 ///////////////////////////////////////////////////////////////////////////
 cFile::File_t cFile::Tell() const
 {
-    ASSERT(mpData->mpCurrStream != 0);
+    ASSERT(IsOpen());
+
+    if (mpData->mpCurrStream == NULL)
+        return lseek(mpData->m_fd, 0, SEEK_CUR);
 
     return ftell(mpData->mpCurrStream);
 }
@@ -404,9 +663,13 @@ cFile::File_t cFile::Tell() const
 ///////////////////////////////////////////////////////////////////////////
 bool cFile::Flush() //throw(eFile)
 {
-    if (mpData->mpCurrStream == NULL)
+    if (!IsOpen())
         throw eFileFlush(mpData->mFileName, iFSServices::GetInstance()->GetErrString());
 
+    // nothing is buffered for a scanning read
+    if (mpData->mpCurrStream == NULL)
+        return true;
+
     return (fflush(mpData->mpCurrStream) == 0);
 }
 ///////////////////////////////////////////////////////////////////////////
@@ -416,7 +679,14 @@ bool cFile::Flush() //throw(eFile)
 ///////////////////////////////////////////////////////////////////////////
 void cFile::Rewind() const //throw(eFile)
 {
-    ASSERT(mpData->mpCurrStream != 0);
+    ASSERT(IsOpen());
+
+    if (mpData->mpCurrStream == NULL)
+    {
+        if (lseek(mpData->m_fd, 0, SEEK_SET) != 0)
+            throw(eFileRewind(mpData->mFileName, iFSServices::GetInstance()->GetErrString()));
+        return;
+    }
 
     rewind(mpData->mpCurrStream);
     if (ftell(mpData->mpCurrStream) != 0)
@@ -433,7 +703,7 @@ cFile::File_t cFile::GetSize() const
     File_t ret;
 
     //Has a file been opened? If not, return -1
-    if (mpData->mpCurrStream == NULL)
+    if (!IsOpen())
         return -1;
 
     ret = Seek(0, cFile::SEEK_EOF);
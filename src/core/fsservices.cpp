@@ -38,8 +38,58 @@
 #include <errno.h>
 #include "corestrings.h"
 
+#if SUPPORTS_DIR_FDS
+#include <unistd.h>
+#endif
+
 iFSServices* iFSServices::mpInstance = 0;
 
 //#############################################################################
 // eFSServices
 //#############################################################################
+
+//#############################################################################
+// cFSDirHandle
+//#############################################################################
+cFSDirHandle::cFSDirHandle(const TSTRING& strPath, int fd) : mPath(strPath), mFd(fd), mHolds(0)
+{
+}
+
+cFSDirHandle::~cFSDirHandle()
+{
+    Close();
+}
+
+TSTRING cFSDirHandle::GetPath(const TSTRING& strName) const
+{
+    if (strName.empty())
+        return mPath;
+
+    TSTRING strPath = mPath;
+    if (strPath.empty() || strPath[strPath.length() - 1] != _T('/'))
+        strPath += _T('/');
+    return strPath + strName;
+}
+
+void cFSDirHandle::Hold()
+{
+    AddRef();
+    mHolds++;
+}
+
+void cFSDirHandle::Unhold()
+{
+    ASSERT(mHolds > 0);
+    if (--mHolds == 0)
+        Close();
+    Release();
+}
+
+void cFSDirHandle::Close()
+{
+#if SUPPORTS_DIR_FDS
+    if (mFd >= 0)
+        close(mFd);
+#endif
+    mFd = -1;
+}
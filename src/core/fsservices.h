@@ -60,6 +60,9 @@
 #ifndef __FILEERROR_H
 #include "fileerror.h"
 #endif
+#ifndef __REFCOUNTOBJ_H
+#include "refcountobj.h"
+#endif
 
 //=========================================================================
 // STANDARD LIBRARY INCLUDES
@@ -139,6 +142,27 @@ struct cFSStatArgs
         TY_NAMED
     };
 
+    // the fields Stat() can be asked to fill out. dev, rdev and blksize always are,
+    // along with the file type.
+    enum Fields
+    {
+        FIELD_TYPE   = 0x0001,
+        FIELD_MODE   = 0x0002,
+        FIELD_NLINK  = 0x0004,
+        FIELD_UID    = 0x0008,
+        FIELD_GID    = 0x0010,
+        FIELD_ATIME  = 0x0020,
+        FIELD_MTIME  = 0x0040,
+        FIELD_CTIME  = 0x0080,
+        FIELD_INO    = 0x0100,
+        FIELD_SIZE   = 0x0200,
+        FIELD_BLOCKS = 0x0400,
+        FIELD_BTIME  = 0x0800,
+
+        FIELD_BASIC = 0x07ff, // everything but btime; what lstat() has always returned
+        FIELD_ALL   = 0x0fff
+    };
+
     // attr is fs dependent?
     uint64  dev;     // dep
     int64   ino;     // dep
@@ -151,6 +175,9 @@ struct cFSStatArgs
     cFSTime atime;   // indep
     cFSTime mtime;   // indep
     cFSTime ctime;   // indep
+    int32   mtimeNsec; // indep; the nanoseconds past mtime, 0 if the system doesn't say
+    int32   ctimeNsec; // indep; likewise for ctime
+    cFSTime btime;   // indep; only if mFields contains FIELD_BTIME
     int64   blksize; // indep
     int64   blocks;  // dep
     int64   fstype;  // dep
@@ -161,10 +188,57 @@ struct cFSStatArgs
     FileType mFileType; // redundant with other information in this struct, but
                         // broken out for convenience
 
+    uint32 mRequested; // the Fields that were asked for
+    uint32 mFields;    // the Fields that have values; the file system may not have some of
+                       // what was asked for
+
     //TODO: access control list should go here, too
     //std::list <cACLElem> mACL; // indep
 };
 
+// an open directory, so that the names in it can be looked up without walking
+//     the directory's whole path again each time. The descriptor stays open
+//     while the directory is held at least once; anything that just keeps a
+//     reference after the last Unhold() falls back to using full paths.
+//
+//     References and holds may only be taken and dropped on one thread. Other
+//     threads may use GetFd() while the directory is held on their behalf.
+class cFSDirHandle : public cRefCountObj
+{
+public:
+    cFSDirHandle(const TSTRING& strPath, int fd);
+
+    const TSTRING& GetPath() const;
+    TSTRING        GetPath(const TSTRING& strName) const;
+    // the first returns the directory's own path, the second the path of strName in it
+    int GetFd() const;
+    // the directory's descriptor, or -1 if it isn't open
+
+    void Hold();
+    void Unhold();
+    // Hold() also adds a reference, and Unhold() releases it
+
+protected:
+    virtual ~cFSDirHandle();
+
+private:
+    void Close();
+
+    TSTRING mPath;
+    int     mFd;
+    int     mHolds;
+};
+
+inline const TSTRING& cFSDirHandle::GetPath() const
+{
+    return mPath;
+}
+
+inline int cFSDirHandle::GetFd() const
+{
+    return mFd;
+}
+
 
 //=========================================================================
 //
@@ -245,8 +319,9 @@ public:
     ////////////////////////////////////////
     // major filesystem functions
     ////////////////////////////////////////
-    virtual void Stat(const TSTRING& strFileName, cFSStatArgs& pStat) const = 0;
-    // fills out the cFSStatArgs structure with the stat info for the named file
+    virtual void Stat(const TSTRING& strFileName, cFSStatArgs& pStat, uint32 fields = cFSStatArgs::FIELD_BASIC) const = 0;
+    // fills out the cFSStatArgs structure with the stat info for the named file. fields are
+    // the cFSStatArgs::Fields that are needed; where it makes a difference, only those are fetched.
     virtual void GetTempDirName(TSTRING& strName) const = 0;
     // makes directory if it doesn't exist already.  Dirname will end with a delimiter ( '/' )
 
@@ -282,6 +357,27 @@ public:
     virtual void GetCurrentDir(TSTRING& strCurDir) const = 0;
     // returns the current working directory
 
+    ////////////////////////////////////////
+    // open directory functions
+    ////////////////////////////////////////
+    virtual cFSDirHandle* OpenDir(const TSTRING& strName, const cFSDirHandle* pParent = 0) const = 0;
+    // opens the named directory, which is looked up in pParent if that is not null. The caller
+    // owns the return value, and has to Hold() it to keep it open. Throws eFSServices.
+    virtual void ReadDir(const cFSDirHandle& dir, std::vector<TSTRING>& vDirContents, const TSTRING& strName = _T("")) const = 0;
+    // like ReadDir() above, for dir itself or, if strName isn't empty, the directory strName in it. Only
+    // short names are returned.
+    virtual void ReadDir(const cFSDirHandle&                  dir,
+                         std::vector<TSTRING>&                vDirContents,
+                         std::vector<cFSStatArgs::FileType>&  vTypes,
+                         const TSTRING&                       strName = _T("")) const = 0;
+    // like ReadDir() above, and also puts the type of each entry into vTypes, where the directory
+    // itself records it. Entries whose type can only be found out with Stat() are TY_INVALID.
+    virtual void Stat(const cFSDirHandle& dir,
+                      const TSTRING&      strName,
+                      cFSStatArgs&        stat,
+                      uint32              fields = cFSStatArgs::FIELD_BASIC) const = 0;
+    // like Stat() above, for the name strName in dir
+
 
     ////////////////////////////////////////
     // file specific functions
@@ -302,6 +398,10 @@ public:
     //This defaults to true if not specified.
     virtual void SetResolveNames(bool resolve) = 0;
 
+    virtual void SetStatDontSync(bool dontSync) = 0;
+    // if true, Stat() may use whatever attributes are cached for a file on a network file
+    // system, rather than asking the server. Only has an effect where statx() is available.
+
     ////////////////////////////////////////
     // miscellaneous utility functions
     ////////////////////////////////////////
@@ -108,6 +108,7 @@ void haval_hash P_((haval_state *,
 void haval_end P_((haval_state *, uint8 *)); /* finalization */
 void haval_hash_block P_((haval_state *));       /* hash a 32-word block */
 static void haval_tailor P_((haval_state *));    /* folding the last output */
+static void haval_compress P_((haval_word *, const uint8 *)); /* hash 128 bytes */
 
 static uint8 padding[128] = {        /* constants for padding */
 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -170,8 +171,9 @@ static uint8 padding[128] = {        /* constants for padding */
  */
 
 #if PASS == 3
-# define Fphi_1(x6, x5, x4, x3, x2, x1, x0) \
-           f_1(x1, x0, x3, x5, x6, x2, x4)
+/* f_1(x1, x0, x3, x5, x6, x2, x4), with x0 (the word the last step wrote) last */
+# define Fphi_1(x6, x5, x4, x3, x2, x1, x0)                     \
+           ((x2) & ((x4) ^ (x3)) ^ (x5) & (x1) ^ (x4) ^ (x6) & (x0))
 #else
 # if PASS == 4
 #  define Fphi_1(x6, x5, x4, x3, x2, x1, x0) \
@@ -183,8 +185,11 @@ static uint8 padding[128] = {        /* constants for padding */
 #endif
 
 #if   PASS == 3
-# define Fphi_2(x6, x5, x4, x3, x2, x1, x0) \
-           f_2(x4, x2, x1, x0, x5, x3, x6)
+/* f_2(x4, x2, x1, x0, x5, x3, x6), likewise */
+# define Fphi_2(x6, x5, x4, x3, x2, x1, x0)                       \
+           ((x5) & ((x1) & (x2) ^ (x4) ^ (x6)) ^                    \
+            (x1) & ((x3) ^ (x2)) ^ (x6) ^                           \
+            ((x0) & (x2) | ~(x0) & (x3) & (x5)))
 #else
 # if PASS == 4
 #  define Fphi_2(x6, x5, x4, x3, x2, x1, x0) \
@@ -196,8 +201,10 @@ static uint8 padding[128] = {        /* constants for padding */
 #endif
 
 #if PASS == 3
-# define Fphi_3(x6, x5, x4, x3, x2, x1, x0) \
-           f_3(x6, x1, x2, x3, x4, x5, x0)
+/* f_3(x6, x1, x2, x3, x4, x5, x0), likewise */
+# define Fphi_3(x6, x5, x4, x3, x2, x1, x0)                       \
+           ((x3) & ((x5) & (x4) ^ (x6)) ^ (x5) & (x2) ^ (x4) & (x1) ^ \
+            (x0) & ~(x3))
 #else
 # if PASS == 4
 #  define Fphi_3(x6, x5, x4, x3, x2, x1, x0) \
@@ -246,22 +253,6 @@ static uint8 padding[128] = {        /* constants for padding */
       (x7) = rotate_right(temp, 7) + rotate_right((x7), 11) + (w) + (c);  \
       }
 
-/*
- * translate every four characters into a word.
- * assume the number of characters is a multiple of four.
- */
-#define ch2uint(string, word, slen) {      \
-  uint8 *sp = string;              \
-  haval_word    *wp = word;                \
-  while (sp < (string) + (slen)) {         \
-    *wp++ =  (haval_word)*sp            |  \
-            ((haval_word)*(sp+1) <<  8) |  \
-            ((haval_word)*(sp+2) << 16) |  \
-            ((haval_word)*(sp+3) << 24);   \
-    sp += 4;                               \
-  }                                        \
-}
-
 /* translate each word into four characters */
 #define uint2ch(word, string, wlen) {              \
   haval_word    *wp = word;                        \
@@ -370,42 +361,23 @@ void haval_hash (haval_state* state, uint8* str, int str_len)
   }
   state->count[1] += (haval_word)str_len >> 29;
 
-#if BYTEORDER == 0x1234
-
-  /* hash as many blocks as possible */
-  if (rmd_len + str_len >= 128) {
-    memcpy (((uint8 *)state->block)+rmd_len, str, fill_len);
-    haval_hash_block (state);
-    for (i = fill_len; i + 127 < str_len; i += 128){
-      memcpy ((uint8 *)state->block, str+i, 128);
-      haval_hash_block (state);
-    }
-    rmd_len = 0;
-  } else {
-    i = 0;
-  }
-  memcpy (((uint8 *)state->block)+rmd_len, str+i, str_len-i);
-
-#else
-
-  /* hash as many blocks as possible */
+  /*
+   * hash as many blocks as possible.  whole blocks are hashed straight
+   * from the caller's buffer; only a block that straddles two calls is
+   * put together in the remainder first.
+   */
   if (rmd_len + str_len >= 128) {
-    memcpy ((char*) &state->remainder[rmd_len], (char*) str, fill_len);
-    ch2uint(state->remainder, state->block, 128);
-    haval_hash_block (state);
-    for (i = fill_len; i + 127 < (unsigned int)str_len; i += 128){
-      memcpy ((char *) state->remainder, (char *) str+i, 128);
-      ch2uint(state->remainder, state->block, 128);
-      haval_hash_block (state);
+    memcpy (&state->remainder[rmd_len], str, fill_len);
+    haval_compress (state->fingerprint, state->remainder);
+    for (i = fill_len; i + 127 < (unsigned int)str_len; i += 128) {
+      haval_compress (state->fingerprint, str + i);
     }
     rmd_len = 0;
   } else {
     i = 0;
   }
   /* save the remaining input chars */
-  memcpy ((char *) &state->remainder[rmd_len], (char *) str+i, str_len-i);
-
-#endif
+  memcpy (&state->remainder[rmd_len], str+i, str_len-i);
 }
 
 /* finalization */
@@ -448,15 +420,39 @@ void haval_end (haval_state* state, uint8 final_fpt[FPTLEN >> 3])
 /* hash a 32-word block */
 void haval_hash_block (haval_state* state)
 {
-  register haval_word t0 = state->fingerprint[0],    /* make use of */
-                      t1 = state->fingerprint[1],    /* internal registers */
-                      t2 = state->fingerprint[2],
-                      t3 = state->fingerprint[3],
-                      t4 = state->fingerprint[4],
-                      t5 = state->fingerprint[5],
-                      t6 = state->fingerprint[6],
-                      t7 = state->fingerprint[7],
-                      *w = state->block;
+  uint8 block[128];
+
+  uint2ch (state->block, block, 32);
+  haval_compress (state->fingerprint, block);
+}
+
+/*
+ * hash 128 bytes of message into the fingerprint.  the message words are
+ * little-endian; on little-endian machines they're used as they are.
+ */
+static void haval_compress (haval_word* fingerprint, const uint8* block)
+{
+  haval_word w[32];
+
+#ifdef WORDS_BIGENDIAN
+  for (int i = 0; i < 32; i++) {
+    w[i] =  (haval_word)block[4*i]            |
+           ((haval_word)block[4*i+1] <<  8)   |
+           ((haval_word)block[4*i+2] << 16)   |
+           ((haval_word)block[4*i+3] << 24);
+  }
+#else
+  memcpy (w, block, sizeof(w));
+#endif
+
+  register haval_word t0 = fingerprint[0],    /* make use of */
+                      t1 = fingerprint[1],    /* internal registers */
+                      t2 = fingerprint[2],
+                      t3 = fingerprint[3],
+                      t4 = fingerprint[4],
+                      t5 = fingerprint[5],
+                      t6 = fingerprint[6],
+                      t7 = fingerprint[7];
 
   /* Pass 1 */
   FF_1(t7, t6, t5, t4, t3, t2, t1, t0, *(w   ));
@@ -647,14 +643,14 @@ void haval_hash_block (haval_state* state)
   FF_5(t0, t7, t6, t5, t4, t3, t2, t1, *(w+15), 0x409F60C4);
 #endif
 
-  state->fingerprint[0] += t0;
-  state->fingerprint[1] += t1;
-  state->fingerprint[2] += t2;
-  state->fingerprint[3] += t3;
-  state->fingerprint[4] += t4;
-  state->fingerprint[5] += t5;
-  state->fingerprint[6] += t6;
-  state->fingerprint[7] += t7;
+  fingerprint[0] += t0;
+  fingerprint[1] += t1;
+  fingerprint[2] += t2;
+  fingerprint[3] += t3;
+  fingerprint[4] += t4;
+  fingerprint[5] += t5;
+  fingerprint[6] += t6;
+  fingerprint[7] += t7;
 }
 
 /* tailor the last output */
@@ -54,6 +54,7 @@
  **********************************************************************/
 #include "stdcore.h"
 #include "md5.h"
+#include <string.h>
 
 /* forward declaration */
 static void Transform (uint32*, uint32*);
@@ -70,8 +71,10 @@ static uint8 PADDING[64] = {
 };
 
 /* F, G, H and I are basic MD5 functions */
-#define F(x, y, z) (((x) & (y)) | ((~x) & (z)))
-#define G(x, y, z) (((x) & (z)) | ((y) & (~z)))
+/* F and G are written with one operation fewer than in RFC 1321, which
+   doesn't change what they work out to */
+#define F(x, y, z) ((((y) ^ (z)) & (x)) ^ (z))
+#define G(x, y, z) ((((x) ^ (y)) & (z)) ^ (y))
 #define H(x, y, z) ((x) ^ (y) ^ (z))
 #define I(x, y, z) ((y) ^ ((x) | (~z)))
 
@@ -119,14 +122,28 @@ void MD5Init (MD5_CTX* mdContext)
   mdContext->buf[3] = (uint32)0x10325476;
 }
 
+/* Decode puts 64 bytes together into 16 little-endian words, a byte at a
+   time so it doesn't matter what order this machine keeps them in */
+static void Decode (uint32* out, const uint8* in)
+{
+  unsigned int i, ii;
+
+  for (i = 0, ii = 0; i < 16; i++, ii += 4)
+    out[i] = (((uint32)in[ii+3]) << 24) |
+             (((uint32)in[ii+2]) << 16) |
+             (((uint32)in[ii+1]) << 8) |
+             ((uint32)in[ii]);
+}
+
 /* The routine MD5Update updates the message-digest context to
    account for the presence of each of the characters inBuf[0..inLen-1]
-   in the message whose digest is being computed.  */
+   in the message whose digest is being computed.  Whole blocks are
+   hashed where they are; only the start of a block that isn't complete
+   yet is copied into mdContext->in, to wait for the rest of it. */
 void MD5Update (MD5_CTX* mdContext, uint8* inBuf, unsigned int inLen)
 {
   uint32 in[16];
   int mdi;
-  unsigned int i, ii;
 
   /* compute number of bytes mod 64 */
   mdi = (int)((mdContext->i[0] >> 3) & 0x3F);
@@ -143,21 +160,26 @@ void MD5Update (MD5_CTX* mdContext, uint8* inBuf, unsigned int inLen)
   mdContext->i[0] += ((uint32)inLen << 3);
   mdContext->i[1] += ((uint32)inLen >> 29);
 
-  while (inLen--) {
-    /* add new character to buffer, increment mdi */
-    mdContext->in[mdi++] = *inBuf++;
-
-    /* transform if necessary */
-    if (mdi == 0x40) {
-      for (i = 0, ii = 0; i < 16; i++, ii += 4)
-        in[i] = (((uint32)mdContext->in[ii+3]) << 24) |
-                (((uint32)mdContext->in[ii+2]) << 16) |
-                (((uint32)mdContext->in[ii+1]) << 8) |
-                ((uint32)mdContext->in[ii]);
-      Transform (mdContext->buf, in);
-      mdi = 0;
+  /* finish off a block left over from last time */
+  if (mdi) {
+    unsigned int fill = 0x40 - mdi;
+    if (inLen < fill) {
+      memcpy (mdContext->in + mdi, inBuf, inLen);
+      return;
     }
+    memcpy (mdContext->in + mdi, inBuf, fill);
+    Decode (in, mdContext->in);
+    Transform (mdContext->buf, in);
+    inBuf += fill;
+    inLen -= fill;
   }
+
+  for (; inLen >= 0x40; inLen -= 0x40, inBuf += 0x40) {
+    Decode (in, inBuf);
+    Transform (mdContext->buf, in);
+  }
+
+  memcpy (mdContext->in, inBuf, inLen);
 }
 
 /* The routine MD5Final terminates the message-digest computation and
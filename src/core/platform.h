@@ -319,6 +319,7 @@
 // TODO:mdb -- this is not complete or rigorous on the unix side!!!
 #    define SUPPORTS_WIN32_THREADS IS_WIN32
 #    define SUPPORTS_POSIX_THREADS (!SUPPORTS_WIN32_THREADS)
+#    define SUPPORTS_WORKER_THREADS (SUPPORTS_POSIX_THREADS && HAVE_PTHREAD_H)
 
 // Miscellaneous
 #    define WCHAR_IS_16_BITS IS_WIN32
@@ -343,6 +344,17 @@
 #    define SUPPORTS_DIRECT_IO (IS_LINUX)
 // Linux is the only platform where direct i/o hashing has been tested & works properly so far.
 
+#    define SUPPORTS_DIR_FDS (HAVE_OPENAT && HAVE_FSTATAT && HAVE_READLINKAT && HAVE_FDOPENDIR && !USES_DEVICE_PATH)
+// Names in a directory being scanned are looked up relative to a descriptor for it, rather than by full path.
+
+#    define SUPPORTS_MAPPED_HASHING (HAVE_MMAP && SUPPORTS_POSIX_SIGNALS && !USES_DEVICE_PATH)
+// Large files can be hashed straight out of a read-only mapping; a SIGBUS from a file that
+// shrinks while mapped is caught and turned into a read error.
+
+#    define SUPPORTS_MAPPED_DATABASE (HAVE_MMAP && !USES_DEVICE_PATH)
+// The database's working file is mapped shared and changed in place, rather than being read
+// and written a block at a time through cBlockFile's own cache.
+
 #    define SUPPORTS_TERMIOS (!IS_RTEMS && !IS_REDOX)
 // RTEMS errors are probably just a buildsys issue & this will change or go away.
 // Redox will probably implement this in the future.
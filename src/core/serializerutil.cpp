@@ -39,21 +39,23 @@ namespace
 {
 template<class FROM, class TO> int64 CopyImpl(TO* pTo, FROM* pFrom, int64 amt)
 {
+    // databases get copied through here, so this goes a megabyte at a time; the
+    // buffer is on the heap and never bigger than what is being copied
     enum
     {
-        BUF_SIZE = 8192
+        BUF_SIZE = 1024 * 1024
     };
-    int8  buf[BUF_SIZE];
-    int64 amtLeft = amt;
+    std::vector<int8> buf((size_t)std::min<int64>(std::max<int64>(amt, 1), BUF_SIZE));
+    int64             amtLeft = amt;
 
     while (amtLeft > 0)
     {
         // NOTE: We use int's here rather than int64 because iSerializer and cArchive
         // only take int's as their size parameter - dmb
-        int amtToRead = amtLeft > BUF_SIZE ? BUF_SIZE : (int)amtLeft;
-        int amtRead   = pFrom->ReadBlob(buf, amtToRead);
+        int amtToRead = amtLeft > (int64)buf.size() ? (int)buf.size() : (int)amtLeft;
+        int amtRead   = pFrom->ReadBlob(&buf[0], amtToRead);
         amtLeft -= amtRead;
-        pTo->WriteBlob(buf, amtRead);
+        pTo->WriteBlob(&buf[0], amtRead);
         if (amtRead < amtToRead)
             break;
     }
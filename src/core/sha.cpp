@@ -71,6 +71,14 @@
 
 #include "sha.h"
 
+#if HAVE_GCC && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#   define SHS_USES_SHANI 1
+#   include <cpuid.h>
+#   include <immintrin.h>
+#else
+#   define SHS_USES_SHANI 0
+#endif
+
 /* The SHS f()-functions */
 
 #define f1(x,y,z)   ( ( x & y ) | ( ~x & z ) )              /* Rounds  0-19 */
@@ -97,19 +105,39 @@
 
 #define S(n,X)  ( ( X << n ) | ( X >> ( 32 - n ) ) )
 
-/* The initial expanding function */
+/* Initialize the SHS values */
+
+void shsInit(SHS_INFO* shsInfo)
+{
+    /* Set the h-vars to their initial values */
+    shsInfo->digest[ 0 ] = h0init;
+    shsInfo->digest[ 1 ] = h1init;
+    shsInfo->digest[ 2 ] = h2init;
+    shsInfo->digest[ 3 ] = h3init;
+    shsInfo->digest[ 4 ] = h4init;
+
+    /* Initialise bit count */
+    shsInfo->countLo = shsInfo->countHi = 0L;
+    }
+
+/* Perform the SHS transformation on nBlocks 64-byte blocks, straight out of
+   the caller's buffer.  The work registers are locals, not globals as they
+   once were, so several threads can hash at once.  The words are put
+   together a byte at a time, so this works whatever the byte order, and
+   the expansion only keeps the last 16 words around. */
 
 #ifdef NEW_SHA
-#define expand(count)   temp = W[ count - 3 ] ^ W[ count - 8 ] ^ W[ count - 14 ] ^ W[ count - 16 ];W[ count ] = S(1, temp)
+#define expand(count)   ( x = W[ ( count - 3 ) & 15 ] ^ W[ ( count - 8 ) & 15 ] ^ \
+                              W[ ( count - 14 ) & 15 ] ^ W[ count & 15 ], \
+                          W[ count & 15 ] = S( 1, x ) )
 #else
-#define expand(count)   W[ count ] = W[ count - 3 ] ^ W[ count - 8 ] ^ W[ count - 14 ] ^ W[ count - 16 ]
+#define expand(count)   ( W[ count & 15 ] ^= W[ ( count - 3 ) & 15 ] ^ W[ ( count - 8 ) & 15 ] ^ \
+                                             W[ ( count - 14 ) & 15 ] )
 #endif
 
-/* The four SHS sub-rounds */
-
-#define subRound1(count)    \
+#define subRound(f, k, w)   \
     { \
-    temp = S( 5, A ) + f1( B, C, D ) + E + W[ count ] + K1; \
+    temp = S( 5, A ) + f( B, C, D ) + E + ( w ) + k; \
     E = D; \
     D = C; \
     C = S( 30, B ); \
@@ -117,213 +145,222 @@
     A = temp; \
     }
 
-#define subRound2(count)    \
-    { \
-    temp = S( 5, A ) + f2( B, C, D ) + E + W[ count ] + K2; \
-    E = D; \
-    D = C; \
-    C = S( 30, B ); \
-    B = A; \
-    A = temp; \
-    }
+static void shsTransformGeneric(uint32* digest, const uint8* buffer, int nBlocks)
+{
+    uint32 W[ 16 ], temp, x;
+    uint32 A, B, C, D, E;
+    int i;
 
-#define subRound3(count)    \
-    { \
-    temp = S( 5, A ) + f3( B, C, D ) + E + W[ count ] + K3; \
-    E = D; \
-    D = C; \
-    C = S( 30, B ); \
-    B = A; \
-    A = temp; \
+    for( ; nBlocks > 0; nBlocks--, buffer += SHS_BLOCKSIZE )
+    {
+    for( i = 0; i < 16; i++ )
+        W[ i ] = ( ( uint32 ) buffer[ 4 * i ] << 24 ) | ( ( uint32 ) buffer[ 4 * i + 1 ] << 16 ) |
+                 ( ( uint32 ) buffer[ 4 * i + 2 ] << 8 ) | ( uint32 ) buffer[ 4 * i + 3 ];
+
+    A = digest[ 0 ];
+    B = digest[ 1 ];
+    C = digest[ 2 ];
+    D = digest[ 3 ];
+    E = digest[ 4 ];
+
+    for( i = 0; i < 16; i++ )
+        subRound( f1, K1, W[ i ] );
+    for( ; i < 20; i++ )
+        subRound( f1, K1, expand( i ) );
+    for( ; i < 40; i++ )
+        subRound( f2, K2, expand( i ) );
+    for( ; i < 60; i++ )
+        subRound( f3, K3, expand( i ) );
+    for( ; i < 80; i++ )
+        subRound( f4, K4, expand( i ) );
+
+    digest[ 0 ] += A;
+    digest[ 1 ] += B;
+    digest[ 2 ] += C;
+    digest[ 3 ] += D;
+    digest[ 4 ] += E;
     }
+}
+
+#if SHS_USES_SHANI
+/* The same, using the SHA extensions.  Each sha1rnds4 does four rounds; the
+   schedule for each group of four words j >= 4 comes from the four groups
+   before it, which are kept in m[ j % 4 ] .. m[ ( j + 3 ) % 4 ].  A and the
+   message words go in the high lanes, hence the shuffles. */
+
+__attribute__(( target( "sha,sse4.1" ) ))
+static void shsTransformSHANI(uint32* digest, const uint8* buffer, int nBlocks)
+{
+    const __m128i byteSwap = _mm_set_epi64x( 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL );
+    __m128i abcd = _mm_shuffle_epi32( _mm_loadu_si128( ( const __m128i* ) digest ), 0x1B );
+    __m128i e0   = _mm_set_epi32( ( int ) digest[ 4 ], 0, 0, 0 );
+
+    for( ; nBlocks > 0; nBlocks--, buffer += SHS_BLOCKSIZE )
+    {
+    __m128i abcdSave = abcd, e0Save = e0, eNext, e;
+    __m128i m[ 4 ];
 
-#define subRound4(count)    \
+    m[ 0 ] = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* ) ( buffer ) ), byteSwap );
+    m[ 1 ] = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* ) ( buffer + 16 ) ), byteSwap );
+    m[ 2 ] = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* ) ( buffer + 32 ) ), byteSwap );
+    m[ 3 ] = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* ) ( buffer + 48 ) ), byteSwap );
+
+#define shaniRounds(j, f) \
     { \
-    temp = S( 5, A ) + f4( B, C, D ) + E + W[ count ] + K4; \
-    E = D; \
-    D = C; \
-    C = S( 30, B ); \
-    B = A; \
-    A = temp; \
+    if( j >= 4 ) \
+        m[ j % 4 ] = _mm_sha1msg2_epu32( _mm_xor_si128( _mm_sha1msg1_epu32( m[ j % 4 ], m[ ( j + 1 ) % 4 ] ), \
+                                                        m[ ( j + 2 ) % 4 ] ), m[ ( j + 3 ) % 4 ] ); \
+    e = ( j == 0 ) ? _mm_add_epi32( e0, m[ 0 ] ) : _mm_sha1nexte_epu32( eNext, m[ j % 4 ] ); \
+    eNext = abcd; \
+    abcd = _mm_sha1rnds4_epu32( abcd, e, f ); \
     }
 
-/* The two buffers of 5 32-bit words */
+    shaniRounds( 0, 0 );  shaniRounds( 1, 0 );  shaniRounds( 2, 0 );  shaniRounds( 3, 0 );  shaniRounds( 4, 0 );
+    shaniRounds( 5, 1 );  shaniRounds( 6, 1 );  shaniRounds( 7, 1 );  shaniRounds( 8, 1 );  shaniRounds( 9, 1 );
+    shaniRounds( 10, 2 ); shaniRounds( 11, 2 ); shaniRounds( 12, 2 ); shaniRounds( 13, 2 ); shaniRounds( 14, 2 );
+    shaniRounds( 15, 3 ); shaniRounds( 16, 3 ); shaniRounds( 17, 3 ); shaniRounds( 18, 3 ); shaniRounds( 19, 3 );
 
-uint32 h0, h1, h2, h3, h4;
-uint32 A, B, C, D, E;
+#undef shaniRounds
 
-/* Initialize the SHS values */
+    e0   = _mm_sha1nexte_epu32( eNext, e0Save );
+    abcd = _mm_add_epi32( abcd, abcdSave );
+    }
 
-void shsInit(SHS_INFO* shsInfo)
+    _mm_storeu_si128( ( __m128i* ) digest, _mm_shuffle_epi32( abcd, 0x1B ) );
+    digest[ 4 ] = ( uint32 ) _mm_extract_epi32( e0, 3 );
+}
+
+static bool shsHaveSHANI()
 {
-    /* Set the h-vars to their initial values */
-    shsInfo->digest[ 0 ] = h0init;
-    shsInfo->digest[ 1 ] = h1init;
-    shsInfo->digest[ 2 ] = h2init;
-    shsInfo->digest[ 3 ] = h3init;
-    shsInfo->digest[ 4 ] = h4init;
+    unsigned int eax, ebx, ecx, edx;
 
-    /* Initialise bit count */
-    shsInfo->countLo = shsInfo->countHi = 0L;
-    }
+    if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) || !( ecx & bit_SSE4_1 ) || !( ecx & bit_SSSE3 ) )
+        return false;
+    if( __get_cpuid_max( 0, 0 ) < 7 )
+        return false;
+    __cpuid_count( 7, 0, eax, ebx, ecx, edx );
+    return ( ebx & ( 1 << 29 ) ) != 0; /* SHA */
+}
+#endif /* SHS_USES_SHANI */
+
+/* The transformation this cpu is best at, picked the first time it's needed
+   unless shsSetKernel has been called */
 
-/* Perform the SHS transformation.  Note that this code, like MD5, seems to
-   break some optimizing compilers - it may be necessary to split it into
-   sections, eg based on the four subrounds */
+static int s_kernel = -1;
 
-void shsTransform(SHS_INFO *shsInfo)
+static int shsBestKernel()
 {
-    uint32 W[ 80 ], temp;
-    int i;
+#if SHS_USES_SHANI
+    static const bool bHaveSHANI = shsHaveSHANI();
+    if( bHaveSHANI )
+        return SHS_KERNEL_SHANI;
+#endif
+    return SHS_KERNEL_GENERIC;
+}
 
-    /* Step A.  Copy the data buffer into the local work buffer */
-    for( i = 0; i < 16; i++ )
-    W[ i ] = shsInfo->data[ i ];
-
-    /* Step B.  Expand the 16 words into 64 temporary data words */
-    expand( 16 ); expand( 17 ); expand( 18 ); expand( 19 ); expand( 20 );
-    expand( 21 ); expand( 22 ); expand( 23 ); expand( 24 ); expand( 25 );
-    expand( 26 ); expand( 27 ); expand( 28 ); expand( 29 ); expand( 30 );
-    expand( 31 ); expand( 32 ); expand( 33 ); expand( 34 ); expand( 35 );
-    expand( 36 ); expand( 37 ); expand( 38 ); expand( 39 ); expand( 40 );
-    expand( 41 ); expand( 42 ); expand( 43 ); expand( 44 ); expand( 45 );
-    expand( 46 ); expand( 47 ); expand( 48 ); expand( 49 ); expand( 50 );
-    expand( 51 ); expand( 52 ); expand( 53 ); expand( 54 ); expand( 55 );
-    expand( 56 ); expand( 57 ); expand( 58 ); expand( 59 ); expand( 60 );
-    expand( 61 ); expand( 62 ); expand( 63 ); expand( 64 ); expand( 65 );
-    expand( 66 ); expand( 67 ); expand( 68 ); expand( 69 ); expand( 70 );
-    expand( 71 ); expand( 72 ); expand( 73 ); expand( 74 ); expand( 75 );
-    expand( 76 ); expand( 77 ); expand( 78 ); expand( 79 );
-
-    /* Step C.  Set up first buffer */
-    A = shsInfo->digest[ 0 ];
-    B = shsInfo->digest[ 1 ];
-    C = shsInfo->digest[ 2 ];
-    D = shsInfo->digest[ 3 ];
-    E = shsInfo->digest[ 4 ];
-
-    /* Step D.  Serious mangling, divided into four sub-rounds */
-    subRound1( 0 ); subRound1( 1 ); subRound1( 2 ); subRound1( 3 );
-    subRound1( 4 ); subRound1( 5 ); subRound1( 6 ); subRound1( 7 );
-    subRound1( 8 ); subRound1( 9 ); subRound1( 10 ); subRound1( 11 );
-    subRound1( 12 ); subRound1( 13 ); subRound1( 14 ); subRound1( 15 );
-    subRound1( 16 ); subRound1( 17 ); subRound1( 18 ); subRound1( 19 );
-    subRound2( 20 ); subRound2( 21 ); subRound2( 22 ); subRound2( 23 );
-    subRound2( 24 ); subRound2( 25 ); subRound2( 26 ); subRound2( 27 );
-    subRound2( 28 ); subRound2( 29 ); subRound2( 30 ); subRound2( 31 );
-    subRound2( 32 ); subRound2( 33 ); subRound2( 34 ); subRound2( 35 );
-    subRound2( 36 ); subRound2( 37 ); subRound2( 38 ); subRound2( 39 );
-    subRound3( 40 ); subRound3( 41 ); subRound3( 42 ); subRound3( 43 );
-    subRound3( 44 ); subRound3( 45 ); subRound3( 46 ); subRound3( 47 );
-    subRound3( 48 ); subRound3( 49 ); subRound3( 50 ); subRound3( 51 );
-    subRound3( 52 ); subRound3( 53 ); subRound3( 54 ); subRound3( 55 );
-    subRound3( 56 ); subRound3( 57 ); subRound3( 58 ); subRound3( 59 );
-    subRound4( 60 ); subRound4( 61 ); subRound4( 62 ); subRound4( 63 );
-    subRound4( 64 ); subRound4( 65 ); subRound4( 66 ); subRound4( 67 );
-    subRound4( 68 ); subRound4( 69 ); subRound4( 70 ); subRound4( 71 );
-    subRound4( 72 ); subRound4( 73 ); subRound4( 74 ); subRound4( 75 );
-    subRound4( 76 ); subRound4( 77 ); subRound4( 78 ); subRound4( 79 );
-
-    /* Step E.  Build message digest */
-    shsInfo->digest[ 0 ] += A;
-    shsInfo->digest[ 1 ] += B;
-    shsInfo->digest[ 2 ] += C;
-    shsInfo->digest[ 3 ] += D;
-    shsInfo->digest[ 4 ] += E;
+static void shsTransform(uint32* digest, const uint8* buffer, int nBlocks)
+{
+#if SHS_USES_SHANI
+    if( ( s_kernel < 0 ? shsBestKernel() : s_kernel ) == SHS_KERNEL_SHANI )
+    {
+        shsTransformSHANI( digest, buffer, nBlocks );
+        return;
     }
+#endif
+    shsTransformGeneric( digest, buffer, nBlocks );
+}
 
-#ifndef WORDS_BIGENDIAN
+bool shsSetKernel(SHS_KERNEL kernel)
+{
+    if( kernel < 0 || kernel >= SHS_KERNEL_NUMITEMS )
+        return false;
+    if( kernel == SHS_KERNEL_SHANI && shsBestKernel() != SHS_KERNEL_SHANI )
+        return false;
 
-/* When run on a little-endian CPU we need to perform byte reversal on an
-   array of longwords.  It is possible to make the code endianness-
-   independant by fiddling around with data at the byte level, but this
-   makes for very slow code, so we rely on the user to sort out endianness
-   at compile time */
+    s_kernel = kernel;
+    return true;
+}
 
-static void byteReverse(uint32* buffer, int byteCount)
-    {
-    uint32 value;
-    int count;
+SHS_KERNEL shsGetKernel()
+{
+    return ( SHS_KERNEL ) ( s_kernel < 0 ? shsBestKernel() : s_kernel );
+}
 
-    byteCount /= sizeof( uint32 );
-    for( count = 0; count < byteCount; count++ )
+const char* shsKernelName(SHS_KERNEL kernel)
+{
+    switch( kernel )
     {
-    value = ( buffer[ count ] << 16 ) | ( buffer[ count ] >> 16 );
-    buffer[ count ] = ( ( value & 0xFF00FF00L ) >> 8 ) | ( ( value & 0x00FF00FFL ) << 8 );
-    }
+    case SHS_KERNEL_GENERIC: return "generic";
+    case SHS_KERNEL_SHANI:   return "sha-ni";
+    default:                 return "unknown";
     }
-#endif /* #ifndef WORDS_BIGENDIAN */
+}
 
-/* Update SHS for a block of data.  This code assumes that the buffer size
-   is a multiple of SHS_BLOCKSIZE bytes long, which makes the code a lot
-   more efficient since it does away with the need to handle partial blocks
-   between calls to shsUpdate() */
+/* Update SHS for a block of data.  Whole blocks are hashed where they are;
+   shsInfo->data holds on to the start of a block that isn't complete yet,
+   as raw bytes, until the rest of it turns up. */
 
 void shsUpdate(SHS_INFO* shsInfo, uint8* buffer, int count)
     {
+    uint8* pending = ( uint8 * ) shsInfo->data;
+    int    used    = ( int ) ( ( shsInfo->countLo >> 3 ) & 0x3F );
+
     /* Update bitcount */
     if( ( shsInfo->countLo + ( ( uint32 ) count << 3 ) ) < shsInfo->countLo )
     shsInfo->countHi++; /* Carry from low to high bitCount */
     shsInfo->countLo += ( ( uint32 ) count << 3 );
     shsInfo->countHi += ( ( uint32 ) count >> 29 );
 
+    /* Finish off a block left over from last time */
+    if( used )
+    {
+    int fill = SHS_BLOCKSIZE - used;
+    if( count < fill )
+    {
+        memcpy( pending + used, buffer, count );
+        return;
+    }
+    memcpy( pending + used, buffer, fill );
+    shsTransform( shsInfo->digest, pending, 1 );
+    buffer += fill;
+    count -= fill;
+    }
+
     /* Process data in SHS_BLOCKSIZE chunks */
-    while( count >= SHS_BLOCKSIZE )
+    if( count >= SHS_BLOCKSIZE )
     {
-    memcpy( (char *) shsInfo->data, (char *) buffer, SHS_BLOCKSIZE );
-#ifndef WORDS_BIGENDIAN
-    byteReverse( shsInfo->data, SHS_BLOCKSIZE );
-#endif /* #ifndef WORDS_BIGENDIAN */
-    shsTransform( shsInfo );
-    buffer += SHS_BLOCKSIZE;
-    count -= SHS_BLOCKSIZE;
+    shsTransform( shsInfo->digest, buffer, count / SHS_BLOCKSIZE );
+    buffer += count & ~( SHS_BLOCKSIZE - 1 );
+    count &= SHS_BLOCKSIZE - 1;
     }
 
-    /* Handle any remaining bytes of data.  This should only happen once
-       on the final lot of data */
-    memcpy( (char *) shsInfo->data, (char *) buffer, count );
+    /* Hold on to what's left */
+    memcpy( pending, buffer, count );
     }
 
 void shsFinal(SHS_INFO *shsInfo)
 {
-    int count;
+    uint8 padding[ 2 * SHS_BLOCKSIZE ];
     uint32 lowBitcount = shsInfo->countLo, highBitcount = shsInfo->countHi;
+    int count, padLen, i;
 
     /* Compute number of bytes mod 64 */
     count = ( int ) ( ( shsInfo->countLo >> 3 ) & 0x3F );
 
-    /* Set the first char of padding to 0x80.  This is safe since there is
-       always at least one byte free */
-    ( ( uint8 * ) shsInfo->data )[ count++ ] = 0x80;
+    /* Copy what's left, add a 0x80 and pad out to 56 mod 64 */
+    memcpy( padding, shsInfo->data, count );
+    padding[ count++ ] = 0x80;
+    padLen = ( count > 56 ) ? 2 * SHS_BLOCKSIZE : SHS_BLOCKSIZE;
+    memset( padding + count, 0, padLen - count );
 
-    /* Pad out to 56 mod 64 */
-    if( count > 56 )
+    /* Append length in bits, most significant byte first, and transform */
+    for( i = 0; i < 4; i++ )
     {
-    /* Two lots of padding:  Pad the first block to 64 bytes */
-    memset( ( char * ) shsInfo->data + count, 0, 64 - count );
-#ifndef WORDS_BIGENDIAN
-    byteReverse( shsInfo->data, SHS_BLOCKSIZE );
-#endif /* #ifndef WORDS_BIGENDIAN */
-    shsTransform( shsInfo );
-
-    /* Now fill the next block with 56 bytes */
-    memset( (char *) shsInfo->data, 0, 56 );
+    padding[ padLen - 8 + i ] = ( uint8 ) ( highBitcount >> ( 24 - 8 * i ) );
+    padding[ padLen - 4 + i ] = ( uint8 ) ( lowBitcount >> ( 24 - 8 * i ) );
     }
-    else
-    /* Pad block to 56 bytes */
-    memset( ( char * ) shsInfo->data + count, 0, 56 - count );
-#ifndef WORDS_BIGENDIAN 
-    byteReverse( shsInfo->data, SHS_BLOCKSIZE );
-#endif /* #ifndef WORDS_BIGENDIAN */
-
-    /* Append length in bits and transform */
-    shsInfo->data[ 14 ] = highBitcount;
-    shsInfo->data[ 15 ] = lowBitcount;
-
-    shsTransform( shsInfo );
-#ifndef WORDS_BIGENDIAN 
-    byteReverse( shsInfo->data, SHS_DIGESTSIZE );
-#endif /* #ifndef WORDS_BIGENDIAN */
+
+    shsTransform( shsInfo->digest, padding, padLen / SHS_BLOCKSIZE );
     }
 
 #ifdef TEST
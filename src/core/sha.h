@@ -58,6 +58,18 @@ void shsInit(SHS_INFO *shsInfo);
 void shsUpdate(SHS_INFO* shsInfo, uint8* buffer, int count);
 void shsFinal(SHS_INFO* shsInfo);
 
+/* The ways the SHS transformation can be done; they all give the same
+   answer.  The fastest one this cpu can run is used unless told otherwise. */
+typedef enum {
+           SHS_KERNEL_GENERIC,            /* portable C */
+           SHS_KERNEL_SHANI,              /* x86 SHA extensions */
+           SHS_KERNEL_NUMITEMS
+           } SHS_KERNEL;
+
+bool        shsSetKernel(SHS_KERNEL kernel); /* false if this cpu can't run it */
+SHS_KERNEL  shsGetKernel();
+const char* shsKernelName(SHS_KERNEL kernel);
+
 /* The next def turns on the change to the algorithm introduced by NIST at
  * the behest of the NSA.  It supposedly corrects a weakness in the original
  * formulation.  Bruce Schneier described it thus in a posting to the
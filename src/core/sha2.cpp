@@ -0,0 +1,465 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// sha2.cpp -- the built in SHA-256 and SHA-512 (FIPS 180-4)
+//
+// Only built when there's no OpenSSL; see fco/signature.h.  SHA-256 has a
+// second transformation that uses the x86 SHA extensions, picked at run
+// time the same way the built in SHA-1 picks its own.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "stdcore.h"
+#include <string.h>
+#include "sha2.h"
+
+#if HAVE_GCC && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#    define SHA256_USES_SHANI 1
+#    include <cpuid.h>
+#    include <immintrin.h>
+#else
+#    define SHA256_USES_SHANI 0
+#endif
+
+#define ROR32(x, n) ( ( ( x ) >> ( n ) ) | ( ( x ) << ( 32 - ( n ) ) ) )
+#define ROR64(x, n) ( ( ( x ) >> ( n ) ) | ( ( x ) << ( 64 - ( n ) ) ) )
+
+#define CH(x, y, z)  ( ( z ) ^ ( ( x ) & ( ( y ) ^ ( z ) ) ) )
+#define MAJ(x, y, z) ( ( ( x ) & ( y ) ) | ( ( z ) & ( ( x ) | ( y ) ) ) )
+
+static const uint32 K256[ 64 ] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint64 K512[ 80 ] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static inline uint32 load32be(const uint8* p)
+{
+    return ( ( uint32 ) p[ 0 ] << 24 ) | ( ( uint32 ) p[ 1 ] << 16 ) | ( ( uint32 ) p[ 2 ] << 8 ) | p[ 3 ];
+}
+
+static inline uint64 load64be(const uint8* p)
+{
+    return ( ( uint64 ) load32be( p ) << 32 ) | load32be( p + 4 );
+}
+
+static inline void store64be(uint8* p, uint64 x)
+{
+    for( int i = 0; i < 8; i++ )
+        p[ i ] = ( uint8 ) ( x >> ( 56 - 8 * i ) );
+}
+
+/* The message schedule only keeps the last 16 words around; W[ i & 15 ]
+   is overwritten with word i once i is past the first block's worth. */
+
+#define SCHED256(i) \
+    ( W[ ( i ) & 15 ] += ( ROR32( W[ ( ( i ) - 2 ) & 15 ], 17 ) ^ ROR32( W[ ( ( i ) - 2 ) & 15 ], 19 ) ^ ( W[ ( ( i ) - 2 ) & 15 ] >> 10 ) ) + \
+                         W[ ( ( i ) - 7 ) & 15 ] + \
+                         ( ROR32( W[ ( ( i ) - 15 ) & 15 ], 7 ) ^ ROR32( W[ ( ( i ) - 15 ) & 15 ], 18 ) ^ ( W[ ( ( i ) - 15 ) & 15 ] >> 3 ) ) )
+
+#define ROUND256(a, b, c, d, e, f, g, h, i, w) \
+    { \
+    uint32 t1 = h + ( ROR32( e, 6 ) ^ ROR32( e, 11 ) ^ ROR32( e, 25 ) ) + CH( e, f, g ) + K256[ i ] + ( w ); \
+    d += t1; \
+    h = t1 + ( ROR32( a, 2 ) ^ ROR32( a, 13 ) ^ ROR32( a, 22 ) ) + MAJ( a, b, c ); \
+    }
+
+static void sha256TransformGeneric(uint32* state, const uint8* buffer, int nBlocks)
+{
+    for( ; nBlocks > 0; nBlocks--, buffer += SHA256_BLOCKSIZE )
+    {
+        uint32 W[ 16 ];
+        uint32 a = state[ 0 ], b = state[ 1 ], c = state[ 2 ], d = state[ 3 ];
+        uint32 e = state[ 4 ], f = state[ 5 ], g = state[ 6 ], h = state[ 7 ];
+        int    i;
+
+        for( i = 0; i < 16; i++ )
+            W[ i ] = load32be( buffer + 4 * i );
+
+        for( i = 0; i < 64; i += 8 )
+        {
+            if( i < 16 )
+            {
+                ROUND256( a, b, c, d, e, f, g, h, i + 0, W[ i + 0 ] );
+                ROUND256( h, a, b, c, d, e, f, g, i + 1, W[ i + 1 ] );
+                ROUND256( g, h, a, b, c, d, e, f, i + 2, W[ i + 2 ] );
+                ROUND256( f, g, h, a, b, c, d, e, i + 3, W[ i + 3 ] );
+                ROUND256( e, f, g, h, a, b, c, d, i + 4, W[ i + 4 ] );
+                ROUND256( d, e, f, g, h, a, b, c, i + 5, W[ i + 5 ] );
+                ROUND256( c, d, e, f, g, h, a, b, i + 6, W[ i + 6 ] );
+                ROUND256( b, c, d, e, f, g, h, a, i + 7, W[ i + 7 ] );
+            }
+            else
+            {
+                ROUND256( a, b, c, d, e, f, g, h, i + 0, SCHED256( i + 0 ) );
+                ROUND256( h, a, b, c, d, e, f, g, i + 1, SCHED256( i + 1 ) );
+                ROUND256( g, h, a, b, c, d, e, f, i + 2, SCHED256( i + 2 ) );
+                ROUND256( f, g, h, a, b, c, d, e, i + 3, SCHED256( i + 3 ) );
+                ROUND256( e, f, g, h, a, b, c, d, i + 4, SCHED256( i + 4 ) );
+                ROUND256( d, e, f, g, h, a, b, c, i + 5, SCHED256( i + 5 ) );
+                ROUND256( c, d, e, f, g, h, a, b, i + 6, SCHED256( i + 6 ) );
+                ROUND256( b, c, d, e, f, g, h, a, i + 7, SCHED256( i + 7 ) );
+            }
+        }
+
+        state[ 0 ] += a; state[ 1 ] += b; state[ 2 ] += c; state[ 3 ] += d;
+        state[ 4 ] += e; state[ 5 ] += f; state[ 6 ] += g; state[ 7 ] += h;
+    }
+}
+
+#if SHA256_USES_SHANI
+/* The same, using the SHA extensions.  The state is kept as ABEF and CDGH,
+   the way sha256rnds2 wants it, and each sha256rnds2 does two rounds.  For
+   each group of four rounds j, m[ j % 4 ] holds the message words; the
+   words for group j + 1 are finished off from groups j - 2 .. j, and
+   sha256msg1 starts on the ones for group j + 3. */
+
+__attribute__(( target( "sha,sse4.1" ) ))
+static void sha256TransformSHANI(uint32* state, const uint8* buffer, int nBlocks)
+{
+    const __m128i byteSwap = _mm_set_epi64x( 0x0c0d0e0f08090a0bLL, 0x0405060700010203LL );
+
+    __m128i tmp   = _mm_shuffle_epi32( _mm_loadu_si128( ( const __m128i* ) &state[ 0 ] ), 0xB1 ); /* CDAB */
+    __m128i efgh  = _mm_shuffle_epi32( _mm_loadu_si128( ( const __m128i* ) &state[ 4 ] ), 0x1B ); /* EFGH */
+    __m128i abef  = _mm_alignr_epi8( tmp, efgh, 8 );
+    __m128i cdgh  = _mm_blend_epi16( efgh, tmp, 0xF0 );
+
+    for( ; nBlocks > 0; nBlocks--, buffer += SHA256_BLOCKSIZE )
+    {
+        __m128i abefSave = abef, cdghSave = cdgh, msg;
+        __m128i m[ 4 ];
+
+#define shaniRounds(j) \
+    { \
+    if( j < 4 ) \
+        m[ j ] = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* ) ( buffer + 16 * j ) ), byteSwap ); \
+    msg  = _mm_add_epi32( m[ j % 4 ], _mm_loadu_si128( ( const __m128i* ) &K256[ 4 * j ] ) ); \
+    cdgh = _mm_sha256rnds2_epu32( cdgh, abef, msg ); \
+    if( j >= 3 && j <= 14 ) \
+        m[ ( j + 1 ) % 4 ] = _mm_sha256msg2_epu32( _mm_add_epi32( m[ ( j + 1 ) % 4 ], \
+                                                                  _mm_alignr_epi8( m[ j % 4 ], m[ ( j + 3 ) % 4 ], 4 ) ), \
+                                                   m[ j % 4 ] ); \
+    abef = _mm_sha256rnds2_epu32( abef, cdgh, _mm_shuffle_epi32( msg, 0x0E ) ); \
+    if( j >= 1 && j <= 12 ) \
+        m[ ( j + 3 ) % 4 ] = _mm_sha256msg1_epu32( m[ ( j + 3 ) % 4 ], m[ j % 4 ] ); \
+    }
+
+        shaniRounds( 0 );  shaniRounds( 1 );  shaniRounds( 2 );  shaniRounds( 3 );
+        shaniRounds( 4 );  shaniRounds( 5 );  shaniRounds( 6 );  shaniRounds( 7 );
+        shaniRounds( 8 );  shaniRounds( 9 );  shaniRounds( 10 ); shaniRounds( 11 );
+        shaniRounds( 12 ); shaniRounds( 13 ); shaniRounds( 14 ); shaniRounds( 15 );
+
+#undef shaniRounds
+
+        abef = _mm_add_epi32( abef, abefSave );
+        cdgh = _mm_add_epi32( cdgh, cdghSave );
+    }
+
+    tmp  = _mm_shuffle_epi32( abef, 0x1B );  /* FEBA */
+    cdgh = _mm_shuffle_epi32( cdgh, 0xB1 );  /* DCHG */
+    _mm_storeu_si128( ( __m128i* ) &state[ 0 ], _mm_blend_epi16( tmp, cdgh, 0xF0 ) ); /* DCBA */
+    _mm_storeu_si128( ( __m128i* ) &state[ 4 ], _mm_alignr_epi8( cdgh, tmp, 8 ) );    /* HGFE */
+}
+
+static bool sha256HaveSHANI()
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) || !( ecx & bit_SSE4_1 ) || !( ecx & bit_SSSE3 ) )
+        return false;
+    if( __get_cpuid_max( 0, 0 ) < 7 )
+        return false;
+    __cpuid_count( 7, 0, eax, ebx, ecx, edx );
+    return ( ebx & ( 1 << 29 ) ) != 0; /* SHA */
+}
+#endif /* SHA256_USES_SHANI */
+
+static int s_kernel = -1;
+
+static int sha256BestKernel()
+{
+#if SHA256_USES_SHANI
+    static const bool bHaveSHANI = sha256HaveSHANI();
+    if( bHaveSHANI )
+        return SHA256_KERNEL_SHANI;
+#endif
+    return SHA256_KERNEL_GENERIC;
+}
+
+static void sha256Transform(uint32* state, const uint8* buffer, int nBlocks)
+{
+#if SHA256_USES_SHANI
+    if( ( s_kernel < 0 ? sha256BestKernel() : s_kernel ) == SHA256_KERNEL_SHANI )
+    {
+        sha256TransformSHANI( state, buffer, nBlocks );
+        return;
+    }
+#endif
+    sha256TransformGeneric( state, buffer, nBlocks );
+}
+
+bool sha256SetKernel(SHA256_KERNEL kernel)
+{
+    if( kernel < 0 || kernel >= SHA256_KERNEL_NUMITEMS )
+        return false;
+    if( kernel == SHA256_KERNEL_SHANI && sha256BestKernel() != SHA256_KERNEL_SHANI )
+        return false;
+
+    s_kernel = kernel;
+    return true;
+}
+
+SHA256_KERNEL sha256GetKernel()
+{
+    return ( SHA256_KERNEL ) ( s_kernel < 0 ? sha256BestKernel() : s_kernel );
+}
+
+const char* sha256KernelName(SHA256_KERNEL kernel)
+{
+    switch( kernel )
+    {
+    case SHA256_KERNEL_GENERIC: return "generic";
+    case SHA256_KERNEL_SHANI:   return "sha-ni";
+    default:                    return "unknown";
+    }
+}
+
+#define SCHED512(i) \
+    ( W[ ( i ) & 15 ] += ( ROR64( W[ ( ( i ) - 2 ) & 15 ], 19 ) ^ ROR64( W[ ( ( i ) - 2 ) & 15 ], 61 ) ^ ( W[ ( ( i ) - 2 ) & 15 ] >> 6 ) ) + \
+                         W[ ( ( i ) - 7 ) & 15 ] + \
+                         ( ROR64( W[ ( ( i ) - 15 ) & 15 ], 1 ) ^ ROR64( W[ ( ( i ) - 15 ) & 15 ], 8 ) ^ ( W[ ( ( i ) - 15 ) & 15 ] >> 7 ) ) )
+
+#define ROUND512(a, b, c, d, e, f, g, h, i, w) \
+    { \
+    uint64 t1 = h + ( ROR64( e, 14 ) ^ ROR64( e, 18 ) ^ ROR64( e, 41 ) ) + CH( e, f, g ) + K512[ i ] + ( w ); \
+    d += t1; \
+    h = t1 + ( ROR64( a, 28 ) ^ ROR64( a, 34 ) ^ ROR64( a, 39 ) ) + MAJ( a, b, c ); \
+    }
+
+static void sha512Transform(uint64* state, const uint8* buffer, int nBlocks)
+{
+    for( ; nBlocks > 0; nBlocks--, buffer += SHA512_BLOCKSIZE )
+    {
+        uint64 W[ 16 ];
+        uint64 a = state[ 0 ], b = state[ 1 ], c = state[ 2 ], d = state[ 3 ];
+        uint64 e = state[ 4 ], f = state[ 5 ], g = state[ 6 ], h = state[ 7 ];
+        int    i;
+
+        for( i = 0; i < 16; i++ )
+            W[ i ] = load64be( buffer + 8 * i );
+
+        for( i = 0; i < 80; i += 8 )
+        {
+            if( i < 16 )
+            {
+                ROUND512( a, b, c, d, e, f, g, h, i + 0, W[ i + 0 ] );
+                ROUND512( h, a, b, c, d, e, f, g, i + 1, W[ i + 1 ] );
+                ROUND512( g, h, a, b, c, d, e, f, i + 2, W[ i + 2 ] );
+                ROUND512( f, g, h, a, b, c, d, e, i + 3, W[ i + 3 ] );
+                ROUND512( e, f, g, h, a, b, c, d, i + 4, W[ i + 4 ] );
+                ROUND512( d, e, f, g, h, a, b, c, i + 5, W[ i + 5 ] );
+                ROUND512( c, d, e, f, g, h, a, b, i + 6, W[ i + 6 ] );
+                ROUND512( b, c, d, e, f, g, h, a, i + 7, W[ i + 7 ] );
+            }
+            else
+            {
+                ROUND512( a, b, c, d, e, f, g, h, i + 0, SCHED512( i + 0 ) );
+                ROUND512( h, a, b, c, d, e, f, g, i + 1, SCHED512( i + 1 ) );
+                ROUND512( g, h, a, b, c, d, e, f, i + 2, SCHED512( i + 2 ) );
+                ROUND512( f, g, h, a, b, c, d, e, i + 3, SCHED512( i + 3 ) );
+                ROUND512( e, f, g, h, a, b, c, d, i + 4, SCHED512( i + 4 ) );
+                ROUND512( d, e, f, g, h, a, b, c, i + 5, SCHED512( i + 5 ) );
+                ROUND512( c, d, e, f, g, h, a, b, i + 6, SCHED512( i + 6 ) );
+                ROUND512( b, c, d, e, f, g, h, a, i + 7, SCHED512( i + 7 ) );
+            }
+        }
+
+        state[ 0 ] += a; state[ 1 ] += b; state[ 2 ] += c; state[ 3 ] += d;
+        state[ 4 ] += e; state[ 5 ] += f; state[ 6 ] += g; state[ 7 ] += h;
+    }
+}
+
+/* Update a hash with a block of data.  Whole blocks are hashed straight
+   out of the caller's buffer; info->data holds on to the start of a block
+   that isn't complete yet. */
+
+void sha256Init(SHA256_INFO* info)
+{
+    static const uint32 init[ 8 ] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                      0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+    memcpy( info->state, init, sizeof( init ) );
+    info->count = 0;
+}
+
+void sha256Update(SHA256_INFO* info, const uint8* buffer, int count)
+{
+    int used = ( int ) ( info->count % SHA256_BLOCKSIZE );
+
+    info->count += count;
+
+    if( used )
+    {
+        int fill = SHA256_BLOCKSIZE - used;
+        if( count < fill )
+        {
+            memcpy( info->data + used, buffer, count );
+            return;
+        }
+        memcpy( info->data + used, buffer, fill );
+        sha256Transform( info->state, info->data, 1 );
+        buffer += fill;
+        count -= fill;
+    }
+
+    if( count >= SHA256_BLOCKSIZE )
+    {
+        sha256Transform( info->state, buffer, count / SHA256_BLOCKSIZE );
+        buffer += count - count % SHA256_BLOCKSIZE;
+        count %= SHA256_BLOCKSIZE;
+    }
+
+    memcpy( info->data, buffer, count );
+}
+
+void sha256Final(SHA256_INFO* info, uint8 digest[ SHA256_DIGESTSIZE ])
+{
+    uint8 padding[ 2 * SHA256_BLOCKSIZE ];
+    int   used   = ( int ) ( info->count % SHA256_BLOCKSIZE );
+    int   padLen = ( used < SHA256_BLOCKSIZE - 8 ) ? SHA256_BLOCKSIZE : 2 * SHA256_BLOCKSIZE;
+    int   i;
+
+    /* what's left, a 1 bit, zeros, and the length in bits, big-endian */
+    memcpy( padding, info->data, used );
+    padding[ used ] = 0x80;
+    memset( padding + used + 1, 0, padLen - used - 1 );
+    store64be( padding + padLen - 8, info->count << 3 );
+
+    sha256Transform( info->state, padding, padLen / SHA256_BLOCKSIZE );
+
+    for( i = 0; i < 8; i++ )
+    {
+        digest[ 4 * i ]     = ( uint8 ) ( info->state[ i ] >> 24 );
+        digest[ 4 * i + 1 ] = ( uint8 ) ( info->state[ i ] >> 16 );
+        digest[ 4 * i + 2 ] = ( uint8 ) ( info->state[ i ] >> 8 );
+        digest[ 4 * i + 3 ] = ( uint8 ) info->state[ i ];
+    }
+}
+
+void sha512Init(SHA512_INFO* info)
+{
+    static const uint64 init[ 8 ] = { 0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+                                      0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+                                      0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+                                      0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL };
+
+    memcpy( info->state, init, sizeof( init ) );
+    info->count = 0;
+}
+
+void sha512Update(SHA512_INFO* info, const uint8* buffer, int count)
+{
+    int used = ( int ) ( info->count % SHA512_BLOCKSIZE );
+
+    info->count += count;
+
+    if( used )
+    {
+        int fill = SHA512_BLOCKSIZE - used;
+        if( count < fill )
+        {
+            memcpy( info->data + used, buffer, count );
+            return;
+        }
+        memcpy( info->data + used, buffer, fill );
+        sha512Transform( info->state, info->data, 1 );
+        buffer += fill;
+        count -= fill;
+    }
+
+    if( count >= SHA512_BLOCKSIZE )
+    {
+        sha512Transform( info->state, buffer, count / SHA512_BLOCKSIZE );
+        buffer += count - count % SHA512_BLOCKSIZE;
+        count %= SHA512_BLOCKSIZE;
+    }
+
+    memcpy( info->data, buffer, count );
+}
+
+void sha512Final(SHA512_INFO* info, uint8 digest[ SHA512_DIGESTSIZE ])
+{
+    uint8 padding[ 2 * SHA512_BLOCKSIZE ];
+    int   used   = ( int ) ( info->count % SHA512_BLOCKSIZE );
+    int   padLen = ( used < SHA512_BLOCKSIZE - 16 ) ? SHA512_BLOCKSIZE : 2 * SHA512_BLOCKSIZE;
+    int   i;
+
+    /* the length is 128 bits here; the top 64 are the bits shifted out */
+    memcpy( padding, info->data, used );
+    padding[ used ] = 0x80;
+    memset( padding + used + 1, 0, padLen - used - 1 );
+    store64be( padding + padLen - 16, info->count >> 61 );
+    store64be( padding + padLen - 8, info->count << 3 );
+
+    sha512Transform( info->state, padding, padLen / SHA512_BLOCKSIZE );
+
+    for( i = 0; i < 8; i++ )
+        store64be( digest + 8 * i, info->state[ i ] );
+}
@@ -0,0 +1,80 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// sha2.h -- the built in SHA-256 and SHA-512, used when there's no OpenSSL
+///////////////////////////////////////////////////////////////////////////////
+#ifndef __SHA2_H
+#define __SHA2_H
+
+#ifndef __TYPES_H
+#include "types.h"
+#endif
+
+#define SHA256_BLOCKSIZE  64
+#define SHA256_DIGESTSIZE 32
+#define SHA512_BLOCKSIZE  128
+#define SHA512_DIGESTSIZE 64
+
+typedef struct {
+    uint32 state[ 8 ];
+    uint64 count;                     /* bytes hashed so far */
+    uint8  data[ SHA256_BLOCKSIZE ];  /* the start of a block that isn't complete yet */
+} SHA256_INFO;
+
+typedef struct {
+    uint64 state[ 8 ];
+    uint64 count;                     /* bytes hashed so far */
+    uint8  data[ SHA512_BLOCKSIZE ];
+} SHA512_INFO;
+
+void sha256Init(SHA256_INFO* info);
+void sha256Update(SHA256_INFO* info, const uint8* buffer, int count);
+void sha256Final(SHA256_INFO* info, uint8 digest[ SHA256_DIGESTSIZE ]);
+
+void sha512Init(SHA512_INFO* info);
+void sha512Update(SHA512_INFO* info, const uint8* buffer, int count);
+void sha512Final(SHA512_INFO* info, uint8 digest[ SHA512_DIGESTSIZE ]);
+
+/* The ways the SHA-256 transformation can be done; they all give the same
+   answer.  The fastest one this cpu can run is used unless told otherwise. */
+typedef enum {
+    SHA256_KERNEL_GENERIC,            /* portable C */
+    SHA256_KERNEL_SHANI,              /* x86 SHA extensions */
+    SHA256_KERNEL_NUMITEMS
+} SHA256_KERNEL;
+
+bool          sha256SetKernel(SHA256_KERNEL kernel); /* false if this cpu can't run it */
+SHA256_KERNEL sha256GetKernel();
+const char*   sha256KernelName(SHA256_KERNEL kernel);
+
+#endif /* __SHA2_H */
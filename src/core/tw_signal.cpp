@@ -35,6 +35,11 @@
 #include "corestrings.h"
 #include <signal.h>
 #include <stdlib.h>
+#include <setjmp.h>
+
+#if SUPPORTS_WORKER_THREADS
+#include <pthread.h>
+#endif
 
 static void util_SignalHandler(int sig);
 
@@ -63,6 +68,127 @@ tw_sighandler_t tw_HandleSignal(int sig)
     return signal(sig, util_SignalHandler);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// tw_CatchBusError
+//
+// The jump buffer is per thread, since any of the hashing threads may be
+// reading a mapped file. It is only looked at by the handler when the signal
+// arrives on a thread that is inside tw_CatchBusError.
+///////////////////////////////////////////////////////////////////////////////
+#if SUPPORTS_POSIX_SIGNALS
+
+static tw_sighandler_t s_prevBusHandler = SIG_DFL;
+
+#    if SUPPORTS_WORKER_THREADS
+static pthread_key_t  s_busJumpKey;
+static pthread_once_t s_busJumpOnce = PTHREAD_ONCE_INIT;
+
+static void util_CreateBusJumpKey()
+{
+    pthread_key_create(&s_busJumpKey, 0);
+}
+
+static sigjmp_buf* util_GetBusJump()
+{
+    return static_cast<sigjmp_buf*>(pthread_getspecific(s_busJumpKey));
+}
+
+static void util_SetBusJump(sigjmp_buf* pJump)
+{
+    pthread_setspecific(s_busJumpKey, pJump);
+}
+#    else
+static sigjmp_buf* s_pBusJump = 0;
+
+static sigjmp_buf* util_GetBusJump()
+{
+    return s_pBusJump;
+}
+
+static void util_SetBusJump(sigjmp_buf* pJump)
+{
+    s_pBusJump = pJump;
+}
+#    endif
+
+static void util_BusErrorHandler(int sig)
+{
+    sigjmp_buf* pJump = util_GetBusJump();
+    if (pJump)
+        siglongjmp(*pJump, 1);
+
+    // not one of ours; do what would have happened without us
+    if (s_prevBusHandler == SIG_DFL || s_prevBusHandler == SIG_IGN)
+    {
+        signal(sig, SIG_DFL);
+        raise(sig);
+    }
+    else
+        s_prevBusHandler(sig);
+}
+
+bool tw_CatchBusError(void (*pFunc)(void*), void* pArg)
+{
+#    if SUPPORTS_WORKER_THREADS
+    pthread_once(&s_busJumpOnce, util_CreateBusJumpKey);
+#    endif
+
+    // install our handler in front of whatever is there, unless it already is; this is
+    // checked every time since tw_HandleSignal() may have been called after the last one
+    struct sigaction curAction;
+    sigaction(SIGBUS, 0, &curAction);
+    if (curAction.sa_handler != util_BusErrorHandler)
+    {
+        struct sigaction busAction;
+        busAction.sa_handler = util_BusErrorHandler;
+        busAction.sa_flags   = 0;
+        sigemptyset(&busAction.sa_mask);
+
+        s_prevBusHandler = curAction.sa_handler;
+        sigaction(SIGBUS, &busAction, 0);
+    }
+
+    // worker threads run with every signal blocked, and a blocked SIGBUS from a
+    // fault just kills the process, so let it through while pFunc runs
+    sigset_t busSignal, oldSignals;
+    sigemptyset(&busSignal);
+    sigaddset(&busSignal, SIGBUS);
+#    if SUPPORTS_WORKER_THREADS
+    pthread_sigmask(SIG_UNBLOCK, &busSignal, &oldSignals);
+#    else
+    sigprocmask(SIG_UNBLOCK, &busSignal, &oldSignals);
+#    endif
+
+    bool       bOK = true;
+    sigjmp_buf jump;
+    if (sigsetjmp(jump, 1) == 0)
+    {
+        util_SetBusJump(&jump);
+        pFunc(pArg);
+    }
+    else
+        bOK = false;
+
+    util_SetBusJump(0);
+#    if SUPPORTS_WORKER_THREADS
+    pthread_sigmask(SIG_SETMASK, &oldSignals, 0);
+#    else
+    sigprocmask(SIG_SETMASK, &oldSignals, 0);
+#    endif
+
+    return bOK;
+}
+
+#else
+
+bool tw_CatchBusError(void (*pFunc)(void*), void* pArg)
+{
+    pFunc(pArg);
+    return true;
+}
+
+#endif
+
 void util_SignalHandler(int sig)
 {
     //If we're on unix, let's print out a nice error message telling
@@ -63,5 +63,14 @@ tw_sighandler_t tw_sigign(int sig);
 //
 tw_sighandler_t tw_HandleSignal(int sig);
 
+///////////////////////////////////////////////////////////////////////////////
+// tw_CatchBusError -- calls pFunc(pArg) and returns true, or returns false if
+//      it was cut short by a SIGBUS, which is what touching a mapped page past
+//      the end of a file that has since shrunk raises. pFunc must not leave
+//      anything needing a destructor on the stack. A SIGBUS that happens
+//      outside of this still goes to whatever handler was there before.
+//
+bool tw_CatchBusError(void (*pFunc)(void*), void* pArg);
+
 
 #endif //__TW_SIGNAL_H
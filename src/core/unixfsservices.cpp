@@ -135,13 +135,27 @@ static bool                             util_GetNextPathElement(const TSTRING& s
 static void                             util_RemoveDuplicateSeps(TSTRING& strPath);
 static bool                             util_TrailingSep(TSTRING& str, bool fLeaveSep);
 static void                             util_RemoveTrailingSeps(TSTRING& str);
+static void                             util_ReadDirEntries(DIR*                                dp,
+                                                            const TSTRING&                      strDir,
+                                                            std::vector<TSTRING>&               v,
+                                                            bool                                bFullPaths,
+                                                            std::vector<cFSStatArgs::FileType>* pTypes = 0);
+static void                             util_CopyStat(struct stat statbuf, uint32 fields, cFSStatArgs& stat);
+static cFSStatArgs::FileType            util_FileType(mode_t mode);
+static cFSStatArgs::FileType            util_DirEntType(const struct dirent* d);
+#if SUPPORTS_DIR_FDS
+static int util_OpenDirAt(int dirfd, const TCHAR* name);
+#endif
+#if HAVE_STATX
+static int util_Statx(int dirfd, const TCHAR* name, uint32 fields, bool bDontSync, cFSStatArgs& stat);
+#endif
 template<typename T> static inline void util_ZeroMemory(T& obj);
 
 //=========================================================================
 // PUBLIC METHOD CODE
 //=========================================================================
 
-cUnixFSServices::cUnixFSServices() : mResolveNames(true)
+cUnixFSServices::cUnixFSServices() : mResolveNames(true), mbStatDontSync(false)
 {
 }
 
@@ -213,31 +227,68 @@ void cUnixFSServices::ReadDir(const TSTRING& strFilenameC, std::vector<TSTRING>&
         return;
     }
 
-    struct dirent* d;
+    util_ReadDirEntries(dp, strFilename, v, bFullPaths);
 
-    while ((d = readdir(dp)) != NULL)
+    //Close the directory
+    closedir(dp);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// OpenDir
+///////////////////////////////////////////////////////////////////////////////
+cFSDirHandle* cUnixFSServices::OpenDir(const TSTRING& strName, const cFSDirHandle* pParent) const
+{
+    TSTRING strPath = pParent ? pParent->GetPath(strName) : strName;
+    int     fd      = -1;
+
+#if SUPPORTS_DIR_FDS
+    if (pParent && pParent->GetFd() >= 0)
+        fd = util_OpenDirAt(pParent->GetFd(), strName.c_str());
+    else
+        fd = util_OpenDirAt(AT_FDCWD, strPath.c_str());
+
+    if (fd < 0)
+        throw eFSServicesGeneric(strPath, iFSServices::GetInstance()->GetErrString());
+#endif
+
+    return new cFSDirHandle(strPath, fd);
+}
+
+void cUnixFSServices::ReadDir(const cFSDirHandle& dir, std::vector<TSTRING>& v, const TSTRING& strName) const
+{
+    std::vector<cFSStatArgs::FileType> vTypes;
+    ReadDir(dir, v, vTypes, strName);
+}
+
+void cUnixFSServices::ReadDir(const cFSDirHandle&                 dir,
+                              std::vector<TSTRING>&               v,
+                              std::vector<cFSStatArgs::FileType>& vTypes,
+                              const TSTRING&                      strName) const
+{
+#if SUPPORTS_DIR_FDS
+    if (dir.GetFd() >= 0)
     {
-        if ((strcmp(d->d_name, _T(".")) != 0) && (strcmp(d->d_name, _T("..")) != 0))
+        // open the directory again, so that we get our own read position
+        DIR* dp  = 0;
+        int  dfd = util_OpenDirAt(dir.GetFd(), strName.empty() ? _T(".") : strName.c_str());
+        if (dfd >= 0)
         {
-            if (bFullPaths)
-            {
-                //Create the full pathname
-                TSTRING strNewName = strFilename;
+            dp = fdopendir(dfd);
+            if (dp == NULL)
+                close(dfd);
+        }
 
-                // get full path of dir entry
-                util_TrailingSep(strNewName, true);
-                strNewName += d->d_name;
+        if (dp == NULL)
+            throw eFSServicesGeneric(dir.GetPath(strName), iFSServices::GetInstance()->GetErrString());
 
-                // save full path name
-                v.push_back(strNewName);
-            }
-            else
-                v.push_back(d->d_name);
-        }
+        util_ReadDirEntries(dp, dir.GetPath(strName), v, false, &vTypes);
+        closedir(dp);
+        return;
     }
+#endif
 
-    //Close the directory
-    closedir(dp);
+    ReadDir(dir.GetPath(strName), v, false);
+    vTypes.assign(v.size(), cFSStatArgs::TY_INVALID);
 }
 
 /* needs to and with S_IFMT, check EQUALITY with S_*, and return more types
@@ -316,98 +367,61 @@ void cUnixFSServices::SetTempDirName(TSTRING& tmpPath)
 
 
 #if !USES_DEVICE_PATH
-void cUnixFSServices::Stat(const TSTRING& strName, cFSStatArgs& stat) const
+void cUnixFSServices::Stat(const TSTRING& strName, cFSStatArgs& stat, uint32 fields) const
 {
 #else
-void cUnixFSServices::Stat(const TSTRING& strNameC, cFSStatArgs& stat) const
+void cUnixFSServices::Stat(const TSTRING& strNameC, cFSStatArgs& stat, uint32 fields) const
 {
     TSTRING strName = cDevicePath::AsNative(strNameC);
 #endif
-    //local variable for obtaining info on file.
-    struct stat statbuf;
+    int ret = -1;
+
+#if HAVE_STATX
+    ret = util_Statx(AT_FDCWD, strName.c_str(), fields, mbStatDontSync, stat);
+    if (ret < 0 && (errno == ENOSYS || errno == EPERM))
+#endif
+    {
+        //local variable for obtaining info on file.
+        struct stat statbuf;
 
-    int ret;
-    ret = lstat(strName.c_str(), &statbuf);
+        ret = lstat(strName.c_str(), &statbuf);
+        if (ret == 0)
+            util_CopyStat(statbuf, fields, stat);
+    }
 
     cDebug d("cUnixFSServices::Stat");
     d.TraceDetail("Executing on file %s (result=%d)\n", strName.c_str(), ret);
 
     if (ret < 0)
         throw eFSServicesGeneric(strName, iFSServices::GetInstance()->GetErrString());
+}
 
-#if HAVE_STRUCT_STAT_ST_RDEV
-    // new stuff 7/17/99 - BAM
-    // if the file is not a device set rdev to zero by hand (most OSs will
-    // do this for us, but some don't)
-    if (!S_ISBLK(statbuf.st_mode) && !S_ISCHR(statbuf.st_mode))
+void cUnixFSServices::Stat(const cFSDirHandle& dir, const TSTRING& strName, cFSStatArgs& stat, uint32 fields) const
+{
+#if SUPPORTS_DIR_FDS
+    if (dir.GetFd() >= 0)
     {
-        // must zero memory instead of '= 0' since we don't know the
-        // actual type of the object -- could be a struct (requiring '= {0}' )
-        util_ZeroMemory(statbuf.st_rdev);
-    }
-#endif
+        int ret = -1;
 
-    //copy information returned by lstat call into the structure passed in
-    stat.gid   = statbuf.st_gid;
-    stat.atime = statbuf.st_atime;
-    stat.ctime = statbuf.st_ctime;
-    stat.mtime = statbuf.st_mtime;
-    stat.dev   = statbuf.st_dev;
-
-#if HAVE_STRUCT_STAT_ST_RDEV
-    stat.rdev = statbuf.st_rdev;
-#else
-    stat.rdev = 0;
-#endif
-
-    stat.ino     = statbuf.st_ino;
-    stat.mode    = statbuf.st_mode;
-    stat.nlink   = statbuf.st_nlink;
-    stat.size    = statbuf.st_size;
-    stat.uid     = statbuf.st_uid;
-    stat.blksize = statbuf.st_blksize;
-
-#if HAVE_STRUCT_STAT_ST_BLOCKS
-    stat.blocks = statbuf.st_blocks;
-#else
-    stat.blocks = 0;
-#endif
-
-    // set the file type
-    if (S_ISREG(statbuf.st_mode))
-        stat.mFileType = cFSStatArgs::TY_FILE;
-    else if (S_ISDIR(statbuf.st_mode))
-        stat.mFileType = cFSStatArgs::TY_DIR;
-    else if (S_ISLNK(statbuf.st_mode))
-        stat.mFileType = cFSStatArgs::TY_SYMLINK;
-    else if (S_ISBLK(statbuf.st_mode))
-        stat.mFileType = cFSStatArgs::TY_BLOCKDEV;
-    else if (S_ISCHR(statbuf.st_mode))
-        stat.mFileType = cFSStatArgs::TY_CHARDEV;
-    else if (S_ISFIFO(statbuf.st_mode))
-        stat.mFileType = cFSStatArgs::TY_FIFO;
-#ifdef S_ISSOCK
-    else if (S_ISSOCK(statbuf.st_mode))
-        stat.mFileType = cFSStatArgs::TY_SOCK;
-#endif
-
-#if HAVE_DOOR_CREATE
-    else if (S_ISDOOR(statbuf.st_mode))
-        stat.mFileType = cFSStatArgs::TY_DOOR;
-#endif
+#    if HAVE_STATX
+        ret = util_Statx(dir.GetFd(), strName.c_str(), fields, mbStatDontSync, stat);
+        if (ret < 0 && (errno == ENOSYS || errno == EPERM))
+#    endif
+        {
+            struct stat statbuf;
 
-#if HAVE_PORT_CREATE
-    else if (S_ISPORT(statbuf.st_mode))
-        stat.mFileType = cFSStatArgs::TY_PORT;
-#endif
+            ret = fstatat(dir.GetFd(), strName.c_str(), &statbuf, AT_SYMLINK_NOFOLLOW);
+            if (ret == 0)
+                util_CopyStat(statbuf, fields, stat);
+        }
 
-#ifdef S_ISNAM
-    else if (S_ISNAM(statbuf.st_mode))
-        stat.mFileType = cFSStatArgs::TY_NAMED;
+        if (ret < 0)
+            throw eFSServicesGeneric(dir.GetPath(strName), iFSServices::GetInstance()->GetErrString());
+        return;
+    }
 #endif
 
-    else
-        stat.mFileType = cFSStatArgs::TY_INVALID;
+    Stat(dir.GetPath(strName), stat, fields);
 }
 
 void cUnixFSServices::GetMachineName(TSTRING& strName) const
@@ -532,6 +546,11 @@ void cUnixFSServices::SetResolveNames(bool resolve)
     mResolveNames = resolve;
 }
 
+void cUnixFSServices::SetStatDontSync(bool dontSync)
+{
+    mbStatDontSync = dontSync;
+}
+
 
 bool cUnixFSServices::GetUserName(uid_t user_id, TSTRING& tstrUser) const
 {
@@ -1211,6 +1230,268 @@ void util_RemoveTrailingSeps(TSTRING& str)
     }
 }
 
+#if SUPPORTS_DIR_FDS
+///////////////////////////////////////////////////////////////////////////////
+// util_OpenDirAt -- opens the directory name in dirfd for reading. A symlink
+//      that has taken the place of the directory since it was stat()ed is not
+//      followed.
+///////////////////////////////////////////////////////////////////////////////
+int util_OpenDirAt(int dirfd, const TCHAR* name)
+{
+    int flags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW;
+#    ifdef O_NOATIME
+    int fd = openat(dirfd, name, flags | O_NOATIME);
+
+    // O_NOATIME is only allowed on directories we own, unless we are root
+    if (fd >= 0 || errno != EPERM)
+        return fd;
+#    endif
+    return openat(dirfd, name, flags);
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// util_ReadDirEntries -- reads everything but . and .. from an open directory.
+//      If pTypes isn't null, the d_type of each entry goes into it.
+///////////////////////////////////////////////////////////////////////////////
+void util_ReadDirEntries(DIR*                                dp,
+                         const TSTRING&                      strDir,
+                         std::vector<TSTRING>&               v,
+                         bool                                bFullPaths,
+                         std::vector<cFSStatArgs::FileType>* pTypes)
+{
+    struct dirent* d;
+
+    while ((d = readdir(dp)) != NULL)
+    {
+        if ((strcmp(d->d_name, _T(".")) != 0) && (strcmp(d->d_name, _T("..")) != 0))
+        {
+            if (bFullPaths)
+            {
+                //Create the full pathname
+                TSTRING strNewName = strDir;
+
+                // get full path of dir entry
+                util_TrailingSep(strNewName, true);
+                strNewName += d->d_name;
+
+                // save full path name
+                v.push_back(strNewName);
+            }
+            else
+                v.push_back(d->d_name);
+
+            if (pTypes)
+                pTypes->push_back(util_DirEntType(d));
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_DirEntType -- the file type readdir() gave for an entry; TY_INVALID if
+//      it didn't give one
+///////////////////////////////////////////////////////////////////////////////
+cFSStatArgs::FileType util_DirEntType(const struct dirent* d)
+{
+#if HAVE_STRUCT_DIRENT_D_TYPE
+    switch (d->d_type)
+    {
+    case DT_REG:
+        return cFSStatArgs::TY_FILE;
+    case DT_DIR:
+        return cFSStatArgs::TY_DIR;
+    case DT_BLK:
+        return cFSStatArgs::TY_BLOCKDEV;
+    case DT_CHR:
+        return cFSStatArgs::TY_CHARDEV;
+    case DT_LNK:
+        return cFSStatArgs::TY_SYMLINK;
+    case DT_FIFO:
+        return cFSStatArgs::TY_FIFO;
+    case DT_SOCK:
+        return cFSStatArgs::TY_SOCK;
+#    ifdef DT_DOOR
+    case DT_DOOR:
+        return cFSStatArgs::TY_DOOR;
+#    endif
+    default:
+        // DT_UNKNOWN, or something we don't have a type for
+        break;
+    }
+#endif
+
+    return cFSStatArgs::TY_INVALID;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_CopyStat -- fills out a cFSStatArgs from what lstat() returned
+///////////////////////////////////////////////////////////////////////////////
+void util_CopyStat(struct stat statbuf, uint32 fields, cFSStatArgs& stat)
+{
+#if HAVE_STRUCT_STAT_ST_RDEV
+    // new stuff 7/17/99 - BAM
+    // if the file is not a device set rdev to zero by hand (most OSs will
+    // do this for us, but some don't)
+    if (!S_ISBLK(statbuf.st_mode) && !S_ISCHR(statbuf.st_mode))
+    {
+        // must zero memory instead of '= 0' since we don't know the
+        // actual type of the object -- could be a struct (requiring '= {0}' )
+        util_ZeroMemory(statbuf.st_rdev);
+    }
+#endif
+
+    //copy information returned by lstat call into the structure passed in
+    stat.gid   = statbuf.st_gid;
+    stat.atime = statbuf.st_atime;
+    stat.ctime = statbuf.st_ctime;
+    stat.mtime = statbuf.st_mtime;
+    stat.btime = 0;
+
+#if HAVE_STRUCT_STAT_ST_MTIM
+    stat.mtimeNsec = statbuf.st_mtim.tv_nsec;
+    stat.ctimeNsec = statbuf.st_ctim.tv_nsec;
+#else
+    stat.mtimeNsec = 0;
+    stat.ctimeNsec = 0;
+#endif
+
+    stat.dev = statbuf.st_dev;
+
+#if HAVE_STRUCT_STAT_ST_RDEV
+    stat.rdev = statbuf.st_rdev;
+#else
+    stat.rdev = 0;
+#endif
+
+    stat.ino     = statbuf.st_ino;
+    stat.mode    = statbuf.st_mode;
+    stat.nlink   = statbuf.st_nlink;
+    stat.size    = statbuf.st_size;
+    stat.uid     = statbuf.st_uid;
+    stat.blksize = statbuf.st_blksize;
+
+#if HAVE_STRUCT_STAT_ST_BLOCKS
+    stat.blocks = statbuf.st_blocks;
+#else
+    stat.blocks = 0;
+#endif
+
+    // lstat() always gets everything it can, whatever was asked for
+    stat.mRequested = fields | cFSStatArgs::FIELD_BASIC;
+    stat.mFields    = cFSStatArgs::FIELD_BASIC;
+
+    // set the file type
+    stat.mFileType = util_FileType(statbuf.st_mode);
+}
+
+#if HAVE_STATX
+///////////////////////////////////////////////////////////////////////////////
+// util_Statx -- like fstatat(), but only fetches the requested fields, which
+//      can save a trip to the server on network file systems. Returns -1 and
+//      sets errno on failure; ENOSYS means the kernel doesn't have statx(), and
+//      EPERM that a seccomp filter (some containers) refuses it.
+///////////////////////////////////////////////////////////////////////////////
+int util_Statx(int dirfd, const TCHAR* name, uint32 fields, bool bDontSync, cFSStatArgs& stat)
+{
+    static const struct
+    {
+        uint32       field;
+        unsigned int mask;
+    } masks[] = { { cFSStatArgs::FIELD_TYPE, STATX_TYPE },     { cFSStatArgs::FIELD_MODE, STATX_MODE },
+                  { cFSStatArgs::FIELD_NLINK, STATX_NLINK },   { cFSStatArgs::FIELD_UID, STATX_UID },
+                  { cFSStatArgs::FIELD_GID, STATX_GID },       { cFSStatArgs::FIELD_ATIME, STATX_ATIME },
+                  { cFSStatArgs::FIELD_MTIME, STATX_MTIME },   { cFSStatArgs::FIELD_CTIME, STATX_CTIME },
+                  { cFSStatArgs::FIELD_INO, STATX_INO },       { cFSStatArgs::FIELD_SIZE, STATX_SIZE },
+                  { cFSStatArgs::FIELD_BLOCKS, STATX_BLOCKS }, { cFSStatArgs::FIELD_BTIME, STATX_BTIME } };
+    static const int numMasks = sizeof(masks) / sizeof(masks[0]);
+
+    // the file type is always needed
+    fields |= cFSStatArgs::FIELD_TYPE;
+
+    unsigned int mask = 0;
+    for (int i = 0; i < numMasks; i++)
+    {
+        if (fields & masks[i].field)
+            mask |= masks[i].mask;
+    }
+
+    struct statx stx;
+    int          flags = AT_SYMLINK_NOFOLLOW | (bDontSync ? AT_STATX_DONT_SYNC : AT_STATX_SYNC_AS_STAT);
+    if (statx(dirfd, name, flags, mask, &stx) < 0)
+        return -1;
+
+    stat.mRequested = fields;
+    stat.mFields    = 0;
+    for (int i = 0; i < numMasks; i++)
+    {
+        if (stx.stx_mask & masks[i].mask)
+            stat.mFields |= masks[i].field;
+    }
+
+    stat.dev     = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    stat.rdev    = (S_ISBLK(stx.stx_mode) || S_ISCHR(stx.stx_mode)) ? makedev(stx.stx_rdev_major, stx.stx_rdev_minor) : 0;
+    stat.ino     = stx.stx_ino;
+    stat.mode    = stx.stx_mode;
+    stat.nlink   = stx.stx_nlink;
+    stat.uid     = stx.stx_uid;
+    stat.gid     = stx.stx_gid;
+    stat.size    = stx.stx_size;
+    stat.atime   = stx.stx_atime.tv_sec;
+    stat.mtime   = stx.stx_mtime.tv_sec;
+    stat.ctime   = stx.stx_ctime.tv_sec;
+    stat.btime   = (stat.mFields & cFSStatArgs::FIELD_BTIME) ? stx.stx_btime.tv_sec : 0;
+    stat.blksize = stx.stx_blksize;
+    stat.blocks  = stx.stx_blocks;
+
+    stat.mtimeNsec = stx.stx_mtime.tv_nsec;
+    stat.ctimeNsec = stx.stx_ctime.tv_nsec;
+
+    stat.mFileType = util_FileType(stx.stx_mode);
+
+    return 0;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// util_FileType -- the file type from the st_mode bits
+///////////////////////////////////////////////////////////////////////////////
+cFSStatArgs::FileType util_FileType(mode_t mode)
+{
+    if (S_ISREG(mode))
+        return cFSStatArgs::TY_FILE;
+    else if (S_ISDIR(mode))
+        return cFSStatArgs::TY_DIR;
+    else if (S_ISLNK(mode))
+        return cFSStatArgs::TY_SYMLINK;
+    else if (S_ISBLK(mode))
+        return cFSStatArgs::TY_BLOCKDEV;
+    else if (S_ISCHR(mode))
+        return cFSStatArgs::TY_CHARDEV;
+    else if (S_ISFIFO(mode))
+        return cFSStatArgs::TY_FIFO;
+#ifdef S_ISSOCK
+    else if (S_ISSOCK(mode))
+        return cFSStatArgs::TY_SOCK;
+#endif
+
+#if HAVE_DOOR_CREATE
+    else if (S_ISDOOR(mode))
+        return cFSStatArgs::TY_DOOR;
+#endif
+
+#if HAVE_PORT_CREATE
+    else if (S_ISPORT(mode))
+        return cFSStatArgs::TY_PORT;
+#endif
+
+#ifdef S_ISNAM
+    else if (S_ISNAM(mode))
+        return cFSStatArgs::TY_NAMED;
+#endif
+
+    return cFSStatArgs::TY_INVALID;
+}
+
 template<typename T> static inline void util_ZeroMemory(T& obj)
 {
     memset(&obj, 0, sizeof(obj));
@@ -83,7 +83,7 @@ public:
     ////////////////////////////////////////
     // major filesystem functions
     ////////////////////////////////////////
-    virtual void Stat(const TSTRING& strFileName, cFSStatArgs& pStat) const;
+    virtual void Stat(const TSTRING& strFileName, cFSStatArgs& pStat, uint32 fields = cFSStatArgs::FIELD_BASIC) const;
     // fills out the cFSStatArgs structure with the stat info for the named file
 
     virtual void GetTempDirName(TSTRING& strName) const;
@@ -120,6 +120,20 @@ public:
     virtual void GetCurrentDir(TSTRING& strCurDir) const;
     // returns the current working directory
 
+    ////////////////////////////////////////
+    // open directory functions
+    ////////////////////////////////////////
+    virtual cFSDirHandle* OpenDir(const TSTRING& strName, const cFSDirHandle* pParent = 0) const;
+    virtual void ReadDir(const cFSDirHandle& dir, std::vector<TSTRING>& vDirContents, const TSTRING& strName = _T("")) const;
+    virtual void ReadDir(const cFSDirHandle&                 dir,
+                         std::vector<TSTRING>&               vDirContents,
+                         std::vector<cFSStatArgs::FileType>& vTypes,
+                         const TSTRING&                      strName = _T("")) const;
+    virtual void Stat(const cFSDirHandle& dir,
+                      const TSTRING&      strName,
+                      cFSStatArgs&        stat,
+                      uint32              fields = cFSStatArgs::FIELD_BASIC) const;
+
 
     ////////////////////////////////////////
     // file specific functions
@@ -140,6 +154,8 @@ public:
     //This defaults to true if not specified.
     virtual void SetResolveNames(bool resolve);
 
+    virtual void SetStatDontSync(bool dontSync);
+
     ////////////////////////////////////////
     // miscellaneous utility functions
     ////////////////////////////////////////
@@ -161,6 +177,7 @@ public:
 private:
     TSTRING mTempPath;
     bool    mResolveNames;
+    bool    mbStatDontSync;
 };
 
 #endif //__UNIXFSSERVICES_H
@@ -0,0 +1,289 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+// workerpool.cpp
+#include "stdcore.h"
+#include "workerpool.h"
+#include "debug.h"
+
+#if SUPPORTS_WORKER_THREADS
+#    include <pthread.h>
+#    include <signal.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// cWorkerPool_i
+///////////////////////////////////////////////////////////////////////////////
+class cWorkerPool_i
+{
+public:
+    typedef std::list<iWorkerTask*> TaskList;
+    typedef std::map<iWorkerTask*, TaskList::iterator> TaskMap;
+
+    TaskList mQueue;       // tasks that no one has started yet, in submission order
+    TaskMap  mOutstanding; // queued or running tasks; running ones map to mQueue.end()
+
+#if SUPPORTS_WORKER_THREADS
+    std::vector<pthread_t> mThreads;
+    pthread_mutex_t        mMutex;
+    pthread_cond_t         mWorkReady; // signalled when a task is queued or the pool shuts down
+    pthread_cond_t         mWorkDone;  // signalled when a task finishes
+    bool                   mbShutdown;
+#endif
+
+    void Lock();
+    void Unlock();
+    void WaitForDone();
+    void SignalDone();
+
+    void RunTask(iWorkerTask* pTask);
+    // runs a task taken off the queue and marks it finished. Must be called
+    // with the lock held; the lock is dropped while the task runs.
+};
+
+#if SUPPORTS_WORKER_THREADS
+
+inline void cWorkerPool_i::Lock()
+{
+    pthread_mutex_lock(&mMutex);
+}
+
+inline void cWorkerPool_i::Unlock()
+{
+    pthread_mutex_unlock(&mMutex);
+}
+
+inline void cWorkerPool_i::WaitForDone()
+{
+    pthread_cond_wait(&mWorkDone, &mMutex);
+}
+
+inline void cWorkerPool_i::SignalDone()
+{
+    pthread_cond_broadcast(&mWorkDone);
+}
+
+#else
+
+// without threads, tasks only ever run on the thread that waits for them,
+// so there is nothing to lock and nothing to wait on.
+inline void cWorkerPool_i::Lock()
+{
+}
+
+inline void cWorkerPool_i::Unlock()
+{
+}
+
+inline void cWorkerPool_i::WaitForDone()
+{
+    ASSERT(false);
+}
+
+inline void cWorkerPool_i::SignalDone()
+{
+}
+
+#endif
+
+void cWorkerPool_i::RunTask(iWorkerTask* pTask)
+{
+    mOutstanding[pTask] = mQueue.end();
+    Unlock();
+
+    try
+    {
+        pTask->Run();
+    }
+    catch (...)
+    {
+        // tasks are supposed to hold on to their own errors
+        ASSERT(false);
+    }
+
+    Lock();
+    mOutstanding.erase(pTask);
+    SignalDone();
+}
+
+#if SUPPORTS_WORKER_THREADS
+///////////////////////////////////////////////////////////////////////////////
+// util_WorkerThread -- the body of each thread in the pool
+///////////////////////////////////////////////////////////////////////////////
+static void* util_WorkerThread(void* pArg)
+{
+    cWorkerPool_i* pPool = static_cast<cWorkerPool_i*>(pArg);
+
+    pPool->Lock();
+    while (true)
+    {
+        while (pPool->mQueue.empty() && !pPool->mbShutdown)
+            pthread_cond_wait(&pPool->mWorkReady, &pPool->mMutex);
+
+        if (pPool->mQueue.empty())
+            break;
+
+        iWorkerTask* pTask = pPool->mQueue.front();
+        pPool->mQueue.pop_front();
+        pPool->RunTask(pTask);
+    }
+    pPool->Unlock();
+
+    return 0;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor, dtor
+///////////////////////////////////////////////////////////////////////////////
+cWorkerPool::cWorkerPool(int numThreads) : mpData(new cWorkerPool_i)
+{
+#if SUPPORTS_WORKER_THREADS
+    pthread_mutex_init(&mpData->mMutex, 0);
+    pthread_cond_init(&mpData->mWorkReady, 0);
+    pthread_cond_init(&mpData->mWorkDone, 0);
+    mpData->mbShutdown = false;
+
+    // the workers should never field signals meant for the main thread, so
+    // block everything while they are created; they inherit the mask.
+    sigset_t allSignals, oldSignals;
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_SETMASK, &allSignals, &oldSignals);
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, util_WorkerThread, mpData) != 0)
+        {
+            cDebug d("cWorkerPool::cWorkerPool");
+            d.TraceError("Only able to start %d of %d worker threads\n", i, numThreads);
+            break;
+        }
+        mpData->mThreads.push_back(thread);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &oldSignals, 0);
+#else
+    (void)numThreads;
+#endif
+}
+
+cWorkerPool::~cWorkerPool()
+{
+    WaitAll();
+
+#if SUPPORTS_WORKER_THREADS
+    mpData->Lock();
+    mpData->mbShutdown = true;
+    pthread_cond_broadcast(&mpData->mWorkReady);
+    mpData->Unlock();
+
+    for (std::vector<pthread_t>::iterator i = mpData->mThreads.begin(); i != mpData->mThreads.end(); ++i)
+        pthread_join(*i, 0);
+
+    pthread_cond_destroy(&mpData->mWorkDone);
+    pthread_cond_destroy(&mpData->mWorkReady);
+    pthread_mutex_destroy(&mpData->mMutex);
+#endif
+
+    delete mpData;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// GetNumThreads
+///////////////////////////////////////////////////////////////////////////////
+int cWorkerPool::GetNumThreads() const
+{
+#if SUPPORTS_WORKER_THREADS
+    return mpData->mThreads.size();
+#else
+    return 0;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Submit
+///////////////////////////////////////////////////////////////////////////////
+void cWorkerPool::Submit(iWorkerTask* pTask)
+{
+    ASSERT(pTask != 0);
+
+    mpData->Lock();
+    ASSERT(mpData->mOutstanding.find(pTask) == mpData->mOutstanding.end());
+    mpData->mOutstanding[pTask] = mpData->mQueue.insert(mpData->mQueue.end(), pTask);
+#if SUPPORTS_WORKER_THREADS
+    pthread_cond_signal(&mpData->mWorkReady);
+#endif
+    mpData->Unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Wait
+///////////////////////////////////////////////////////////////////////////////
+void cWorkerPool::Wait(iWorkerTask* pTask)
+{
+    mpData->Lock();
+
+    cWorkerPool_i::TaskMap::iterator i = mpData->mOutstanding.find(pTask);
+    if (i != mpData->mOutstanding.end() && i->second != mpData->mQueue.end())
+    {
+        // no one has gotten to it yet; rather than sit idle, run it here
+        mpData->mQueue.erase(i->second);
+        mpData->RunTask(pTask);
+    }
+
+    while (mpData->mOutstanding.find(pTask) != mpData->mOutstanding.end())
+        mpData->WaitForDone();
+
+    mpData->Unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WaitAll
+///////////////////////////////////////////////////////////////////////////////
+void cWorkerPool::WaitAll()
+{
+    mpData->Lock();
+
+    // help drain the queue, then wait for whatever is still running
+    while (!mpData->mQueue.empty())
+    {
+        iWorkerTask* pTask = mpData->mQueue.front();
+        mpData->mQueue.pop_front();
+        mpData->RunTask(pTask);
+    }
+
+    while (!mpData->mOutstanding.empty())
+        mpData->WaitForDone();
+
+    mpData->Unlock();
+}
@@ -0,0 +1,90 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// workerpool.h
+//
+// iWorkerTask -- a unit of work that can be handed to a cWorkerPool
+// cWorkerPool -- a fixed set of threads that runs iWorkerTasks
+#ifndef __WORKERPOOL_H
+#define __WORKERPOOL_H
+
+///////////////////////////////////////////////////////////////////////////////
+// iWorkerTask
+///////////////////////////////////////////////////////////////////////////////
+class iWorkerTask
+{
+public:
+    virtual void Run() = 0;
+    // does the work. This may be called on any thread, so implementations must
+    // not touch unsynchronized shared state (reference counts, the fco name
+    // table, error buckets, ...) and should not let exceptions escape.
+
+    virtual ~iWorkerTask()
+    {
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// cWorkerPool
+///////////////////////////////////////////////////////////////////////////////
+class cWorkerPool_i;
+
+class cWorkerPool
+{
+public:
+    explicit cWorkerPool(int numThreads);
+    // starts numThreads worker threads. If numThreads is less than one, or the
+    // platform has no thread support, no threads are started and each task is
+    // run on the calling thread when it is waited for.
+    ~cWorkerPool();
+    // waits for all outstanding tasks, then stops the threads
+
+    int GetNumThreads() const;
+
+    void Submit(iWorkerTask* pTask);
+    // queues a task to be run. The pool does not take ownership; the task must
+    // stay alive until Wait() or WaitAll() has returned for it.
+    void Wait(iWorkerTask* pTask);
+    // blocks until pTask has run. If no thread has picked it up yet, it is
+    // run on the calling thread instead.
+    void WaitAll();
+    // blocks until every submitted task has run
+
+private:
+    cWorkerPool(const cWorkerPool&);
+    void operator=(const cWorkerPool&);
+
+    cWorkerPool_i* mpData;
+};
+
+#endif //__WORKERPOOL_H
@@ -69,7 +69,7 @@ public:
     }
     int8* GetData()
     {
-        return mpData;
+        return mpMapped ? mpMapped : mpData;
     }
 
     bool AssertValid() const;
@@ -89,12 +89,13 @@ protected:
     uint8 mGuardMax[NUM_GUARD_BLOCKS];
     bool  mbDirty;
     int   mBlockNum;
+    int8* mpMapped; // where the block is in a mapped file, in which case mpData isn't used
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 // ctor
 ///////////////////////////////////////////////////////////////////////////////
-template<int SIZE> inline cBlock<SIZE>::cBlock() : mbDirty(false), mBlockNum(cBlock::INVALID_NUM)
+template<int SIZE> inline cBlock<SIZE>::cBlock() : mbDirty(false), mBlockNum(cBlock::INVALID_NUM), mpMapped(0)
 {
     // To prevent misaligned memory access, the size of the data and the
     // number of guard blocks must be a multiple of the byte alignment
@@ -135,7 +136,8 @@ template<int SIZE> inline bool cBlock<SIZE>::AssertValid() const
 
 template<int SIZE> inline bool cBlock<SIZE>::IsValidAddr(int8* pAddr) const
 {
-    return ((pAddr >= &mpData[0]) && (pAddr <= &mpData[SIZE - 1]));
+    const int8* pData = mpMapped ? mpMapped : mpData;
+    return ((pAddr >= &pData[0]) && (pAddr <= &pData[SIZE - 1]));
 }
 
 
@@ -160,6 +162,12 @@ public:
     {
         mTimestamp = timestamp;
     }
+    void SetMapping(int8* pMapped)
+    {
+        // changes to a mapped block are already in the file, so it is never dirty
+        cBlock<SIZE>::mpMapped = pMapped;
+        cBlock<SIZE>::mbDirty  = false;
+    }
     uint32 GetTimestamp() const
     {
         return mTimestamp;
@@ -185,9 +193,9 @@ template<int SIZE> inline cBlockImpl<SIZE>::cBlockImpl() : cBlock<SIZE>(), mTime
 template<int SIZE> inline void cBlockImpl<SIZE>::Write(cBidirArchive& arch) //throw( eArchive )
 {
     ASSERT(mbDirty);
-    ASSERT((mBlockNum >= 0) && (((mBlockNum + 1) * SIZE) <= arch.Length()));
+    ASSERT((mBlockNum >= 0) && ((((int64)mBlockNum + 1) * SIZE) <= arch.Length()));
 
-    arch.Seek((cBlock<SIZE>::mBlockNum * SIZE), cBidirArchive::BEGINNING);
+    arch.Seek(((int64)cBlock<SIZE>::mBlockNum * SIZE), cBidirArchive::BEGINNING);
     arch.WriteBlob(cBlock<SIZE>::mpData, SIZE);
 
     cBlock<SIZE>::mbDirty = false;
@@ -201,11 +209,11 @@ template<int SIZE> inline void cBlockImpl<SIZE>::Read(cBidirArchive& arch, int b
     if (blockNum != INVALID_NUM)
         cBlock<SIZE>::mBlockNum = blockNum;
 
-    ASSERT((mBlockNum >= 0) && (((mBlockNum + 1) * SIZE) <= arch.Length()));
+    ASSERT((mBlockNum >= 0) && ((((int64)mBlockNum + 1) * SIZE) <= arch.Length()));
 
     //    std::cout << "cBlockImpl<SIZE>::Read() mBlockNum = " << mBlockNum << " arch.Length() = " << arch.Length() << std::endl;
 
-    arch.Seek((cBlock<SIZE>::mBlockNum * SIZE), cBidirArchive::BEGINNING);
+    arch.Seek(((int64)cBlock<SIZE>::mBlockNum * SIZE), cBidirArchive::BEGINNING);
     arch.ReadBlob(cBlock<SIZE>::mpData, SIZE);
 
     cBlock<SIZE>::mbDirty = false;
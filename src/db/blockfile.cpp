@@ -44,6 +44,7 @@
 #include "core/archive.h"
 
 #include <vector>
+#include <algorithm>
 
 //-----------------------------------------------------------------------------
 // cBlockFile
@@ -52,16 +53,20 @@
 ///////////////////////////////////////////////////////////////////////////////
 // ctor
 ///////////////////////////////////////////////////////////////////////////////
-cBlockFile::cBlockFile() : mNumPages(-1), mNumBlocks(-1), mTimer(0), mpArchive(0)
+cBlockFile::cBlockFile()
+    : mNumPages(-1),
+      mNumBlocks(-1),
+      mTimer(0),
+      mpArchive(0),
+      mLruHead(-1),
+      mLruTail(-1),
+      mpMap(0),
+      mMapLen(0),
+      mNumBlockWrite(0),
+      mNumBlockRead(0),
+      mNumPageFault(0),
+      mNumPageRequests(0)
 {
-#ifdef _BLOCKFILE_DEBUG
-
-    mNumBlockWrite   = 0;
-    mNumBlockRead    = 0;
-    mNumPageFault    = 0;
-    mNumPageRequests = 0;
-
-#endif //_BLOCKFILE_DEBUG
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -72,12 +77,45 @@ cBlockFile::~cBlockFile()
     Close();
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// SetCacheSize / GetDefaultNumPages
+///////////////////////////////////////////////////////////////////////////////
+int64 cBlockFile::sCacheSize = 8 * 1024 * 1024;
+
+void cBlockFile::SetCacheSize(int64 nBytes)
+{
+    sCacheSize = nBytes;
+}
+
+#if SUPPORTS_MAPPED_DATABASE
+bool cBlockFile::sbUseMapping = true;
+#else
+bool cBlockFile::sbUseMapping = false;
+#endif
+
+void cBlockFile::SetUseMapping(bool bUseMapping)
+{
+    sbUseMapping = bUseMapping;
+}
+
+bool cBlockFile::GetUseMapping()
+{
+    return sbUseMapping;
+}
+
+int cBlockFile::GetDefaultNumPages()
+{
+    // the LRU list needs at least two pages to page one out while another is in use
+    int64 numPages = sCacheSize / BLOCK_SIZE;
+    return (int)std::max(std::min(numPages, (int64)TSS_INT32_MAX), (int64)2);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Open
 ///////////////////////////////////////////////////////////////////////////////
 void cBlockFile::Open(const TSTRING& fileName, int numPages, bool bTruncate) //throw (eArchive)
 {
-    ASSERT(numPages > 0);
+    ASSERT(numPages >= 0);
     ASSERT(!mpArchive);
 
     cFileArchive* pArch = new cFileArchive;
@@ -88,32 +126,85 @@ void cBlockFile::Open(const TSTRING& fileName, int numPages, bool bTruncate) //t
 
 void cBlockFile::Open(cBidirArchive* pArch, int numPages) //throw (eArchive)
 {
-    ASSERT(numPages > 0);
+    ASSERT(numPages >= 0);
     ASSERT(!mpArchive);
     //
     // keep my sanity...
     //
     pArch->Seek(0, cBidirArchive::BEGINNING);
-    //
-    // initialize the paged blocks list...
-    //
     mpArchive = pArch;
-    mNumPages = numPages;
-    mvPagedBlocks.resize(mNumPages);
-    ASSERT(mvPagedBlocks.capacity() == mNumPages); // make sure that we didn't alloc too many!
     //
     // if the file is newly created, set its size to that of a single block
     //
     if (mpArchive->Length() == 0)
     {
-        mpArchive->WriteBlob(mvPagedBlocks[0].GetData(), GetBlockSize());
+        BlockImpl emptyBlock;
+        mpArchive->WriteBlob(emptyBlock.GetData(), GetBlockSize());
     }
     //
     // make sure that the file is an appropriate length
     // TODO -- what is the correct thing to do if this fails? right now, I assert, but
     //      perhaps I should throw an exception or increase the file size to the next block interval
     ASSERT(mpArchive->Length() % GetBlockSize() == 0);
-    mNumBlocks = mpArchive->Length() / GetBlockSize();
+    mNumBlocks = (int)(mpArchive->Length() / GetBlockSize());
+    mvBlockPage.assign(mNumBlocks, -1);
+    //
+    // map it if we can; then the pages only say where the blocks are, so we don't need many
+    //
+    mpMap     = 0;
+    mMapLen   = 0;
+    mNumPages = (numPages > 0) ? numPages : GetDefaultNumPages();
+    if (sbUseMapping)
+    {
+        MapArchive();
+        if (mpMap)
+            mNumPages = std::min(mNumPages, (int)MAX_MAPPED_PAGES);
+    }
+    //
+    // initialize the paged blocks list; pages are added to it as they are first needed. Room is
+    // set aside for the blocks already in the file, since a small database never needs more;
+    // a Block* is only good until the next call into the block file, so growing past that is fine.
+    //
+    int numReserved = std::min(mNumPages, mNumBlocks);
+    mvPagedBlocks.clear();
+    mvPagedBlocks.reserve(numReserved);
+    mvPageLinks.clear();
+    mvPageLinks.reserve(numReserved);
+    mLruHead = mLruTail = -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// MapArchive
+///////////////////////////////////////////////////////////////////////////////
+void cBlockFile::MapArchive() //throw (eArchive)
+{
+    //
+    // the mapping grows by doubling, so the pages are seldom moved
+    //
+    int64 len    = mpArchive->Length();
+    int64 mapLen = mMapLen ? mMapLen : (1024 * 1024);
+    while (mapLen < len)
+        mapLen *= 2;
+
+    int8* pMap = mpArchive->MapShared(mapLen);
+    if (!pMap)
+    {
+        // not being able to map it at all is fine; we just page it like we used to
+        if (mpMap)
+            throw eArchiveMemmap();
+        return;
+    }
+
+    if (pMap != mpMap)
+    {
+        for (BlockVector::iterator i = mvPagedBlocks.begin(); i != mvPagedBlocks.end(); ++i)
+        {
+            if (i->GetBlockNum() != Block::INVALID_NUM)
+                i->SetMapping(pMap + (int64)i->GetBlockNum() * BLOCK_SIZE);
+        }
+    }
+    mpMap   = pMap;
+    mMapLen = mapLen;
 }
 
 
@@ -125,8 +216,23 @@ void cBlockFile::Close()
     if (mpArchive)
     {
         Flush();
-        delete mpArchive;
+        delete mpArchive; // which unmaps it, too
         mpArchive = 0;
+        mpMap     = 0;
+        mMapLen   = 0;
+
+        cDebug d("cBlockFile::Close");
+        d.TraceDetail("%d page requests, %d page faults, %d block reads, %d block writes, %d of %d pages used\n",
+                      mNumPageRequests,
+                      mNumPageFault,
+                      mNumBlockRead,
+                      mNumBlockWrite,
+                      (int)mvPagedBlocks.size(),
+                      mNumPages);
+
+        mvPagedBlocks.clear();
+        mvPageLinks.clear();
+        mvBlockPage.clear();
     }
 }
 
@@ -136,6 +242,12 @@ void cBlockFile::Close()
 void cBlockFile::Flush()
 {
     ASSERT(mpArchive);
+    if (mpMap)
+    {
+        mpArchive->SyncMap();
+        return;
+    }
+
     for (BlockVector::iterator i = mvPagedBlocks.begin(); i != mvPagedBlocks.end(); ++i)
     {
         FlushBlock(&(*i));
@@ -147,8 +259,8 @@ void cBlockFile::Flush()
 ///////////////////////////////////////////////////////////////////////////////
 cBlockFile::Block* cBlockFile::GetBlock(int blockNum) //throw (eArchive)
 {
-#ifdef _BLOCKFILE_DEBUG
     mNumPageRequests++;
+#ifdef _BLOCKFILE_DEBUG
     AssertValid();
 #endif
     //
@@ -163,6 +275,7 @@ cBlockFile::Block* cBlockFile::GetBlock(int blockNum) //throw (eArchive)
 
     //
     // first, increment the timer; if it flips, reset everybody's access times to 0.
+    // The timestamps are only kept for TraceContents(); the LRU list decides what gets paged out.
     //
     mTimer++;
     if (mTimer == 0)
@@ -175,57 +288,94 @@ cBlockFile::Block* cBlockFile::GetBlock(int blockNum) //throw (eArchive)
     //
     // now, see if the desired block is in memory...
     //
-    for (BlockVector::iterator i = mvPagedBlocks.begin(); i != mvPagedBlocks.end(); ++i)
+    int page = mvBlockPage[blockNum];
+    if (page >= 0)
     {
-        if (i->GetBlockNum() == blockNum)
-        {
-            // this is easy; just return the block.
-            i->SetTimestamp(mTimer);
-            d.TraceNever("\tBlock %d was in memory.\n", blockNum);
-            return &(*i);
-        }
+        // this is easy; just return the block.
+        mvPagedBlocks[page].SetTimestamp(mTimer);
+        TouchPage(page);
+        d.TraceNever("\tBlock %d was in memory.\n", blockNum);
+        return &mvPagedBlocks[page];
     }
     //
-    // ok, we are going to have to page it into memory; look for the page with the earliest timestamp to
-    // remove...
+    // ok, we are going to have to page it into memory; use a new page if we haven't used them
+    // all yet, or else the least recently used one.
     //
-#ifdef _BLOCKFILE_DEBUG
     mNumPageFault++;
-#endif
     d.TraceNever("\tBlock %d was not in memory; paging it in\n", blockNum);
 
-    uint32                earliestTime = mvPagedBlocks[0].GetTimestamp();
-    BlockVector::iterator it           = mvPagedBlocks.begin();
-    BlockVector::iterator earliestIter = it;
-    ++it; // since we don't want to check the first one
-    ASSERT(it != mvPagedBlocks.end());
-    for (; it != mvPagedBlocks.end(); ++it)
+    if ((int)mvPagedBlocks.size() < mNumPages)
     {
-        if (it->GetTimestamp() < earliestTime)
-        {
-            earliestIter = it;
-            earliestTime = it->GetTimestamp();
-        }
+        page = (int)mvPagedBlocks.size();
+        mvPagedBlocks.push_back(BlockImpl());
+        tPageLink link = {-1, -1};
+        mvPageLinks.push_back(link);
+    }
+    else
+    {
+        page = mLruTail;
+        ASSERT(page >= 0);
+        //
+        // flush the page data to disk if it is dirty...
+        //
+        BlockImpl& victim = mvPagedBlocks[page];
+        FlushBlock(&victim);
+        d.TraceNever("\tPaging out block %d\n", victim.GetBlockNum());
+        mvBlockPage[victim.GetBlockNum()] = -1;
     }
-    ASSERT((earliestIter >= mvPagedBlocks.begin()) && (earliestIter < mvPagedBlocks.end()));
-    //
-    // flush the page data to disk if it is dirty...
-    //
-    FlushBlock(&(*earliestIter));
-    d.TraceNever("\tPaging out block %d\n", earliestIter->GetBlockNum());
     //
     // ok, now we can read in the new page...
     //
-    earliestIter->SetBlockNum(blockNum);
-    earliestIter->Read(*mpArchive);
-    earliestIter->SetTimestamp(mTimer);
-    //
-    // this variable keeps track of how many block reads we do.
+    BlockImpl& block = mvPagedBlocks[page];
+    block.SetBlockNum(blockNum);
+    block.SetTimestamp(mTimer);
+    mvBlockPage[blockNum] = page;
+    TouchPage(page);
+    if (mpMap)
+    {
+        block.SetMapping(mpMap + (int64)blockNum * BLOCK_SIZE);
+    }
+    else
+    {
+        block.Read(*mpArchive);
+        //
+        // this variable keeps track of how many block reads we do.
+        mNumBlockRead++;
+    }
 #ifdef _BLOCKFILE_DEBUG
-    mNumBlockRead++;
     AssertValid();
 #endif
-    return &(*earliestIter);
+    return &block;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TouchPage
+///////////////////////////////////////////////////////////////////////////////
+void cBlockFile::TouchPage(int page)
+{
+    if (page == mLruHead)
+        return;
+
+    tPageLink& link = mvPageLinks[page];
+    //
+    // unlink it, if it is in the list...
+    //
+    if (link.mPrev >= 0)
+        mvPageLinks[link.mPrev].mNext = link.mNext;
+    if (link.mNext >= 0)
+        mvPageLinks[link.mNext].mPrev = link.mPrev;
+    if (page == mLruTail)
+        mLruTail = link.mPrev;
+    //
+    // ...and put it at the front
+    //
+    link.mPrev = -1;
+    link.mNext = mLruHead;
+    if (mLruHead >= 0)
+        mvPageLinks[mLruHead].mPrev = page;
+    mLruHead = page;
+    if (mLruTail < 0)
+        mLruTail = page;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -245,13 +395,16 @@ cBlockFile::Block* cBlockFile::CreateBlock()
     // write empty data in the new block's location
     //
     //ASSERT(GetNumBlocks() * GetBlockSize() <= mpArchive->Length());
-    d.TraceDetail("Seeking to %d * %d = %d\n", GetNumBlocks(), GetBlockSize(), GetNumBlocks() * GetBlockSize());
-    mpArchive->Seek(GetNumBlocks() * GetBlockSize(), cBidirArchive::BEGINNING);
+    d.TraceDetail("Seeking to %d * %d\n", GetNumBlocks(), GetBlockSize());
+    mpArchive->Seek((int64)GetNumBlocks() * GetBlockSize(), cBidirArchive::BEGINNING);
     mpArchive->WriteBlob(emptyBlock, BLOCK_SIZE);
     //
     // now, page it in...
     //
     mNumBlocks++;
+    mvBlockPage.push_back(-1);
+    if (mpMap)
+        MapArchive();
     return GetBlock(GetNumBlocks() - 1);
 }
 
@@ -298,6 +451,8 @@ void cBlockFile::TraceContents(int dl) const
     d.Trace(dl, "Number of page requests:%d\n", mNumPageRequests);
 
     d.Trace(dl, "Number of pages:        %d\n", mNumPages);
+    d.Trace(dl, "Number of pages used:   %d\n", (int)mvPagedBlocks.size());
+    d.Trace(dl, "Mapped:                 %s\n", mpMap ? "true" : "false");
     d.Trace(dl, "-------------------------\n");
     //
     // trace out all the block information...
@@ -326,7 +481,7 @@ void cBlockFile::AssertValid() const
         // make sure the archive length and block count match up
         //
 #    ifdef DEBUG
-    if (mpArchive->Length() != (GetBlockSize() * GetNumBlocks()))
+    if (mpArchive->Length() != ((int64)GetBlockSize() * GetNumBlocks()))
     {
         cDebug d("cBlockFile::AssertValid");
         d.Trace(cDebug::D_DEBUG, "FATAL ERROR!!!\n");
@@ -339,7 +494,7 @@ void cBlockFile::AssertValid() const
         TraceContents(cDebug::D_DEBUG);
     }
 #    endif
-    ASSERT(mpArchive->Length() == (GetBlockSize() * GetNumBlocks()));
+    ASSERT(mpArchive->Length() == ((int64)GetBlockSize() * GetNumBlocks()));
 
     //
     // iterate through the pages...
@@ -355,6 +510,10 @@ void cBlockFile::AssertValid() const
         //
         ASSERT(i->GetTimestamp() <= mTimer);
         //
+        // and that the index agrees about where it is
+        //
+        ASSERT((blockNum == cBlock<BLOCK_SIZE>::INVALID_NUM) || (mvBlockPage[blockNum] == (i - mvPagedBlocks.begin())));
+        //
         // assert that the guard bytes haven't been modified
         i->AssertValid();
     }
@@ -66,12 +66,18 @@ public:
     };
     typedef cBlock<BLOCK_SIZE> Block;
 
+    enum
+    {
+        MAX_MAPPED_PAGES = 64
+    };
+
     cBlockFile();
     ~cBlockFile();
 
     void Open(const TSTRING& fileName, int numPages, bool bTruncate = false); //throw (eArchive)
         // opens the given file name as a block file, and uses numPages to signify the
-        // number of pages to cache blocks in as they are accessed from disk.
+        // number of pages to cache blocks in as they are accessed from disk. If numPages
+        // is 0, the number of pages comes from SetCacheSize().
         // if bTruncate is true, then the file is created with zero length.
     void Open(cBidirArchive* pArch, int numPages); //throw (eArchive)
         // the same as the previous Open(), except the passed in archive is used. This class will destroy
@@ -107,6 +113,45 @@ public:
         return mpArchive;
     }
     // NOTE -- be _very_ careful with this archive. It should probably not be written to
+
+    static void SetCacheSize(int64 nBytes);
+    static int  GetDefaultNumPages();
+    // the memory to cache blocks in when Open() is passed 0 pages; the default is 8 MB.
+    // Pages are only allocated as they are needed, so small files don't use all of it.
+
+    static void SetUseMapping(bool bUseMapping);
+    static bool GetUseMapping();
+    bool        IsMapped() const
+    {
+        return mpMap != 0;
+    }
+    // if the archive can be mapped (see cBidirArchive::MapShared()), which is the default
+    // where the platform allows it, blocks are handed out straight from the mapping and the
+    // operating system's page cache takes the place of ours. Then only up to
+    // MAX_MAPPED_PAGES pages are used, and they hold where each block is rather than a copy.
+
+    int GetNumPages() const
+    {
+        return mNumPages;
+    }
+    int GetNumBlockWrites() const
+    {
+        return mNumBlockWrite;
+    }
+    int GetNumBlockReads() const
+    {
+        return mNumBlockRead;
+    }
+    int GetNumPageFaults() const
+    {
+        return mNumPageFault;
+    }
+    int GetNumPageRequests() const
+    {
+        return mNumPageRequests;
+    }
+    // how well the cache is doing, for sizing it
+
 private:
     typedef cBlockImpl<BLOCK_SIZE> BlockImpl;
     typedef std::vector<BlockImpl> BlockVector;
@@ -117,8 +162,36 @@ private:
     cBidirArchive* mpArchive;  // note: I always own the deletion of the archive
     BlockVector    mvPagedBlocks;
 
+    // the page each block is in, or -1, indexed by block number
+    std::vector<int> mvBlockPage;
+    // the pages in least-recently-used order, as a list threaded through mvPageLinks;
+    // mLruHead is the page used most recently and mLruTail is the next to be paged out
+    struct tPageLink
+    {
+        int mPrev;
+        int mNext;
+    };
+    std::vector<tPageLink> mvPageLinks;
+    int                    mLruHead;
+    int                    mLruTail;
+
+    int8* mpMap;   // the archive's contents, if it is mapped
+    int64 mMapLen; // the length of that mapping, which is more than the archive's
+
+    int mNumBlockWrite;   // counts how many writes we have done
+    int mNumBlockRead;    // counts how many reads we have done
+    int mNumPageFault;    // number of times a page fault occured
+    int mNumPageRequests; // number of page requests (useful to compare with mNumPageFault)
+
+    static int64 sCacheSize;
+    static bool  sbUseMapping;
+
     void FlushBlock(BlockImpl* pBlock); //throw (eArchive)
                                         // helper function that writes a block to disk if it is dirty
+    void TouchPage(int page);
+    // moves the page to the head of the LRU list
+    void MapArchive(); //throw (eArchive)
+        // maps the archive, with room for it to grow, and points the pages at the new mapping
 
     ///////////////////////////////////////////////////////////////////////////
     // Profiling / Debugging interface
@@ -130,14 +203,6 @@ public:
     // dl is the debug level to trace it at; -1 means to use D_DEBUG
     void AssertValid() const;
     // ASSERTs as much as we can about the consistancy of our internal state.
-    int mNumBlockWrite;
-    // counts how many writes we have done
-    int mNumBlockRead;
-    // counts how many reads we have done
-    int mNumPageFault;
-    // number of times a page fault occured
-    int mNumPageRequests;
-    // number of page requests (useful to compare with mNumPageFault)
 
 #endif //_BLOCKFILE_DEBUG
 };
@@ -149,13 +214,12 @@ public:
 inline void cBlockFile::FlushBlock(cBlockFile::BlockImpl* pBlock) //throw (eArchive)
 {
 
-    if ((pBlock->GetBlockNum() != Block::INVALID_NUM) && pBlock->IsDirty())
+    // a mapped block was changed in place
+    if (!mpMap && (pBlock->GetBlockNum() != Block::INVALID_NUM) && pBlock->IsDirty())
     {
         // mNumBlockWrite keeps track of how many block writes we do
         //
-#ifdef _BLOCKFILE_DEBUG
         mNumBlockWrite++;
-#endif
 
         pBlock->Write(*mpArchive);
     }
@@ -37,6 +37,8 @@
 #include "blockrecordfile.h"
 #include "core/archive.h"
 
+#include <algorithm>
+
 ///////////////////////////////////////////////////////////////////////////////
 // util_InitBlockArray
 ///////////////////////////////////////////////////////////////////////////////
@@ -51,7 +53,7 @@ static inline void util_InitBlockArray(cBlockRecordArray& block)
 ///////////////////////////////////////////////////////////////////////////////
 // ctor
 ///////////////////////////////////////////////////////////////////////////////
-cBlockRecordFile::cBlockRecordFile() : mLastAddedTo(-1), mbOpen(false)
+cBlockRecordFile::cBlockRecordFile() : mLastAddedTo(-1), mbOpen(false), mNumSpaceLeaves(0), mbSpaceIndexed(false)
 {
 }
 
@@ -137,6 +139,9 @@ void cBlockRecordFile::Close() //throw (eArchive)
     mBlockFile.Close();
     mbOpen = false;
     mvBlocks.clear();
+    mvSpaceTree.clear();
+    mNumSpaceLeaves = 0;
+    mbSpaceIndexed  = false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -165,6 +170,7 @@ cBlockRecordFile::tAddr cBlockRecordFile::AddItem(int8* pData, int dataSize) //t
     // now, insert the data...
     //
     rtn.mIndex = mvBlocks[rtn.mBlockNum].AddItem(pData, dataSize, 1);
+    UpdateSpace(rtn.mBlockNum);
     //
     // update the last added to pointer and return the location...
     //
@@ -184,6 +190,7 @@ void cBlockRecordFile::RemoveItem(cBlockRecordFile::tAddr dataAddr) //throw (eAr
 #endif
 
     mvBlocks[dataAddr.mBlockNum].DeleteItem(dataAddr.mIndex);
+    UpdateSpace(dataAddr.mBlockNum);
     //
     // remove unneeded blocks at the end...
     //
@@ -274,19 +281,18 @@ int cBlockRecordFile::FindRoomForData(int32 dataSize) //throw (eArchive)
         }
     }
     //
-    // ok, I guess we will have to iterate through all the blocks...
+    // ok, find the first block with enough room...
     //
-    BlockArray::iterator it;
-    int                  cnt = 0;
-    for (it = mvBlocks.begin(); it != mvBlocks.end(); ++it, ++cnt)
+    if (!mbSpaceIndexed)
+        IndexSpace();
+
+    int cnt = FindSpace(dataSize);
+    if (cnt >= 0)
     {
-        util_InitBlockArray(*it);
-        if (it->GetAvailableSpace() >= dataSize)
-        {
-            d.TraceDetail("---Found room in block %d\n", cnt);
-            return cnt;
-        }
+        d.TraceDetail("---Found room in block %d\n", cnt);
+        return cnt;
     }
+    cnt = mvBlocks.size();
     //
     // if we got here, then we need to add a new block
     //
@@ -295,12 +301,79 @@ int cBlockRecordFile::FindRoomForData(int32 dataSize) //throw (eArchive)
     ASSERT((mBlockFile.GetNumBlocks() == (mvBlocks.size() + 1)) && (mvBlocks.size() == cnt));
     mvBlocks.push_back(cBlockRecordArray(&mBlockFile, cnt));
     mvBlocks.back().InitNewBlock();
+    UpdateSpace(cnt);
 
     ASSERT(mvBlocks.back().GetAvailableSpace() >= dataSize);
 
     return cnt;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// IndexSpace
+///////////////////////////////////////////////////////////////////////////////
+void cBlockRecordFile::IndexSpace() //throw (eArchive)
+{
+    cDebug d("cBlockRecordFile::IndexSpace");
+    d.TraceDetail("Indexing the space available in %d blocks\n", (int)mvBlocks.size());
+
+    mNumSpaceLeaves = 64;
+    while (mNumSpaceLeaves < (int)mvBlocks.size())
+        mNumSpaceLeaves *= 2;
+    mvSpaceTree.assign(mNumSpaceLeaves * 2, -1);
+
+    for (size_t i = 0; i < mvBlocks.size(); i++)
+    {
+        util_InitBlockArray(mvBlocks[i]);
+        mvSpaceTree[mNumSpaceLeaves + i] = mvBlocks[i].GetAvailableSpace();
+    }
+    for (int node = mNumSpaceLeaves - 1; node > 0; node--)
+        mvSpaceTree[node] = std::max(mvSpaceTree[node * 2], mvSpaceTree[node * 2 + 1]);
+
+    mbSpaceIndexed = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// UpdateSpace
+///////////////////////////////////////////////////////////////////////////////
+void cBlockRecordFile::UpdateSpace(int32 blockNum)
+{
+    if (!mbSpaceIndexed)
+        return;
+
+    if (blockNum >= mNumSpaceLeaves)
+    {
+        // out of room in the tree; build a bigger one
+        IndexSpace();
+        return;
+    }
+
+    int node          = mNumSpaceLeaves + blockNum;
+    mvSpaceTree[node] = mvBlocks[blockNum].GetAvailableSpace();
+    for (node /= 2; node > 0; node /= 2)
+        mvSpaceTree[node] = std::max(mvSpaceTree[node * 2], mvSpaceTree[node * 2 + 1]);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FindSpace
+///////////////////////////////////////////////////////////////////////////////
+int cBlockRecordFile::FindSpace(int32 dataSize) const
+{
+    ASSERT(mbSpaceIndexed);
+    if (mvSpaceTree[1] < dataSize)
+        return -1;
+    //
+    // go down the left-most branch that has room
+    //
+    int node = 1;
+    while (node < mNumSpaceLeaves)
+    {
+        node *= 2;
+        if (mvSpaceTree[node] < dataSize)
+            node++;
+    }
+    return node - mNumSpaceLeaves;
+}
+
 
 #ifdef _BLOCKFILE_DEBUG
 
@@ -324,6 +397,7 @@ void cBlockRecordFile::AssertValid() const
 {
     ASSERT((mLastAddedTo >= 0) && (mLastAddedTo < mvBlocks.size()));
     ASSERT(mvBlocks.size() == mBlockFile.GetNumBlocks());
+    ASSERT(!mbSpaceIndexed || ((int)mvBlocks.size() <= mNumSpaceLeaves));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
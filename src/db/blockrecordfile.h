@@ -135,6 +135,15 @@ private:
     cBlockFile mBlockFile;
     BlockArray mvBlocks;
 
+    // the space available in each block, kept as a tree where each node holds the most space
+    // available under it, so FindRoomForData() can find the first block with enough room
+    // without reading any of them. The leaves start at mvSpaceTree[mNumSpaceLeaves], and are -1
+    // for blocks that don't exist yet. It is built the first time it is needed, since an
+    // existing file's blocks all have to be read to build it.
+    std::vector<int32> mvSpaceTree;
+    int                mNumSpaceLeaves;
+    bool               mbSpaceIndexed;
+
     cBlockRecordFile(const cBlockRecordFile& rhs); //not impl
     void operator=(const cBlockRecordFile& rhs);   //not impl
 
@@ -144,6 +153,12 @@ private:
         // for storage in a block
     void OpenImpl(bool bTruncate); //throw (eArchive)
                                    // implementation of the Open() methods above; both end up calling this.
+    void IndexSpace(); //throw (eArchive)
+        // reads all the blocks that haven't been, and builds mvSpaceTree
+    void UpdateSpace(int32 blockNum);
+    // updates mvSpaceTree, if it has been built, with the block's available space
+    int FindSpace(int32 dataSize) const;
+    // returns the first block in mvSpaceTree with at least dataSize available, or -1
 
     //-------------------------------------------------------------------------
     // Profiling / Debugging Interface
@@ -289,6 +289,11 @@ void cHierDatabaseIter::LoadArrayAt(const cHierAddr& addr) //throw (eArchive, eH
         {
             util_ReadObject(mpDb, &mEntries.back(), curAddr);
         }
+        catch (eArchiveIntegrity&)
+        {
+            // the database has been tampered with, so none of it can be trusted
+            throw;
+        }
         catch (eError& e)
         {
             e.SetFatality(false);
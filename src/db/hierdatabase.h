@@ -82,9 +82,10 @@ public:
     // overrides from base class
     //
     virtual void
-                 Open(const TSTRING& fileName, int numPages = 5, bool bTruncate = false); //throw (eArchive, eHierDatabase)
-    virtual void Open(cBidirArchive* pArch, int numPages = 5); //throw (eArchive, eHierDatabase)
+                 Open(const TSTRING& fileName, int numPages = 0, bool bTruncate = false); //throw (eArchive, eHierDatabase)
+    virtual void Open(cBidirArchive* pArch, int numPages = 0); //throw (eArchive, eHierDatabase)
         // for the second Open(), this class owns the destruction of the archive
+        // numPages of 0 uses cBlockFile's cache size
         //TODO -- make numPages the last parameter
 
     bool IsCaseSensitive() const
@@ -60,6 +60,8 @@
 
 class iFCO;
 class cErrorBucket;
+class cWorkerPool;
+class cFCOPropVector;
 
 //=========================================================================
 // DECLARATION OF CLASSES
@@ -160,6 +162,21 @@ public:
     virtual void SetIterFlags(int i)  = 0;
     // any flags needed for iteration.
 
+    virtual void SetWorkerPool(cWorkerPool* pPool) = 0;
+    // the pool that directory reads may be spread across; null (the default) means
+    // everything is read on the calling thread. The pool is not owned by the iterator,
+    // and copies made with CreateCopy() share it.
+    virtual void Prefetch() = 0;
+    // a hint that the current object will be descended into later on. If there is
+    // a worker pool, the iterator may start reading the object's children in the
+    // background; Descend() then picks up the results, reporting any errors at that
+    // point just as if it had done the reading itself. Does nothing if !CanDescend().
+    virtual void SetLeafProps(const cFCOPropVector& v) = 0;
+    // the properties that are going to be calculated for objects that can't have children.
+    // If the iterator can tell that an object has none without looking it up, and none of
+    // these properties need it looked up either, it may skip that and fill in only the
+    // object's type. Until this is called, every property is assumed to be needed.
+
 
     //TODO - should the iterator have insertion or deletion methods?
     //      It seems to me that insertion is necessary for rapid database creation, but deletion is
@@ -82,6 +82,17 @@ public:
     virtual int  GetIterFlags() const;
     virtual void SetIterFlags(int i);
 
+    virtual void SetWorkerPool(cWorkerPool* pPool)
+    {
+    }
+    virtual void Prefetch()
+    {
+    }
+    virtual void SetLeafProps(const cFCOPropVector& v)
+    {
+    }
+    // by default everything is read inline; derived classes may do better
+
 
     //
     // must override this functions
@@ -40,6 +40,20 @@ class cFCOPropVector;
 class iFCOVisitor;
 class iFCOSet;
 class cErrorBucket;
+class cWorkerPool;
+
+///////////////////////////////////////////////////////////////////////////////
+// iFCOHashCache -- where a genre keeps the expensive properties of its fcos
+//      from one run to the next. A prop calc only ever uses the cache of its
+//      own genre, so there is nothing here for anyone else to call.
+///////////////////////////////////////////////////////////////////////////////
+class iFCOHashCache
+{
+public:
+    virtual ~iFCOHashCache()
+    {
+    }
+};
 
 // cErrorBucket error numbers...
 /*  // the prop calculator owns all error numbers from 200-299
@@ -85,13 +99,40 @@ public:
     enum CalcFlags
     {
         DO_NOT_MODIFY_PROPERTIES = 0x00000001, // reset any properties that may have been altered due to measurement
-        DIRECT_IO                = 0x00000002  // use direct i/o when scanning files
+        DIRECT_IO                = 0x00000002, // use direct i/o when scanning files
+        DEFER_HASHES             = 0x00000004, // hand hashing off to the worker pool, if there is one
+        HASH_EVERY_LINK          = 0x00000008, // hash each hard link to a file, rather than the file once
+        KEEP_STAT                = 0x00000010  // leave the stat() result for the next visit to the same fco
     };
 
     virtual int  GetCalcFlags() const = 0;
     virtual void SetCalcFlags(int i)  = 0;
     // any calculation flags needed for calculation.
 
+    virtual void         SetWorkerPool(cWorkerPool* pPool) = 0;
+    virtual cWorkerPool* GetWorkerPool() const             = 0;
+    // the pool that deferred work is run on; null (the default) means everything
+    // is calculated inline. The pool is not owned by the calculator.
+    //
+    // An fco visited while DEFER_HASHES is set may have work left running in
+    // the pool when the visit returns. The next visit to that fco waits for the
+    // work and stores its results, adding any errors to the error bucket at that
+    // point; WaitForPending() does the same for every fco still outstanding.
+    virtual void WaitForPending() = 0;
+
+    virtual void SetHashCache(iFCOHashCache* pCache) = 0;
+    // if this is set, content properties are looked for in pCache before they are
+    // calculated, and stored in it after. pCache must belong to the calculator's
+    // genre, and is not owned by the calculator.
+
+    virtual const cFCOPropVector& GetContentProps() const = 0;
+    // the properties that are calculated from an fco's contents rather than its
+    // metadata (ie -- the expensive ones)
+    virtual const cFCOPropVector& GetQuickCheckProps() const = 0;
+    // metadata properties that, between them, change whenever an fco's contents
+    // do. If none of these differ from an earlier state of the fco, the content
+    // properties from that state may be used instead of being recalculated.
+
     virtual ~iFCOPropCalc()
     {
     }
@@ -0,0 +1,134 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+// fcoquickcheck.cpp
+//
+
+#include "stdfco.h"
+
+#include "fcoquickcheck.h"
+#include "fco.h"
+#include "fcocompare.h"
+#include "fconame.h"
+#include "fcopropcalc.h"
+#include "fcopropset.h"
+#include "fcospec.h"
+#include "fcoundefprop.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// cQuickCheck
+///////////////////////////////////////////////////////////////////////////////
+cQuickCheck::cQuickCheck() : mSampleRate(0), mSeed(0)
+{
+}
+
+void cQuickCheck::SetSampleRate(uint32 rate, uint32 seed)
+{
+    mSampleRate = rate;
+    mSeed       = seed;
+}
+
+bool cQuickCheck::IsSampled(const cFCOName& name) const
+{
+    if (mSampleRate == 0)
+        return false;
+
+    TSTRING str  = name.AsString();
+    uint32  hash = mSeed;
+    for (TSTRING::const_iterator i = str.begin(); i != str.end(); ++i)
+        hash = (hash * 31) + (unsigned char)*i;
+
+    return (hash % mSampleRate) == 0;
+}
+
+bool cQuickCheck::ReuseContentProps(const iFCO*     pOldFCO,
+                                    iFCO*           pNewFCO,
+                                    const iFCOSpec* pSpec,
+                                    iFCOPropCalc*   pCalc) const
+{
+    //
+    // figure out which of the content properties we could take from the old fco;
+    // there is no point in keeping an old value that couldn't be calculated.
+    //
+    const iFCOPropSet* pOldSet     = pOldFCO->GetPropSet();
+    cFCOPropVector     propsToCopy = pSpec->GetPropVector(pSpec->GetSpecMask(pNewFCO));
+    propsToCopy &= pCalc->GetContentProps();
+    propsToCopy &= pOldSet->GetValidVector();
+
+    bool bAny = false;
+    for (int i = 0; i < propsToCopy.GetSize(); i++)
+    {
+        if (!propsToCopy.ContainsItem(i))
+            continue;
+
+        if (pOldSet->GetPropAt(i)->GetType() == cFCOUndefinedProp::GetInstance()->GetType())
+            propsToCopy.RemoveItem(i);
+        else
+            bAny = true;
+    }
+
+    if (!bAny || IsSampled(pNewFCO->GetName()))
+        return false;
+
+    //
+    // bring the new fco's metadata up to date and see if anything has changed.
+    // Everything else the spec asks for is calculated now, so only the content
+    // properties are left for the visit after this, and that visit gets to use
+    // the same stat().
+    //
+    const cFCOPropVector& contentProps = pCalc->GetContentProps();
+    cFCOPropVector        propsToCheck = pSpec->GetPropVector(pSpec->GetSpecMask(pNewFCO));
+    propsToCheck |= pCalc->GetQuickCheckProps();
+    propsToCheck |= contentProps;
+    propsToCheck ^= contentProps;
+
+    cFCOPropVector propsToCalc = pCalc->GetPropVector();
+    int            calcFlags   = pCalc->GetCalcFlags();
+    pCalc->SetPropVector(propsToCheck);
+    pCalc->SetCalcFlags(calcFlags | iFCOPropCalc::KEEP_STAT);
+    pNewFCO->AcceptVisitor(pCalc->GetVisitor());
+    pCalc->SetCalcFlags(calcFlags);
+    pCalc->SetPropVector(propsToCalc);
+
+    // the quick check properties have to match; so does anything else the spec
+    // asks for that could be calculated for the new fco
+    cFCOPropVector propsToCompare = pNewFCO->GetPropSet()->GetValidVector();
+    propsToCompare &= propsToCheck;
+    propsToCompare |= pCalc->GetQuickCheckProps();
+
+    cFCOCompare compare(propsToCompare);
+    if (compare.Compare(pOldFCO, pNewFCO) != cFCOCompare::EQUAL)
+        return false;
+
+    pNewFCO->GetPropSet()->CopyProps(pOldSet, propsToCopy);
+    return true;
+}
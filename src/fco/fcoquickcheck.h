@@ -0,0 +1,73 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+// fcoquickcheck.h
+//
+#ifndef __FCOQUICKCHECK_H
+#define __FCOQUICKCHECK_H
+
+class iFCO;
+class iFCOSpec;
+class iFCOPropCalc;
+class cFCOName;
+
+///////////////////////////////////////////////////////////////////////////////
+// cQuickCheck -- lets an integrity check skip recalculating an fco's content
+//      properties (its hashes, for files) when its metadata shows that it
+//      hasn't changed since the database was made. The property calculator
+//      decides what counts as content and what counts as metadata.
+///////////////////////////////////////////////////////////////////////////////
+class cQuickCheck
+{
+public:
+    cQuickCheck();
+
+    void SetSampleRate(uint32 rate, uint32 seed);
+    // if rate is not zero, about one in every rate unchanged fcos has its content
+    // properties recalculated anyway. Which ones is decided by the fco name and
+    // the seed, so a different seed on every run covers everything over time.
+
+    bool ReuseContentProps(const iFCO* pOldFCO, iFCO* pNewFCO, const iFCOSpec* pSpec, iFCOPropCalc* pCalc) const;
+    // calculates pNewFCO's quick check properties and the other non-content
+    // properties that pSpec asks for and, if they all match pOldFCO's, copies the
+    // content properties that pSpec asks for from pOldFCO to pNewFCO. The
+    // calculator leaves valid properties alone, so they are not recalculated after
+    // this. Returns true if anything was copied.
+
+private:
+    bool IsSampled(const cFCOName& name) const;
+
+    uint32 mSampleRate;
+    uint32 mSeed;
+};
+
+#endif //__FCOQUICKCHECK_H
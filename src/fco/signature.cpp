@@ -42,6 +42,10 @@
 #include "fcoundefprop.h"
 #include "core/archive.h"
 #include "core/debug.h"
+#include "core/workerpool.h"
+#include "core/tw_signal.h"
+#include <stdlib.h>
+#include <algorithm>
 #ifndef HAVE_OPENSSL_MD5_H
 #    ifdef HAVE_STRINGS_H
 #        include <strings.h> /* for bcopy(), this is only needed for Solaris */
@@ -97,44 +101,728 @@ iFCOProp::CmpResult iSignature::Compare(const iFCOProp* rhs, Op op) const
         return (op == iFCOProp::OP_NE) ? iFCOProp::CMP_TRUE : iFCOProp::CMP_FALSE;
 }
 
-bool cArchiveSigGen::s_hex    = false;
-bool cArchiveSigGen::s_direct = false;
+iSignature* iSignature::CreateRange(int64 offset) const
+{
+    // only signatures with a range alignment can be hashed in pieces
+    (void)offset;
+    ASSERT(false);
+    return 0;
+}
+
+void iSignature::AddRange(const iSignature& range)
+{
+    (void)range;
+    ASSERT(false);
+}
+
+// what holes are hashed from, a block at a time
+static const byte s_zeros[iSignature::SUGGESTED_BLOCK_SIZE * 16] = {0};
+
+void iSignature::UpdateZeros(int64 count)
+{
+    while (count > 0)
+    {
+        int cb = (count > (int64)sizeof(s_zeros)) ? (int)sizeof(s_zeros) : static_cast<int>(count);
+        Update(s_zeros, cb);
+        count -= cb;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cSigReadBuffer -- an uninitialized block of memory to read into, aligned
+//      well enough for direct i/o
+///////////////////////////////////////////////////////////////////////////////
+class cSigReadBuffer
+{
+public:
+    explicit cSigReadBuffer(int size) : mpAlloc(0), mpBuf(0), mSize(size)
+    {
+    }
+    ~cSigReadBuffer()
+    {
+        free(mpAlloc);
+    }
+
+    byte* Get()
+    {
+        if (!mpBuf)
+        {
+            mpAlloc = static_cast<byte*>(malloc(mSize + iSignature::SUGGESTED_BLOCK_SIZE));
+            if (!mpAlloc)
+                throw std::bad_alloc();
+
+            unsigned long mod = (unsigned long)mpAlloc % iSignature::SUGGESTED_BLOCK_SIZE;
+            mpBuf             = mpAlloc + (iSignature::SUGGESTED_BLOCK_SIZE - mod);
+        }
+        return mpBuf;
+    }
+
+private:
+    cSigReadBuffer(const cSigReadBuffer&);
+    cSigReadBuffer& operator=(const cSigReadBuffer&);
+
+    byte* mpAlloc;
+    byte* mpBuf;
+    int   mSize;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// cSigReadTask -- reads the next block of an archive on a worker thread,
+//      holding on to any error until the hashing thread picks up the result
+///////////////////////////////////////////////////////////////////////////////
+class cSigReadTask : public iWorkerTask
+{
+public:
+    cSigReadTask(cArchive& a, const TSTRING& name)
+        : mArch(a), mName(name), mpBuf(0), mSize(0), mcbRead(0), mbError(false)
+    {
+    }
+
+    void SetBuffer(byte* pBuf, int size)
+    {
+        mpBuf   = pBuf;
+        mSize   = size;
+        mcbRead = 0;
+        mbError = false;
+    }
+
+    virtual void Run()
+    {
+        try
+        {
+            mcbRead = mArch.ReadBlob(mpBuf, mSize);
+        }
+        catch (eError& e)
+        {
+            mError  = e;
+            mbError = true;
+        }
+        catch (std::exception& e)
+        {
+            mError  = eArchiveRead(mName, e.what());
+            mbError = true;
+        }
+        catch (...)
+        {
+            mError  = eArchiveRead(mName, _T("unknown"));
+            mbError = true;
+        }
+    }
+
+    int GetResult() const
+    {
+        if (mbError)
+            throw mError;
+        return mcbRead;
+    }
+
+private:
+    cArchive& mArch;
+    TSTRING   mName; // of the archive, for errors that don't say which file they were in
+    byte*     mpBuf;
+    int       mSize;
+    int       mcbRead;
+    bool      mbError;
+    ePoly     mError;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// cSigUpdateTask -- updates one signature with one buffer on a hasher thread
+///////////////////////////////////////////////////////////////////////////////
+class cSigUpdateTask : public iWorkerTask
+{
+public:
+    explicit cSigUpdateTask(iSignature* pSig) : mpSig(pSig), mpBuf(0), mcbLen(0)
+    {
+    }
+
+    void SetBuffer(const byte* pBuf, int cbLen)
+    {
+        mpBuf  = pBuf;
+        mcbLen = cbLen;
+    }
+
+    virtual void Run()
+    {
+        mpSig->Update(mpBuf, mcbLen);
+    }
+
+private:
+    iSignature* mpSig;
+    const byte* mpBuf;
+    int         mcbLen;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// cSigUpdater -- hands each block to every signature, either one after the
+//      other or, if asked to, at the same time on the hashing threads. The
+//      first signature is always updated on the calling thread, and any other
+//      one no thread has got to by then is too, so nothing waits for nothing.
+///////////////////////////////////////////////////////////////////////////////
+class cSigUpdater
+{
+public:
+    cSigUpdater(const std::vector<iSignature*>& sigs, bool bParallel) : mSigs(sigs), mpPool(0)
+    {
+        if (bParallel && mSigs.size() > 1)
+        {
+            for (size_t i = 1; i < mSigs.size(); i++)
+                mTasks.push_back(new cSigUpdateTask(mSigs[i]));
+            mpPool = &cArchiveSigGen::GetWorkerPool();
+        }
+    }
+
+    ~cSigUpdater()
+    {
+        // Update() may have thrown before waiting for its tasks, so do that first
+        for (size_t i = 0; i < mTasks.size(); i++)
+        {
+            mpPool->Wait(mTasks[i]);
+            delete mTasks[i];
+        }
+    }
+
+    void Update(const byte* pBuf, int cbLen)
+    {
+        if (!mpPool)
+        {
+            for (size_t i = 0; i < mSigs.size(); i++)
+                mSigs[i]->Update(pBuf, cbLen);
+            return;
+        }
+
+        size_t i;
+        for (i = 0; i < mTasks.size(); i++)
+        {
+            mTasks[i]->SetBuffer(pBuf, cbLen);
+            mpPool->Submit(mTasks[i]);
+        }
+
+        mSigs[0]->Update(pBuf, cbLen);
+
+        // pBuf is reused once we return, so every signature has to be done with it
+        for (i = 0; i < mTasks.size(); i++)
+            mpPool->Wait(mTasks[i]);
+    }
+
+private:
+    cSigUpdater(const cSigUpdater&);
+    cSigUpdater& operator=(const cSigUpdater&);
+
+    const std::vector<iSignature*>& mSigs;
+    std::vector<cSigUpdateTask*>    mTasks;
+    cWorkerPool*                    mpPool;
+};
+
+bool  cArchiveSigGen::s_hex          = false;
+bool  cArchiveSigGen::s_direct       = false;
+int   cArchiveSigGen::s_readSize     = cArchiveSigGen::DEFAULT_READ_SIZE;
+bool  cArchiveSigGen::s_readAhead    = true;
+bool  cArchiveSigGen::s_parallelSigs = false;
+int64 cArchiveSigGen::s_mapThreshold = 0;
+int64 cArchiveSigGen::s_splitThreshold = 0;
+int   cArchiveSigGen::s_hashThreads    = 1;
+bool  cArchiveSigGen::s_skipHoles      = true;
 
 void cArchiveSigGen::AddSig(iSignature* pSig)
 {
     mSigList.push_back(pSig);
 }
 
-void cArchiveSigGen::CalculateSignatures(cArchive& a)
+void cArchiveSigGen::SetReadSize(int size)
 {
-    byte                      abBuf[iSignature::SUGGESTED_BLOCK_SIZE * 2];
-    int                       cbRead;
+    if (size < iSignature::SUGGESTED_BLOCK_SIZE)
+        size = iSignature::SUGGESTED_BLOCK_SIZE;
+    if (size > MAX_READ_SIZE)
+        size = MAX_READ_SIZE;
+
+    s_readSize = (size + iSignature::SUGGESTED_BLOCK_SIZE - 1) & ~(iSignature::SUGGESTED_BLOCK_SIZE - 1);
+}
+
+void cArchiveSigGen::CalculateSignatures(cArchive& a, const TSTRING& name)
+{
+    const int                 readSize = s_readSize;
+    cSigReadBuffer            buf0(readSize), buf1(readSize);
     container_type::size_type i;
-    byte*                     pBuf = abBuf;
 
-    if (s_direct)
+    // init hash
+    for (i = 0; i < mSigList.size(); i++)
+        mSigList[i]->Init();
+
+    // hash data
+    byte* pBuf   = buf0.Get();
+    int   cbRead = a.ReadBlob(pBuf, readSize);
+
+    // only worth starting hasher threads if there is more than one block, and
+    // there are none at all if we are only to hash on one
+    const bool  bThreads = cbRead == readSize && GetHashThreads() > 1;
+    cSigUpdater updater(mSigList, bThreads && s_parallelSigs);
+
+    if (bThreads && s_readAhead)
     {
-        unsigned long mod    = (unsigned long)abBuf % iSignature::SUGGESTED_BLOCK_SIZE;
-        unsigned long offset = (iSignature::SUGGESTED_BLOCK_SIZE - mod);
-        pBuf                 = abBuf + offset;
+        //
+        // there is more to come, so read each block while the one before it is
+        // being hashed. If Update() throws, the read still has to be waited for
+        // before the task and the buffer go away.
+        //
+        cSigReadTask task(a, name);
+        cWorkerPool& reader = GetWorkerPool();
+        byte*        pNext  = buf1.Get();
+
+        while (cbRead == readSize)
+        {
+            task.SetBuffer(pNext, readSize);
+            reader.Submit(&task);
+
+            try
+            {
+                updater.Update(pBuf, cbRead);
+            }
+            catch (...)
+            {
+                reader.Wait(&task);
+                throw;
+            }
+
+            reader.Wait(&task);
+            cbRead = task.GetResult();
+            std::swap(pBuf, pNext);
+        }
+        updater.Update(pBuf, cbRead);
+    }
+    else
+    {
+        updater.Update(pBuf, cbRead);
+        while (cbRead == readSize)
+        {
+            cbRead = a.ReadBlob(pBuf, readSize);
+            updater.Update(pBuf, cbRead);
+        }
     }
 
-    // init hash
+    // finalize hash
+    for (i = 0; i < mSigList.size(); i++)
+        mSigList[i]->Finit();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cSigMapTask -- updates some signatures with all of a mapped file, a read's
+//      worth at a time, since the signatures take an int length. A SIGBUS
+//      from the file shrinking is caught on whichever thread this runs on.
+///////////////////////////////////////////////////////////////////////////////
+class cSigMapTask : public iWorkerTask
+{
+public:
+    cSigMapTask(iSignature* const* ppSigs, size_t numSigs, const byte* pData, int64 len)
+        : mppSigs(ppSigs), mNumSigs(numSigs), mpData(pData), mLen(len), mbOK(false)
+    {
+    }
+
+    virtual void Run()
+    {
+        mbOK = tw_CatchBusError(UpdateSigs, this);
+    }
+
+    bool OK() const
+    {
+        return mbOK;
+    }
+
+private:
+    static void UpdateSigs(void* pArg)
+    {
+        cSigMapTask* pTask    = static_cast<cSigMapTask*>(pArg);
+        const int    readSize = cArchiveSigGen::GetReadSize();
+
+        const byte* pData = pTask->mpData;
+        int64       len   = pTask->mLen;
+        while (len > 0)
+        {
+            int cbLen = (len > readSize) ? readSize : static_cast<int>(len);
+            for (size_t i = 0; i < pTask->mNumSigs; i++)
+                pTask->mppSigs[i]->Update(pData, cbLen);
+            pData += cbLen;
+            len -= cbLen;
+        }
+    }
+
+    iSignature* const* mppSigs;
+    size_t             mNumSigs;
+    const byte*        mpData;
+    int64              mLen;
+    bool               mbOK;
+};
+
+bool cArchiveSigGen::CalculateSignatures(const byte* pData, int64 len)
+{
+    container_type::size_type i;
+    bool                      bOK = true;
+
     for (i = 0; i < mSigList.size(); i++)
         mSigList[i]->Init();
 
-    // hash data
+    if (s_parallelSigs && mSigList.size() > 1 && len > s_readSize && GetHashThreads() > 1)
+    {
+        // the whole file is there already, so each signature can go through it on its own
+        std::vector<cSigMapTask*> tasks;
+        for (i = 0; i < mSigList.size(); i++)
+            tasks.push_back(new cSigMapTask(&mSigList[i], 1, pData, len));
+        {
+            // other files may be using the pool too, so only our own tasks are waited for
+            cWorkerPool& hashers = GetWorkerPool();
+            for (i = 1; i < tasks.size(); i++)
+                hashers.Submit(tasks[i]);
+            tasks[0]->Run();
+            for (i = 1; i < tasks.size(); i++)
+                hashers.Wait(tasks[i]);
+        }
+        for (i = 0; i < tasks.size(); i++)
+        {
+            bOK = bOK && tasks[i]->OK();
+            delete tasks[i];
+        }
+    }
+    else if (!mSigList.empty())
+    {
+        cSigMapTask task(&mSigList[0], mSigList.size(), pData, len);
+        task.Run();
+        bOK = task.OK();
+    }
+
+    if (!bOK)
+        return false;
+
+    for (i = 0; i < mSigList.size(); i++)
+        mSigList[i]->Finit();
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_HashExtents -- updates sigs with len bytes of a from offset. If the
+//      file may have holes, only the parts that hold data are read, and the
+//      holes in between are handed over as zeros. Returns false if the file
+//      turned out to end sooner.
+///////////////////////////////////////////////////////////////////////////////
+static bool util_HashExtents(const cFileArchive&             a,
+                             int64                           offset,
+                             int64                           len,
+                             bool                            bHoles,
+                             const std::vector<iSignature*>& sigs,
+                             byte*                           pBuf,
+                             int                             readSize)
+{
+    const int64 end = offset + len;
+    while (offset < end)
+    {
+        int64 dataStart = offset, dataEnd = end;
+        if (bHoles && (!a.FindData(offset, dataStart, dataEnd) || dataStart > end))
+            dataStart = dataEnd = end;
+        if (dataEnd > end)
+            dataEnd = end;
+
+        if (dataStart > offset)
+        {
+            for (size_t i = 0; i < sigs.size(); i++)
+                sigs[i]->UpdateZeros(dataStart - offset);
+            offset = dataStart;
+        }
+
+        while (offset < dataEnd)
+        {
+            int cbWant = (dataEnd - offset > readSize) ? readSize : static_cast<int>(dataEnd - offset);
+            int cbRead = a.ReadAt(offset, pBuf, cbWant);
+            if (cbRead < cbWant)
+                return false;
+
+            for (size_t i = 0; i < sigs.size(); i++)
+                sigs[i]->Update(pBuf, cbRead);
+            offset += cbRead;
+        }
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cSigRangeTask -- reads one piece of a file at its own offset and hashes it
+//      for every signature, on whichever thread gets to it. Errors are held
+//      on to until the result is asked for, as cSigReadTask does.
+///////////////////////////////////////////////////////////////////////////////
+class cSigRangeTask : public iWorkerTask
+{
+public:
+    cSigRangeTask(const cFileArchive& a, const std::vector<iSignature*>& sigs, bool bHoles)
+        : mArch(a),
+          mName(a.GetCurrentFilename()),
+          mSigs(sigs),
+          mBuf(cArchiveSigGen::GetReadSize()),
+          mOffset(0),
+          mLen(0),
+          mbHoles(bHoles),
+          mbShort(false),
+          mbError(false)
+    {
+    }
+
+    ~cSigRangeTask()
+    {
+        Clear();
+    }
+
+    void SetRange(int64 offset, int64 len)
+    {
+        Clear();
+        for (size_t i = 0; i < mSigs.size(); i++)
+            mRanges.push_back(mSigs[i]->CreateRange(offset));
+        mOffset = offset;
+        mLen    = len;
+        mbShort = false;
+        mbError = false;
+    }
+
+    virtual void Run()
+    {
+        try
+        {
+            if (!util_HashExtents(mArch, mOffset, mLen, mbHoles, mRanges, mBuf.Get(), cArchiveSigGen::GetReadSize()))
+            {
+                mbShort = true;
+                return;
+            }
+
+            for (size_t i = 0; i < mRanges.size(); i++)
+                mRanges[i]->Finit();
+        }
+        catch (eError& e)
+        {
+            mError  = e;
+            mbError = true;
+        }
+        catch (std::exception& e)
+        {
+            mError  = eArchiveRead(mName, e.what());
+            mbError = true;
+        }
+        catch (...)
+        {
+            mError  = eArchiveRead(mName, _T("unknown"));
+            mbError = true;
+        }
+    }
+
+    // hands the finished piece to the signatures it was hashed for; false if the file was
+    // too short to fill it
+    bool AddTo()
+    {
+        if (mbError)
+            throw mError;
+        if (mbShort)
+            return false;
+
+        for (size_t i = 0; i < mSigs.size(); i++)
+            mSigs[i]->AddRange(*mRanges[i]);
+        return true;
+    }
+
+private:
+    cSigRangeTask(const cSigRangeTask&);
+    cSigRangeTask& operator=(const cSigRangeTask&);
+
+    void Clear()
+    {
+        for (size_t i = 0; i < mRanges.size(); i++)
+            delete mRanges[i];
+        mRanges.clear();
+    }
+
+    const cFileArchive&             mArch;
+    TSTRING                         mName; // taken once, rather than on a worker thread
+    const std::vector<iSignature*>& mSigs;
+    std::vector<iSignature*>        mRanges;
+    cSigReadBuffer                  mBuf;
+    int64                           mOffset;
+    int64                           mLen;
+    bool                            mbHoles; // whether the file may be sparse
+    bool                            mbShort;
+    bool                            mbError;
+    ePoly                           mError;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// cSigRangeHasher -- keeps a few pieces of a file going at once on the
+//      hashing threads, and takes them back in order
+///////////////////////////////////////////////////////////////////////////////
+class cSigRangeHasher
+{
+public:
+    cSigRangeHasher(const cFileArchive& a, const std::vector<iSignature*>& sigs, int numThreads, bool bHoles)
+        : mpPool(&cArchiveSigGen::GetWorkerPool())
+    {
+        // enough pieces for every thread, and one more to have ready
+        for (int i = 0; i <= numThreads; i++)
+            mTasks.push_back(new cSigRangeTask(a, sigs, bHoles));
+    }
+
+    ~cSigRangeHasher()
+    {
+        // Run() may have given up early, so wait for whatever is still running first
+        for (size_t i = 0; i < mTasks.size(); i++)
+            mpPool->Wait(mTasks[i]);
+        for (size_t i = 0; i < mTasks.size(); i++)
+            delete mTasks[i];
+    }
+
+    // hashes numRanges pieces of RANGE_SIZE bytes from the start of the file
+    bool Run(int64 numRanges)
+    {
+        const int64 numTasks = static_cast<int64>(mTasks.size());
+        int64       next;
+
+        for (next = 0; next < numRanges && next < numTasks; next++)
+        {
+            mTasks[next]->SetRange(next * cArchiveSigGen::RANGE_SIZE, cArchiveSigGen::RANGE_SIZE);
+            mpPool->Submit(mTasks[next]);
+        }
+
+        for (int64 r = 0; r < numRanges; r++)
+        {
+            cSigRangeTask* pTask = mTasks[r % numTasks];
+            mpPool->Wait(pTask);
+            if (!pTask->AddTo())
+                return false;
+
+            if (next < numRanges)
+            {
+                pTask->SetRange(next * cArchiveSigGen::RANGE_SIZE, cArchiveSigGen::RANGE_SIZE);
+                mpPool->Submit(pTask);
+                next++;
+            }
+        }
+        return true;
+    }
+
+private:
+    cSigRangeHasher(const cSigRangeHasher&);
+    cSigRangeHasher& operator=(const cSigRangeHasher&);
+
+    std::vector<cSigRangeTask*> mTasks;
+    cWorkerPool*                mpPool;
+};
+
+bool cArchiveSigGen::CanSplit() const
+{
+    if (mSigList.empty())
+        return false;
+
+    for (container_type::size_type i = 0; i < mSigList.size(); i++)
+    {
+        // a piece has to be a power of two number of the signature's smallest pieces
+        int64 align = mSigList[i]->GetRangeAlignment();
+        if (align <= 0 || RANGE_SIZE % align != 0)
+            return false;
+
+        int64 n = RANGE_SIZE / align;
+        if ((n & (n - 1)) != 0)
+            return false;
+    }
+    return true;
+}
+
+bool cArchiveSigGen::CalculateSignatures(const cFileArchive& a, int64 len)
+{
+    ASSERT(CanSplit());
+    container_type::size_type i;
+
+    for (i = 0; i < mSigList.size(); i++)
+        mSigList[i]->Init();
+
+    // the last piece could be the root of a tree, so it goes through Update() with
+    // whatever else is left; there's always some, since that isn't allowed to be empty
+    int64 numRanges = (len > 0) ? (len - 1) / RANGE_SIZE : 0;
+    if (numRanges > 0)
+    {
+        cSigRangeHasher hasher(a, mSigList, GetHashThreads(), HasHoles(a, len));
+        if (!hasher.Run(numRanges))
+            return false;
+    }
+
+    const int      readSize = s_readSize;
+    cSigReadBuffer buf(readSize);
+    byte*          pBuf   = buf.Get();
+    int64          offset = numRanges * RANGE_SIZE;
+    int            cbRead;
+
+    // read to the end, wherever that is now, as the other versions do
     do
     {
-        cbRead = a.ReadBlob(pBuf, iSignature::SUGGESTED_BLOCK_SIZE);
+        cbRead = a.ReadAt(offset, pBuf, readSize);
+        if (cbRead == 0 && offset == numRanges * RANGE_SIZE && numRanges > 0)
+            return false;
 
         for (i = 0; i < mSigList.size(); i++)
             mSigList[i]->Update(pBuf, cbRead);
-    } while (cbRead == iSignature::SUGGESTED_BLOCK_SIZE);
+        offset += cbRead;
+    } while (cbRead == readSize);
 
-    // finalize hash
     for (i = 0; i < mSigList.size(); i++)
         mSigList[i]->Finit();
+
+    return true;
+}
+
+bool cArchiveSigGen::HasHoles(const cFileArchive& a, int64 len)
+{
+    if (!s_skipHoles || len <= 0)
+        return false;
+
+    int64 dataStart, dataEnd;
+    if (!a.FindData(0, dataStart, dataEnd))
+        return true;
+    return dataStart > 0 || dataEnd < len;
+}
+
+bool cArchiveSigGen::CalculateSparseSignatures(const cFileArchive& a, int64 len)
+{
+    container_type::size_type i;
+
+    for (i = 0; i < mSigList.size(); i++)
+        mSigList[i]->Init();
+
+    const int      readSize = s_readSize;
+    cSigReadBuffer buf(readSize);
+    byte*          pBuf = buf.Get();
+
+    // a hole at the end doesn't read short if the file is cut back, so look again
+    if (!util_HashExtents(a, 0, len, true, mSigList, pBuf, readSize) || a.Length() < len)
+        return false;
+
+    // and read whatever has been added since, as the other versions do
+    int64 offset = len;
+    int   cbRead;
+    do
+    {
+        cbRead = a.ReadAt(offset, pBuf, readSize);
+        for (i = 0; i < mSigList.size(); i++)
+            mSigList[i]->Update(pBuf, cbRead);
+        offset += cbRead;
+    } while (cbRead == readSize);
+
+    for (i = 0; i < mSigList.size(); i++)
+        mSigList[i]->Finit();
+
+    return true;
+}
+
+int cArchiveSigGen::GetHashThreads()
+{
+    return (s_hashThreads > 1) ? s_hashThreads : 1;
+}
+
+cWorkerPool& cArchiveSigGen::GetWorkerPool()
+{
+    // started by whichever thread gets here first, and stopped at exit
+    static cWorkerPool pool(GetHashThreads());
+    return pool;
 }
 
 bool cArchiveSigGen::Hex()
@@ -404,6 +1092,11 @@ void cCRC32Signature::Update(const byte* const pbData, int cbDataLen)
     crcUpdate(mCRCInfo, (uint8*)pbData, cbDataLen);
 }
 
+void cCRC32Signature::UpdateZeros(int64 count)
+{
+    crcUpdateZeros(mCRCInfo, count);
+}
+
 void cCRC32Signature::Finit()
 {
     crcFinit(mCRCInfo);
@@ -901,3 +1594,265 @@ bool cHAVALSignature::IsEqual(const iSignature& rhs) const
         return (memcmp(mSignature, ((cHAVALSignature&)rhs).mSignature, SIG_BYTE_SIZE) == 0);
     }
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// class cDigestSignature -- base for signatures that are a fixed size digest
+///////////////////////////////////////////////////////////////////////////////
+
+cDigestSignature::cDigestSignature(int digestSize) : mDigestSize(digestSize)
+{
+    ASSERT(digestSize > 0 && digestSize <= MAX_DIGEST_SIZE);
+    memset(mDigest, 0, sizeof(mDigest));
+}
+
+cDigestSignature::~cDigestSignature()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// AsString -- Returns Base64 representation of mDigest in a TSTRING
+TSTRING cDigestSignature::AsString() const
+{
+    if (cArchiveSigGen::Hex())
+        return AsStringHex();
+
+    char buf[(MAX_DIGEST_SIZE * 8 + 5) / 6 + 1];
+    btob64((byte*)mDigest, buf, mDigestSize * 8);
+    return TSTRING(buf);
+}
+
+TSTRING cDigestSignature::AsStringHex() const
+{
+    static const TCHAR hexDigits[] = _T("0123456789abcdef");
+
+    TSTRING ret;
+    ret.reserve(mDigestSize * 2);
+    for (int i = 0; i < mDigestSize; ++i)
+    {
+        ret += hexDigits[mDigest[i] >> 4];
+        ret += hexDigits[mDigest[i] & 0xf];
+    }
+    return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Copy -- Copies the sig value using a base class pointer.
+void cDigestSignature::Copy(const iFCOProp* rhs)
+{
+    ASSERT(GetType() == rhs->GetType());
+    const cDigestSignature* pRhs = static_cast<const cDigestSignature*>(rhs);
+    ASSERT(mDigestSize == pRhs->mDigestSize);
+    memcpy(mDigest, pRhs->mDigest, mDigestSize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Serializer Implementation: Read and Write
+void cDigestSignature::Read(iSerializer* pSerializer, int32 version)
+{
+    if (version > Version())
+        ThrowAndAssert(eSerializerVersionMismatch(_T("Digest Read")));
+
+    pSerializer->ReadBlob(mDigest, mDigestSize);
+}
+
+void cDigestSignature::Write(iSerializer* pSerializer) const
+{
+    pSerializer->WriteBlob(mDigest, mDigestSize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Equal -- Tests for equality given a base pointer.
+bool cDigestSignature::IsEqual(const iSignature& rhs) const
+{
+    if (this == &rhs)
+        return true;
+
+    const cDigestSignature& digestRhs = static_cast<const cDigestSignature&>(rhs);
+    return (mDigestSize == digestRhs.mDigestSize && memcmp(mDigest, digestRhs.mDigest, mDigestSize) == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class cSHA256Signature -- A SHA-256 signature
+///////////////////////////////////////////////////////////////////////////////
+
+IMPLEMENT_TYPEDSERIALIZABLE(cSHA256Signature, _T("cSHA256Signature"), 0, 1)
+
+cSHA256Signature::cSHA256Signature() : cDigestSignature(32)
+{
+    memset(&mSHAInfo, 0, sizeof(mSHAInfo));
+}
+
+cSHA256Signature::~cSHA256Signature()
+{
+}
+
+void cSHA256Signature::Init()
+{
+#ifdef HAVE_COMMONCRYPTO_COMMONDIGEST_H
+    CC_SHA256_Init(&mSHAInfo);
+#elif HAVE_OPENSSL_SHA_H
+    SHA256_Init(&mSHAInfo);
+#else
+    sha256Init(&mSHAInfo);
+#endif
+}
+
+void cSHA256Signature::Update(const byte* const pbData, int cbDataLen)
+{
+#ifdef HAVE_COMMONCRYPTO_COMMONDIGEST_H
+    CC_SHA256_Update(&mSHAInfo, (uint8*)pbData, cbDataLen);
+#elif HAVE_OPENSSL_SHA_H
+    SHA256_Update(&mSHAInfo, (uint8*)pbData, cbDataLen);
+#else
+    sha256Update(&mSHAInfo, (uint8*)pbData, cbDataLen);
+#endif
+}
+
+void cSHA256Signature::Finit()
+{
+#ifdef HAVE_COMMONCRYPTO_COMMONDIGEST_H
+    CC_SHA256_Final(mDigest, &mSHAInfo);
+#elif HAVE_OPENSSL_SHA_H
+    SHA256_Final(mDigest, &mSHAInfo);
+#else
+    sha256Final(&mSHAInfo, mDigest);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class cSHA512Signature -- A SHA-512 signature
+///////////////////////////////////////////////////////////////////////////////
+
+IMPLEMENT_TYPEDSERIALIZABLE(cSHA512Signature, _T("cSHA512Signature"), 0, 1)
+
+cSHA512Signature::cSHA512Signature() : cDigestSignature(64)
+{
+    memset(&mSHAInfo, 0, sizeof(mSHAInfo));
+}
+
+cSHA512Signature::~cSHA512Signature()
+{
+}
+
+void cSHA512Signature::Init()
+{
+#ifdef HAVE_COMMONCRYPTO_COMMONDIGEST_H
+    CC_SHA512_Init(&mSHAInfo);
+#elif HAVE_OPENSSL_SHA_H
+    SHA512_Init(&mSHAInfo);
+#else
+    sha512Init(&mSHAInfo);
+#endif
+}
+
+void cSHA512Signature::Update(const byte* const pbData, int cbDataLen)
+{
+#ifdef HAVE_COMMONCRYPTO_COMMONDIGEST_H
+    CC_SHA512_Update(&mSHAInfo, (uint8*)pbData, cbDataLen);
+#elif HAVE_OPENSSL_SHA_H
+    SHA512_Update(&mSHAInfo, (uint8*)pbData, cbDataLen);
+#else
+    sha512Update(&mSHAInfo, (uint8*)pbData, cbDataLen);
+#endif
+}
+
+void cSHA512Signature::Finit()
+{
+#ifdef HAVE_COMMONCRYPTO_COMMONDIGEST_H
+    CC_SHA512_Final(mDigest, &mSHAInfo);
+#elif HAVE_OPENSSL_SHA_H
+    SHA512_Final(mDigest, &mSHAInfo);
+#else
+    sha512Final(&mSHAInfo, mDigest);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class cBLAKE2Signature -- A BLAKE2b-512 signature
+///////////////////////////////////////////////////////////////////////////////
+
+IMPLEMENT_TYPEDSERIALIZABLE(cBLAKE2Signature, _T("cBLAKE2Signature"), 0, 1)
+
+cBLAKE2Signature::cBLAKE2Signature() : cDigestSignature(BLAKE2B_DIGESTSIZE)
+{
+    memset(&mBlakeInfo, 0, sizeof(mBlakeInfo));
+}
+
+cBLAKE2Signature::~cBLAKE2Signature()
+{
+}
+
+void cBLAKE2Signature::Init()
+{
+    blake2bInit(&mBlakeInfo);
+}
+
+void cBLAKE2Signature::Update(const byte* const pbData, int cbDataLen)
+{
+    blake2bUpdate(&mBlakeInfo, (uint8*)pbData, cbDataLen);
+}
+
+void cBLAKE2Signature::Finit()
+{
+    blake2bFinal(&mBlakeInfo, mDigest);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class cBLAKE3Signature -- A BLAKE3 signature, 256 bits
+///////////////////////////////////////////////////////////////////////////////
+
+IMPLEMENT_TYPEDSERIALIZABLE(cBLAKE3Signature, _T("cBLAKE3Signature"), 0, 1)
+
+cBLAKE3Signature::cBLAKE3Signature() : cDigestSignature(BLAKE3_DIGESTSIZE), mbRange(false), mRangeStart(0)
+{
+    blake3Init(&mBlakeInfo);
+    memset(mRangeCV, 0, sizeof(mRangeCV));
+}
+
+cBLAKE3Signature::~cBLAKE3Signature()
+{
+}
+
+void cBLAKE3Signature::Init()
+{
+    mbRange = false;
+    blake3Init(&mBlakeInfo);
+}
+
+void cBLAKE3Signature::Update(const byte* const pbData, int cbDataLen)
+{
+    blake3Update(&mBlakeInfo, (uint8*)pbData, cbDataLen);
+}
+
+void cBLAKE3Signature::Finit()
+{
+    if (mbRange)
+        blake3FinalSubtree(&mBlakeInfo, mRangeCV);
+    else
+        blake3Final(&mBlakeInfo, mDigest);
+}
+
+int64 cBLAKE3Signature::GetRangeAlignment() const
+{
+    return BLAKE3_CHUNKSIZE;
+}
+
+iSignature* cBLAKE3Signature::CreateRange(int64 offset) const
+{
+    ASSERT(offset % BLAKE3_CHUNKSIZE == 0);
+
+    cBLAKE3Signature* pRange = new cBLAKE3Signature;
+    pRange->mbRange          = true;
+    pRange->mRangeStart      = offset / BLAKE3_CHUNKSIZE;
+    blake3InitAt(&pRange->mBlakeInfo, pRange->mRangeStart);
+    return pRange;
+}
+
+void cBLAKE3Signature::AddRange(const iSignature& range)
+{
+    ASSERT(range.GetType() == GetType());
+    const cBLAKE3Signature& rhs = static_cast<const cBLAKE3Signature&>(range);
+
+    ASSERT(rhs.mbRange && rhs.mRangeStart == mBlakeInfo.chunk.chunkCounter);
+    blake3AddSubtree(&mBlakeInfo, rhs.mRangeCV, rhs.mBlakeInfo.chunk.chunkCounter + 1 - rhs.mRangeStart);
+}
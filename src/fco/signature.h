@@ -71,6 +71,10 @@
 #    endif
 #endif
 
+#if !defined(HAVE_OPENSSL_SHA_H) && !defined(HAVE_COMMONCRYPTO_COMMONDIGEST_H)
+#include "core/sha2.h"
+#endif
+
 /*Use OSX CommonCrypto lib if available*/
 #ifdef HAVE_COMMONCRYPTO_COMMONDIGEST_H
 #include <CommonCrypto/CommonDigest.h>
@@ -78,6 +82,8 @@
 
 
 #include "core/haval.h"
+#include "core/blake2.h"
+#include "core/blake3.h"
 // TODO: figure out a way to do this without including these headers.
 // pool of objects?
 
@@ -111,11 +117,34 @@ public:
     virtual void Update(const byte* const pbData, int cbDataLen) = 0;
     // may be called multiple times -- best to call with blocks of size SUGGESTED_BLOCK_SIZE,
     // but can handle any size data.
+    virtual void UpdateZeros(int64 count);
+    // the same as Update() with count zero bytes, which is what a hole in a sparse file
+    // reads back as. By default they really are hashed; signatures that can skip over
+    // them more cheaply do.
     virtual void Finit() = 0;
     // call to finish hashing
 
     virtual TSTRING AsStringHex() const = 0;
 
+    //
+    // hashing a big input a piece at a time
+    //
+    virtual int64 GetRangeAlignment() const
+    {
+        return 0;
+    }
+    // signatures that are worked out from independently hashed pieces of their input,
+    // as tree hashes are, return the length of the smallest piece. Pieces have to be a
+    // power of two multiple of that, and start on a multiple of their own length.
+    // 0, the default, means the input has to go through Update() in one go.
+    virtual iSignature* CreateRange(int64 offset) const;
+    // returns a new signature of this kind, initialized to hash the piece of input that
+    // starts offset bytes in. Update() it with the piece and Finit() it, then pass it to
+    // AddRange(). Only allowed if GetRangeAlignment() isn't 0.
+    virtual void AddRange(const iSignature& range);
+    // takes in a finished piece in place of Update()ing this with its bytes. Everything
+    // before the piece must have gone in already, and there must be more after it.
+
     //
     // from iFCOProp
     //
@@ -141,22 +170,149 @@ protected:
 //      Stores a list of signatures (added by AddSig()), and when
 //      CalculateSignatures is called, makes ONE sweep through the archive,
 //      calculating hashes for all signatures in the list.
+//
+//      The archive is read GetReadSize() bytes at a time. If it turns out to
+//      be longer than that, read-ahead is on and there is more than one hash
+//      thread, the next block is read on another thread while the current one
+//      is being hashed. With parallel signatures on as well, each block is
+//      also handed to all the signatures at once, one thread apiece.
+//
+//      A regular file big enough to be split, all of whose signatures can be
+//      hashed in pieces (see iSignature::GetRangeAlignment()), is instead
+//      read in RANGE_SIZE pieces at their own offsets, and GetHashThreads()
+//      of the pieces are hashed at once.
+//
+//      The threads for all of this are the ones in GetWorkerPool(), which is
+//      shared by every file hashed in the process.
+//
+//      Either way, holes in a sparse regular file aren't read, since they are
+//      known to be zeros; see HasHoles().
 ///////////////////////////////////////////////////////////////////////////////
+class cFileArchive;
+class cWorkerPool;
+
 class cArchiveSigGen
 {
 public:
     cArchiveSigGen(){};
 
+    enum
+    {
+        DEFAULT_READ_SIZE = 0x40000,   // 256 KiB
+        MAX_READ_SIZE     = 0x4000000, // 64 MiB
+        RANGE_SIZE        = 0x1000000  // 16 MiB
+    };
+
     void AddSig(iSignature* pSig);
     // adds a signature to the list
 
-    void CalculateSignatures(cArchive& a);
+    void CalculateSignatures(cArchive& a, const TSTRING& name = _T(""));
     // produces signature of archive for all signatures in the list
-    // remember to rewind archive!
+    // remember to rewind archive! name is the archive's file name, for read
+    // errors that come back from another thread without one
+
+    bool CalculateSignatures(const byte* pData, int64 len);
+    // produces signature of len bytes at pData, normally a mapped file, for all
+    // signatures in the list. Returns false if touching the data raised SIGBUS,
+    // which is what happens when a mapped file is truncated while it is hashed;
+    // the signatures are of no use then.
+
+    static bool HasHoles(const cFileArchive& a, int64 len);
+    // whether the first len bytes of a have holes in them that don't need reading; never
+    // true with SkipHoles() off
+    bool CalculateSparseSignatures(const cFileArchive& a, int64 len);
+    // produces signature of the len byte file a for all signatures in the list, reading
+    // only the parts of it that aren't holes. Returns false if the file turned out to be
+    // shorter than len.
+
+    bool CanSplit() const;
+    // whether every signature in the list can be hashed RANGE_SIZE bytes at a time
+    bool CalculateSignatures(const cFileArchive& a, int64 len);
+    // produces signature of the len byte file a for all signatures in the list, which
+    // must be able to be split, reading and hashing its pieces at the same time. Returns
+    // false if the file turned out to be shorter than len, as the mapped version does.
 
     static bool Hex();
     static void SetHex(bool);
 
+    static int GetReadSize()
+    {
+        return s_readSize;
+    }
+    static void SetReadSize(int size);
+    // the number of bytes to read at a time. This is rounded up to a multiple of
+    // iSignature::SUGGESTED_BLOCK_SIZE, so that it works for direct i/o, and kept
+    // between that and MAX_READ_SIZE.
+
+    static bool ReadAhead()
+    {
+        return s_readAhead;
+    }
+    static void SetReadAhead(bool b)
+    {
+        s_readAhead = b;
+    }
+    // whether to read the next block while hashing the current one; true by default,
+    // though it is only done with more than one hash thread
+
+    static bool ParallelSigs()
+    {
+        return s_parallelSigs;
+    }
+    static void SetParallelSigs(bool b)
+    {
+        s_parallelSigs = b;
+    }
+    // whether to update each signature on a thread of its own, so a file takes
+    // as long as its slowest hash rather than all of them added up; false by default,
+    // and only done with more than one hash thread
+
+    static int64 GetMapThreshold()
+    {
+        return s_mapThreshold;
+    }
+    static void SetMapThreshold(int64 size)
+    {
+        s_mapThreshold = size;
+    }
+    // regular files at least this many bytes long are hashed through a read-only
+    // mapping rather than read into a buffer; 0, the default, means never
+
+    static int64 GetSplitThreshold()
+    {
+        return s_splitThreshold;
+    }
+    static void SetSplitThreshold(int64 size)
+    {
+        s_splitThreshold = size;
+    }
+    // regular files at least this many bytes long are hashed a piece at a time on several
+    // threads, if their signatures allow it; 0, the default, means never
+
+    static int  GetHashThreads();
+    static void SetHashThreads(int n)
+    {
+        s_hashThreads = n;
+    }
+    // how many threads to hash on, and how many pieces of a file to hash at once; 1,
+    // the default, means everything is hashed on the calling thread and no pool is
+    // started. GetWorkerPool() is started with this many threads the first time it
+    // is needed, so changes after that only affect the pieces.
+
+    static cWorkerPool& GetWorkerPool();
+    // the threads that read ahead, update parallel signatures and hash the pieces of
+    // split files, for every cArchiveSigGen in the process
+
+    static bool SkipHoles()
+    {
+        return s_skipHoles;
+    }
+    static void SetSkipHoles(bool b)
+    {
+        s_skipHoles = b;
+    }
+    // whether holes in sparse files are hashed as zeros without being read; true by default
+
     static bool UseDirectIO()
     {
         return s_direct;
@@ -176,6 +332,13 @@ private:
 
     static bool s_direct;
     static bool s_hex;
+    static int  s_readSize;
+    static bool  s_readAhead;
+    static bool  s_parallelSigs;
+    static int64 s_mapThreshold;
+    static int64 s_splitThreshold;
+    static int   s_hashThreads;
+    static bool  s_skipHoles;
 };
 
 
@@ -248,6 +411,7 @@ public:
 
     virtual void Init();
     virtual void Update(const byte* const pbData, int cbDataLen);
+    virtual void UpdateZeros(int64 count);
     virtual void Finit();
 
     virtual TSTRING AsString() const;
@@ -376,4 +540,130 @@ protected:
     uint8       mSignature[SIG_BYTE_SIZE];
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// class cDigestSignature -- base for signatures whose value is just a digest
+//      of some fixed number of bytes. Takes care of displaying, comparing,
+//      copying and serializing it, so a new hash only has to supply
+//      Init(), Update() and Finit(), the last of which fills in mDigest.
+///////////////////////////////////////////////////////////////////////////////
+class cDigestSignature : public iSignature
+{
+public:
+    explicit cDigestSignature(int digestSize);
+    virtual ~cDigestSignature();
+
+    virtual TSTRING AsString() const;
+    virtual TSTRING AsStringHex() const;
+    virtual void    Copy(const iFCOProp* rhs);
+
+    virtual void Read(iSerializer* pSerializer, int32 version = 0); // throw (eSerializer, eArchive)
+    virtual void Write(iSerializer* pSerializer) const;             // throw (eSerializer, eArchive)
+
+protected:
+    enum
+    {
+        MAX_DIGEST_SIZE = 64
+    };
+
+    virtual bool IsEqual(const iSignature& rhs) const;
+
+    int   mDigestSize;
+    uint8 mDigest[MAX_DIGEST_SIZE];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class cSHA256Signature -- A SHA-256 signature
+///////////////////////////////////////////////////////////////////////////////
+class cSHA256Signature : public cDigestSignature
+{
+    DECLARE_TYPEDSERIALIZABLE()
+
+public:
+    cSHA256Signature();
+    virtual ~cSHA256Signature();
+
+    virtual void Init();
+    virtual void Update(const byte* const pbData, int cbDataLen);
+    virtual void Finit();
+
+protected:
+#ifdef HAVE_COMMONCRYPTO_COMMONDIGEST_H
+    CC_SHA256_CTX mSHAInfo;
+#elif HAVE_OPENSSL_SHA_H
+    SHA256_CTX mSHAInfo;
+#else
+    SHA256_INFO mSHAInfo;
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class cSHA512Signature -- A SHA-512 signature
+///////////////////////////////////////////////////////////////////////////////
+class cSHA512Signature : public cDigestSignature
+{
+    DECLARE_TYPEDSERIALIZABLE()
+
+public:
+    cSHA512Signature();
+    virtual ~cSHA512Signature();
+
+    virtual void Init();
+    virtual void Update(const byte* const pbData, int cbDataLen);
+    virtual void Finit();
+
+protected:
+#ifdef HAVE_COMMONCRYPTO_COMMONDIGEST_H
+    CC_SHA512_CTX mSHAInfo;
+#elif HAVE_OPENSSL_SHA_H
+    SHA512_CTX mSHAInfo;
+#else
+    SHA512_INFO mSHAInfo;
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class cBLAKE2Signature -- A BLAKE2b-512 signature
+///////////////////////////////////////////////////////////////////////////////
+class cBLAKE2Signature : public cDigestSignature
+{
+    DECLARE_TYPEDSERIALIZABLE()
+
+public:
+    cBLAKE2Signature();
+    virtual ~cBLAKE2Signature();
+
+    virtual void Init();
+    virtual void Update(const byte* const pbData, int cbDataLen);
+    virtual void Finit();
+
+protected:
+    BLAKE2B_INFO mBlakeInfo;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class cBLAKE3Signature -- A BLAKE3 signature, 256 bits
+///////////////////////////////////////////////////////////////////////////////
+class cBLAKE3Signature : public cDigestSignature
+{
+    DECLARE_TYPEDSERIALIZABLE()
+
+public:
+    cBLAKE3Signature();
+    virtual ~cBLAKE3Signature();
+
+    virtual void Init();
+    virtual void Update(const byte* const pbData, int cbDataLen);
+    virtual void Finit();
+
+    virtual int64       GetRangeAlignment() const;
+    virtual iSignature* CreateRange(int64 offset) const;
+    virtual void        AddRange(const iSignature& range);
+
+protected:
+    BLAKE3_INFO mBlakeInfo;
+    bool        mbRange;     // hashing a piece of the input rather than all of it
+    uint64      mRangeStart; // the piece's first chunk
+    uint32      mRangeCV[8]; // and its chaining value, once finished
+};
+
 #endif // __SIGNATURE_H
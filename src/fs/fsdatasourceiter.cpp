@@ -45,16 +45,307 @@
 #include "core/errorbucket.h"
 #include "core/corestrings.h"
 #include "core/usernotify.h"
+#include "core/errorutil.h"
+#include "core/refcountobj.h"
+#include "core/workerpool.h"
+#include "core/archive.h"
 #include "fco/twfactory.h"
 #include "fco/fconametranslator.h"
 #include "fco/fconameinfo.h"
+#include "fco/signature.h"
 #include "fsstrings.h"
 
+//=========================================================================
+// UTIL FUNCTION PROTOTYPES
+//=========================================================================
+
+static void util_SetFileType(cFSPropSet& propSet, cFSStatArgs::FileType type);
+
+//=========================================================================
+// UTIL CLASSES
+//=========================================================================
+
+///////////////////////////////////////////////////////////////////////////////
+// cFSDirListing -- the names in one directory and the stat() results for each
+//      of them, read on a worker thread. Errors are held onto, so that the
+//      iterator can report them when it gets to the directory or object that
+//      caused them.
+//
+//      If the parent directory is known, it is held open until the listing is
+//      destroyed, and everything is looked up relative to it. Unless bStatLeaves
+//      is true, entries the directory says aren't directories are not stat()ed.
+///////////////////////////////////////////////////////////////////////////////
+class cFSDirListing : public iWorkerTask
+{
+public:
+    cFSDirListing(const TSTRING& strDir, cFSDirHandle* pParent, const TSTRING& strChild, bool bStatLeaves)
+        : mDir(strDir), mpParent(pParent), mChild(strChild), mbStatLeaves(bStatLeaves), mbReadDirError(false)
+    {
+        if (mpParent)
+            mpParent->Hold();
+    }
+
+    virtual ~cFSDirListing()
+    {
+        if (mpParent)
+            mpParent->Unhold();
+    }
+
+    virtual void Run();
+
+    struct Entry
+    {
+        Entry() : mType(cFSStatArgs::TY_INVALID), mbHaveStat(false), mbError(false)
+        {
+        }
+
+        cFSStatArgs           mStat;
+        cFSStatArgs::FileType mType; // what the directory said, if mStat wasn't filled in
+        bool                  mbHaveStat;
+        bool                  mbError;
+        ePoly                 mError;
+    };
+    typedef std::map<TSTRING, Entry> EntryMap; // by full path
+
+    TSTRING              mDir;
+    cFSDirHandle*        mpParent; // the directory mDir is in, or null
+    TSTRING              mChild;   // mDir's name in mpParent
+    bool                 mbStatLeaves;
+    std::vector<TSTRING> mNames;
+    bool                 mbReadDirError;
+    ePoly                mReadDirError;
+    EntryMap             mEntries;
+
+private:
+    void SetReadDirError(const eError& e);
+};
+
+void cFSDirListing::SetReadDirError(const eError& e)
+{
+    mReadDirError  = e;
+    mbReadDirError = true;
+}
+
+void cFSDirListing::Run()
+{
+    std::vector<cFSStatArgs::FileType> vTypes;
+    try
+    {
+        if (mpParent)
+            iFSServices::GetInstance()->ReadDir(*mpParent, mNames, vTypes, mChild);
+        else
+            iFSServices::GetInstance()->ReadDir(mDir, mNames, false);
+    }
+    catch (eError& e)
+    {
+        SetReadDirError(eFSDataSourceIterReadDir(mDir, e.GetMsg(), eError::NON_FATAL));
+    }
+    catch (std::exception& e)
+    {
+        SetReadDirError(eFSDataSourceIterReadDir(mDir, e.what(), eError::NON_FATAL));
+    }
+    catch (...)
+    {
+        SetReadDirError(eFSDataSourceIterReadDir(mDir, "unknown", eError::NON_FATAL));
+    }
+
+    // build the names the same way cFCOName::AsString() does, so the iterator
+    // can find them again
+    TSTRING strPrefix = mDir;
+    if (strPrefix.empty() || strPrefix[strPrefix.length() - 1] != _T('/'))
+        strPrefix += _T('/');
+
+    for (size_t i = 0; i < mNames.size(); i++)
+    {
+        TSTRING strName = strPrefix + mNames[i];
+        Entry&  entry   = mEntries[strName];
+
+        cFSStatArgs::FileType type = (i < vTypes.size()) ? vTypes[i] : cFSStatArgs::TY_INVALID;
+        if (!mbStatLeaves && type != cFSStatArgs::TY_INVALID && type != cFSStatArgs::TY_DIR)
+        {
+            entry.mType = type;
+            continue;
+        }
+
+        try
+        {
+            if (mpParent)
+                iFSServices::GetInstance()->Stat(
+                    *mpParent, mChild + _T('/') + mNames[i], entry.mStat, cFSStatArgs::FIELD_ALL);
+            else
+                iFSServices::GetInstance()->Stat(strName, entry.mStat, cFSStatArgs::FIELD_ALL);
+            entry.mbHaveStat = true;
+        }
+        catch (eError& e)
+        {
+            e.SetFatality(false);
+            entry.mError  = e;
+            entry.mbError = true;
+        }
+        catch (std::exception& e)
+        {
+            entry.mError  = eFSDataSourceIter(strName, e.what(), eError::NON_FATAL);
+            entry.mbError = true;
+        }
+        catch (...)
+        {
+            entry.mError  = eFSDataSourceIter(strName, "unknown", eError::NON_FATAL);
+            entry.mbError = true;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cFSDirPrefetch -- the directory listings that have been handed to the
+//      worker pool and not yet picked up, shared by an iterator and all of
+//      its copies
+///////////////////////////////////////////////////////////////////////////////
+class cFSDirPrefetch : public cRefCountObj
+{
+public:
+    explicit cFSDirPrefetch(cWorkerPool* pPool) : mpPool(pPool)
+    {
+    }
+
+    cWorkerPool* GetPool() const
+    {
+        return mpPool;
+    }
+
+    void Start(const TSTRING& strDir, cFSDirHandle* pParent, const TSTRING& strChild, bool bStatLeaves);
+    // starts listing the named directory, if that isn't already under way. If pParent
+    // isn't null, strDir is strChild in that directory.
+    cFSDirListing* Take(const TSTRING& strDir);
+    // returns the finished listing for the directory, waiting for it if need be,
+    // or null if it was never started. The caller owns the return value.
+
+protected:
+    virtual ~cFSDirPrefetch();
+
+private:
+    typedef std::map<TSTRING, cFSDirListing*> ListingMap;
+
+    cWorkerPool* mpPool;
+    ListingMap   mListings;
+};
+
+cFSDirPrefetch::~cFSDirPrefetch()
+{
+    for (ListingMap::iterator i = mListings.begin(); i != mListings.end(); ++i)
+    {
+        mpPool->Wait(i->second);
+        delete i->second;
+    }
+}
+
+void cFSDirPrefetch::Start(const TSTRING& strDir, cFSDirHandle* pParent, const TSTRING& strChild, bool bStatLeaves)
+{
+    if (mListings.find(strDir) != mListings.end())
+        return;
+
+    cFSDirListing* pListing = new cFSDirListing(strDir, pParent, strChild, bStatLeaves);
+    mListings[strDir]       = pListing;
+    mpPool->Submit(pListing);
+}
+
+cFSDirListing* cFSDirPrefetch::Take(const TSTRING& strDir)
+{
+    ListingMap::iterator i = mListings.find(strDir);
+    if (i == mListings.end())
+        return 0;
+
+    cFSDirListing* pListing = i->second;
+    mListings.erase(i);
+
+    mpPool->Wait(pListing);
+    return pListing;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cFSReadAhead -- asks for the start of one regular file to be read into the
+//      page cache. The open() is done on one of the hashing threads if there
+//      are any, or right away if there aren't. Nothing is reported; a file that
+//      can't be read ahead will be found out about when it is hashed. This is
+//      shared by an iterator and its copies, and is waited for when the last
+//      of them lets go of it.
+///////////////////////////////////////////////////////////////////////////////
+class cFSReadAhead : public cRefCountObj
+{
+public:
+    cFSReadAhead(cFSDirHandle* pDir, const TSTRING& strName, int64 len);
+
+protected:
+    virtual ~cFSReadAhead();
+
+private:
+    class cTask : public iWorkerTask
+    {
+    public:
+        cTask(cFSDirHandle* pDir, const TSTRING& strName, int64 len) : mpDir(pDir), mName(strName), mLen(len)
+        {
+        }
+
+        virtual void Run();
+
+        cFSDirHandle* mpDir; // the directory mName is in, held open; null if mName is a full path
+        TSTRING       mName;
+        int64         mLen;
+    };
+
+    cTask        mTask;
+    cWorkerPool* mpPool; // the pool mTask was handed to, or null if it has run already
+};
+
+cFSReadAhead::cFSReadAhead(cFSDirHandle* pDir, const TSTRING& strName, int64 len)
+    : mTask(pDir, strName, len), mpPool(0)
+{
+    if (pDir)
+        pDir->Hold();
+
+    if (cArchiveSigGen::GetHashThreads() > 1)
+    {
+        mpPool = &cArchiveSigGen::GetWorkerPool();
+        mpPool->Submit(&mTask);
+    }
+    else
+        mTask.Run();
+}
+
+cFSReadAhead::~cFSReadAhead()
+{
+    if (mpPool)
+        mpPool->Wait(&mTask);
+    if (mTask.mpDir)
+        mTask.mpDir->Unhold();
+}
+
+void cFSReadAhead::cTask::Run()
+{
+    try
+    {
+        cFileArchive arch;
+        arch.OpenRead(mpDir, mName.c_str(), cFileArchive::FA_SCANNING);
+        arch.WillNeed(std::min(arch.Length(), mLen));
+        arch.Close();
+    }
+    catch (...)
+    {
+    }
+}
+
 //=========================================================================
 // METHOD CODE
 //=========================================================================
 
-cFSDataSourceIter::cFSDataSourceIter() : cFCODataSourceIterImpl(), mDev(0)
+cFSDataSourceIter::cFSDataSourceIter()
+    : cFCODataSourceIterImpl(),
+      mDev(0),
+      mpPrefetch(0),
+      mpListing(0),
+      mpDir(0),
+      mbStatLeaves(true),
+      mbHashLeaves(false),
+      mAheadPos(0)
 {
     // set the case sensitiveness of the parent...
     //
@@ -63,9 +354,22 @@ cFSDataSourceIter::cFSDataSourceIter() : cFCODataSourceIterImpl(), mDev(0)
 
 cFSDataSourceIter::~cFSDataSourceIter()
 {
+    ClearListing();
+    ClearReadAhead();
+    SetDir(0);
+    if (mpPrefetch)
+        mpPrefetch->Release();
 }
 
-cFSDataSourceIter::cFSDataSourceIter(const cFSDataSourceIter& rhs) : cFCODataSourceIterImpl(), mDev(0)
+cFSDataSourceIter::cFSDataSourceIter(const cFSDataSourceIter& rhs)
+    : cFCODataSourceIterImpl(),
+      mDev(0),
+      mpPrefetch(0),
+      mpListing(0),
+      mpDir(0),
+      mbStatLeaves(true),
+      mbHashLeaves(false),
+      mAheadPos(0)
 {
     // set the case sensitiveness of the parent...
     //
@@ -84,12 +388,36 @@ cFSDataSourceIter& cFSDataSourceIter::operator=(const cFSDataSourceIter& rhs)
     // copy base
     cFCODataSourceIterImpl::operator=(rhs);
     // copy derived
-    mDev = rhs.mDev;
+    mDev         = rhs.mDev;
+    mbStatLeaves = rhs.mbStatLeaves;
+    mbHashLeaves = rhs.mbHashLeaves;
+
+    // the prefetched listings are shared, but our peers have already been
+    // read, so there is no need to copy their stat results
+    if (rhs.mpPrefetch)
+        rhs.mpPrefetch->AddRef();
+    if (mpPrefetch)
+        mpPrefetch->Release();
+    mpPrefetch = rhs.mpPrefetch;
+    ClearListing();
+    mTypes = rhs.mTypes;
+
+    // we have the same peers, so we need their directory open too, and the
+    // files that have been read ahead don't need to be again
+    SetDir(rhs.mpDir);
+
+    for (size_t i = 0; i < rhs.mAhead.size(); i++)
+        rhs.mAhead[i].second->AddRef();
+    ClearReadAhead();
+    mAheadPos = rhs.mAheadPos;
+    mAhead    = rhs.mAhead;
 
     return *this;
 }
 
 static bool gCrossFileSystems = false;
+static int   gReadAheadFiles = 8;
+static int64 gReadAheadBytes = 32 * 1024 * 1024;
 
 // Call this to set the property where cFSDataSourceIter does not automatically recurse
 // across file system boundaries.  Currently this is by default is set to false.
@@ -98,12 +426,151 @@ static bool gCrossFileSystems = false;
     gCrossFileSystems = crossFS;
 }
 
+/*static*/ void cFSDataSourceIter::SetReadAhead(int numFiles, int64 numBytes)
+{
+    gReadAheadFiles = numFiles;
+    gReadAheadBytes = numBytes;
+}
+
+/*static*/ void cFSDataSourceIter::GetReadAhead(int& numFiles, int64& numBytes)
+{
+    numFiles = gReadAheadFiles;
+    numBytes = gReadAheadBytes;
+}
+
 void cFSDataSourceIter::AddIterationError(const eError& e)
 {
     if (mpErrorBucket)
         mpErrorBucket->AddError(e);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// SetWorkerPool
+///////////////////////////////////////////////////////////////////////////////
+void cFSDataSourceIter::SetWorkerPool(cWorkerPool* pPool)
+{
+    if (mpPrefetch)
+        mpPrefetch->Release();
+    mpPrefetch = pPool ? new cFSDirPrefetch(pPool) : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Prefetch
+///////////////////////////////////////////////////////////////////////////////
+void cFSDataSourceIter::Prefetch()
+{
+    if (!mpPrefetch || Done() || !CanDescend())
+        return;
+
+    // don't start reading a directory on another file system; we won't be
+    // descending into it
+    const cFSPropSet& propSet = static_cast<const cFSObject*>(*mCurPos)->GetFSPropSet();
+    if (gCrossFileSystems == false && (mDev != 0) &&
+        (!propSet.GetValidVector().ContainsItem(cFSPropSet::PROP_DEV) || propSet.GetDev() != mDev))
+        return;
+
+    mpPrefetch->Start(GetName().AsString(), mpDir, GetName().GetShortName(), mbStatLeaves);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SetLeafProps
+///////////////////////////////////////////////////////////////////////////////
+void cFSDataSourceIter::SetLeafProps(const cFCOPropVector& v)
+{
+    cFCOPropVector others = v;
+    if (others.GetSize() > cFSPropSet::PROP_FILETYPE)
+        others.RemoveItem(cFSPropSet::PROP_FILETYPE);
+
+    mbStatLeaves = (others != cFCOPropVector(others.GetSize()));
+
+    static const int hashes[] = { cFSPropSet::PROP_CRC32,  cFSPropSet::PROP_MD5,    cFSPropSet::PROP_SHA,
+                                  cFSPropSet::PROP_HAVAL,  cFSPropSet::PROP_SHA256, cFSPropSet::PROP_SHA512,
+                                  cFSPropSet::PROP_BLAKE2, cFSPropSet::PROP_BLAKE3 };
+    mbHashLeaves = false;
+    for (size_t i = 0; i < sizeof(hashes) / sizeof(hashes[0]); i++)
+    {
+        if (hashes[i] < v.GetSize() && v.ContainsItem(hashes[i]))
+            mbHashLeaves = true;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SeekBegin, Next -- these keep the read-ahead going
+///////////////////////////////////////////////////////////////////////////////
+void cFSDataSourceIter::SeekBegin()
+{
+    cFCODataSourceIterImpl::SeekBegin();
+    ReadAhead();
+}
+
+void cFSDataSourceIter::Next()
+{
+    cFCODataSourceIterImpl::Next();
+    ReadAhead();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ReadAhead -- forgets about the peers we have passed, and asks for the next
+//      regular files to be read until there are enough of them on the way.
+//      Only files the directory says are regular files are read ahead, so
+//      nothing has to be stat()ed here, and nothing that would block an
+//      open() is opened.
+///////////////////////////////////////////////////////////////////////////////
+void cFSDataSourceIter::ReadAhead()
+{
+    if (gReadAheadFiles <= 0 || !mbHashLeaves || mpPrefetch || cArchiveSigGen::UseDirectIO() || Done())
+        return;
+
+    const size_t cur = mCurPos - mPeers.begin();
+    while (!mAhead.empty() && mAhead.front().first <= cur)
+    {
+        mAhead.front().second->Release();
+        mAhead.pop_front();
+    }
+
+    if (mAheadPos <= cur)
+        mAheadPos = cur + 1;
+
+    const int64 len = gReadAheadBytes / gReadAheadFiles;
+    for (; mAheadPos < mPeers.size() && (int)mAhead.size() < gReadAheadFiles && len > 0; mAheadPos++)
+    {
+        const cFSObject* pObj = static_cast<const cFSObject*>(mPeers[mAheadPos]);
+
+        std::map<TSTRING, cFSStatArgs::FileType>::const_iterator i = mTypes.find(pObj->GetName().AsString());
+        if (i == mTypes.end() || i->second != cFSStatArgs::TY_FILE)
+            continue;
+
+        cFSDirHandle* pDir = (mpDir && mpDir->GetFd() >= 0) ? mpDir : 0;
+        mAhead.push_back(std::make_pair(
+            mAheadPos, new cFSReadAhead(pDir, pDir ? TSTRING(pObj->GetName().GetShortName()) : i->first, len)));
+    }
+}
+
+void cFSDataSourceIter::ClearReadAhead()
+{
+    for (size_t i = 0; i < mAhead.size(); i++)
+        mAhead[i].second->Release();
+
+    mAheadPos = 0;
+    mAhead.clear();
+}
+
+void cFSDataSourceIter::ClearListing()
+{
+    delete mpListing;
+    mpListing = 0;
+    mTypes.clear();
+}
+
+void cFSDataSourceIter::SetDir(cFSDirHandle* pDir)
+{
+    if (pDir)
+        pDir->Hold();
+    if (mpDir)
+        mpDir->Unhold();
+    mpDir = pDir;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // CreateCopy
 ///////////////////////////////////////////////////////////////////////////////
@@ -128,8 +595,18 @@ iFCO* cFSDataSourceIter::CreateObject(const cFCOName& name, bool bCreatePeers)
 {
     cFSObject* pNewObj = new cFSObject(name);
 
+    if (bCreatePeers && mParentName.GetSize() > 0)
+    {
+        // this is one of the names GetChildrenNames() just read
+        pNewObj->SetParentDir(mpDir);
+    }
+    else
+        SetDir(0);
+
     if (!bCreatePeers)
     {
+        ClearListing();
+
         // when bCreatePeers is false, it means we should set mDev to the
         // device number of the current object (ie -- it is a new "start point")
         // If we don't do this here, InitializeTypeInfo() will reject creating the
@@ -150,9 +627,82 @@ iFCO* cFSDataSourceIter::CreateObject(const cFCOName& name, bool bCreatePeers)
 
 void cFSDataSourceIter::GetChildrenNames(const TSTRING& strParentName, std::vector<TSTRING>& vChildrenNames)
 {
+    ClearListing();
+    ClearReadAhead();
+
+    if (mpPrefetch)
+        mpListing = mpPrefetch->Take(strParentName);
+
+    //
+    // open the directory, relative to the one it is in if we can. That is the
+    // prefetch's if there is one, or else ours, when we are descending into one
+    // of our peers.
+    //
+    cFSDirHandle* pParent = 0;
+    TSTRING       strName = strParentName;
+    if (mpListing && mpListing->mpParent)
+    {
+        pParent = mpListing->mpParent;
+        strName = mpListing->mChild;
+    }
+    else if (!mpListing && mpDir && mpDir->GetPath(mParentName.GetShortName()) == strParentName)
+    {
+        pParent = mpDir;
+        strName = mParentName.GetShortName();
+    }
+
+    cFSDirHandle* pDir = 0;
     try
     {
-        iFSServices::GetInstance()->ReadDir(strParentName, vChildrenNames, false);
+        pDir = iFSServices::GetInstance()->OpenDir(strName, pParent);
+    }
+    catch (eError& e)
+    {
+        // if it has already been read, we can make do with full paths
+        if (!mpListing)
+            AddIterationError(eFSDataSourceIterReadDir(strParentName, e.GetMsg(), eError::NON_FATAL));
+    }
+
+    SetDir(pDir);
+    if (pDir)
+        pDir->Release();
+
+    //
+    // if the directory was read ahead of time, just pick up the results
+    //
+    if (mpListing)
+    {
+        if (mpListing->mbReadDirError)
+            AddIterationError(mpListing->mReadDirError);
+
+        vChildrenNames.swap(mpListing->mNames);
+        return;
+    }
+
+    if (!mpDir)
+        return;
+
+    try
+    {
+        // the types are wanted for leaves that won't be stat()ed, and to know
+        // which files to read ahead
+        if (mbStatLeaves && !mbHashLeaves)
+            iFSServices::GetInstance()->ReadDir(*mpDir, vChildrenNames);
+        else
+        {
+            std::vector<cFSStatArgs::FileType> vTypes;
+            iFSServices::GetInstance()->ReadDir(*mpDir, vChildrenNames, vTypes);
+
+            TSTRING strPrefix = strParentName;
+            if (strPrefix.empty() || strPrefix[strPrefix.length() - 1] != _T('/'))
+                strPrefix += _T('/');
+
+            for (size_t i = 0; i < vChildrenNames.size() && i < vTypes.size(); i++)
+            {
+                if (vTypes[i] != cFSStatArgs::TY_INVALID && vTypes[i] != cFSStatArgs::TY_DIR)
+                    mTypes[strPrefix + vChildrenNames[i]] = vTypes[i];
+            }
+        }
     }
     catch (eError& e)
     {
@@ -168,11 +718,30 @@ void cFSDataSourceIter::GetChildrenNames(const TSTRING& strParentName, std::vect
     }
 }
 
-bool cFSDataSourceIter::DoStat(const TSTRING& name, cFSStatArgs& statArgs)
+bool cFSDataSourceIter::DoStat(const cFSObject& obj, const TSTRING& name, cFSStatArgs& statArgs)
 {
+    if (mpListing)
+    {
+        cFSDirListing::EntryMap::iterator i = mpListing->mEntries.find(name);
+        if (i != mpListing->mEntries.end() && (i->second.mbHaveStat || i->second.mbError))
+        {
+            bool bSuccess = !i->second.mbError;
+            if (bSuccess)
+                statArgs = i->second.mStat;
+            else
+                AddIterationError(i->second.mError);
+
+            mpListing->mEntries.erase(i);
+            return bSuccess;
+        }
+    }
+
     try
     {
-        iFSServices::GetInstance()->Stat(name, statArgs);
+        if (obj.GetParentDir())
+            iFSServices::GetInstance()->Stat(*obj.GetParentDir(), obj.GetName().GetShortName(), statArgs, cFSStatArgs::FIELD_ALL);
+        else
+            iFSServices::GetInstance()->Stat(name, statArgs, cFSStatArgs::FIELD_ALL);
     }
     catch (eError& e)
     {
@@ -194,6 +763,34 @@ bool cFSDataSourceIter::DoStat(const TSTRING& name, cFSStatArgs& statArgs)
     return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// GetLeafType -- if only the file type of leaves is needed, and the directory
+//      recorded that the named peer isn't a directory, returns true and what
+//      it is
+///////////////////////////////////////////////////////////////////////////////
+bool cFSDataSourceIter::GetLeafType(const TSTRING& name, cFSStatArgs::FileType& type) const
+{
+    if (mbStatLeaves)
+        return false;
+
+    if (mpListing)
+    {
+        cFSDirListing::EntryMap::const_iterator i = mpListing->mEntries.find(name);
+        if (i == mpListing->mEntries.end() || i->second.mType == cFSStatArgs::TY_INVALID)
+            return false;
+
+        type = i->second.mType;
+        return true;
+    }
+
+    std::map<TSTRING, cFSStatArgs::FileType>::const_iterator i = mTypes.find(name);
+    if (i == mTypes.end())
+        return false;
+
+    type = i->second;
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // InitializeTypeInfo
 ///////////////////////////////////////////////////////////////////////////////
@@ -210,9 +807,25 @@ bool cFSDataSourceIter::InitializeTypeInfo(iFCO* pFCO)
     cFSPropSet& propSet = pObj->GetFSPropSet();
     propSet.SetFileType(cFSPropSet::FT_INVALID);
 
+    // if all we need is the type, and it isn't a directory we have to look into,
+    // what the directory told us is enough
+    //
     cFSStatArgs statArgs;
-    if (!DoStat(pObj->GetName().AsString(), statArgs))
+    if (GetLeafType(pObj->GetName().AsString(), statArgs.mFileType))
+    {
+        util_SetFileType(propSet, statArgs.mFileType);
+        return true;
+    }
+
+    if (!DoStat(*pObj, pObj->GetName().AsString(), statArgs))
+    {
+        pObj->AddStat();
         return false;
+    }
+
+    // keep the results around so the property calculator doesn't have to stat() again
+    //
+    pObj->SetStatArgs(statArgs);
 
     // don't create the object if it is on a different file system...
     //
@@ -241,8 +854,17 @@ bool cFSDataSourceIter::InitializeTypeInfo(iFCO* pFCO)
     propSet.SetBlocks(     statArgs.blocks);
     propSet.SetGrowingFile(statArgs.size);
 
-    // set the file type
-    switch (statArgs.mFileType)
+    util_SetFileType(propSet, statArgs.mFileType);
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_SetFileType
+///////////////////////////////////////////////////////////////////////////////
+static void util_SetFileType(cFSPropSet& propSet, cFSStatArgs::FileType type)
+{
+    switch (type)
     {
     case cFSStatArgs::TY_FILE:
         propSet.SetFileType(cFSPropSet::FT_FILE);
@@ -278,6 +900,4 @@ bool cFSDataSourceIter::InitializeTypeInfo(iFCO* pFCO)
         // set it to invalid
         propSet.SetFileType(cFSPropSet::FT_INVALID);
     }
-
-    return true;
 }
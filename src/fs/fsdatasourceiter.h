@@ -41,10 +41,16 @@
 #include "fco/fcodatasourceiterimpl.h"
 #include "core/fileerror.h"
 #include "core/fsservices.h"
+#include <deque>
 
 TSS_FILE_EXCEPTION(eFSDataSourceIter, eFileError)
 TSS_FILE_EXCEPTION(eFSDataSourceIterReadDir, eFSDataSourceIter)
 
+class cFSDirPrefetch;
+class cFSDirListing;
+class cFSReadAhead;
+class cFSObject;
+
 
 //=========================================================================
 // DECLARATION OF CLASSES
@@ -72,11 +78,47 @@ public:
     // Call this to set the property where cFSDataSourceIter does not automatically recurse
     // across file system boundaries.  Currently this is by default is set to false.
 
+    virtual void SetWorkerPool(cWorkerPool* pPool);
+    virtual void Prefetch();
+    // Prefetch() hands the readdir() of the current directory, and the lstat()
+    // of everything in it, to the pool. The listing is shared with all copies of
+    // this iterator, so it is picked up by whichever one descends into it.
+    // Directories on other file systems are left alone, unless the iterator
+    // crosses file systems.
+    virtual void SetLeafProps(const cFCOPropVector& v);
+    // if v asks for nothing but the file type, objects the directory says aren't
+    // directories are not lstat()ed; only their file type is filled in.
+
+    static void SetReadAhead(int numFiles, int64 numBytes);
+    static void GetReadAhead(int& numFiles, int64& numBytes);
+    // as the iterator moves through its peers, the next numFiles of them that the
+    // directory says are regular files are asked to be read into the page cache,
+    // up to numBytes / numFiles of each, so the disk is kept busy while each file
+    // is hashed. The open() for this is done on one of the hashing threads, if
+    // there are any. This is only done when the leaf props include a hash, and not
+    // with a worker pool, whose threads keep several reads going already. numFiles
+    // of 0 turns it off.
+
+    virtual void SeekBegin();
+    virtual void Next();
+
     //void TraceContents(int dl = -1) const;
 private:
     uint64 mDev; // the device number of the last node reached through SeekTo()
                  // if this is zero, then it is assumed to be uninitialized
 
+    cFSDirPrefetch* mpPrefetch; // the listings in progress; null if there is no worker pool
+    cFSDirListing*  mpListing;  // the prefetched stat() results for mPeers, if any
+    cFSDirHandle*   mpDir;      // the directory mPeers were read from, held open; null if
+                                // mPeers didn't come from reading a directory
+    bool            mbStatLeaves; // false if only the type of non-directories is needed
+    std::map<TSTRING, cFSStatArgs::FileType> mTypes; // the types of mPeers the directory
+                                                     // recorded, by full path
+    bool            mbHashLeaves; // whether the leaf props include a hash
+    size_t          mAheadPos;    // the next peer to think about reading ahead
+    std::deque<std::pair<size_t, cFSReadAhead*> > mAhead; // peers past mCurPos that have been
+                                                          // read ahead, shared with our copies
+
     //-------------------------------------------------------------------------
     // helper methods
     //-------------------------------------------------------------------------
@@ -87,7 +129,12 @@ private:
     virtual bool  InitializeTypeInfo(iFCO* pFCO);
 
     void AddIterationError(const eError& e);
-    bool DoStat(const TSTRING& name, cFSStatArgs& statArgs);
+    bool DoStat(const cFSObject& obj, const TSTRING& name, cFSStatArgs& statArgs);
+    bool GetLeafType(const TSTRING& name, cFSStatArgs::FileType& type) const;
+    void ClearListing();
+    void SetDir(cFSDirHandle* pDir);
+    void ReadAhead();
+    void ClearReadAhead();
 };
 
 #endif //__FSDATASOURCEITER_H
@@ -38,6 +38,7 @@
 #include "fserrors.h"
 #include "fspropcalc.h"
 #include "fsdatasourceiter.h"
+#include "fshashcache.h"
 #include "core/errortable.h"
 
 
@@ -47,6 +48,7 @@ TSS_REGISTER_ERROR(eFSPropCalc(), _T("Property calculation error."))
 //TSS_REGISTER_ERROR( eFSPropCalcResetAccessTime(), _T("Could not reset access time for file.") )
 TSS_REGISTER_ERROR(eFSDataSourceIter(), _T("Data source iterator error."))
 TSS_REGISTER_ERROR(eFSDataSourceIterReadDir(), _T("Could not access directory contents."))
+TSS_REGISTER_ERROR(eFSHashCache(), _T("Hash cache error."))
 
 
 TSS_END_ERROR_REGISTRATION()
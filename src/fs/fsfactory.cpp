@@ -120,12 +120,18 @@ cFCOPropVector cFSFactory::GetLooseDirMask() const
         vec.AddItem(cFSPropSet::PROP_ATIME);
         vec.AddItem(cFSPropSet::PROP_CTIME);
         vec.AddItem(cFSPropSet::PROP_MTIME);
+        vec.AddItem(cFSPropSet::PROP_CTIME_NSEC);
+        vec.AddItem(cFSPropSet::PROP_MTIME_NSEC);
         vec.AddItem(cFSPropSet::PROP_BLOCKS);
         vec.AddItem(cFSPropSet::PROP_GROWING_FILE);
         vec.AddItem(cFSPropSet::PROP_CRC32);
         vec.AddItem(cFSPropSet::PROP_MD5);
         vec.AddItem(cFSPropSet::PROP_SHA);
         vec.AddItem(cFSPropSet::PROP_HAVAL);
+        vec.AddItem(cFSPropSet::PROP_SHA256);
+        vec.AddItem(cFSPropSet::PROP_SHA512);
+        vec.AddItem(cFSPropSet::PROP_BLAKE2);
+        vec.AddItem(cFSPropSet::PROP_BLAKE3);
 
         bInit = true;
     }
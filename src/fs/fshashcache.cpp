@@ -0,0 +1,426 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+// fshashcache.cpp
+
+#include "stdfs.h"
+#include "fshashcache.h"
+#include "fspropset.h"
+#include "fsstrings.h"
+#include "core/debug.h"
+#include "core/serializerimpl.h"
+
+#include <time.h>
+
+// the table starts with a Header, which is followed by its Entries, sorted by
+// device and inode, and then the data they refer to. Each entry's data is
+// its signatures, in property order, each one a uint32 length followed by
+// what the signature's Write() wrote. Everything is in the machine's byte
+// order; the magic number tells if the file came from somewhere else.
+struct cFSHashCache::Header
+{
+    char   magic[8];
+    uint32 entrySize;
+    uint32 reserved;
+    int64  numEntries;
+    int64  dataLen;
+};
+
+struct cFSHashCache::Entry
+{
+    uint64 dev;
+    uint64 ino;
+    int64  size;
+    int64  mtime;
+    int64  ctime;
+    int64  lastUsed;
+    uint32 props; // which properties' signatures there are, one bit each
+    uint32 dataLen;
+    int64  dataOffset; // from the start of the data
+};
+
+static const char HASH_CACHE_MAGIC[8] = { 'T', 'W', 'H', 'C', 0x01, 0x02, 0x03, 0x04 };
+static const int64 NSEC_PER_SEC       = 1000000000;
+
+static bool util_SameKey(const cFSHashCache::Key& lhs, const cFSHashCache::Key& rhs)
+{
+    return lhs.dev == rhs.dev && lhs.ino == rhs.ino && lhs.size == rhs.size && lhs.mtime == rhs.mtime &&
+           lhs.ctime == rhs.ctime;
+}
+
+cFSHashCache::cFSHashCache()
+    : mpImage(0), mImageLen(0), mpEntries(0), mNumEntries(0), mpData(0), mDataLen(0), mNow(time(0))
+{
+}
+
+cFSHashCache::~cFSHashCache()
+{
+}
+
+uint32 cFSHashCache::GetKeyFields()
+{
+    return cFSStatArgs::FIELD_TYPE | cFSStatArgs::FIELD_INO | cFSStatArgs::FIELD_SIZE | cFSStatArgs::FIELD_MTIME |
+           cFSStatArgs::FIELD_CTIME;
+}
+
+void cFSHashCache::MakeKey(const cFSStatArgs& ss, Key& key)
+{
+    ASSERT((ss.mRequested & GetKeyFields()) == GetKeyFields());
+
+    key.dev   = ss.dev;
+    key.ino   = ss.ino;
+    key.size  = ss.size;
+    key.mtime = ss.mtime * NSEC_PER_SEC + ss.mtimeNsec;
+    key.ctime = ss.ctime * NSEC_PER_SEC + ss.ctimeNsec;
+}
+
+void cFSHashCache::Clear()
+{
+    mCopy.clear();
+    mpImage     = 0;
+    mImageLen   = 0;
+    mpEntries   = 0;
+    mNumEntries = 0;
+    mpData      = 0;
+    mDataLen    = 0;
+    mUsed.clear();
+    mRecords.clear();
+}
+
+void cFSHashCache::Load(cFileArchive& arch, int64 offset, int64 len)
+{
+    Clear();
+
+    TSTRING fileName = arch.GetCurrentFilename();
+    if (offset < 0 || len < (int64)sizeof(Header) || offset + len > arch.Length())
+        throw eFSHashCache(fileName, TSS_GetString(cFS, fs::STR_HASH_CACHE_BAD_FORMAT));
+
+    // the table is copied rather than mapped, so that what is checked and used is
+    // a private copy; a mapping could be changed, or truncated, under us
+    mCopy.resize(len);
+    for (int64 done = 0; done < len;)
+    {
+        int n = arch.ReadAt(offset + done, &mCopy[done], (int)std::min<int64>(len - done, 0x100000));
+        if (n <= 0)
+        {
+            Clear();
+            throw eFSHashCache(fileName, TSS_GetString(cFS, fs::STR_HASH_CACHE_BAD_FORMAT));
+        }
+        done += n;
+    }
+    mpImage   = &mCopy[0];
+    mImageLen = len;
+
+    const Header* pHeader = reinterpret_cast<const Header*>(mpImage);
+    int64         room    = len - sizeof(Header);
+    if (memcmp(pHeader->magic, HASH_CACHE_MAGIC, sizeof(HASH_CACHE_MAGIC)) != 0 ||
+        pHeader->entrySize != sizeof(Entry) || pHeader->numEntries < 0 ||
+        pHeader->numEntries > room / (int64)sizeof(Entry) || pHeader->dataLen < 0 ||
+        pHeader->numEntries * (int64)sizeof(Entry) + pHeader->dataLen != room)
+    {
+        Clear();
+        throw eFSHashCache(fileName, TSS_GetString(cFS, fs::STR_HASH_CACHE_BAD_FORMAT));
+    }
+
+    mpEntries   = reinterpret_cast<const Entry*>(mpImage + sizeof(Header));
+    mNumEntries = pHeader->numEntries;
+    mpData      = mpImage + sizeof(Header) + mNumEntries * sizeof(Entry);
+    mDataLen    = pHeader->dataLen;
+    mUsed.assign(mNumEntries, false);
+
+    cDebug d("cFSHashCache::Load");
+    d.TraceDetail("Loaded %d entries from %s\n", (int)mNumEntries, fileName.c_str());
+}
+
+const void* cFSHashCache::GetImage() const
+{
+    return mpImage;
+}
+
+int64 cFSHashCache::GetImageLength() const
+{
+    return mImageLen;
+}
+
+int cFSHashCache::GetNumEntries() const
+{
+    int n = mRecords.size();
+    for (int64 i = 0; i < mNumEntries; i++)
+    {
+        if (mRecords.find(Inode(mpEntries[i].dev, mpEntries[i].ino)) == mRecords.end())
+            n++;
+    }
+    return n;
+}
+
+void cFSHashCache::SetTime(int64 now)
+{
+    mNow = now;
+}
+
+const cFSHashCache::Entry* cFSHashCache::FindEntry(const Key& key) const
+{
+    int64 lo = 0;
+    int64 hi = mNumEntries;
+    while (lo < hi)
+    {
+        int64        mid = lo + (hi - lo) / 2;
+        const Entry& e   = mpEntries[mid];
+        if (e.dev < key.dev || (e.dev == key.dev && e.ino < key.ino))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < mNumEntries && mpEntries[lo].dev == key.dev && mpEntries[lo].ino == key.ino)
+        return &mpEntries[lo];
+    return 0;
+}
+
+bool cFSHashCache::ReadEntry(const Entry& entry, SigMap& sigs) const
+{
+    if (entry.dataOffset < 0 || entry.dataOffset > mDataLen || entry.dataLen > mDataLen - entry.dataOffset)
+        return false;
+
+    const int8* p   = mpData + entry.dataOffset;
+    const int8* end = p + entry.dataLen;
+    for (int i = 0; i < 32; i++)
+    {
+        if (!(entry.props & (1u << i)))
+            continue;
+
+        uint32 len;
+        if (end - p < (int64)sizeof(len))
+            return false;
+        memcpy(&len, p, sizeof(len));
+        p += sizeof(len);
+        if ((uint32)(end - p) < len)
+            return false;
+
+        sigs[i].assign(reinterpret_cast<const char*>(p), len);
+        p += len;
+    }
+
+    return p == end;
+}
+
+void cFSHashCache::MarkUsed(const Entry& entry)
+{
+    mUsed[&entry - mpEntries] = true;
+}
+
+bool cFSHashCache::Lookup(const Key& key, const cFCOPropVector& sigProps, cFSPropSet& propSet)
+{
+    SigMap        found;
+    const SigMap* pSigs  = &found;
+    const Entry*  pEntry = 0;
+
+    RecordMap::const_iterator r = mRecords.find(Inode(key.dev, key.ino));
+    if (r != mRecords.end())
+    {
+        if (!util_SameKey(key, r->second.key))
+            return false;
+        pSigs = &r->second.sigs;
+    }
+    else
+    {
+        pEntry = FindEntry(key);
+        if (!pEntry)
+            return false;
+
+        Key entryKey = { pEntry->dev, pEntry->ino, pEntry->size, pEntry->mtime, pEntry->ctime };
+        if (!util_SameKey(key, entryKey) || !ReadEntry(*pEntry, found))
+            return false;
+    }
+
+    for (int i = 0; i < propSet.GetNumProps(); i++)
+    {
+        if (!sigProps.ContainsItem(i))
+            continue;
+
+        SigMap::const_iterator sig = pSigs->find(i);
+        if (sig == pSigs->end())
+            return false;
+
+        try
+        {
+            cFixedMemArchive arch(const_cast<int8*>(reinterpret_cast<const int8*>(sig->second.data())),
+                                  sig->second.size());
+            cSerializerImpl ser(arch, cSerializerImpl::S_READ);
+            iFCOProp*       pProp = propSet.GetPropAt(i);
+            pProp->Read(&ser, pProp->Version());
+        }
+        catch (eError&)
+        {
+            return false;
+        }
+    }
+
+    if (pEntry)
+        MarkUsed(*pEntry);
+
+    return true;
+}
+
+void cFSHashCache::Store(const Key& key, const cFCOPropVector& sigProps, const cFSPropSet& propSet)
+{
+    // a file can change again within the same tick of its clock without its
+    // times changing, so one that has only just changed may not stay as it is
+    if (key.mtime / NSEC_PER_SEC >= mNow - RACY_SECS || key.ctime / NSEC_PER_SEC >= mNow - RACY_SECS)
+        return;
+
+    // keep whatever other signatures the file already has cached
+    SigMap              sigs;
+    Inode               inode(key.dev, key.ino);
+    RecordMap::iterator r = mRecords.find(inode);
+    if (r != mRecords.end())
+    {
+        if (util_SameKey(key, r->second.key))
+            sigs.swap(r->second.sigs);
+    }
+    else
+    {
+        const Entry* pEntry = FindEntry(key);
+        if (pEntry)
+        {
+            Key entryKey = { pEntry->dev, pEntry->ino, pEntry->size, pEntry->mtime, pEntry->ctime };
+            if (!util_SameKey(key, entryKey) || !ReadEntry(*pEntry, sigs))
+                sigs.clear();
+        }
+    }
+
+    for (int i = 0; i < propSet.GetNumProps(); i++)
+    {
+        if (!sigProps.ContainsItem(i))
+            continue;
+
+        ASSERT(i < 32);
+        cMemoryArchive  arch;
+        cSerializerImpl ser(arch, cSerializerImpl::S_WRITE);
+        propSet.GetPropAt(i)->Write(&ser);
+        sigs[i].assign(reinterpret_cast<const char*>(arch.GetMemory()), arch.Length());
+    }
+
+    Record& rec  = mRecords[inode];
+    rec.key      = key;
+    rec.lastUsed = mNow;
+    rec.sigs.swap(sigs);
+}
+
+void cFSHashCache::Write(cArchive& arch) const
+{
+    // merge what was loaded with what was stored since, working out where
+    // everything is going to go before any of it is written
+    const int64 expired = mNow - (int64)EXPIRY_DAYS * 24 * 60 * 60;
+
+    std::vector<Entry>         entries;
+    std::vector<const Record*> records; // where each entry's data comes from, or
+    std::vector<const Entry*>  images;  // the image's entry it is a copy of
+    int64                      dataLen = 0;
+
+    RecordMap::const_iterator r = mRecords.begin();
+    int64                     i = 0;
+    while (i < mNumEntries || r != mRecords.end())
+    {
+        Entry e;
+        if (r == mRecords.end() || (i < mNumEntries && Inode(mpEntries[i].dev, mpEntries[i].ino) < r->first))
+        {
+            const Entry* pImage = &mpEntries[i];
+            e                   = *pImage;
+            if (mUsed[i])
+                e.lastUsed = mNow;
+            i++;
+            if (e.lastUsed < expired || e.dataOffset < 0 || e.dataOffset > mDataLen ||
+                e.dataLen > mDataLen - e.dataOffset)
+                continue;
+            records.push_back(0);
+            images.push_back(pImage);
+        }
+        else
+        {
+            // this supersedes the image's entry for the same inode, if it has one
+            if (i < mNumEntries && Inode(mpEntries[i].dev, mpEntries[i].ino) == r->first)
+                i++;
+
+            const Record& rec = r->second;
+            e.dev             = rec.key.dev;
+            e.ino             = rec.key.ino;
+            e.size            = rec.key.size;
+            e.mtime           = rec.key.mtime;
+            e.ctime           = rec.key.ctime;
+            e.lastUsed        = rec.lastUsed;
+            e.props           = 0;
+            e.dataLen         = 0;
+            for (SigMap::const_iterator s = rec.sigs.begin(); s != rec.sigs.end(); ++s)
+            {
+                e.props |= 1u << s->first;
+                e.dataLen += sizeof(uint32) + s->second.size();
+            }
+            records.push_back(&rec);
+            images.push_back(0);
+            ++r;
+        }
+
+        e.dataOffset = dataLen;
+        dataLen += e.dataLen;
+        entries.push_back(e);
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HASH_CACHE_MAGIC, sizeof(HASH_CACHE_MAGIC));
+    header.entrySize  = sizeof(Entry);
+    header.numEntries = entries.size();
+    header.dataLen    = dataLen;
+    arch.WriteBlob(&header, sizeof(header));
+
+    if (!entries.empty())
+        arch.WriteBlob(&entries[0], entries.size() * sizeof(Entry));
+
+    // the image is still mapped, so its entries' data can come straight out of it
+    for (size_t n = 0; n < entries.size(); n++)
+    {
+        if (images[n])
+        {
+            arch.WriteBlob(mpData + images[n]->dataOffset, images[n]->dataLen);
+            continue;
+        }
+
+        const SigMap& sigs = records[n]->sigs;
+        for (SigMap::const_iterator s = sigs.begin(); s != sigs.end(); ++s)
+        {
+            uint32 len = s->second.size();
+            arch.WriteBlob(&len, sizeof(len));
+            arch.WriteBlob(s->second.data(), len);
+        }
+    }
+}
@@ -0,0 +1,154 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+// fshashcache.h
+//
+// cFSHashCache -- remembers files' signatures from one run to the next
+#ifndef __FSHASHCACHE_H
+#define __FSHASHCACHE_H
+
+#ifndef __FCOPROPVECTOR_H
+#include "fco/fcopropvector.h"
+#endif
+
+#ifndef __FCOPROPCALC_H
+#include "fco/fcopropcalc.h"
+#endif
+
+#include "core/fsservices.h"
+#include "core/archive.h"
+#include "core/fileerror.h"
+
+class cFSPropSet;
+
+TSS_FILE_EXCEPTION(eFSHashCache, eFileError)
+
+///////////////////////////////////////////////////////////////////////////////
+// cFSHashCache -- a table of signatures, keyed by the device, inode, size and
+//      modification and change times of the file they were calculated from.
+//      As long as a file's key stays the same its contents are taken not to
+//      have changed, so the signatures can be used again without reading it.
+//
+//      What was saved last time is read into memory as it is and searched in
+//      place, and anything new is kept on the side until the table is written
+//      out again.
+//      The table knows nothing about keeping itself from being tampered with;
+//      that is up to whoever reads and writes the file it lives in.
+///////////////////////////////////////////////////////////////////////////////
+class cFSHashCache : public iFCOHashCache
+{
+public:
+    struct Key
+    {
+        uint64 dev;
+        uint64 ino;
+        int64  size;
+        int64  mtime; // in nanoseconds
+        int64  ctime; // likewise
+    };
+
+    cFSHashCache();
+    ~cFSHashCache();
+
+    static uint32 GetKeyFields();
+    // the cFSStatArgs::Fields that MakeKey() needs
+    static void MakeKey(const cFSStatArgs& ss, Key& key);
+
+    void Load(cFileArchive& arch, int64 offset, int64 len); // throw(eFSHashCache, eArchive)
+    // copies the len bytes at offset in arch, which Write() wrote, into memory and uses
+    // them as the table to start from. Anything in the cache already is dropped.
+    const void* GetImage() const;
+    int64       GetImageLength() const;
+    // the table Load() read, exactly as it was in the file. Nothing reads the file after
+    // Load(), so once this has been checked, changes to the file can't affect the cache.
+    void Clear();
+
+    bool Lookup(const Key& key, const cFCOPropVector& sigProps, cFSPropSet& propSet);
+    // if all of the signatures in sigProps are cached under key, this copies them into
+    // propSet and returns true. Otherwise it returns false and propSet may have been
+    // written over.
+    void Store(const Key& key, const cFCOPropVector& sigProps, const cFSPropSet& propSet);
+    // caches the signatures in sigProps from propSet under key, along with whatever
+    // else was already cached under the same key. Files that changed too recently to
+    // be sure they won't change again without their times changing are left out.
+
+    void Write(cArchive& arch) const; // throw(eArchive)
+    // writes out everything in the cache that has been used in the last EXPIRY_DAYS
+
+    int  GetNumEntries() const;
+    void SetTime(int64 now);
+    // the time, in seconds, entries are stamped with when they are used; it starts
+    // out as the time the cache was created
+
+    enum
+    {
+        EXPIRY_DAYS = 30, // how long an entry is kept without being used
+        RACY_SECS   = 2   // how recently a file can have changed and still be cached
+    };
+
+private:
+    cFSHashCache(const cFSHashCache&);
+    void operator=(const cFSHashCache&);
+
+    struct Entry; // the table's layout in the file
+    struct Header;
+
+    typedef std::map<int, std::string> SigMap; // serialized signatures, by property
+
+    struct Record
+    {
+        Key    key;
+        int64  lastUsed;
+        SigMap sigs;
+    };
+
+    typedef std::pair<uint64, uint64>  Inode;
+    typedef std::map<Inode, Record>     RecordMap;
+
+    const Entry* FindEntry(const Key& key) const;
+    // the image's entry for key's inode, or null if there isn't one
+    bool ReadEntry(const Entry& entry, SigMap& sigs) const;
+    void MarkUsed(const Entry& entry);
+
+    std::vector<int8> mCopy;   // the table Load() read
+    const int8*       mpImage; // and where it starts
+    int64             mImageLen;
+    const Entry*      mpEntries;
+    int64             mNumEntries;
+    const int8*       mpData;
+    int64             mDataLen;
+    std::vector<bool> mUsed; // which of the image's entries have been used this time
+    RecordMap         mRecords; // entries stored this time
+    int64             mNow;
+};
+
+#endif //__FSHASHCACHE_H
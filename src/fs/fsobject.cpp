@@ -72,14 +72,14 @@ public:
 #endif //_DEBUG
 
 
-cFSObject::cFSObject(const cFCOName& name) : mName(name)
+cFSObject::cFSObject(const cFCOName& name) : mName(name), mbStatFresh(false), mStatCount(0), mpParentDir(0)
 {
 #ifdef DEBUG
     gNumFSObjectCreate++;
 #endif
 }
 
-cFSObject::cFSObject() : mName(_T("undefined"))
+cFSObject::cFSObject() : mName(_T("undefined")), mbStatFresh(false), mStatCount(0), mpParentDir(0)
 {
 #ifdef DEBUG
     gNumFSObjectCreate++;
@@ -88,6 +88,9 @@ cFSObject::cFSObject() : mName(_T("undefined"))
 
 cFSObject::~cFSObject()
 {
+    if (mpParentDir)
+        mpParentDir->Release();
+
 #ifdef DEBUG
     gNumFSObjectDestroy++;
 #endif
@@ -104,6 +107,44 @@ void cFSObject::SetName(const cFCOName& name)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// SetParentDir
+///////////////////////////////////////////////////////////////////////////////
+void cFSObject::SetParentDir(cFSDirHandle* pDir)
+{
+    if (pDir)
+        pDir->AddRef();
+    if (mpParentDir)
+        mpParentDir->Release();
+    mpParentDir = pDir;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SetStatArgs, TakeStatArgs, PutBackStatArgs
+///////////////////////////////////////////////////////////////////////////////
+void cFSObject::SetStatArgs(const cFSStatArgs& stat)
+{
+    mStat       = stat;
+    mbStatFresh = true;
+    mStatCount++;
+}
+
+bool cFSObject::TakeStatArgs(cFSStatArgs& stat)
+{
+    if (!mbStatFresh)
+        return false;
+
+    stat        = mStat;
+    mbStatFresh = false;
+    return true;
+}
+
+void cFSObject::PutBackStatArgs(const cFSStatArgs& stat)
+{
+    mStat       = stat;
+    mbStatFresh = true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // GetCaps
 ///////////////////////////////////////////////////////////////////////////////
@@ -181,6 +222,9 @@ void cFSObject::Read(iSerializer* pSerializer, int32 version)
 
     pSerializer->ReadObject(&mName);
     pSerializer->ReadObject(&mPropSet);
+
+    // whatever we knew about the object on disk has nothing to do with this
+    mbStatFresh = false;
 }
 
 void cFSObject::Write(iSerializer* pSerializer) const
@@ -53,6 +53,10 @@
 #include "fco/fconame.h"
 #endif
 
+#ifndef __FSSERVICES_H
+#include "core/fsservices.h"
+#endif
+
 ///////////////////////////////////////////////////////////////////
 // cFSObject -- base class for files and directory FCOs
 class cFSObject : public iFCO
@@ -76,6 +80,27 @@ public:
     cFSPropSet&       GetFSPropSet();
     // returns a reference to the FS property set
 
+    void SetStatArgs(const cFSStatArgs& stat);
+    // called by whoever stat()s this object. The result is kept for the next
+    // property calculation, so that it doesn't have to stat() the object again.
+    bool TakeStatArgs(cFSStatArgs& stat);
+    // if the object has been stat()ed since the last property calculation, fills
+    // out stat with the result and returns true. A result is only handed out once,
+    // so any later calculation sees the object as it is at that time.
+    void PutBackStatArgs(const cFSStatArgs& stat);
+    // hands a result that was taken back for the next property calculation; this
+    // doesn't count as another stat()
+    void AddStat();
+    // records a stat() of this object whose result isn't kept
+    int GetStatCount() const;
+    // the number of times this object has been stat()ed since it was created
+
+    void          SetParentDir(cFSDirHandle* pDir);
+    cFSDirHandle* GetParentDir() const;
+    // the directory this object was found in, if it came from a directory iterator;
+    // null otherwise. The object only keeps a reference to the handle, so the
+    // directory may well have been closed by the time it is looked at.
+
     // iSerializable interface
     virtual void Read(iSerializer* pSerializer, int32 version = 0); // throw (eSerializer, eArchive)
     virtual void Write(iSerializer* pSerializer) const;             // throw (eSerializer, eArchive)
@@ -94,8 +119,12 @@ public:
     // stack.
 
 private:
-    cFSPropSet mPropSet;
-    cFCOName   mName;
+    cFSPropSet    mPropSet;
+    cFCOName      mName;
+    cFSStatArgs   mStat;       // the last stat() result, if mbStatFresh
+    bool          mbStatFresh; // has mStat been handed out yet?
+    int           mStatCount;
+    cFSDirHandle* mpParentDir;
 };
 
 //////////////////////////////////////////////////////
@@ -111,5 +140,20 @@ inline cFSPropSet& cFSObject::GetFSPropSet()
     return mPropSet;
 }
 
+inline void cFSObject::AddStat()
+{
+    mStatCount++;
+}
+
+inline int cFSObject::GetStatCount() const
+{
+    return mStatCount;
+}
+
+inline cFSDirHandle* cFSObject::GetParentDir() const
+{
+    return mpParentDir;
+}
+
 
 #endif
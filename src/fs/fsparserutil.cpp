@@ -116,6 +116,27 @@ bool cFSParserUtil::MapStringToProperty(const TSTRING& str, int& propIndex) cons
         case 'l':
             propIndex = cFSPropSet::PROP_GROWING_FILE;
             break;
+        case 'B':
+            propIndex = cFSPropSet::PROP_BTIME;
+            break;
+        case 'E':
+            propIndex = cFSPropSet::PROP_MTIME_NSEC;
+            break;
+        case 'F':
+            propIndex = cFSPropSet::PROP_CTIME_NSEC;
+            break;
+        case 'X':
+            propIndex = cFSPropSet::PROP_SHA256;
+            break;
+        case 'Y':
+            propIndex = cFSPropSet::PROP_SHA512;
+            break;
+        case 'W':
+            propIndex = cFSPropSet::PROP_BLAKE2;
+            break;
+        case 'Z':
+            propIndex = cFSPropSet::PROP_BLAKE3;
+            break;
         default:
             fMappedChar = false;
             break;
@@ -41,32 +41,409 @@
 #include "fco/twfactory.h"
 #include "fspropcalc.h"
 #include "fsobject.h"
+#include "fshashcache.h"
+#include "core/errorutil.h"
+#include "core/workerpool.h"
+#include "fsstrings.h"
 
 #include <unistd.h>
 #include <errno.h>
 
-cFSPropCalc::cFSPropCalc() : mCollAction(iFCOPropCalc::PROP_LEAVE), mCalcFlags(0), mpErrorBucket(0)
+// the most deferred hash tasks that may hold their file's directory open at once
+static const int MAX_HELD_DIRS = 256;
+
+// the longest symbolic link GetSymLinkStr() will make room for
+static const size_t MAX_SYMLINK_SIZE = 128 * TW_PATH_SIZE;
+
+///////////////////////////////////////////////////////////////////////////////
+// cFSHashTask -- generates the signatures of one file or symbolic link. This
+//      may run on a worker thread, so it only touches the name, archives and
+//      signatures it owns; an error is held onto until the prop calc passes it
+//      on to the error bucket.
+///////////////////////////////////////////////////////////////////////////////
+class cFSHashTask : public iWorkerTask
+{
+public:
+    cFSHashTask(const TSTRING& strName, cFSDirHandle* pDir, const TSTRING& strShortName, bool bSymLink, bool bDirectIO);
+    virtual ~cFSHashTask();
+
+    virtual void Run();
+
+    TSTRING           mName;
+    cFSDirHandle*     mpDir;      // if not null, the file is opened as mShortName in this directory,
+    TSTRING           mShortName; // which is held open until the task is destroyed
+    bool              mbSymLink;
+    bool              mbDirectIO;
+    cArchiveSigGen    mSigGen;
+    cFCOPropVector    mSigProps; // the signature properties being generated
+    bool              mbSuccess;
+    bool              mbHasError;
+    ePoly             mError;
+    uint32            mOrder; // when deferred, the order the task was handed to the pool
+    bool              mbCacheKey; // whether mCacheKey is set, so the signatures can be shared and cached
+    cFSHashCache::Key mCacheKey;
+    int64             mNLink; // the file's link count, if mCacheKey is set
+
+private:
+    void SetError(const eError& e);
+};
+
+cFSHashTask::cFSHashTask(
+    const TSTRING& strName, cFSDirHandle* pDir, const TSTRING& strShortName, bool bSymLink, bool bDirectIO)
+    : mName(strName),
+      mpDir(pDir),
+      mShortName(strShortName),
+      mbSymLink(bSymLink),
+      mbDirectIO(bDirectIO),
+      mbSuccess(false),
+      mbHasError(false),
+      mOrder(0),
+      mbCacheKey(false),
+      mNLink(0)
+{
+    if (mpDir)
+        mpDir->Hold();
+}
+
+cFSHashTask::~cFSHashTask()
+{
+    if (mpDir)
+        mpDir->Unhold();
+}
+
+void cFSHashTask::SetError(const eError& e)
+{
+    mError = e;
+    mError.SetFatality(false);
+    mbHasError = true;
+}
+
+void cFSHashTask::Run()
+{
+    cFileArchive   arch;
+    cMemoryArchive memArch;
+    cBidirArchive* pTheArch = &arch;
+
+    mbSuccess = false;
+
+    if (mbSymLink)
+    {
+        pTheArch = &memArch;
+        if (!cFSPropCalc::GetSymLinkStr(mpDir, mpDir ? mShortName : mName, memArch))
+        {
+            SetError(eArchiveOpen(mName, iFSServices::GetInstance()->GetErrString(), eError::NON_FATAL));
+            return;
+        }
+    }
+    else
+    {
+        try
+        {
+            arch.OpenRead(mpDir,
+                          mpDir ? mShortName.c_str() : mName.c_str(),
+                          (mbDirectIO ? cFileArchive::FA_SCANNING | cFileArchive::FA_DIRECT : cFileArchive::FA_SCANNING));
+        }
+        catch (eError&)
+        {
+            SetError(eArchiveOpen(mName, iFSServices::GetInstance()->GetErrString(), eError::NON_FATAL));
+            return;
+        }
+        catch (std::exception& e)
+        {
+            SetError(eArchiveOpen(mName, e.what(), eError::NON_FATAL));
+            return;
+        }
+        catch (...)
+        {
+            SetError(eArchiveOpen(mName, "unknown", eError::NON_FATAL));
+            return;
+        }
+    }
+
+    try
+    {
+        // big regular files are hashed straight out of a mapping, which saves copying them
+        // into a buffer; direct i/o is meant to stay out of the page cache, so it never is
+        const void* pMap      = 0;
+        int64       len       = mbSymLink ? 0 : arch.Length();
+        const int64 threshold = cArchiveSigGen::GetMapThreshold();
+        const int64 split     = cArchiveSigGen::GetSplitThreshold();
+
+        // and really big ones are hashed a piece at a time on several threads, if
+        // there are several and all their signatures can be put together from pieces
+        const bool bSplit = !mbSymLink && split > 0 && len >= split && cArchiveSigGen::GetHashThreads() > 1 &&
+                            mSigGen.CanSplit();
+
+        // the holes in sparse ones are hashed as zeros without reading them, which
+        // neither a mapping nor an ordinary read can do. A file no longer than a
+        // read is read in one go anyway, so isn't worth looking at.
+        const bool bSparse = !bSplit && !mbSymLink && len > cArchiveSigGen::GetReadSize() &&
+                             cArchiveSigGen::HasHoles(arch, len);
+        if (!bSplit && !bSparse && !mbSymLink && !mbDirectIO && threshold > 0 && len >= threshold)
+            pMap = arch.Map(len);
+
+        if (bSplit)
+        {
+            if (!mSigGen.CalculateSignatures(arch, len))
+                throw eArchiveRead(mName, TSS_GetString(cFS, fs::STR_FILE_SHRANK_WHILE_HASHED), eError::NON_FATAL);
+        }
+        else if (bSparse)
+        {
+            if (!mSigGen.CalculateSparseSignatures(arch, len))
+                throw eArchiveRead(mName, TSS_GetString(cFS, fs::STR_FILE_SHRANK_WHILE_HASHED), eError::NON_FATAL);
+        }
+        else if (pMap)
+        {
+            if (!mSigGen.CalculateSignatures(static_cast<const byte*>(pMap), len))
+                throw eArchiveRead(mName, TSS_GetString(cFS, fs::STR_FILE_SHRANK_WHILE_MAPPED), eError::NON_FATAL);
+        }
+        else
+        {
+            pTheArch->Seek(0, cBidirArchive::BEGINNING);
+            mSigGen.CalculateSignatures(*pTheArch, mName);
+        }
+        arch.Close();
+    }
+    catch (eError& e)
+    {
+        SetError(e);
+        return;
+    }
+    catch (std::exception& e)
+    {
+        SetError(eArchiveRead(mName, e.what(), eError::NON_FATAL));
+        return;
+    }
+    catch (...)
+    {
+        SetError(eArchiveRead(mName, "unknown", eError::NON_FATAL));
+        return;
+    }
+
+    mbSuccess = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cFSLinkMap -- the signatures of regular files with more than one hard link,
+//      so that the file is only read for the first of its links that is visited.
+//      An entry goes away once all of the file's links have been seen, and if
+//      there are ever MAX_ENTRIES of them, the oldest is dropped to make room.
+///////////////////////////////////////////////////////////////////////////////
+class cFSLinkMap
+{
+public:
+    cFSLinkMap();
+
+    bool Lookup(const cFSHashCache::Key& key, const cFCOPropVector& sigProps, cFSPropSet& propSet);
+    // if all of the signatures in sigProps are stored under key, this copies them
+    // into propSet and returns true
+    void Store(const cFSHashCache::Key& key, int64 nlink, const cFCOPropVector& sigProps, const cFSPropSet& propSet);
+    // keeps the signatures in sigProps from propSet for the file's other nlink - 1 links
+
+    cFSObject* GetPending(const cFSHashCache::Key& key) const;
+    void       SetPending(const cFSHashCache::Key& key, cFSObject* pObj);
+    void       ClearPending(const cFSHashCache::Key& key, cFSObject* pObj);
+    // the object whose deferred hash task is reading the file, if there is one
+
+    enum
+    {
+        MAX_ENTRIES = 4096
+    };
+
+private:
+    struct KeyLess
+    {
+        bool operator()(const cFSHashCache::Key& lhs, const cFSHashCache::Key& rhs) const;
+    };
+
+    struct Record
+    {
+        Record() : sigs(), props(cFSPropSet::PROP_NUMITEMS), linksLeft(0), age(0)
+        {
+        }
+
+        cFSPropSet     sigs;
+        cFCOPropVector props;     // which of sigs have been stored
+        int64          linksLeft; // how many more links are expected to look this up
+        uint32         age;       // this record's key in mAges
+    };
+
+    typedef std::map<cFSHashCache::Key, Record, KeyLess>     RecordMap;
+    typedef std::map<uint32, cFSHashCache::Key>               AgeMap;
+    typedef std::map<cFSHashCache::Key, cFSObject*, KeyLess> PendingMap;
+
+    void Erase(RecordMap::iterator i);
+
+    RecordMap  mRecords;
+    AgeMap     mAges; // mRecords' keys, oldest first
+    uint32     mNextAge;
+    PendingMap mPending;
+};
+
+bool cFSLinkMap::KeyLess::operator()(const cFSHashCache::Key& lhs, const cFSHashCache::Key& rhs) const
+{
+    if (lhs.dev != rhs.dev)
+        return lhs.dev < rhs.dev;
+    if (lhs.ino != rhs.ino)
+        return lhs.ino < rhs.ino;
+    if (lhs.size != rhs.size)
+        return lhs.size < rhs.size;
+    if (lhs.mtime != rhs.mtime)
+        return lhs.mtime < rhs.mtime;
+    return lhs.ctime < rhs.ctime;
+}
+
+cFSLinkMap::cFSLinkMap() : mNextAge(0)
+{
+}
+
+void cFSLinkMap::Erase(RecordMap::iterator i)
+{
+    mAges.erase(i->second.age);
+    mRecords.erase(i);
+}
+
+bool cFSLinkMap::Lookup(const cFSHashCache::Key& key, const cFCOPropVector& sigProps, cFSPropSet& propSet)
+{
+    RecordMap::iterator i = mRecords.find(key);
+    if (i == mRecords.end())
+        return false;
+
+    cFCOPropVector have = sigProps;
+    have &= i->second.props;
+    if (!(have == sigProps))
+        return false;
+
+    propSet.CopyProps(&i->second.sigs, sigProps);
+
+    if (--i->second.linksLeft <= 0)
+        Erase(i);
+
+    return true;
+}
+
+void cFSLinkMap::Store(const cFSHashCache::Key& key, int64 nlink, const cFCOPropVector& sigProps, const cFSPropSet& propSet)
+{
+    if (nlink < 2)
+        return;
+
+    RecordMap::iterator i = mRecords.find(key);
+    if (i == mRecords.end())
+    {
+        if (mRecords.size() >= MAX_ENTRIES)
+            Erase(mRecords.find(mAges.begin()->second));
+
+        i                 = mRecords.insert(std::make_pair(key, Record())).first;
+        i->second.age     = mNextAge++;
+        mAges[i->second.age] = key;
+    }
+
+    // whichever link this was, the rest of them are still to come
+    i->second.sigs.CopyProps(&propSet, sigProps);
+    i->second.props |= sigProps;
+    i->second.linksLeft = nlink - 1;
+}
+
+cFSObject* cFSLinkMap::GetPending(const cFSHashCache::Key& key) const
+{
+    PendingMap::const_iterator i = mPending.find(key);
+    return i == mPending.end() ? 0 : i->second;
+}
+
+void cFSLinkMap::SetPending(const cFSHashCache::Key& key, cFSObject* pObj)
+{
+    mPending[key] = pObj;
+}
+
+void cFSLinkMap::ClearPending(const cFSHashCache::Key& key, cFSObject* pObj)
+{
+    PendingMap::iterator i = mPending.find(key);
+    if (i != mPending.end() && i->second == pObj)
+        mPending.erase(i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cFSPropCalc
+///////////////////////////////////////////////////////////////////////////////
+cFSPropCalc::cFSPropCalc()
+    : mCollAction(iFCOPropCalc::PROP_LEAVE),
+      mCalcFlags(0),
+      mpErrorBucket(0),
+      mpWorkerPool(0),
+      mpHashCache(0),
+      mNumDeferred(0),
+      mNumHeldDirs(0),
+      mContentProps(cFSPropSet::PROP_NUMITEMS),
+      mQuickCheckProps(cFSPropSet::PROP_NUMITEMS),
+      mpLinks(new cFSLinkMap)
 {
+    mContentProps.AddItem(cFSPropSet::PROP_CRC32);
+    mContentProps.AddItem(cFSPropSet::PROP_MD5);
+    mContentProps.AddItem(cFSPropSet::PROP_SHA);
+    mContentProps.AddItem(cFSPropSet::PROP_HAVAL);
+    mContentProps.AddItem(cFSPropSet::PROP_SHA256);
+    mContentProps.AddItem(cFSPropSet::PROP_SHA512);
+    mContentProps.AddItem(cFSPropSet::PROP_BLAKE2);
+    mContentProps.AddItem(cFSPropSet::PROP_BLAKE3);
+
+    mQuickCheckProps.AddItem(cFSPropSet::PROP_SIZE);
+    mQuickCheckProps.AddItem(cFSPropSet::PROP_MTIME);
+    mQuickCheckProps.AddItem(cFSPropSet::PROP_CTIME);
+    mQuickCheckProps.AddItem(cFSPropSet::PROP_INODE);
 }
 
 cFSPropCalc::~cFSPropCalc()
 {
+    // anything still outstanding is abandoned; the tasks just have to be
+    // finished before they and their objects go away.
+    for (PendingMap::iterator i = mPending.begin(); i != mPending.end(); ++i)
+    {
+        mpWorkerPool->Wait(i->second);
+        delete i->second;
+        i->first->Release();
+    }
+
+    delete mpLinks;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// NeedsStat -- returns true if any properties are in the vector that require
-//      a stat() call
+// StatFields -- returns the cFSStatArgs::Fields a stat() needs to fetch for the
+//      properties in the vector; 0 if there are none that require a stat() call
 ///////////////////////////////////////////////////////////////////////////////
-static bool NeedsStat(const cFCOPropVector& v)
+static uint32 StatFields(const cFCOPropVector& v)
 {
-    return (v.ContainsItem(cFSPropSet::PROP_DEV) || v.ContainsItem(cFSPropSet::PROP_RDEV) ||
-            v.ContainsItem(cFSPropSet::PROP_INODE) || v.ContainsItem(cFSPropSet::PROP_MODE) ||
-            v.ContainsItem(cFSPropSet::PROP_NLINK) || v.ContainsItem(cFSPropSet::PROP_UID) ||
-            v.ContainsItem(cFSPropSet::PROP_GID) || v.ContainsItem(cFSPropSet::PROP_SIZE) ||
-            v.ContainsItem(cFSPropSet::PROP_ATIME) || v.ContainsItem(cFSPropSet::PROP_MTIME) ||
-            v.ContainsItem(cFSPropSet::PROP_CTIME) || v.ContainsItem(cFSPropSet::PROP_BLOCK_SIZE) ||
-            v.ContainsItem(cFSPropSet::PROP_BLOCKS) || v.ContainsItem(cFSPropSet::PROP_FILETYPE) ||
-            v.ContainsItem(cFSPropSet::PROP_GROWING_FILE));
+    static const struct
+    {
+        int    prop;
+        uint32 fields;
+    } fields[] = { { cFSPropSet::PROP_DEV, cFSStatArgs::FIELD_TYPE },
+                   { cFSPropSet::PROP_RDEV, cFSStatArgs::FIELD_TYPE },
+                   { cFSPropSet::PROP_INODE, cFSStatArgs::FIELD_INO },
+                   { cFSPropSet::PROP_MODE, cFSStatArgs::FIELD_MODE },
+                   { cFSPropSet::PROP_NLINK, cFSStatArgs::FIELD_NLINK },
+                   { cFSPropSet::PROP_UID, cFSStatArgs::FIELD_UID },
+                   { cFSPropSet::PROP_GID, cFSStatArgs::FIELD_GID },
+                   { cFSPropSet::PROP_SIZE, cFSStatArgs::FIELD_SIZE },
+                   { cFSPropSet::PROP_ATIME, cFSStatArgs::FIELD_ATIME },
+                   { cFSPropSet::PROP_MTIME, cFSStatArgs::FIELD_MTIME },
+                   { cFSPropSet::PROP_CTIME, cFSStatArgs::FIELD_CTIME },
+                   { cFSPropSet::PROP_MTIME_NSEC, cFSStatArgs::FIELD_MTIME },
+                   { cFSPropSet::PROP_CTIME_NSEC, cFSStatArgs::FIELD_CTIME },
+                   { cFSPropSet::PROP_BTIME, cFSStatArgs::FIELD_BTIME },
+                   { cFSPropSet::PROP_BLOCK_SIZE, cFSStatArgs::FIELD_TYPE },
+                   { cFSPropSet::PROP_BLOCKS, cFSStatArgs::FIELD_BLOCKS },
+                   { cFSPropSet::PROP_FILETYPE, cFSStatArgs::FIELD_TYPE },
+                   { cFSPropSet::PROP_GROWING_FILE, cFSStatArgs::FIELD_SIZE } };
+
+    uint32 result = 0;
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+    {
+        if (v.ContainsItem(fields[i].prop))
+            result |= fields[i].fields;
+    }
+
+    // dev, rdev and the block size come along with the file type
+    return result ? (result | cFSStatArgs::FIELD_TYPE) : 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -78,12 +455,17 @@ static bool NeedsStat(const cFCOPropVector& v)
 
 bool cFSPropCalc::GetSymLinkStr(const TSTRING& strName, cArchive& arch, size_t size)
 {
+    if (size == 0 || size > MAX_SYMLINK_SIZE)
+        return false;
+
     std::vector<char> data(size + 1);
     char*             buf = &data[0];
 
 #if defined(O_PATH) // A Linuxism that lets us read symlinks w/o bumping the access time.
-    int fd  = open(strName.c_str(), (O_PATH | O_NOFOLLOW | O_NOATIME));
-    int rtn = readlinkat(fd, 0, buf, size);
+    int fd = open(strName.c_str(), (O_PATH | O_NOFOLLOW | O_NOATIME));
+    if (fd < 0)
+        return false;
+    int rtn = readlinkat(fd, "", buf, size);
     close(fd);
 #else
     int rtn = readlink(strName.c_str(), buf, size);
@@ -108,7 +490,7 @@ bool cFSPropCalc::GetSymLinkStr(const TSTRING& strName, cArchive& arch, size_t s
     if ((size_t)rtn == size)
 #endif
     {
-        if (size < 128 * TW_PATH_SIZE)
+        if (size < MAX_SYMLINK_SIZE)
             return GetSymLinkStr(strName, arch, size * 2);
 
         return false;
@@ -120,20 +502,70 @@ bool cFSPropCalc::GetSymLinkStr(const TSTRING& strName, cArchive& arch, size_t s
     return true;
 }
 
+bool cFSPropCalc::GetSymLinkStr(const cFSDirHandle* pDir, const TSTRING& strName, cArchive& arch, size_t size)
+{
+#if SUPPORTS_DIR_FDS
+    if (pDir && pDir->GetFd() >= 0)
+    {
+        if (size == 0 || size > MAX_SYMLINK_SIZE)
+            return false;
+
+        std::vector<char> data(size + 1);
+        char*             buf = &data[0];
+
+#    if defined(O_PATH)
+        int fd = openat(pDir->GetFd(), strName.c_str(), (O_PATH | O_NOFOLLOW | O_NOATIME));
+        if (fd < 0)
+            return false;
+        int rtn = readlinkat(fd, "", buf, size);
+        close(fd);
+#    else
+        int rtn = readlinkat(pDir->GetFd(), strName.c_str(), buf, size);
+#    endif
+
+        if (rtn < 0)
+        {
+            // as above, some OSes say ERANGE rather than truncating
+            if (ERANGE == errno)
+                return GetSymLinkStr(pDir, strName, arch, size * 2);
+
+            return false;
+        }
+
+        // as above, a full buffer means the link may have been truncated
+        if ((size_t)rtn == size)
+        {
+            if (size < MAX_SYMLINK_SIZE)
+                return GetSymLinkStr(pDir, strName, arch, size * 2);
+
+            return false;
+        }
+
+        arch.WriteBlob(buf, rtn);
+        return true;
+    }
+#endif
+
+    return GetSymLinkStr(pDir ? pDir->GetPath(strName) : strName, arch, size);
+}
+
 void cFSPropCalc::AddPropCalcError(const eError& e)
 {
     if (mpErrorBucket)
         mpErrorBucket->AddError(e);
 }
 
-bool cFSPropCalc::DoStat(const TSTRING& strName, cFSStatArgs& statArgs)
+bool cFSPropCalc::DoStat(const cFSObject& obj, const TSTRING& strName, uint32 fields, cFSStatArgs& statArgs)
 {
     cDebug d("cFSPropCalc::DoStat");
 
     try
     {
         d.TraceDetail("---Performing Stat()\n");
-        iFSServices::GetInstance()->Stat(strName, statArgs);
+        if (obj.GetParentDir())
+            iFSServices::GetInstance()->Stat(*obj.GetParentDir(), obj.GetName().GetShortName(), statArgs, fields);
+        else
+            iFSServices::GetInstance()->Stat(strName, statArgs, fields);
     }
     catch (eError& e)
     {
@@ -158,65 +590,6 @@ bool cFSPropCalc::DoStat(const TSTRING& strName, cFSStatArgs& statArgs)
     return true;
 }
 
-bool cFSPropCalc::DoOpen(const TSTRING& strName, cFileArchive& arch)
-{
-    try
-    {
-        arch.OpenRead(strName.c_str(),
-                      ((mCalcFlags & iFCOPropCalc::DIRECT_IO) ? cFileArchive::FA_SCANNING | cFileArchive::FA_DIRECT :
-                                                                cFileArchive::FA_SCANNING));
-    }
-    catch (eError&)
-    {
-        AddPropCalcError(eArchiveOpen(strName, iFSServices::GetInstance()->GetErrString(), eError::NON_FATAL));
-        return false;
-    }
-    catch (std::exception& e)
-    {
-        AddPropCalcError(eArchiveOpen(strName, e.what(), eError::NON_FATAL));
-        return false;
-    }
-    catch (...)
-    {
-        AddPropCalcError(eArchiveOpen(strName, "unknown", eError::NON_FATAL));
-        return false;
-    }
-
-    return true;
-}
-
-bool cFSPropCalc::DoHash(const TSTRING& strName, cBidirArchive* pTheArch, cArchiveSigGen& asg, cFileArchive& arch)
-{
-    cDebug d("cFSPropCalc::DoHash");
-    try
-    {
-        pTheArch->Seek(0, cBidirArchive::BEGINNING);
-        asg.CalculateSignatures(*pTheArch);
-        arch.Close();
-    }
-    catch (eError& e)
-    {
-        d.TraceError("Error generating hashes for %s : %s\n", strName.c_str(), e.GetMsg().c_str());
-        e.SetFatality(false);
-        AddPropCalcError(e);
-        return false;
-    }
-    catch (std::exception& e)
-    {
-        d.TraceError("Error generating hashes for %s : %s\n", strName.c_str(), e.what());
-        AddPropCalcError(eArchiveRead(strName, e.what(), eError::NON_FATAL));
-        return false;
-    }
-    catch (...)
-    {
-        d.TraceError("Unknown error generating hashes for %s\n", strName.c_str());
-        AddPropCalcError(eArchiveRead(strName, "unknown", eError::NON_FATAL));
-        return false;
-    }
-
-    return true;
-}
-
 void cFSPropCalc::HandleStatProperties(const cFCOPropVector& propsToCheck, const cFSStatArgs& ss, cFSPropSet& propSet)
 {
     if (propsToCheck.ContainsItem(cFSPropSet::PROP_DEV))
@@ -249,9 +622,24 @@ void cFSPropCalc::HandleStatProperties(const cFCOPropVector& propsToCheck, const
     if (propsToCheck.ContainsItem(cFSPropSet::PROP_MTIME))
         propSet.SetModifyTime(ss.mtime);
 
+    if (propsToCheck.ContainsItem(cFSPropSet::PROP_MTIME_NSEC))
+        propSet.SetModifyTimeNsec(ss.mtimeNsec);
+
     if (propsToCheck.ContainsItem(cFSPropSet::PROP_CTIME))
         propSet.SetCreateTime(ss.ctime);
 
+    if (propsToCheck.ContainsItem(cFSPropSet::PROP_CTIME_NSEC))
+        propSet.SetCreateTimeNsec(ss.ctimeNsec);
+
+    if (propsToCheck.ContainsItem(cFSPropSet::PROP_BTIME))
+    {
+        // not every file system records this
+        if (ss.mFields & cFSStatArgs::FIELD_BTIME)
+            propSet.SetBirthTime(ss.btime);
+        else
+            propSet.SetUndefinedBirthTime();
+    }
+
     if (propsToCheck.ContainsItem(cFSPropSet::PROP_BLOCK_SIZE))
         propSet.SetBlockSize(ss.blksize);
 
@@ -305,9 +693,13 @@ void cFSPropCalc::HandleStatProperties(const cFCOPropVector& propsToCheck, const
     }
 }
 
-void cFSPropCalc::HandleHashes(const cFCOPropVector& propsToCheck, const TSTRING& strName, cFSPropSet& propSet)
+void cFSPropCalc::HandleHashes(const cFCOPropVector& propsToCheck,
+                               const TSTRING&        strName,
+                               cFSObject&            obj,
+                               const cFSStatArgs*    pStat)
 {
-    bool hash_success = false;
+    cFSPropSet& propSet      = obj.GetFSPropSet();
+    bool        hash_success = false;
 
     // if the file type is not a regular file, we will
     // not try to open the file for signature generation
@@ -316,66 +708,133 @@ void cFSPropCalc::HandleHashes(const cFCOPropVector& propsToCheck, const TSTRING
     {
         if ( // if we need to open the file
             propsToCheck.ContainsItem(cFSPropSet::PROP_CRC32) || propsToCheck.ContainsItem(cFSPropSet::PROP_MD5) ||
-            propsToCheck.ContainsItem(cFSPropSet::PROP_SHA) || propsToCheck.ContainsItem(cFSPropSet::PROP_HAVAL))
+            propsToCheck.ContainsItem(cFSPropSet::PROP_SHA) || propsToCheck.ContainsItem(cFSPropSet::PROP_HAVAL) ||
+            propsToCheck.ContainsItem(cFSPropSet::PROP_SHA256) || propsToCheck.ContainsItem(cFSPropSet::PROP_SHA512) ||
+            propsToCheck.ContainsItem(cFSPropSet::PROP_BLAKE2) || propsToCheck.ContainsItem(cFSPropSet::PROP_BLAKE3))
         {
-            cFileArchive   arch;
-            cMemoryArchive memArch;
-            cBidirArchive* pTheArch;
-            hash_success = true;
+            // open the file relative to its directory, if that is still open. A deferred
+            // task keeps the directory open until it is finished, so only so many of them
+            // are allowed to, to stay well clear of the descriptor limit.
+            bool          bDefer = mpWorkerPool && (mCalcFlags & iFCOPropCalc::DEFER_HASHES);
+            cFSDirHandle* pDir   = obj.GetParentDir();
+            if (pDir && (pDir->GetFd() < 0 || (bDefer && mNumHeldDirs >= MAX_HELD_DIRS)))
+                pDir = 0;
+
+            TW_UNIQUE_PTR<cFSHashTask> pTask(new cFSHashTask(strName,
+                                                             pDir,
+                                                             obj.GetName().GetShortName(),
+                                                             propSet.GetFileType() == cFSPropSet::FT_SYMLINK,
+                                                             (mCalcFlags & iFCOPropCalc::DIRECT_IO) != 0));
+
+            if (propsToCheck.ContainsItem(cFSPropSet::PROP_CRC32))
+            {
+                propSet.SetDefinedCRC32(true);
+                pTask->mSigGen.AddSig(propSet.GetCRC32());
+                pTask->mSigProps.AddItem(cFSPropSet::PROP_CRC32);
+            }
 
-            if (propSet.GetFileType() == cFSPropSet::FT_SYMLINK)
+            if (propsToCheck.ContainsItem(cFSPropSet::PROP_MD5))
             {
-                pTheArch = &memArch;
-                if (!GetSymLinkStr(strName, memArch))
-                {
-                    // add it to the bucket...
-                    AddPropCalcError(
-                        eArchiveOpen(strName, iFSServices::GetInstance()->GetErrString(), eError::NON_FATAL));
-                    hash_success = false;
-                }
+                propSet.SetDefinedMD5(true);
+                pTask->mSigGen.AddSig(propSet.GetMD5());
+                pTask->mSigProps.AddItem(cFSPropSet::PROP_MD5);
             }
-            else
+
+            if (propsToCheck.ContainsItem(cFSPropSet::PROP_SHA))
+            {
+                propSet.SetDefinedSHA(true);
+                pTask->mSigGen.AddSig(propSet.GetSHA());
+                pTask->mSigProps.AddItem(cFSPropSet::PROP_SHA);
+            }
+
+            if (propsToCheck.ContainsItem(cFSPropSet::PROP_HAVAL))
             {
-                pTheArch     = &arch;
-                hash_success = DoOpen(strName, arch);
+                propSet.SetDefinedHAVAL(true);
+                pTask->mSigGen.AddSig(propSet.GetHAVAL());
+                pTask->mSigProps.AddItem(cFSPropSet::PROP_HAVAL);
+            }
+
+            if (propsToCheck.ContainsItem(cFSPropSet::PROP_SHA256))
+            {
+                propSet.SetDefinedSHA256(true);
+                pTask->mSigGen.AddSig(propSet.GetSHA256());
+                pTask->mSigProps.AddItem(cFSPropSet::PROP_SHA256);
+            }
+
+            if (propsToCheck.ContainsItem(cFSPropSet::PROP_SHA512))
+            {
+                propSet.SetDefinedSHA512(true);
+                pTask->mSigGen.AddSig(propSet.GetSHA512());
+                pTask->mSigProps.AddItem(cFSPropSet::PROP_SHA512);
+            }
+
+            if (propsToCheck.ContainsItem(cFSPropSet::PROP_BLAKE2))
+            {
+                propSet.SetDefinedBLAKE2(true);
+                pTask->mSigGen.AddSig(propSet.GetBLAKE2());
+                pTask->mSigProps.AddItem(cFSPropSet::PROP_BLAKE2);
+            }
+
+            if (propsToCheck.ContainsItem(cFSPropSet::PROP_BLAKE3))
+            {
+                propSet.SetDefinedBLAKE3(true);
+                pTask->mSigGen.AddSig(propSet.GetBLAKE3());
+                pTask->mSigProps.AddItem(cFSPropSet::PROP_BLAKE3);
             }
 
             //
-            // if we have successfully initialized the archive
+            // nothing needs calculating if another link to the file has already
+            // been hashed, or if the file hasn't changed since its signatures
+            // were cached
             //
-            if (hash_success)
+            if (pStat && propSet.GetFileType() == cFSPropSet::FT_FILE)
             {
-                cArchiveSigGen asg;
+                cFSHashCache::MakeKey(*pStat, pTask->mCacheKey);
+                pTask->mbCacheKey = true;
+                pTask->mNLink     = ((mCalcFlags & iFCOPropCalc::HASH_EVERY_LINK) ? 0 : pStat->nlink);
 
-                if (propsToCheck.ContainsItem(cFSPropSet::PROP_CRC32))
+                if (pTask->mNLink > 1)
                 {
-                    propSet.SetDefinedCRC32(true);
-                    asg.AddSig(propSet.GetCRC32());
-                }
+                    // if another link is being hashed right now, wait for it
+                    cFSObject* pOther = mpLinks->GetPending(pTask->mCacheKey);
+                    if (pOther)
+                        FinishPending(pOther);
 
-                if (propsToCheck.ContainsItem(cFSPropSet::PROP_MD5))
-                {
-                    propSet.SetDefinedMD5(true);
-                    asg.AddSig(propSet.GetMD5());
-                }
-
-                if (propsToCheck.ContainsItem(cFSPropSet::PROP_SHA))
-                {
-                    propSet.SetDefinedSHA(true);
-                    asg.AddSig(propSet.GetSHA());
+                    if (mpLinks->Lookup(pTask->mCacheKey, pTask->mSigProps, propSet))
+                        return;
                 }
 
-                if (propsToCheck.ContainsItem(cFSPropSet::PROP_HAVAL))
+                if (mpHashCache && mpHashCache->Lookup(pTask->mCacheKey, pTask->mSigProps, propSet))
                 {
-                    propSet.SetDefinedHAVAL(true);
-                    asg.AddSig(propSet.GetHAVAL());
+                    if (pTask->mNLink > 1)
+                        mpLinks->Store(pTask->mCacheKey, pTask->mNLink, pTask->mSigProps, propSet);
+                    return;
                 }
+            }
 
-                //
-                // calculate the signatures
-                //
-                hash_success = DoHash(strName, pTheArch, asg, arch);
+            //
+            // hand the work off if we can; the object is held onto until the
+            // results are stored in it.
+            //
+            if (bDefer)
+            {
+                ASSERT(mPending.find(&obj) == mPending.end());
+                pTask->mOrder = mNumDeferred++;
+                if (pDir)
+                    mNumHeldDirs++;
+                if (pTask->mNLink > 1)
+                    mpLinks->SetPending(pTask->mCacheKey, &obj);
+                obj.AddRef();
+                mPending[&obj] = pTask.get();
+                mpWorkerPool->Submit(pTask.release());
+                return;
             }
+
+            //
+            // calculate the signatures
+            //
+            pTask->Run();
+            hash_success = FinishHash(*pTask, propSet);
         }
     }
 
@@ -393,9 +852,108 @@ void cFSPropCalc::HandleHashes(const cFCOPropVector& propsToCheck, const TSTRING
 
         if (propsToCheck.ContainsItem(cFSPropSet::PROP_HAVAL))
             propSet.SetDefinedHAVAL(false);
+
+        if (propsToCheck.ContainsItem(cFSPropSet::PROP_SHA256))
+            propSet.SetDefinedSHA256(false);
+
+        if (propsToCheck.ContainsItem(cFSPropSet::PROP_SHA512))
+            propSet.SetDefinedSHA512(false);
+
+        if (propsToCheck.ContainsItem(cFSPropSet::PROP_BLAKE2))
+            propSet.SetDefinedBLAKE2(false);
+
+        if (propsToCheck.ContainsItem(cFSPropSet::PROP_BLAKE3))
+            propSet.SetDefinedBLAKE3(false);
     }
 }
 
+bool cFSPropCalc::FinishHash(cFSHashTask& task, cFSPropSet& propSet)
+{
+    if (task.mbHasError)
+    {
+        cDebug d("cFSPropCalc::FinishHash");
+        d.TraceError("Error generating hashes for %s : %s\n", task.mName.c_str(), task.mError.GetMsg().c_str());
+        AddPropCalcError(task.mError);
+    }
+
+    if (!task.mbSuccess)
+    {
+        if (task.mSigProps.ContainsItem(cFSPropSet::PROP_CRC32))
+            propSet.SetDefinedCRC32(false);
+
+        if (task.mSigProps.ContainsItem(cFSPropSet::PROP_MD5))
+            propSet.SetDefinedMD5(false);
+
+        if (task.mSigProps.ContainsItem(cFSPropSet::PROP_SHA))
+            propSet.SetDefinedSHA(false);
+
+        if (task.mSigProps.ContainsItem(cFSPropSet::PROP_HAVAL))
+            propSet.SetDefinedHAVAL(false);
+
+        if (task.mSigProps.ContainsItem(cFSPropSet::PROP_SHA256))
+            propSet.SetDefinedSHA256(false);
+
+        if (task.mSigProps.ContainsItem(cFSPropSet::PROP_SHA512))
+            propSet.SetDefinedSHA512(false);
+
+        if (task.mSigProps.ContainsItem(cFSPropSet::PROP_BLAKE2))
+            propSet.SetDefinedBLAKE2(false);
+
+        if (task.mSigProps.ContainsItem(cFSPropSet::PROP_BLAKE3))
+            propSet.SetDefinedBLAKE3(false);
+    }
+    else if (task.mbCacheKey)
+    {
+        if (task.mNLink > 1)
+            mpLinks->Store(task.mCacheKey, task.mNLink, task.mSigProps, propSet);
+        if (mpHashCache)
+            mpHashCache->Store(task.mCacheKey, task.mSigProps, propSet);
+    }
+
+    return task.mbSuccess;
+}
+
+void cFSPropCalc::FinishPending(cFSObject* pObj)
+{
+    PendingMap::iterator i = mPending.find(pObj);
+    if (i == mPending.end())
+        return;
+
+    TW_UNIQUE_PTR<cFSHashTask> pTask(i->second);
+    mPending.erase(i);
+    if (pTask->mpDir)
+        mNumHeldDirs--;
+    if (pTask->mNLink > 1)
+        mpLinks->ClearPending(pTask->mCacheKey, pObj);
+
+    mpWorkerPool->Wait(pTask.get());
+    FinishHash(*pTask, pObj->GetFSPropSet());
+    pObj->Release();
+}
+
+static bool util_DeferredBefore(const std::pair<uint32, cFSObject*>& lhs, const std::pair<uint32, cFSObject*>& rhs)
+{
+    return lhs.first < rhs.first;
+}
+
+void cFSPropCalc::WaitForPending()
+{
+    // finish things in the order they were deferred, so errors are reported
+    // in a predictable order
+    std::vector<std::pair<uint32, cFSObject*> > order;
+    for (PendingMap::iterator i = mPending.begin(); i != mPending.end(); ++i)
+        order.push_back(std::make_pair(i->second->mOrder, i->first));
+    std::sort(order.begin(), order.end(), util_DeferredBefore);
+
+    for (std::vector<std::pair<uint32, cFSObject*> >::iterator i = order.begin(); i != order.end(); ++i)
+        FinishPending(i->second);
+}
+
+void cFSPropCalc::SetHashCache(iFCOHashCache* pCache)
+{
+    mpHashCache = static_cast<cFSHashCache*>(pCache);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // VisitFSObject -- this is the workhorse method that actually fills out the
 //      passed in FSObject' properties
@@ -405,6 +963,10 @@ void cFSPropCalc::VisitFSObject(cFSObject& obj)
     cDebug d("cFSPropCalc::VisitFSObject");
     d.TraceDetail(_T("Visiting %s\n"), obj.GetName().AsString().c_str());
 
+    // if this object's hashes were handed off the last time it was visited,
+    // store them now
+    FinishPending(&obj);
+
     // if we are not in overwrite mode, we need to alter the
     // properties we are calculating...
     cFCOPropVector propsToCheck(mPropVector);
@@ -425,9 +987,12 @@ void cFSPropCalc::VisitFSObject(cFSObject& obj)
     propsToCheck.TraceContents(cDebug::D_DETAIL);
 #endif //_DEBUG
 
-    // only do the stat() if it is necessary
+    // only do the stat() if it is necessary; the data source iterator has
+    // usually just done one, in which case we use what it found. Either way,
+    // that result is not used again after this.
     cFSStatArgs ss;
-    TSTRING     strName = iTWFactory::GetInstance()->GetNameTranslator()->ToStringAPI(obj.GetName());
+    bool        bHaveStat = obj.TakeStatArgs(ss);
+    TSTRING     strName   = iTWFactory::GetInstance()->GetNameTranslator()->ToStringAPI(obj.GetName());
 
     // get a reference to the fco's property set
     cFSPropSet& propSet = obj.GetFSPropSet();
@@ -438,15 +1003,33 @@ void cFSPropCalc::VisitFSObject(cFSObject& obj)
     if (propSet.GetFileType() == cFSPropSet::FT_INVALID)
         return;
 
-    if (NeedsStat(propsToCheck))
+    // other links to the file and the hash cache are looked up by what stat()
+    // says about the file, too
+    uint32 fields = StatFields(propsToCheck);
+    bool   bKey   = (mpHashCache || !(mCalcFlags & iFCOPropCalc::HASH_EVERY_LINK)) &&
+                 !((propsToCheck & mContentProps) == cFCOPropVector(cFSPropSet::PROP_NUMITEMS));
+    bool   bKeep  = fields && (mCalcFlags & iFCOPropCalc::KEEP_STAT);
+    if (bKey || (bKeep && (mpHashCache || !(mCalcFlags & iFCOPropCalc::HASH_EVERY_LINK))))
+        fields |= cFSHashCache::GetKeyFields() | cFSStatArgs::FIELD_NLINK;
+
+    if (fields)
     {
-        if (!DoStat(strName, ss))
-            return;
+        // the iterator's stat() may not have fetched everything we need
+        if (!bHaveStat || (ss.mRequested & fields) != fields)
+        {
+            obj.AddStat();
+            if (!DoStat(obj, strName, fields, ss))
+                return;
+        }
 
         HandleStatProperties(propsToCheck, ss, propSet);
+
+        // the next visit will want what stat() said about the file to hash it
+        if (bKeep)
+            obj.PutBackStatArgs(ss);
     }
 
-    HandleHashes(propsToCheck, strName, propSet);
+    HandleHashes(propsToCheck, strName, obj, bKey ? &ss : 0);
 }
 
 void cFSPropCalc::SetPropVector(const cFCOPropVector& pv)
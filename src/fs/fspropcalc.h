@@ -62,6 +62,10 @@
 TSS_FILE_EXCEPTION(eFSPropCalc, eFileError)
 //TSS_EXCEPTION( eFSPropCalcResetAccessTime,    eFSPropCalc ) // this was never used
 
+class cFSHashTask;
+class cFSHashCache;
+class cFSLinkMap;
+
 class cFSPropCalc : public iFCOPropCalc, public iFSVisitor
 {
 public:
@@ -86,7 +90,22 @@ public:
     virtual int  GetCalcFlags() const;
     virtual void SetCalcFlags(int i);
 
+    virtual void         SetWorkerPool(cWorkerPool* pPool);
+    virtual cWorkerPool* GetWorkerPool() const;
+    virtual void         WaitForPending();
+    virtual void         SetHashCache(iFCOHashCache* pCache);
+    // pCache must be a cFSHashCache
+
+    virtual const cFCOPropVector& GetContentProps() const;
+    virtual const cFCOPropVector& GetQuickCheckProps() const;
+    // the hashes, and size/mtime/ctime/inode respectively
+
+    // unless HASH_EVERY_LINK is set, a regular file with more than one hard link is
+    // hashed once per prop calc, and the other links get the same signatures
+
     static bool GetSymLinkStr(const TSTRING& strName, cArchive& arch, size_t size = TW_PATH_SIZE);
+    static bool GetSymLinkStr(const cFSDirHandle* pDir, const TSTRING& strName, cArchive& arch, size_t size = TW_PATH_SIZE);
+    // the second looks strName up in pDir, if that is not null
 
 private:
     cFSPropCalc(const cFSPropCalc&);
@@ -94,16 +113,29 @@ private:
 
     void AddPropCalcError(const eError& e);
 
-    bool DoStat(const TSTRING& name, cFSStatArgs& statArgs);
-    bool DoOpen(const TSTRING& name, cFileArchive& arch);
-    bool DoHash(const TSTRING& name, cBidirArchive* pTheArch, cArchiveSigGen& asg, cFileArchive& arch);
+    bool DoStat(const cFSObject& obj, const TSTRING& name, uint32 fields, cFSStatArgs& statArgs);
     void HandleStatProperties(const cFCOPropVector& propsToCheck, const cFSStatArgs& ss, cFSPropSet& propSet);
-    void HandleHashes(const cFCOPropVector& propsToCheck, const TSTRING& strName, cFSPropSet& propSet);
+    void HandleHashes(const cFCOPropVector& propsToCheck, const TSTRING& strName, cFSObject& obj, const cFSStatArgs* pStat);
+    // pStat is the stat() to look other links and the hash cache up with, if there is one
+    bool FinishHash(cFSHashTask& task, cFSPropSet& propSet);
+    // stores the outcome of a hash task in propSet, returning false if hashing failed
+    void FinishPending(cFSObject* pObj);
+    // waits for pObj's deferred hash task, if it has one, and finishes it
+
+    typedef std::map<cFSObject*, cFSHashTask*> PendingMap;
 
     cFCOPropVector                mPropVector;
     iFCOPropCalc::CollisionAction mCollAction;
     int                           mCalcFlags;
     cErrorBucket*                 mpErrorBucket;
+    cWorkerPool*                  mpWorkerPool;
+    cFSHashCache*                 mpHashCache;
+    PendingMap                    mPending;    // deferred hash tasks, by the object they belong to
+    uint32                        mNumDeferred; // next task mOrder; WaitForPending() sorts by it to collect in submission order
+    int                           mNumHeldDirs; // how many of mPending are holding their directory open
+    cFCOPropVector                mContentProps;
+    cFCOPropVector                mQuickCheckProps;
+    cFSLinkMap*                   mpLinks; // signatures of files with links still to be visited
 };
 
 inline int cFSPropCalc::GetCalcFlags() const
@@ -116,5 +148,25 @@ inline void cFSPropCalc::SetCalcFlags(int i)
     mCalcFlags = i;
 }
 
+inline void cFSPropCalc::SetWorkerPool(cWorkerPool* pPool)
+{
+    mpWorkerPool = pPool;
+}
+
+inline cWorkerPool* cFSPropCalc::GetWorkerPool() const
+{
+    return mpWorkerPool;
+}
+
+inline const cFCOPropVector& cFSPropCalc::GetContentProps() const
+{
+    return mContentProps;
+}
+
+inline const cFCOPropVector& cFSPropCalc::GetQuickCheckProps() const
+{
+    return mQuickCheckProps;
+}
+
 
 #endif //__FSPROPCALC_H
@@ -90,6 +90,7 @@ cFSPropDisplayer::cFSPropDisplayer() : mbLazy(false)
     mpvPropsWeDisplay.AddItemAndGrow(cFSPropSet::PROP_ATIME);
     mpvPropsWeDisplay.AddItemAndGrow(cFSPropSet::PROP_MTIME);
     mpvPropsWeDisplay.AddItemAndGrow(cFSPropSet::PROP_CTIME);
+    mpvPropsWeDisplay.AddItemAndGrow(cFSPropSet::PROP_BTIME);
     mpvPropsWeDisplay.AddItemAndGrow(cFSPropSet::PROP_MODE);
 
     mpvPropsWeDisplay.AddItemAndGrow(cFSPropSet::PROP_BLOCK_SIZE);
@@ -337,6 +338,7 @@ TSTRING cFSPropDisplayer::PropAsString(const iFCO* const pFCO, const int propIdx
         case cFSPropSet::PROP_ATIME:
         case cFSPropSet::PROP_MTIME:
         case cFSPropSet::PROP_CTIME:
+        case cFSPropSet::PROP_BTIME:
         {
             const cFCOPropInt64* const pTypedProp = static_cast<const cFCOPropInt64* const>(pProp);
             int64                      i64        = pTypedProp->GetValue();
@@ -84,7 +84,9 @@ static int cFSPropSet_PropNames[] = {
     fs::STR_PROP_FILETYPE, fs::STR_PROP_DEV,   fs::STR_PROP_RDEV,       fs::STR_PROP_INODE,  fs::STR_PROP_MODE,
     fs::STR_PROP_NLINK,    fs::STR_PROP_UID,   fs::STR_PROP_GID,        fs::STR_PROP_SIZE,   fs::STR_PROP_ATIME,
     fs::STR_PROP_MTIME,    fs::STR_PROP_CTIME, fs::STR_PROP_BLOCK_SIZE, fs::STR_PROP_BLOCKS, fs::STR_PROP_GROWING_FILE,
-    fs::STR_PROP_CRC32,    fs::STR_PROP_MD5,   fs::STR_PROP_SHA,        fs::STR_PROP_HAVAL,  fs::STR_PROP_ACL};
+    fs::STR_PROP_CRC32,    fs::STR_PROP_MD5,   fs::STR_PROP_SHA,        fs::STR_PROP_HAVAL,  fs::STR_PROP_ACL,
+    fs::STR_PROP_BTIME,    fs::STR_PROP_SHA256, fs::STR_PROP_SHA512,    fs::STR_PROP_BLAKE2, fs::STR_PROP_BLAKE3,
+    fs::STR_PROP_MTIME_NSEC, fs::STR_PROP_CTIME_NSEC};
 
 ///////////////////////////////////////////////////////////////////////////////
 // TraceContents
@@ -283,6 +285,20 @@ const iFCOProp* cFSPropSet::GetPropAt(int index) const
     case PROP_ACL:
         ASSERT(false); // unimplemented
         return NULL;
+    case PROP_BTIME:
+        return &mBirthTime;
+    case PROP_SHA256:
+        return &mSHA256;
+    case PROP_SHA512:
+        return &mSHA512;
+    case PROP_BLAKE2:
+        return &mBLAKE2;
+    case PROP_BLAKE3:
+        return &mBLAKE3;
+    case PROP_MTIME_NSEC:
+        return &mModifyTimeNsec;
+    case PROP_CTIME_NSEC:
+        return &mCreateTimeNsec;
     default:
     {
         // bad parameter passed to GetPropAt
@@ -349,6 +365,20 @@ iFCOProp* cFSPropSet::GetPropAt(int index)
     case PROP_ACL:
         ASSERT(false); // unimplemented
         return NULL;
+    case PROP_BTIME:
+        return &mBirthTime;
+    case PROP_SHA256:
+        return &mSHA256;
+    case PROP_SHA512:
+        return &mSHA512;
+    case PROP_BLAKE2:
+        return &mBLAKE2;
+    case PROP_BLAKE3:
+        return &mBLAKE3;
+    case PROP_MTIME_NSEC:
+        return &mModifyTimeNsec;
+    case PROP_CTIME_NSEC:
+        return &mCreateTimeNsec;
     default:
     {
         // bad parameter passed to GetPropAt
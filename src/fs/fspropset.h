@@ -94,6 +94,13 @@ public:
         PROP_SHA,
         PROP_HAVAL,
         PROP_ACL,
+        PROP_BTIME,
+        PROP_SHA256,
+        PROP_SHA512,
+        PROP_BLAKE2,
+        PROP_BLAKE3,
+        PROP_MTIME_NSEC, // the nanoseconds of PROP_MTIME
+        PROP_CTIME_NSEC, // and of PROP_CTIME
 
         PROP_NUMITEMS
     };
@@ -164,6 +171,13 @@ public:
     PROPERTY_OBJ(cSHASignature, SHA, PROP_SHA)
     PROPERTY_OBJ(cHAVALSignature, HAVAL, PROP_HAVAL)
     //PROPERTY_OBJ(cUnixACL,        ACL,            PROP_ACL)  // will eventually be implememented
+    PROPERTY(cFCOPropInt64, BirthTime, PROP_BTIME) //stx_btime -- creation time, where the file system keeps one
+    PROPERTY_OBJ(cSHA256Signature, SHA256, PROP_SHA256)
+    PROPERTY_OBJ(cSHA512Signature, SHA512, PROP_SHA512)
+    PROPERTY_OBJ(cBLAKE2Signature, BLAKE2, PROP_BLAKE2) // BLAKE2b-512
+    PROPERTY_OBJ(cBLAKE3Signature, BLAKE3, PROP_BLAKE3)
+    PROPERTY(cFCOPropInt64, ModifyTimeNsec, PROP_MTIME_NSEC) //st_mtim.tv_nsec
+    PROPERTY(cFCOPropInt64, CreateTimeNsec, PROP_CTIME_NSEC) //st_ctim.tv_nsec
 
     // iSerializable interface
     virtual void Read(iSerializer* pSerializer, int32 version = 0); // throw (eSerializer, eArchive)
@@ -62,6 +62,11 @@ TSS_BeginStringtable(cFS)
     TSS_StringEntry(fs::STR_PROP_GROWING_FILE, _T("Growing Object Size")), TSS_StringEntry(fs::STR_PROP_SHA, _T("SHA")),
     TSS_StringEntry(fs::STR_PROP_HAVAL, _T("HAVAL")),
     TSS_StringEntry(fs::STR_PROP_ACL, _T("ACL Placeholder -- Not Implemented")),
+    TSS_StringEntry(fs::STR_PROP_BTIME, _T("Birth Time")),
+    TSS_StringEntry(fs::STR_PROP_SHA256, _T("SHA-256")), TSS_StringEntry(fs::STR_PROP_SHA512, _T("SHA-512")),
+    TSS_StringEntry(fs::STR_PROP_BLAKE2, _T("BLAKE2")), TSS_StringEntry(fs::STR_PROP_BLAKE3, _T("BLAKE3")),
+    TSS_StringEntry(fs::STR_PROP_MTIME_NSEC, _T("Modify Time (ns)")),
+    TSS_StringEntry(fs::STR_PROP_CTIME_NSEC, _T("Change Time (ns)")),
 
     /*  Leaving these here in case we ever implement long property names
 
@@ -99,5 +104,8 @@ TSS_BeginStringtable(cFS)
     TSS_StringEntry(fs::STR_FS_PARSER_HOSTNAME_VAL, _T("localhost" )),
 
     TSS_StringEntry(fs::STR_DIFFERENT_FILESYSTEM, _T("The object: \"%s\" is on a different file system...ignoring.\n")),
+    TSS_StringEntry(fs::STR_FILE_SHRANK_WHILE_MAPPED, _T("File shrank while it was mapped for hashing")),
+    TSS_StringEntry(fs::STR_FILE_SHRANK_WHILE_HASHED, _T("File shrank while it was being hashed")),
+    TSS_StringEntry(fs::STR_HASH_CACHE_BAD_FORMAT, _T("Hash cache is not in the expected format")),
 
     TSS_EndStringtable(cFS)
@@ -53,6 +53,8 @@ TSS_BeginStringIds(fs)
     STR_PROP_DEV, STR_PROP_RDEV, STR_PROP_INODE, STR_PROP_MODE, STR_PROP_NLINK, STR_PROP_UID, STR_PROP_GID,
     STR_PROP_SIZE, STR_PROP_ATIME, STR_PROP_MTIME, STR_PROP_CTIME, STR_PROP_BLOCK_SIZE, STR_PROP_BLOCKS, STR_PROP_CRC32,
     STR_PROP_MD5, STR_PROP_FILETYPE, STR_PROP_GROWING_FILE, STR_PROP_SHA, STR_PROP_HAVAL, STR_PROP_ACL,
+    STR_PROP_BTIME, STR_PROP_SHA256, STR_PROP_SHA512, STR_PROP_BLAKE2, STR_PROP_BLAKE3,
+    STR_PROP_MTIME_NSEC, STR_PROP_CTIME_NSEC,
 
     /* Leaving these here in case we ever implement long property names
     STR_PARSER_PROP_DEV,
@@ -81,7 +83,7 @@ TSS_BeginStringIds(fs)
     STR_FS_PARSER_READONLY_VAL, STR_FS_PARSER_DYNAMIC_VAL, STR_FS_PARSER_GROWING_VAL, STR_FS_PARSER_IGNOREALL_VAL,
     STR_FS_PARSER_IGNORENONE_VAL, STR_FS_PARSER_DEVICE_VAL, STR_FS_PARSER_HOSTNAME_VAL,
 
-    STR_DIFFERENT_FILESYSTEM
+    STR_DIFFERENT_FILESYSTEM, STR_FILE_SHRANK_WHILE_MAPPED, STR_FILE_SHRANK_WHILE_HASHED, STR_HASH_CACHE_BAD_FORMAT
 
     TSS_EndStringIds(fs)
 
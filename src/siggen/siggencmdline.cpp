@@ -129,6 +129,10 @@ void cSiggenCmdLine::InitCmdLineParser(cCmdLineParser& parser)
     parser.AddArg(MD5, TSTRING(_T("M")), TSTRING(_T("MD5")), cCmdLineParser::PARAM_NONE);
     parser.AddArg(SHA, TSTRING(_T("S")), TSTRING(_T("SHA")), cCmdLineParser::PARAM_NONE);
     parser.AddArg(HAVAL, TSTRING(_T("H")), TSTRING(_T("HAVAL")), cCmdLineParser::PARAM_NONE);
+    parser.AddArg(SHA256, TSTRING(_T("X")), TSTRING(_T("SHA256")), cCmdLineParser::PARAM_NONE);
+    parser.AddArg(SHA512, TSTRING(_T("Y")), TSTRING(_T("SHA512")), cCmdLineParser::PARAM_NONE);
+    parser.AddArg(BLAKE2, TSTRING(_T("W")), TSTRING(_T("BLAKE2")), cCmdLineParser::PARAM_NONE);
+    parser.AddArg(BLAKE3, TSTRING(_T("Z")), TSTRING(_T("BLAKE3")), cCmdLineParser::PARAM_NONE);
 
     //Output switches
     parser.AddArg(ALL, TSTRING(_T("a")), TSTRING(_T("all")), cCmdLineParser::PARAM_NONE);
@@ -271,6 +275,7 @@ int cSiggenCmdLine::Init(cCmdLineParser& parser)
     iter.SeekBegin();
     int  i          = 0; //loop variable
     bool crc_select = false, md5_select = false, sha_select = false, haval_select = false;
+    bool sha256_select = false, sha512_select = false, blake2_select = false, blake3_select = false;
     //boolean locals for dealing with ALL switch. (temp.?) fix -DA
     bool switch_present = false;
     int  ret            = 0; //return value. will be false unless some file is specified.
@@ -303,9 +308,30 @@ int cSiggenCmdLine::Init(cCmdLineParser& parser)
             haval_select = switch_present = true;
             break;
         }
+        case SHA256:
+        {
+            sha256_select = switch_present = true;
+            break;
+        }
+        case SHA512:
+        {
+            sha512_select = switch_present = true;
+            break;
+        }
+        case BLAKE2:
+        {
+            blake2_select = switch_present = true;
+            break;
+        }
+        case BLAKE3:
+        {
+            blake3_select = switch_present = true;
+            break;
+        }
         case ALL:
         {
             crc_select = md5_select = sha_select = haval_select = switch_present = true;
+            sha256_select = sha512_select = blake2_select = blake3_select = true;
             break;
         }
         case HEX:
@@ -333,7 +359,10 @@ int cSiggenCmdLine::Init(cCmdLineParser& parser)
 
     //Default behavior is to print all signatures if no switch is specified.
     if (!switch_present)
+    {
         crc_select = md5_select = sha_select = haval_select = true;
+        sha256_select = sha512_select = blake2_select = blake3_select = true;
+    }
 
     //Push the signatures and their output identifiers onto the mSignature list:
     if (crc_select)
@@ -360,6 +389,30 @@ int cSiggenCmdLine::Init(cCmdLineParser& parser)
         TSTRING     str     = TSS_GetString(cFS, fs::STR_PROP_HAVAL);
         mpData->mSignatures.push_back(std::pair<iSignature*, TSTRING>(sig_ptr, str));
     }
+    if (sha256_select)
+    {
+        iSignature* sig_ptr = new cSHA256Signature;
+        TSTRING     str     = TSS_GetString(cFS, fs::STR_PROP_SHA256);
+        mpData->mSignatures.push_back(std::pair<iSignature*, TSTRING>(sig_ptr, str));
+    }
+    if (sha512_select)
+    {
+        iSignature* sig_ptr = new cSHA512Signature;
+        TSTRING     str     = TSS_GetString(cFS, fs::STR_PROP_SHA512);
+        mpData->mSignatures.push_back(std::pair<iSignature*, TSTRING>(sig_ptr, str));
+    }
+    if (blake2_select)
+    {
+        iSignature* sig_ptr = new cBLAKE2Signature;
+        TSTRING     str     = TSS_GetString(cFS, fs::STR_PROP_BLAKE2);
+        mpData->mSignatures.push_back(std::pair<iSignature*, TSTRING>(sig_ptr, str));
+    }
+    if (blake3_select)
+    {
+        iSignature* sig_ptr = new cBLAKE3Signature;
+        TSTRING     str     = TSS_GetString(cFS, fs::STR_PROP_BLAKE3);
+        mpData->mSignatures.push_back(std::pair<iSignature*, TSTRING>(sig_ptr, str));
+    }
 
     return ret;
 }
@@ -68,6 +68,10 @@ public:
         MD5,
         SHA,
         HAVAL,
+        SHA256,
+        SHA512,
+        BLAKE2,
+        BLAKE3,
 
         //Output switches:
         ALL,
@@ -64,6 +64,10 @@ TSS_BeginStringtable(cSiggen)
                     _T("  -M                   --MD5\n")
                     _T("  -S                   --SHA\n")
                     _T("  -H                   --HAVAL\n")
+                    _T("  -X                   --SHA256\n")
+                    _T("  -Y                   --SHA512\n")
+                    _T("  -W                   --BLAKE2\n")
+                    _T("  -Z                   --BLAKE3\n")
                     _T("file1 [file 2 ...]\n")
                     _T("\n")),
     TSS_StringEntry(siggen::STR_SIGGEN_VERSION, _T("siggen: Display signature function values. \n")),
@@ -65,6 +65,16 @@ BEGIN {
                   violations  => "V:0 S:0 A:0 R:0 C:0"
                   },
 
+              "5-createFile" => {
+
+                  changeFunc  => \&twtools::MakeBigger,
+                  createFunc  => \&twtools::CreateFile,
+                  file        => "xywz.txt",
+                  perms       => "a+w",
+                  contents    => "testing",
+                  violations  => "V:1 S:0 A:0 R:0 C:1"
+                  },
+
 
               );
 
@@ -85,6 +95,7 @@ $twtools::twcwd/$twtools::twrootdir/$TESTS{"1-createFile"}{file}  -> +M;
 $twtools::twcwd/$twtools::twrootdir/$TESTS{"2-createFile"}{file}  -> +S;
 $twtools::twcwd/$twtools::twrootdir/$TESTS{"3-createFile"}{file}  -> +H;
 $twtools::twcwd/$twtools::twrootdir/$TESTS{"4-createFile"}{file}  -> +CMSH;
+$twtools::twcwd/$twtools::twrootdir/$TESTS{"5-createFile"}{file}  -> +XYWZ;
 
 EOT
 
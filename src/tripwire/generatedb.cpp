@@ -56,8 +56,12 @@
 //
 //      this returns true if at least one object was added to the directory.
 ///////////////////////////////////////////////////////////////////////////////
-static void util_ProcessDir(
-    cDbDataSourceIter dbIter, iFCODataSourceIter* pIter, iFCOSpec* pSpec, iFCOPropCalc* pPC, iFCOPropDisplayer* pPD)
+static void util_ProcessDir(cDbDataSourceIter   dbIter,
+                            iFCODataSourceIter* pIter,
+                            iFCOSpec*           pSpec,
+                            iFCOPropCalc*       pPC,
+                            iFCOPropDisplayer*  pPD,
+                            cErrorBucket*       pBucket)
 {
     ASSERT(!dbIter.Done());
     ASSERT(!pIter->Done());
@@ -71,6 +75,10 @@ static void util_ProcessDir(
     pIter->Descend();
     dbIter.Descend();
     //
+    // get the hashing for this directory going in the background, if we can
+    //
+    cPeerPrecalc precalc(pIter, pSpec, pPC, pBucket);
+    //
     // now, iterate through the data source, adding entries to the database ...
     //
     for (pIter->SeekBegin(); !pIter->Done(); pIter->Next())
@@ -86,6 +94,7 @@ static void util_ProcessDir(
         //      this should never really happen unless the data source iter is screwed up.
         // TODO -- use a smart reference counted object pointer here to release the object when it
         //      goes out of scope.
+        precalc.ReleaseErrors(pIter);
         iFCO* pFCO = pIter->CreateFCO();
         if (pFCO)
         {
@@ -102,7 +111,7 @@ static void util_ProcessDir(
                     dbIter.AddChildArray();
                 }
                 TW_UNIQUE_PTR<iFCODataSourceIter> pCopy(pIter->CreateCopy());
-                util_ProcessDir(dbIter, pCopy.get(), pSpec, pPC, pPD);
+                util_ProcessDir(dbIter, pCopy.get(), pSpec, pPC, pPD, pBucket);
                 //
                 // if no files were added, remove the child array...
                 //
@@ -118,8 +127,13 @@ static void util_ProcessDir(
 ///////////////////////////////////////////////////////////////////////////////
 // Execute
 ///////////////////////////////////////////////////////////////////////////////
-void cGenerateDb::Execute(
-    const cFCOSpecList& specList, cHierDatabase& db, iFCOPropDisplayer* pPD, cErrorBucket* pBucket, uint32 flags)
+void cGenerateDb::Execute(const cFCOSpecList& specList,
+                          cHierDatabase&      db,
+                          iFCOPropDisplayer*  pPD,
+                          cErrorBucket*       pBucket,
+                          uint32              flags,
+                          cWorkerPool*        pPool,
+                          iFCOHashCache*      pCache)
 {
     // TODO -- assert the db is empty or clear it out myself!
 
@@ -154,6 +168,15 @@ void cGenerateDb::Execute(
         pPC->SetCalcFlags(pPC->GetCalcFlags() | iFCOPropCalc::DIRECT_IO);
     }
 
+    if (flags & FLAG_HASH_EVERY_LINK)
+    {
+        pPC->SetCalcFlags(pPC->GetCalcFlags() | iFCOPropCalc::HASH_EVERY_LINK);
+    }
+
+    pPC->SetWorkerPool(pPool);
+    pPC->SetHashCache(pCache);
+    pDSIter->SetWorkerPool(pPool);
+
     //
     // iterate over all of the specs...
     //
@@ -166,6 +189,10 @@ void cGenerateDb::Execute(
             TSS_GetString(cTripwire, tripwire::STR_NOTIFY_PROCESSING).c_str(),
             iTWFactory::GetInstance()->GetNameTranslator()->ToStringDisplay(specIter.Spec()->GetStartPoint()).c_str());
         //
+        // let the data source skip looking up what this spec doesn't need
+        //
+        pDSIter->SetLeafProps(specIter.Spec()->GetPropVector(iFCOSpecMask::GetDefaultMask()));
+        //
         // have the iterators seek to the appropriate starting point
         //
         pDSIter->SeekToFCO(specIter.Spec()->GetStartPoint(), false); // false means don't generate my peers...
@@ -195,7 +222,7 @@ void cGenerateDb::Execute(
                         dbIter.AddChildArray();
                     }
                     TW_UNIQUE_PTR<iFCODataSourceIter> pCopy(pDSIter->CreateCopy());
-                    util_ProcessDir(dbIter, pCopy.get(), specIter.Spec(), pPC.get(), pPD);
+                    util_ProcessDir(dbIter, pCopy.get(), specIter.Spec(), pPC.get(), pPD, pBucket);
                     //
                     // if no files were added, remove the child array...
                     //
@@ -207,4 +234,6 @@ void cGenerateDb::Execute(
             }
         }
     }
+
+    pPC->WaitForPending();
 }
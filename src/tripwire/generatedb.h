@@ -45,6 +45,8 @@ class cErrorBucket;
 class cFCOSpecList;
 class cHierDatabase;
 class iFCOPropDisplayer;
+class cWorkerPool;
+class iFCOHashCache;
 
 class cGenerateDb
 {
@@ -53,8 +55,12 @@ public:
                         cHierDatabase&      db,
                         iFCOPropDisplayer*  pPD,
                         cErrorBucket*       pBucket,
-                        uint32              flags = 0);
-    // generates a tripwire database; this asserts that the database is open
+                        uint32              flags  = 0,
+                        cWorkerPool*        pPool  = 0,
+                        iFCOHashCache*      pCache = 0);
+    // generates a tripwire database; this asserts that the database is open.
+    // If pPool is not null, file hashing is spread across its threads. If pCache
+    // is not null, the property calculator uses it (see iFCOPropCalc::SetHashCache()).
 
     enum Flags
     {
@@ -62,8 +68,10 @@ public:
         // when this flag is set, cGenerateDb will attempt to leave no footprints when
         // creating the database for instance, cGenerateDb will tell the property calculator
         // to reset access times.
-        FLAG_DIRECT_IO = 0x00000002
+        FLAG_DIRECT_IO = 0x00000002,
         // Use direct i/o when scanning files
+        FLAG_HASH_EVERY_LINK = 0x00000004
+        // hash each hard link to a file, rather than the file once
     };
 };
 
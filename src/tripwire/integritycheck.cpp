@@ -50,6 +50,8 @@
 #include "core/usernotify.h"
 #include "fco/fconametranslator.h"
 
+#include <time.h>
+
 //
 // TODO -- change the report interface so that it takes an error bucket instead of an error queue and then
 //      pass our error bucket to it.
@@ -244,6 +246,9 @@ void cIntegrityCheck::ProcessChangedFCO(cDbDataSourceIter dbIter, iFCODataSource
 ///////////////////////////////////////////////////////////////////////////////
 void cIntegrityCheck::CompareFCOs(iFCO* pOldFCO, iFCO* pNewFCO)
 {
+    if (mFlags & FLAG_QUICK_CHECK)
+        mQuickCheck.ReuseContentProps(pOldFCO, pNewFCO, mpCurSpec, mpPropCalc);
+
     cTripwireUtil::CalcProps(
         pNewFCO, mpCurSpec, mpPropCalc, 0); //TODO -- a property displayer should be passed in here.
     //
@@ -326,6 +331,11 @@ void cIntegrityCheck::ProcessDir(cDbDataSourceIter dbIter, iFCODataSourceIter* p
         return;
     }
 
+    // get the hashing for this directory going in the background, if we can
+    //
+    cPeerPrecalc precalc(
+        pIter, mpCurSpec, mpPropCalc, &mBucket, &dbIter, (mFlags & FLAG_QUICK_CHECK) ? &mQuickCheck : 0);
+
 #ifdef DEBUG
     if (dbIter.Done())
     {
@@ -361,6 +371,7 @@ void cIntegrityCheck::ProcessDir(cDbDataSourceIter dbIter, iFCODataSourceIter* p
                 //
                 // these are all new entries, add them to the "Added" set...
                 //
+                precalc.ReleaseErrors(pIter);
                 ProcessAddedFCO(dbIter, pIter);
                 pIter->Next();
             }
@@ -397,6 +408,7 @@ void cIntegrityCheck::ProcessDir(cDbDataSourceIter dbIter, iFCODataSourceIter* p
             }
             else if (rel == iFCODataSourceIter::REL_GT)
             {
+                precalc.ReleaseErrors(pIter);
                 ProcessAddedFCO(dbIter, pIter);
                 pIter->Next();
             }
@@ -405,6 +417,7 @@ void cIntegrityCheck::ProcessDir(cDbDataSourceIter dbIter, iFCODataSourceIter* p
                 // we actually have to compare the FCOs at this point...
                 // NOTE -- if the db iter has no data, then this is an add again.
                 //
+                precalc.ReleaseErrors(pIter);
                 ProcessChangedFCO(dbIter, pIter);
 
                 dbIter.Next();
@@ -448,10 +461,20 @@ cIntegrityCheck::~cIntegrityCheck()
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// SetQuickCheckSample
+///////////////////////////////////////////////////////////////////////////////
+void cIntegrityCheck::SetQuickCheckSample(uint32 rate)
+{
+    // a different seed every run, so that the sample moves around
+    //
+    mQuickCheck.SetSampleRate(rate, (uint32)time(0));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Execute
 ///////////////////////////////////////////////////////////////////////////////
-void cIntegrityCheck::Execute(uint32 flags)
+void cIntegrityCheck::Execute(uint32 flags, cWorkerPool* pPool, iFCOHashCache* pCache)
 {
     mFlags = flags;
     // create the data source iterator
@@ -494,6 +517,15 @@ void cIntegrityCheck::Execute(uint32 flags)
         mpPropCalc->SetCalcFlags(mpPropCalc->GetCalcFlags() | iFCOPropCalc::DIRECT_IO);
     }
 
+    if (flags & FLAG_HASH_EVERY_LINK)
+    {
+        mpPropCalc->SetCalcFlags(mpPropCalc->GetCalcFlags() | iFCOPropCalc::HASH_EVERY_LINK);
+    }
+
+    mpPropCalc->SetWorkerPool(pPool);
+    mpPropCalc->SetHashCache(pCache);
+    pDSIter->SetWorkerPool(pPool);
+
     //
     // iterate over all of the specs...
     //
@@ -521,6 +553,7 @@ void cIntegrityCheck::Execute(uint32 flags)
         // seek each iterator to the appropriate starting point...
         //
         dbIter.SeekToFCO(mpCurSpec->GetStartPoint(), false); // false means not to create my peers
+        pDSIter->SetLeafProps(mpCurSpec->GetPropVector(iFCOSpecMask::GetDefaultMask()));
         pDSIter->SeekToFCO(mpCurSpec->GetStartPoint(), false);
         //
         // integrity check the start point; note that the ProcessXXX functions will
@@ -547,6 +580,10 @@ void cIntegrityCheck::Execute(uint32 flags)
             ProcessChangedFCO(dbIter, pDSIter.get());
         }
 
+        // anything still being hashed belongs to this spec's part of the report
+        //
+        mpPropCalc->WaitForPending();
+
         // dissociate the report error bucket and mine...
         //
         mBucket.SetChild(mReportIter.GetErrorQueue()->GetChild());
@@ -557,8 +594,9 @@ void cIntegrityCheck::Execute(uint32 flags)
 ///////////////////////////////////////////////////////////////////////////////
 // ExecuteOnObjectList
 ///////////////////////////////////////////////////////////////////////////////
-void cIntegrityCheck::ExecuteOnObjectList(const std::list<cFCOName>& fcoNames, uint32 flags)
+void cIntegrityCheck::ExecuteOnObjectList(const std::list<cFCOName>& fcoNames, uint32 flags, iFCOHashCache* pCache)
 {
+    mFlags = flags;
     iFCONameTranslator* pTrans = iTWFactory::GetInstance()->GetNameTranslator();
     //
     // create the data source iterator
@@ -592,6 +630,13 @@ void cIntegrityCheck::ExecuteOnObjectList(const std::list<cFCOName>& fcoNames, u
         mpPropCalc->SetCalcFlags(mpPropCalc->GetCalcFlags() | iFCOPropCalc::DIRECT_IO);
     }
 
+    if (flags & FLAG_HASH_EVERY_LINK)
+    {
+        mpPropCalc->SetCalcFlags(mpPropCalc->GetCalcFlags() | iFCOPropCalc::HASH_EVERY_LINK);
+    }
+
+    mpPropCalc->SetHashCache(pCache);
+
     //
     // iterate over all the objects to integrity check..
     //
@@ -50,6 +50,9 @@
 #ifndef __FCOPROPVECTOR_H
 #include "fco/fcopropvector.h"
 #endif
+#ifndef __TRIPWIREUTIL_H
+#include "tripwireutil.h"
+#endif
 
 class cFCOSpecList;
 class cHierDatabase;
@@ -59,6 +62,8 @@ class iFCODataSourceIter;
 class iFCOSpec;
 class cFCOReportSpecIter;
 class iFCOPropCalc;
+class cWorkerPool;
+class iFCOHashCache;
 
 TSS_EXCEPTION(eIC, eError);
 TSS_EXCEPTION(eICFCONotInSpec, eIC);
@@ -87,12 +92,17 @@ public:
 
     ~cIntegrityCheck();
 
-    void Execute(uint32 flags = 0);
+    void Execute(uint32 flags = 0, cWorkerPool* pPool = 0, iFCOHashCache* pCache = 0);
     // flags should be 0, or some combination of the below enumeration
+    // if pPool is not null, file hashing is spread across its threads
+    // if pCache is not null, the property calculator uses it (see iFCOPropCalc::SetHashCache())
     // TODO -- specify what kinds of exception can come up from here....
-    void ExecuteOnObjectList(const std::list<cFCOName>& fcoNames, uint32 flags = 0);
+    void ExecuteOnObjectList(const std::list<cFCOName>& fcoNames, uint32 flags = 0, iFCOHashCache* pCache = 0);
     // executes an integrity check on the objects named in the list. The specList passed in
     // as the first parameter to the ctor is interprited as the db's spec list.
+    void SetQuickCheckSample(uint32 rate);
+    // with FLAG_QUICK_CHECK, about one in every rate unchanged fcos is hashed anyway
+    // (see cQuickCheck::SetSampleRate()); 0, the default, means none are.
     int ObjectsScanned()
     {
         return mnObjectsScanned;
@@ -119,8 +129,13 @@ public:
         FLAG_ERASE_FOOTPRINTS_IC = 0x00000010,
         // when this flag is set, IC will attempt to leave no footprints when doing an integrity check.
         // for instance, IC will tell the property calculator to reset access times.
-        FLAG_DIRECT_IO = 0x00000020
+        FLAG_DIRECT_IO = 0x00000020,
         // Use direct i/o when scanning files
+        FLAG_QUICK_CHECK = 0x00000040,
+        // when this is set, the database's content properties are reused for fcos whose
+        // quick check properties have not changed, instead of being recalculated.
+        FLAG_HASH_EVERY_LINK = 0x00000080
+        // hash each hard link to a file, rather than the file once
     };
 
 private:
@@ -134,6 +149,7 @@ private:
     cFCOReportSpecIter   mReportIter;      // the current iterator into the report
     cFCOPropVector       mLooseDirProps;   // properties that should be ignored in loose directories
     uint32               mFlags;           // flags passed in to execute()
+    cQuickCheck          mQuickCheck;      // used when FLAG_QUICK_CHECK is set
     int                  mnObjectsScanned; // number of objects scanned in system ( scanning includes
                                            // discovering that an FCO does not exist )
 
@@ -142,7 +142,7 @@ cPolicyUpdate::cPolicyUpdate(cGenre::Genre       genreNum,
 ///////////////////////////////////////////////////////////////////////////////
 // Execute
 ///////////////////////////////////////////////////////////////////////////////
-bool cPolicyUpdate::Execute(uint32 flags) // throw (eError)
+bool cPolicyUpdate::Execute(uint32 flags, cWorkerPool* pPool, iFCOHashCache* pCache) // throw (eError)
 {
     // here is my current idea for the algorithm: first, do an integrity check with the new policy on the database and
     // a special flag passed to Execute() to modify what properties are checked. Then, take the resulting
@@ -179,7 +179,12 @@ bool cPolicyUpdate::Execute(uint32 flags) // throw (eError)
         icFlags |= cIntegrityCheck::FLAG_DIRECT_IO;
     }
 
-    ic.Execute(icFlags);
+    if (flags & FLAG_HASH_EVERY_LINK)
+    {
+        icFlags |= cIntegrityCheck::FLAG_HASH_EVERY_LINK;
+    }
+
+    ic.Execute(icFlags, pPool, pCache);
     //TODO-- the second flag I just added probably makes the flag to cUpdateDb::Execute() unnecessary;
     //      I should probably remove it.
 
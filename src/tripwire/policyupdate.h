@@ -46,6 +46,8 @@
 #endif
 
 class cErrorBucket;
+class cWorkerPool;
+class iFCOHashCache;
 
 
 ////////////////////////////////////////////////////////////
@@ -65,9 +67,11 @@ public:
                   cHierDatabase&      db,
                   cErrorBucket*       pBucket);
 
-    bool Execute(uint32 flags = 0); // throw (eError)
+    bool Execute(uint32 flags = 0, cWorkerPool* pPool = 0, iFCOHashCache* pCache = 0); // throw (eError)
         // if false is returned, then there was at least one conflict that came up during the policy
         // update, and if tripwire was run in secure mode then the policy update should fail.
+        // If pPool is not null, file hashing is spread across its threads. If pCache is not
+        // null, the property calculator uses it (see iFCOPropCalc::SetHashCache()).
 
     enum Flags
     {
@@ -77,8 +81,11 @@ public:
         // when this flag is set, cPolicyUpdate will attempt undo any inadvertant modifications
         // it may make when executing.
 
-        FLAG_DIRECT_IO = 0x00000004
+        FLAG_DIRECT_IO = 0x00000004,
         // Use direct i/o when scanning files
+
+        FLAG_HASH_EVERY_LINK = 0x00000008
+        // hash each hard link to a file, rather than the file once
     };
 
 private:
@@ -114,6 +114,15 @@ TSS_REGISTER_ERROR(eTWInvalidReportLevel(), _T("Invalid reporting level specifie
 TSS_REGISTER_ERROR(eTWInvalidReportLevelCfg(),
                    _T("Invalid reporting level in configuration file\nValid levels: [0-4]\n"));
 TSS_REGISTER_ERROR(eTWInvalidPortNumber(), _T("Invalid SMTP port number.\nValid ports: [0-65535]\n"));
+TSS_REGISTER_ERROR(eTWInvalidWorkerCount(), _T("Invalid number of worker threads.\nValid values: [1-1024]\n"));
+TSS_REGISTER_ERROR(eTWInvalidQuickCheckSample(), _T("Invalid quick check sample rate.\nValid values: 0 or more\n"));
+TSS_REGISTER_ERROR(eTWInvalidHashReadSize(), _T("Invalid hash read size.\nValid values: [4-65536]\n"));
+TSS_REGISTER_ERROR(eTWInvalidHashMapThreshold(), _T("Invalid hash mmap threshold.\nValid values: [0-999999999]\n"));
+TSS_REGISTER_ERROR(eTWInvalidHashSplitThreshold(), _T("Invalid hash split threshold.\nValid values: [0-999999999]\n"));
+TSS_REGISTER_ERROR(eTWInvalidHashThreads(), _T("Invalid number of hashing threads.\nValid values: [1-1024]\n"));
+TSS_REGISTER_ERROR(eTWInvalidReadAheadFiles(), _T("Invalid read-ahead file count.\nValid values: [0-1024]\n"));
+TSS_REGISTER_ERROR(eTWInvalidReadAheadSize(), _T("Invalid read-ahead size.\nValid values: [0-999999999]\n"));
+TSS_REGISTER_ERROR(eTWInvalidDbCacheSize(), _T("Invalid database cache size.\nValid values: [1-65535]\n"));
 TSS_REGISTER_ERROR(eTWInvalidTempDirectory(), _T("Cannot access temp directory."));
 
 TSS_REGISTER_ERROR(eTWSyslogNotSupported(), _T("Syslog reporting is not supported on this platform."));
@@ -71,6 +71,8 @@ TSS_BeginStringtable(cTripwire)
                     _T("  -P passphrase        --local-passphrase passphrase\n")
                     _T("  -L localkey          --local-keyfile localkey\n")
                     _T("  -e                   --no-encryption\n")
+                    _T("  -j workers           --workers workers\n")
+                    _T("                       --db-cache-size MB\n")
                     _T("\n")
                     _T("The -v and -s options are mutually exclusive.\n")
                     _T("The -L and -e options are mutually exclusive.\n")
@@ -100,6 +102,9 @@ TSS_BeginStringtable(cTripwire)
                     _T("  -i list              --ignore list\n")
                     _T("  -M                   --email-report\n")
                     _T("  -t { 0|1|2|3|4 }     --email-report-level { 0|1|2|3|4 }\n")
+                    _T("  -j workers           --workers workers\n")
+                    _T("                       --db-cache-size MB\n")
+                    _T("                       --quick-check\n")
                     _T("[object1 [object2...]]\n")
                     _T("\n")
                     _T("The -v and -s options are mutually exclusive.\n")
@@ -125,6 +130,7 @@ TSS_BeginStringtable(cTripwire)
                     _T("  -V editor            --visual editor\n")
                     _T("  -a                   --accept-all\n")
                     _T("  -Z {low | high}      --secure-mode {low | high}\n")
+                    _T("                       --db-cache-size MB\n")
                     _T("\n")
                     _T("The -v and -s options are mutually exclusive.\n")
                     _T("The -a and -V options are mutually exclusive.\n")
@@ -143,6 +149,8 @@ TSS_BeginStringtable(cTripwire)
                     _T("  -P passphrase        --local-passphrase passphrase\n")
                     _T("  -Q passphrase        --site-passphrase passphrase\n")
                     _T("  -Z {low | high}      --secure-mode {low | high}\n")
+                    _T("  -j workers           --workers workers\n")
+                    _T("                       --db-cache-size MB\n")
                     _T("policyfile.txt\n")
                     _T("\n")
                     _T("The -v and -s options are mutually exclusive.\n")
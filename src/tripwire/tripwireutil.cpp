@@ -41,6 +41,8 @@
 #include "fco/fcoprop.h"
 #include "fco/fcopropdisplayer.h"
 #include "fco/fconame.h"
+#include "fco/fcodatasourceiter.h"
+#include "fco/fcospec.h"
 #include "tw/dbdatasource.h"
 #include "tripwirestrings.h"
 
@@ -142,3 +144,89 @@ bool cTripwireUtil::RemoveFCOFromDb(cFCOName name, cDbDataSourceIter& dbIter)
 
     return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// cPeerPrecalc
+///////////////////////////////////////////////////////////////////////////////
+cPeerPrecalc::cPeerPrecalc(iFCODataSourceIter*      pIter,
+                           const iFCOSpec*          pSpec,
+                           iFCOPropCalc*            pCalc,
+                           cErrorBucket*            pBucket,
+                           const cDbDataSourceIter* pDbIter,
+                           const cQuickCheck*       pQuickCheck)
+    : mpBucket(pBucket)
+{
+    if (!pIter || !pCalc->GetWorkerPool())
+        return;
+
+    //
+    // we can only look up the old fcos if the database iterator is in the same
+    // directory as we are
+    //
+    TW_UNIQUE_PTR<cDbDataSourceIter> pOldIter;
+    if (pQuickCheck && pDbIter && pDbIter->GetParentName() == pIter->GetParentName())
+        pOldIter.reset(new cDbDataSourceIter(*pDbIter));
+
+    int flags = pCalc->GetCalcFlags();
+    pCalc->SetCalcFlags(flags | iFCOPropCalc::DEFER_HASHES);
+
+    for (pIter->SeekBegin(); !pIter->Done(); pIter->Next())
+    {
+        if (pSpec->ShouldStopDescent(pIter->GetName()))
+            continue;
+
+        TSTRING      shortName = pIter->GetShortName();
+        cErrorQueue& errors    = mErrors[shortName];
+
+        pIter->SetErrorBucket(&errors);
+        iFCO* pFCO = pIter->CreateFCO();
+        pIter->SetErrorBucket(mpBucket);
+
+        if (pFCO)
+        {
+            // what the calculator can't stat, read or open is held back with the rest
+            pCalc->SetErrorBucket(&errors);
+
+            if (pOldIter.get() && pOldIter->SeekTo(shortName.c_str()) && pOldIter->HasFCOData())
+            {
+                iFCO* pOldFCO = pOldIter->CreateFCO();
+                pQuickCheck->ReuseContentProps(pOldFCO, pFCO, pSpec, pCalc);
+                pOldFCO->Release();
+            }
+
+            pCalc->SetPropVector(pSpec->GetPropVector(pSpec->GetSpecMask(pFCO)));
+            pFCO->AcceptVisitor(pCalc->GetVisitor());
+            pFCO->Release();
+
+            pCalc->SetErrorBucket(mpBucket);
+
+            // the traversal will descend into this later on, so start reading it now
+            if (pIter->CanDescend())
+                pIter->Prefetch();
+        }
+
+        if (errors.GetNumErrors() == 0)
+            mErrors.erase(shortName);
+    }
+
+    pCalc->SetCalcFlags(flags);
+    pIter->SeekBegin();
+}
+
+void cPeerPrecalc::ReleaseErrors(const iFCODataSourceIter* pIter)
+{
+    if (mErrors.empty())
+        return;
+
+    ErrorMap::iterator i = mErrors.find(pIter->GetShortName());
+    if (i == mErrors.end())
+        return;
+
+    if (mpBucket)
+    {
+        cErrorQueueIter errIter(i->second);
+        for (errIter.SeekBegin(); !errIter.Done(); errIter.Next())
+            mpBucket->AddError(errIter.GetError());
+    }
+    mErrors.erase(i);
+}
@@ -37,10 +37,18 @@
 #ifndef __TRIPWIREUTIL_H
 #define __TRIPWIREUTIL_H
 
+#ifndef __ERRORBUCKETIMPL_H
+#include "core/errorbucketimpl.h"
+#endif
+#ifndef __FCOQUICKCHECK_H
+#include "fco/fcoquickcheck.h"
+#endif
+
 class iFCO;
 class iFCOSpec;
 class iFCOPropCalc;
 class iFCOPropDisplayer;
+class iFCODataSourceIter;
 class cFCOName;
 class cDbDataSourceIter;
 class cHierDatabase;
@@ -62,5 +70,44 @@ public:
     // this returns true if fco data was actually removed from the database.
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// cPeerPrecalc -- if the property calculator has a worker pool, this visits
+//      all the peers of a data source iterator before the traversal gets to
+//      them, so that their hashes are generated concurrently. The calculator
+//      finishes each object when CalcProps() visits it for real. Any peers
+//      that will be descended into are handed to the iterator's Prefetch(),
+//      so subdirectories are listed concurrently as well.
+//
+//      Errors the iterator and the calculator report while the peers are
+//      created and visited are held back and passed on by ReleaseErrors(), so
+//      the error bucket sees them in the same order as it would without the pool.
+//
+//      When integrity checking, pass the database iterator for the same
+//      directory and the quick check in use, if any, so that hashes that
+//      will be reused are not started.
+///////////////////////////////////////////////////////////////////////////////
+class cPeerPrecalc
+{
+public:
+    cPeerPrecalc(iFCODataSourceIter*      pIter,
+                 const iFCOSpec*          pSpec,
+                 iFCOPropCalc*            pCalc,
+                 cErrorBucket*            pBucket,
+                 const cDbDataSourceIter* pDbIter     = 0,
+                 const cQuickCheck*       pQuickCheck = 0);
+    // pBucket is the bucket pIter and pCalc report errors to. pIter is left at SeekBegin();
+    // it may be null, in which case there is nothing to do.
+
+    void ReleaseErrors(const iFCODataSourceIter* pIter);
+    // passes on any errors held for pIter's current peer; call this right before
+    // the peer's CreateFCO().
+
+private:
+    typedef std::map<TSTRING, cErrorQueue> ErrorMap;
+
+    ErrorMap      mErrors; // held errors, by the short name of the peer that caused them
+    cErrorBucket* mpBucket;
+};
+
 
 #endif //__TRIPWIREUTIL_H
@@ -72,6 +72,7 @@
 #include "integritycheck.h"
 #include "updatedb.h"
 #include "policyupdate.h"
+#include "core/workerpool.h"
 #include "core/platform.h"
 
 #ifdef TW_PROFILE
@@ -79,6 +80,8 @@
 #endif
 
 #include "fs/fsdatasourceiter.h" // for cross file systems flag
+#include "fs/fshashcache.h"
+#include "db/blockfile.h"        // for the database cache size
 #include <unistd.h>              // for _exit()
 
 //-----------------------------------------------------------------------------
@@ -427,6 +430,218 @@ static void util_InitEmailOptions(cTWModeCommon* pModeInfo, const cConfigFile& c
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// util_GetWorkerCount -- interprets a WORKERS value from the config file or
+//    command line
+///////////////////////////////////////////////////////////////////////////////
+static int util_GetWorkerCount(const TSTRING& str)
+{
+    int i = _ttoi(str.c_str());
+    if (i < 1 || i > 1024)
+        throw eTWInvalidWorkerCount(str);
+    return i;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_GetQuickCheckSample -- interprets a QUICK_CHECK_SAMPLE value from the
+//    config file
+///////////////////////////////////////////////////////////////////////////////
+static int util_GetQuickCheckSample(const TSTRING& str)
+{
+    if (str.empty())
+        throw eTWInvalidQuickCheckSample(str);
+    for (TSTRING::const_iterator i = str.begin(); i != str.end(); ++i)
+    {
+        if (!_istdigit(*i))
+            throw eTWInvalidQuickCheckSample(str);
+    }
+    return _ttoi(str.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_GetHashReadSize -- interprets a HASH_READ_SIZE value from the config
+//    file, which is in kilobytes, and returns it in bytes
+///////////////////////////////////////////////////////////////////////////////
+static int util_GetHashReadSize(const TSTRING& str)
+{
+    int i = _ttoi(str.c_str());
+    if (i < 4 || i > cArchiveSigGen::MAX_READ_SIZE / 1024)
+        throw eTWInvalidHashReadSize(str);
+    return i * 1024;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_GetHashMapThreshold -- interprets a HASH_MMAP_THRESHOLD value from the
+//    config file, which is in kilobytes, and returns it in bytes
+///////////////////////////////////////////////////////////////////////////////
+static int64 util_GetHashMapThreshold(const TSTRING& str)
+{
+    if (str.empty() || str.length() > 9)
+        throw eTWInvalidHashMapThreshold(str);
+    for (TSTRING::const_iterator i = str.begin(); i != str.end(); ++i)
+    {
+        if (!_istdigit(*i))
+            throw eTWInvalidHashMapThreshold(str);
+    }
+    return static_cast<int64>(_ttoi(str.c_str())) * 1024;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_GetHashSplitThreshold -- interprets a HASH_SPLIT_THRESHOLD value from
+//    the config file, which is in kilobytes, and returns it in bytes
+///////////////////////////////////////////////////////////////////////////////
+static int64 util_GetHashSplitThreshold(const TSTRING& str)
+{
+    if (str.empty() || str.length() > 9)
+        throw eTWInvalidHashSplitThreshold(str);
+    for (TSTRING::const_iterator i = str.begin(); i != str.end(); ++i)
+    {
+        if (!_istdigit(*i))
+            throw eTWInvalidHashSplitThreshold(str);
+    }
+    return static_cast<int64>(_ttoi(str.c_str())) * 1024;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_GetHashThreads -- interprets a HASH_THREADS value from the config file
+///////////////////////////////////////////////////////////////////////////////
+static int util_GetHashThreads(const TSTRING& str)
+{
+    int i = _ttoi(str.c_str());
+    if (i < 1 || i > 1024)
+        throw eTWInvalidHashThreads(str);
+    return i;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_GetReadAheadFiles -- interprets a HASH_READ_AHEAD_FILES value from the
+//    config file
+///////////////////////////////////////////////////////////////////////////////
+static int util_GetReadAheadFiles(const TSTRING& str)
+{
+    if (str.empty() || str.length() > 4)
+        throw eTWInvalidReadAheadFiles(str);
+    for (TSTRING::const_iterator i = str.begin(); i != str.end(); ++i)
+    {
+        if (!_istdigit(*i))
+            throw eTWInvalidReadAheadFiles(str);
+    }
+
+    int i = _ttoi(str.c_str());
+    if (i > 1024)
+        throw eTWInvalidReadAheadFiles(str);
+    return i;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_GetReadAheadSize -- interprets a HASH_READ_AHEAD_SIZE value from the
+//    config file, which is in kilobytes, and returns it in bytes
+///////////////////////////////////////////////////////////////////////////////
+static int64 util_GetReadAheadSize(const TSTRING& str)
+{
+    if (str.empty() || str.length() > 9)
+        throw eTWInvalidReadAheadSize(str);
+    for (TSTRING::const_iterator i = str.begin(); i != str.end(); ++i)
+    {
+        if (!_istdigit(*i))
+            throw eTWInvalidReadAheadSize(str);
+    }
+    return static_cast<int64>(_ttoi(str.c_str())) * 1024;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_GetDbCacheSize -- interprets a DB_CACHE_SIZE value from the config file
+//    or the command line, which is in megabytes, and returns it in bytes
+///////////////////////////////////////////////////////////////////////////////
+static int64 util_GetDbCacheSize(const TSTRING& str)
+{
+    if (str.empty() || str.length() > 5)
+        throw eTWInvalidDbCacheSize(str);
+    for (TSTRING::const_iterator i = str.begin(); i != str.end(); ++i)
+    {
+        if (!_istdigit(*i))
+            throw eTWInvalidDbCacheSize(str);
+    }
+
+    int i = _ttoi(str.c_str());
+    if (i < 1 || i > 65535)
+        throw eTWInvalidDbCacheSize(str);
+    return static_cast<int64>(i) * 1024 * 1024;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_CreateWorkerPool -- returns the threads to hash files with, or null if
+//    we are to do everything on this one
+///////////////////////////////////////////////////////////////////////////////
+static cWorkerPool* util_CreateWorkerPool(int numWorkers)
+{
+    return (numWorkers > 1) ? new cWorkerPool(numWorkers) : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cHashCacheUser -- loads the hash cache the config file names, if it names
+//    one, for the property calculators to use. Nothing that goes wrong with
+//    the cache is fatal; it is warned about, and the files it would have
+//    covered are hashed as usual.
+///////////////////////////////////////////////////////////////////////////////
+class cHashCacheUser
+{
+public:
+    cHashCacheUser(const TSTRING& fileName, const cKeyFile& localKeyfile);
+
+    iFCOHashCache* Get();
+    // the cache, or null if the config file doesn't name one
+
+    void Save(const cElGamalSigPrivateKey* pPrivateKey);
+    // writes the cache back out, if there is one; it can only be signed with the
+    // local private key, so nothing is written if pPrivateKey is null
+
+private:
+    TSTRING      mFileName;
+    cFSHashCache mCache;
+};
+
+cHashCacheUser::cHashCacheUser(const TSTRING& fileName, const cKeyFile& localKeyfile) : mFileName(fileName)
+{
+    if (mFileName.empty())
+        return;
+
+    if (cFileUtil::FileExists(mFileName))
+    {
+        try
+        {
+            cTWUtil::ReadHashCache(mFileName.c_str(), mCache, localKeyfile.GetPublicKey());
+        }
+        catch (eError& e)
+        {
+            e.SetFatality(false);
+            cTWUtil::PrintErrorMsg(e);
+            mCache.Clear();
+        }
+    }
+}
+
+iFCOHashCache* cHashCacheUser::Get()
+{
+    return mFileName.empty() ? 0 : &mCache;
+}
+
+void cHashCacheUser::Save(const cElGamalSigPrivateKey* pPrivateKey)
+{
+    if (mFileName.empty() || !pPrivateKey)
+        return;
+
+    try
+    {
+        cTWUtil::WriteHashCache(mFileName.c_str(), mCache, pPrivateKey);
+    }
+    catch (eError& e)
+    {
+        e.SetFatality(false);
+        cTWUtil::PrintErrorMsg(e);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // FillOutConfigInfo -- fills out all the common info with config file information
 ///////////////////////////////////////////////////////////////////////////////
@@ -523,6 +738,88 @@ static void FillOutConfigInfo(cTWModeCommon* pModeInfo, const cConfigFile& cf)
 #endif
     }
 
+    if (cf.Lookup(TSTRING(_T("HASH_READ_SIZE")), str))
+    {
+        cArchiveSigGen::SetReadSize(util_GetHashReadSize(str));
+    }
+
+    if (cf.Lookup(TSTRING(_T("HASH_PARALLEL_SIGNATURES")), str))
+    {
+        if (_tcsicmp(str.c_str(), _T("true")) == 0)
+            cArchiveSigGen::SetParallelSigs(true);
+        else
+            cArchiveSigGen::SetParallelSigs(false);
+    }
+
+    if (cf.Lookup(TSTRING(_T("HASH_MMAP_THRESHOLD")), str))
+    {
+        cArchiveSigGen::SetMapThreshold(util_GetHashMapThreshold(str));
+    }
+
+    if (cf.Lookup(TSTRING(_T("HASH_SPLIT_THRESHOLD")), str))
+    {
+        cArchiveSigGen::SetSplitThreshold(util_GetHashSplitThreshold(str));
+    }
+
+    if (cf.Lookup(TSTRING(_T("HASH_THREADS")), str))
+    {
+        pModeInfo->mNumHashThreads = util_GetHashThreads(str);
+    }
+
+    {
+        int   readAheadFiles = 8;
+        int64 readAheadSize  = 32 * 1024 * 1024;
+        if (cf.Lookup(TSTRING(_T("HASH_READ_AHEAD_FILES")), str))
+            readAheadFiles = util_GetReadAheadFiles(str);
+        if (cf.Lookup(TSTRING(_T("HASH_READ_AHEAD_SIZE")), str))
+            readAheadSize = util_GetReadAheadSize(str);
+        cFSDataSourceIter::SetReadAhead(readAheadFiles, readAheadSize);
+    }
+
+    if (cf.Lookup(TSTRING(_T("HASH_SKIP_HOLES")), str))
+    {
+        if (_tcsicmp(str.c_str(), _T("false")) == 0)
+            cArchiveSigGen::SetSkipHoles(false);
+        else
+            cArchiveSigGen::SetSkipHoles(true);
+    }
+
+    if (cf.Lookup(TSTRING(_T("HASH_CACHE")), str))
+    {
+        pModeInfo->mHashCacheFile = str;
+    }
+
+    if (cf.Lookup(TSTRING(_T("HASH_HARD_LINKS_ONCE")), str))
+    {
+        if (_tcsicmp(str.c_str(), _T("false")) == 0)
+            pModeInfo->mbHashEveryLink = true;
+        else
+            pModeInfo->mbHashEveryLink = false;
+    }
+
+    if (cf.Lookup(TSTRING(_T("WORKERS")), str))
+    {
+        pModeInfo->mNumWorkers = util_GetWorkerCount(str);
+    }
+
+    if (cf.Lookup(TSTRING(_T("DB_CACHE_SIZE")), str))
+    {
+        cBlockFile::SetCacheSize(util_GetDbCacheSize(str));
+    }
+
+    if (cf.Lookup(TSTRING(_T("QUICK_CHECK")), str))
+    {
+        if (_tcsicmp(str.c_str(), _T("true")) == 0)
+            pModeInfo->mbQuickCheck = true;
+        else
+            pModeInfo->mbQuickCheck = false;
+    }
+
+    if (cf.Lookup(TSTRING(_T("QUICK_CHECK_SAMPLE")), str))
+    {
+        pModeInfo->mQuickCheckSample = util_GetQuickCheckSample(str);
+    }
+
     if (cf.Lookup(TSTRING(_T("RESOLVE_IDS_TO_NAMES")), str))
     {
         if (_tcsicmp(str.c_str(), _T("true")) == 0)
@@ -531,6 +828,14 @@ static void FillOutConfigInfo(cTWModeCommon* pModeInfo, const cConfigFile& cf)
             iFSServices::GetInstance()->SetResolveNames(false);
     }
 
+    if (cf.Lookup(TSTRING(_T("STAT_DONT_SYNC")), str))
+    {
+        if (_tcsicmp(str.c_str(), _T("true")) == 0)
+            iFSServices::GetInstance()->SetStatDontSync(true);
+        else
+            iFSServices::GetInstance()->SetStatDontSync(false);
+    }
+
     //
     // turn all of the file names into full paths (they're relative to the exe dir)
     //
@@ -591,6 +896,14 @@ static void FillOutCmdLineInfo(cTWModeCommon* pModeInfo, const cCmdLineParser& c
             pModeInfo->mLocalProvided   = true;
         }
         break;
+        case cTWCmdLine::WORKERS:
+            ASSERT(iter.NumParams() > 0); // should be caught by cmd line parser
+            pModeInfo->mNumWorkers = util_GetWorkerCount(iter.ParamAt(0));
+            break;
+        case cTWCmdLine::DB_CACHE_SIZE:
+            ASSERT(iter.NumParams() > 0); // should be caught by cmd line parser
+            cBlockFile::SetCacheSize(util_GetDbCacheSize(iter.ParamAt(0)));
+            break;
 /*    case cTWCmdLine::NO_BACKUP:
          pModeInfo->mbBackup = false;
          break;
@@ -613,6 +926,11 @@ static void FillOutCmdLineInfo(cTWModeCommon* pModeInfo, const cCmdLineParser& c
         pModeInfo->mReportFile = fullPath;
 
 
+    // hash on as many threads as there are workers, unless the config file says otherwise;
+    // a run with one worker then starts no threads at all
+    cArchiveSigGen::SetHashThreads((pModeInfo->mNumHashThreads > 0) ? pModeInfo->mNumHashThreads
+                                                                      : pModeInfo->mNumWorkers);
+
     // use the verbosity information
     ASSERT((pModeInfo->mVerbosity >= 0) && (pModeInfo->mVerbosity < 3));
     iUserNotify::GetInstance()->SetVerboseLevel(pModeInfo->mVerbosity);
@@ -664,6 +982,8 @@ void cTWModeDbInit::InitCmdLineParser(cCmdLineParser& cmdLine)
 
     cmdLine.AddArg(cTWCmdLine::MODE_INIT, TSTRING(_T("")), TSTRING(_T("init")), cCmdLineParser::PARAM_NONE);
     cmdLine.AddArg(cTWCmdLine::NO_ENCRYPT, TSTRING(_T("e")), TSTRING(_T("no-encryption")), cCmdLineParser::PARAM_NONE);
+    cmdLine.AddArg(cTWCmdLine::WORKERS, TSTRING(_T("j")), TSTRING(_T("workers")), cCmdLineParser::PARAM_ONE);
+    cmdLine.AddArg(cTWCmdLine::DB_CACHE_SIZE, TSTRING(_T("")), TSTRING(_T("db-cache-size")), cCmdLineParser::PARAM_ONE);
     cmdLine.AddArg(cTWCmdLine::PARAMS, TSTRING(_T("")), TSTRING(_T("")), cCmdLineParser::PARAM_NONE);
 
     // mutual exclusion...
@@ -739,9 +1059,11 @@ int cTWModeDbInit::Execute(cErrorQueue* pQueue)
         // open the keyfile for early passphrase...
         cKeyFile                     keyfile;
         const cElGamalSigPrivateKey* pPrivateKey = 0;
+        if (mpData->mbEncryptDb || !mpData->mHashCacheFile.empty())
+            cTWUtil::OpenKeyFile(keyfile, mpData->mLocalKeyFile);
+
         if (mpData->mbEncryptDb)
         {
-            cTWUtil::OpenKeyFile(keyfile, mpData->mLocalKeyFile);
             // open the private key for "early passphrase"
             if (!mpData->mbLatePassphrase)
                 pPrivateKey = cTWUtil::CreatePrivateKey(
@@ -762,6 +1084,10 @@ int cTWModeDbInit::Execute(cErrorQueue* pQueue)
         uint32 gdbFlags = 0;
         gdbFlags |= (mpData->mbResetAccessTime ? cGenerateDb::FLAG_ERASE_FOOTPRINTS_GD : 0);
         gdbFlags |= (mpData->mbDirectIO ? cGenerateDb::FLAG_DIRECT_IO : 0);
+        gdbFlags |= (mpData->mbHashEveryLink ? cGenerateDb::FLAG_HASH_EVERY_LINK : 0);
+
+        TW_UNIQUE_PTR<cWorkerPool> pPool(util_CreateWorkerPool(mpData->mNumWorkers));
+        cHashCacheUser             hashCache(mpData->mHashCacheFile, keyfile);
 
         // loop through the genres
         cGenreSpecListVector::iterator genreIter;
@@ -786,8 +1112,13 @@ int cTWModeDbInit::Execute(cErrorQueue* pQueue)
 
             // generate the database...
             // TODO -- turn pQueue into an error bucket
-            cGenerateDb::Execute(
-                dbIter.GetSpecList(), dbIter.GetDb(), dbIter.GetGenreHeader().GetPropDisplayer(), pQueue, gdbFlags);
+            cGenerateDb::Execute(dbIter.GetSpecList(),
+                                 dbIter.GetDb(),
+                                 dbIter.GetGenreHeader().GetPropDisplayer(),
+                                 pQueue,
+                                 gdbFlags,
+                                 pPool.get(),
+                                 hashCache.Get());
         }
 
         cFCODatabaseUtil::CalculateHeader(dbFile.GetHeader(),
@@ -817,6 +1148,7 @@ int cTWModeDbInit::Execute(cErrorQueue* pQueue)
             cFileUtil::BackupFile(mpData->mDbFile);
 
             cTWUtil::WriteDatabase(mpData->mDbFile.c_str(), dbFile, true, pPrivateKey);
+            hashCache.Save(pPrivateKey);
             keyfile.ReleasePrivateKey();
         }
         else
@@ -930,6 +1262,9 @@ void cTWModeIC::InitCmdLineParser(cCmdLineParser& cmdLine)
     cmdLine.AddArg(cTWCmdLine::GENRE_NAME, TSTRING(_T("x")), TSTRING(_T("section")), cCmdLineParser::PARAM_ONE);
     cmdLine.AddArg(cTWCmdLine::PARAMS, TSTRING(_T("")), TSTRING(_T("")), cCmdLineParser::PARAM_MANY);
     cmdLine.AddArg(cTWCmdLine::HEXADECIMAL, TSTRING(_T("h")), TSTRING(_T("hexadecimal")), cCmdLineParser::PARAM_NONE);
+    cmdLine.AddArg(cTWCmdLine::WORKERS, TSTRING(_T("j")), TSTRING(_T("workers")), cCmdLineParser::PARAM_ONE);
+    cmdLine.AddArg(cTWCmdLine::DB_CACHE_SIZE, TSTRING(_T("")), TSTRING(_T("db-cache-size")), cCmdLineParser::PARAM_ONE);
+    cmdLine.AddArg(cTWCmdLine::QUICK_CHECK, TSTRING(_T("")), TSTRING(_T("quick-check")), cCmdLineParser::PARAM_NONE);
 
     // multiple levels of reporting
     cmdLine.AddArg(
@@ -1038,6 +1373,9 @@ bool cTWModeIC::Init(const cConfigFile& cf, const cCmdLineParser& cmdLine)
         case cTWCmdLine::HEXADECIMAL:
             cArchiveSigGen::SetHex(true);
             break;
+        case cTWCmdLine::QUICK_CHECK:
+            mpData->mbQuickCheck = true;
+            break;
 
         case cTWCmdLine::PARAMS:
         {
@@ -1133,6 +1471,8 @@ int cTWModeIC::Execute(cErrorQueue* pQueue)
 
         cTWUtil::ReadDatabase(mpData->mDbFile.c_str(), dbFile, localKeyfile.GetPublicKey(), bEncrypted);
 
+        cHashCacheUser hashCache(mpData->mHashCacheFile, localKeyfile);
+
         //
         // give a warning if the user that created the database is not the same as the user running right now...
         //
@@ -1259,8 +1599,12 @@ int cTWModeIC::Execute(cErrorQueue* pQueue)
                         icFlags |= (mpData->mfLooseDirs ? cIntegrityCheck::FLAG_LOOSE_DIR : 0);
                         icFlags |= (mpData->mbResetAccessTime ? cIntegrityCheck::FLAG_ERASE_FOOTPRINTS_IC : 0);
                         icFlags |= (mpData->mbDirectIO ? cIntegrityCheck::FLAG_DIRECT_IO : 0);
+                        icFlags |= (mpData->mbHashEveryLink ? cIntegrityCheck::FLAG_HASH_EVERY_LINK : 0);
+                        icFlags |= (mpData->mbQuickCheck ? cIntegrityCheck::FLAG_QUICK_CHECK : 0);
+
+                        ic.SetQuickCheckSample(mpData->mQuickCheckSample);
 
-                        ic.ExecuteOnObjectList(fcoNames, icFlags);
+                        ic.ExecuteOnObjectList(fcoNames, icFlags, hashCache.Get());
                     }
                     catch (eError& e)
                     {
@@ -1412,8 +1756,13 @@ int cTWModeIC::Execute(cErrorQueue* pQueue)
                         icFlags |= (mpData->mfLooseDirs ? cIntegrityCheck::FLAG_LOOSE_DIR : 0);
                         icFlags |= (mpData->mbResetAccessTime ? cIntegrityCheck::FLAG_ERASE_FOOTPRINTS_IC : 0);
                         icFlags |= (mpData->mbDirectIO ? cIntegrityCheck::FLAG_DIRECT_IO : 0);
+                        icFlags |= (mpData->mbHashEveryLink ? cIntegrityCheck::FLAG_HASH_EVERY_LINK : 0);
+                        icFlags |= (mpData->mbQuickCheck ? cIntegrityCheck::FLAG_QUICK_CHECK : 0);
 
-                        ic.Execute(icFlags);
+                        ic.SetQuickCheckSample(mpData->mQuickCheckSample);
+
+                        TW_UNIQUE_PTR<cWorkerPool> pPool(util_CreateWorkerPool(mpData->mNumWorkers));
+                        ic.Execute(icFlags, pPool.get(), hashCache.Get());
                     }
                     catch (eError& e)
                     {
@@ -1505,6 +1854,7 @@ int cTWModeIC::Execute(cErrorQueue* pQueue)
 
             // write the report
             cTWUtil::WriteReport(mpData->mReportFile.c_str(), reportHeader, report, true, pPrivateKey);
+            hashCache.Save(pPrivateKey);
             localKeyfile.ReleasePrivateKey();
         }
         else
@@ -1640,6 +1990,7 @@ void cTWModeDbUpdate::InitCmdLineParser(cCmdLineParser& cmdLine)
     cmdLine.AddArg(cTWCmdLine::ACCEPT_ALL, TSTRING(_T("a")), TSTRING(_T("accept-all")), cCmdLineParser::PARAM_NONE);
     cmdLine.AddArg(cTWCmdLine::SECURE_MODE, TSTRING(_T("Z")), TSTRING(_T("secure-mode")), cCmdLineParser::PARAM_ONE);
     cmdLine.AddArg(cTWCmdLine::EDITOR, TSTRING(_T("V")), TSTRING(_T("visual")), cCmdLineParser::PARAM_ONE);
+    cmdLine.AddArg(cTWCmdLine::DB_CACHE_SIZE, TSTRING(_T("")), TSTRING(_T("db-cache-size")), cCmdLineParser::PARAM_ONE);
     cmdLine.AddArg(cTWCmdLine::PARAMS, TSTRING(_T("")), TSTRING(_T("")), cCmdLineParser::PARAM_NONE);
 
     // mutual exclusion...
@@ -2014,6 +2365,8 @@ void cTWModePolUpdate::InitCmdLineParser(cCmdLineParser& cmdLine)
     cmdLine.AddArg(
         cTWCmdLine::SITE_PASSPHRASE, TSTRING(_T("Q")), TSTRING(_T("site-passphrase")), cCmdLineParser::PARAM_ONE);
     cmdLine.AddArg(cTWCmdLine::SECURE_MODE, TSTRING(_T("Z")), TSTRING(_T("secure-mode")), cCmdLineParser::PARAM_ONE);
+    cmdLine.AddArg(cTWCmdLine::WORKERS, TSTRING(_T("j")), TSTRING(_T("workers")), cCmdLineParser::PARAM_ONE);
+    cmdLine.AddArg(cTWCmdLine::DB_CACHE_SIZE, TSTRING(_T("")), TSTRING(_T("db-cache-size")), cCmdLineParser::PARAM_ONE);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -2135,6 +2488,8 @@ int cTWModePolUpdate::Execute(cErrorQueue* pQueue)
 
         cTWUtil::ReadDatabase(mpData->mDbFile.c_str(), dbFile, localKeyfile.GetPublicKey(), bDbEncrypted);
 
+        cHashCacheUser hashCache(mpData->mHashCacheFile, localKeyfile);
+
         //
         // give a warning if the user that created the database is not the same as the user running right now...
         //
@@ -2217,8 +2572,10 @@ int cTWModePolUpdate::Execute(cErrorQueue* pQueue)
                 puFlags |= mpData->mbSecureMode ? cPolicyUpdate::FLAG_SECURE_MODE : 0;
                 puFlags |= (mpData->mbResetAccessTime ? cPolicyUpdate::FLAG_ERASE_FOOTPRINTS_PU : 0);
                 puFlags |= (mpData->mbDirectIO ? cPolicyUpdate::FLAG_DIRECT_IO : 0);
+                puFlags |= (mpData->mbHashEveryLink ? cPolicyUpdate::FLAG_HASH_EVERY_LINK : 0);
 
-                if ((!pu.Execute(puFlags)) && (mpData->mbSecureMode))
+                TW_UNIQUE_PTR<cWorkerPool> pPool(util_CreateWorkerPool(mpData->mNumWorkers));
+                if ((!pu.Execute(puFlags, pPool.get(), hashCache.Get())) && (mpData->mbSecureMode))
                 {
                     // they were in secure mode and errors occured; an error condition
                     TCOUT << TSS_GetString(cTripwire, tripwire::STR_ERR_POL_UPDATE) << std::endl;
@@ -2248,9 +2605,16 @@ int cTWModePolUpdate::Execute(cErrorQueue* pQueue)
                 uint32 gdbFlags = 0;
                 gdbFlags |= (mpData->mbResetAccessTime ? cGenerateDb::FLAG_ERASE_FOOTPRINTS_GD : 0);
                 gdbFlags |= (mpData->mbDirectIO ? cGenerateDb::FLAG_DIRECT_IO : 0);
+                gdbFlags |= (mpData->mbHashEveryLink ? cGenerateDb::FLAG_HASH_EVERY_LINK : 0);
 
-                cGenerateDb::Execute(
-                    dbIter.GetSpecList(), dbIter.GetDb(), dbIter.GetGenreHeader().GetPropDisplayer(), pQueue, gdbFlags);
+                TW_UNIQUE_PTR<cWorkerPool> pPool(util_CreateWorkerPool(mpData->mNumWorkers));
+                cGenerateDb::Execute(dbIter.GetSpecList(),
+                                     dbIter.GetDb(),
+                                     dbIter.GetGenreHeader().GetPropDisplayer(),
+                                     pQueue,
+                                     gdbFlags,
+                                     pPool.get(),
+                                     hashCache.Get());
 
                 //TODO -- what other prop displayer stuff do I have to do here?
             }
@@ -2331,6 +2695,7 @@ int cTWModePolUpdate::Execute(cErrorQueue* pQueue)
         // write the db to disk...
         //
         cTWUtil::WriteDatabase(mpData->mDbFile.c_str(), dbFile, bDbEncrypted, bDbEncrypted ? privateLocal.GetKey() : 0);
+        hashCache.Save(privateLocal.Valid() ? privateLocal.GetKey() : 0);
     }
     catch (eError& e)
     {
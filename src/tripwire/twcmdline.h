@@ -73,6 +73,15 @@ TSS_EXCEPTION(eTWInvalidConfigFileKey, eError);
 TSS_EXCEPTION(eTWInvalidReportLevel, eError);
 TSS_EXCEPTION(eTWInvalidReportLevelCfg, eError);
 TSS_EXCEPTION(eTWInvalidPortNumber, eError);
+TSS_EXCEPTION(eTWInvalidWorkerCount, eError);
+TSS_EXCEPTION(eTWInvalidQuickCheckSample, eError);
+TSS_EXCEPTION(eTWInvalidHashReadSize, eError);
+TSS_EXCEPTION(eTWInvalidHashMapThreshold, eError);
+TSS_EXCEPTION(eTWInvalidHashSplitThreshold, eError);
+TSS_EXCEPTION(eTWInvalidHashThreads, eError);
+TSS_EXCEPTION(eTWInvalidReadAheadFiles, eError);
+TSS_EXCEPTION(eTWInvalidReadAheadSize, eError);
+TSS_EXCEPTION(eTWInvalidDbCacheSize, eError);
 TSS_EXCEPTION(eTWPassForUnencryptedDb, eError);
 TSS_EXCEPTION(eTWInvalidTempDirectory, eError);
 
@@ -141,6 +150,9 @@ public:
         TEST_EMAIL,
         REPORTLEVEL,
         HEXADECIMAL,
+        WORKERS,
+        QUICK_CHECK,
+        DB_CACHE_SIZE,
         PARAMS, // the final parameters
 
         NUM_CMDLINEARGS
@@ -172,6 +184,12 @@ public:
     bool mbLogToSyslog;      // log significant events and level 0 reports to SYSLOG
     bool mbCrossFileSystems; // automatically recurse across mount points on Unis FS genre
     bool mbDirectIO;         // Use direct i/o when scanning files, if platform supports it.
+    bool mbHashEveryLink;    // hash each hard link to a file, rather than the file once?
+    int  mNumWorkers;        // number of threads to hash files with
+    int  mNumHashThreads;    // threads to read ahead and hash pieces of files on; 0 means mNumWorkers
+    bool mbQuickCheck;       // skip hashing objects whose size and times haven't changed?
+    int  mQuickCheckSample;  // with mbQuickCheck, hash about one in this many unchanged objects anyway
+    TSTRING mHashCacheFile;   // where files' signatures are kept between runs; empty if they aren't
 
     cTextReportViewer::ReportingLevel mEmailReportLevel; // What level of email reporting we should use
     cMailMessage::MailMethod          mMailMethod;       // What mechanism should we use to send the report
@@ -191,6 +209,11 @@ public:
           mbLogToSyslog(false),
           mbCrossFileSystems(false),
           mbDirectIO(false),
+          mbHashEveryLink(false),
+          mNumWorkers(1),
+          mNumHashThreads(0),
+          mbQuickCheck(false),
+          mQuickCheckSample(0),
           mMailMethod(cMailMessage::NO_METHOD),
           mSmtpPort(25),
           mMailNoViolations(true)
@@ -118,6 +118,17 @@ public:
     virtual int  GetIterFlags() const;
     virtual void SetIterFlags(int i);
 
+    virtual void SetWorkerPool(cWorkerPool* pPool)
+    {
+    }
+    virtual void Prefetch()
+    {
+    }
+    virtual void SetLeafProps(const cFCOPropVector& v)
+    {
+    }
+    // the database is always read inline
+
 private:
     //
     // helper methods
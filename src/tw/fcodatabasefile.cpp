@@ -49,23 +49,28 @@
 
 // TODO: May localizable strings need to be moved to string table
 
-IMPLEMENT_TYPEDSERIALIZABLE(cFCODatabaseFile, _T("cFCODatabaseFile"), 0, 1)
+// version 1 had each genre's database inline, and version 2 has the index of its chunks,
+// which are stored outside of the serialized object (see cTWUtil::WriteDatabase())
+IMPLEMENT_TYPEDSERIALIZABLE(cFCODatabaseFile, _T("cFCODatabaseFile"), 0, 2)
 
 
 cFCODatabaseFile::tEntry::tEntry(cGenre::Genre genre)
     //TODO -- ugh, this sucks! I need to add another interface to the database!
     : mDb(cGenreSwitcher::GetInstance()->GetFactoryForGenre((cGenre::Genre)genre)->GetNameInfo()->IsCaseSensitive(),
           cGenreSwitcher::GetInstance()->GetFactoryForGenre((cGenre::Genre)genre)->GetNameInfo()->GetDelimitingChar()),
-      mGenre(genre)
+      mGenre(genre),
+      mpChunks(0)
 {
 }
 
 cFCODatabaseFile::cFCODatabaseFile()
 #ifdef DEBUG
-    : mFileName(_T("Unknown file name"))
+    : mFileName(_T("Unknown file name")),
 #else
-    : mFileName(_T("")) // If we don't know the filename, lets just not have one in release mode.
+    : mFileName(_T("")), // If we don't know the filename, lets just not have one in release mode.
 #endif
+      mChunksStart(0),
+      mChunksEnd(-1)
 {
 }
 
@@ -118,29 +123,60 @@ void cFCODatabaseFile::Read(iSerializer* pSerializer, int32 version)
         // get the spec list
         //
         pSerializer->ReadObject(&entry.mSpecList);
-        //
-        // get the database data
-        //
-        int32 fileSize;
-        pSerializer->ReadInt32(fileSize);
-        //
-        // write the hier database into a temp file...
-        //
-        cLockedTemporaryFileArchive* pArch = new cLockedTemporaryFileArchive();
-        pArch->OpenReadWrite();
-
-        cSerializerUtil::Copy(pArch, pSerializer, fileSize);
-        //
-        // associate the database with this file...
-        //
-        entry.mDb.Open(pArch);
+        if (version >= 2)
+        {
+            //
+            // read the database in place, out of its chunks
+            //
+            cChunkIndex index;
+            index.Read(pSerializer);
+            if (mChunksEnd >= 0 && !index.IsWithin(mChunksStart, mChunksEnd))
+            {
+                throw eSerializerInputStreamFmt(_T("Chunk outside the database's chunks"),
+                                                mFileName,
+                                                eSerializer::TY_FILE);
+            }
+
+            cChunkedArchive* pArch = new cChunkedArchive();
+            try
+            {
+                pArch->Open(mFileName, index);
+            }
+            catch (eError&)
+            {
+                delete pArch;
+                throw;
+            }
+
+            entry.mDb.Open(pArch);
+            entry.mpChunks = pArch;
+        }
+        else
+        {
+            //
+            // get the database data
+            //
+            int32 fileSize;
+            pSerializer->ReadInt32(fileSize);
+            //
+            // write the hier database into a temp file...
+            //
+            cLockedTemporaryFileArchive* pArch = new cLockedTemporaryFileArchive();
+            pArch->OpenReadWrite();
+
+            cSerializerUtil::Copy(pArch, pSerializer, fileSize);
+            //
+            // associate the database with this file...
+            //
+            entry.mDb.Open(pArch);
+        }
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // Write
 ///////////////////////////////////////////////////////////////////////////////
-void cFCODatabaseFile::Write(iSerializer* pSerializer) const //throw( eFCODbFileTooBig )
+void cFCODatabaseFile::Write(iSerializer* pSerializer) const //throw( eSerializer, eArchive )
 {
     //
     // write the db header..
@@ -159,19 +195,35 @@ void cFCODatabaseFile::Write(iSerializer* pSerializer) const //throw( eFCODbFile
         pSerializer->WriteObject(&(*i)->mGenreHeader);
         pSerializer->WriteObject(&(*i)->mSpecList);
         //
-        // copy the database's data into the archive...
+        // the database itself was written by WriteChunks(); this is where it went
         //
+        (*i)->mIndex.Write(pSerializer);
+    }
+}
+
+void cFCODatabaseFile::WriteChunks(cBidirArchive& arch) //throw (eArchive)
+{
+    for (DbList::iterator i = mDbList.begin(); i != mDbList.end(); ++i)
+    {
         (*i)->mDb.Flush();
         cBidirArchive* pDbArch = (*i)->mDb.GetArchive();
-        pDbArch->Seek(0, cBidirArchive::BEGINNING);
 
-        // TODO:BAM -- eventually we should write it as a 64 bit,
-        // but that would change the db format
-        if (pDbArch->Length() > TSS_INT32_MAX)
-            throw eFCODbFileTooBig();
+        //
+        // a database that hasn't changed since it was read doesn't need compressing again
+        //
+        if ((*i)->mpChunks && (*i)->mpChunks->IsInPlace())
+            (*i)->mpChunks->CopyChunks(arch, (*i)->mIndex);
+        else
+            (*i)->mIndex.Build(arch, *pDbArch);
+    }
+}
 
-        pSerializer->WriteInt32(static_cast<int32>(pDbArch->Length()));
-        cSerializerUtil::Copy(pSerializer, pDbArch, pDbArch->Length());
+void cFCODatabaseFile::VerifyChunks() //throw (eArchive)
+{
+    for (DbList::iterator i = mDbList.begin(); i != mDbList.end(); ++i)
+    {
+        if ((*i)->mpChunks)
+            (*i)->mpChunks->VerifyChunks();
     }
 }
 
@@ -237,6 +289,13 @@ TSTRING cFCODatabaseFile::GetFileName() const
     return mFileName;
 }
 
+void cFCODatabaseFile::SetChunkRegion(int64 start, int64 end)
+{
+    ASSERT(start >= 0 && end >= start);
+    mChunksStart = start;
+    mChunksEnd   = end;
+}
+
 //-----------------------------------------------------------------------------
 // cFCODatabaseFileIter
 //-----------------------------------------------------------------------------
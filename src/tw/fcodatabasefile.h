@@ -65,6 +65,9 @@ class cElGamalSigPrivateKey;
 #ifndef __FCOGENRE_H
 #include "fco/fcogenre.h"
 #endif
+#ifndef __CHUNKEDARCHIVE_H
+#include "twcrypto/chunkedarchive.h"
+#endif
 
 //
 // TODO -- support encrypting each entry seperately
@@ -73,7 +76,6 @@ class cElGamalSigPrivateKey;
 //
 
 TSS_EXCEPTION(eFCODbFile, eError);
-TSS_EXCEPTION(eFCODbFileTooBig, eFCODbFile);
 
 //-----------------------------------------------------------------------------
 // cFCODatabaseFile -- class that manages a set of databases (for different genres
@@ -87,7 +89,11 @@ public:
 
     void    SetFileName(const TSTRING& name);
     TSTRING GetFileName() const;
-    // the file name is only used in exception throwing; it is not necessary to set it.
+    // the file name is used in exception throwing, and to find the databases' chunks when
+    // they are read in place; it must be set before Read() is called for that.
+    void SetChunkRegion(int64 start, int64 end);
+    // where in the file the chunks were written; if it is set, Read() rejects an index with
+    // chunks anywhere else
 
     void AddGenre(cGenre::Genre genreId, cFCODatabaseFileIter* pIter = 0); //throw (eArchive)
         // if pIter is not null, then it is pointing at the new node. This asserts that the
@@ -97,6 +103,14 @@ public:
 
     static const cFileHeaderID& GetFileHeaderID();
 
+    void WriteChunks(cBidirArchive& arch); //throw (eArchive)
+        // writes each genre's database to arch as compressed chunks, starting at its current
+        // position. This must be done before Write(), which writes the index of the chunks.
+        // The chunks of a database that is still being read in place are copied as they are.
+    void VerifyChunks(); //throw (eArchive)
+        // checks all the chunks of the databases being read in place against their digests;
+        // otherwise each one is only checked when it is first read
+
     ///////////////////////////////
     // serialization interface
     ///////////////////////////////
@@ -123,6 +137,8 @@ public:
         cFCODbGenreHeader mGenreHeader;
         cFCOSpecList      mSpecList; // the spec used to create the database
         cGenre::Genre     mGenre;    // the genre this is associated with
+        cChunkedArchive*  mpChunks;  // what mDb is read from, if it is read in place; mDb owns it
+        cChunkIndex       mIndex;    // where WriteChunks() put the database
     };
 
 private:
@@ -135,6 +151,8 @@ private:
     cFCODbHeader mHeader;
     DbList       mDbList;   // the list of databases
     TSTRING      mFileName; // for cosmetic purposes only
+    int64        mChunksStart;
+    int64        mChunksEnd; // -1 if SetChunkRegion() hasn't been called
 
     DECLARE_TYPEDSERIALIZABLE()
 };
@@ -168,6 +168,8 @@ bool cFileManipulator::TestDecryption(const cElGamalSigPublicKey& key, bool thor
             cFCODatabaseFile db;
             bool             encrypted;
             cTWUtil::ReadDatabase(mFileName.c_str(), db, &key, encrypted);
+            // the signature only covers the chunks' digests
+            db.VerifyChunks();
         }
         else if (mFileHeader.GetID() == cFCOReport::GetFileHeaderID())
         {
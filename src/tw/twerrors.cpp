@@ -112,6 +112,5 @@ TSS_REGISTER_ERROR(eFileManipUnrecognizedFileType(), _T("Unrecognized file type.
 // Database File
 //
 TSS_REGISTER_ERROR(eFCODbFile(), _T("Database file error."));
-TSS_REGISTER_ERROR(eFCODbFileTooBig(), _T("Database file too large."));
 
 TSS_END_ERROR_REGISTRATION()
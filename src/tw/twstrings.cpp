@@ -148,6 +148,8 @@ TSS_BeginStringtable(cTW)
     TSS_StringEntry(tw::STR_WRITE_DB_FILE, _T("Wrote database file: ")),
     TSS_StringEntry(tw::STR_WRITE_REPORT_FILE, _T("Wrote report file: ")),
     TSS_StringEntry(tw::STR_WRITE_CONFIG_FILE, _T("Wrote configuration file: ")),
+    TSS_StringEntry(tw::STR_OPEN_HASH_CACHE_FILE, _T("Opening hash cache file: ")),
+    TSS_StringEntry(tw::STR_WRITE_HASH_CACHE_FILE, _T("Wrote hash cache file: ")),
 
     TSS_StringEntry(tw::STR_REPORT_TITLE, _T("Open Source Tripwire(R) " PACKAGE_VERSION " Integrity Check Report")),
     TSS_StringEntry(tw::STR_R_GENERATED_BY, _T("Report generated by: ")),
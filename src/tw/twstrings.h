@@ -53,7 +53,8 @@ TSS_BeginStringIds(tw) STR_ERR_MISSING_LOCAL_KEY, STR_ERR_MISSING_SITE_KEY, STR_
     STR_IGNORE_PROPS,   // ignoring properties
     STR_NOT_IMPLEMENTED, STR_REPORT_EMPTY, STR_FILE_WRITTEN, STR_FILE_OPEN, STR_FILE_ENCRYPTED, STR_OPEN_KEYFILE,
     STR_OPEN_CONFIG_FILE, STR_OPEN_DB_FILE, STR_OPEN_REPORT_FILE, STR_OPEN_POLICY_FILE, STR_WRITE_POLICY_FILE,
-    STR_WRITE_DB_FILE, STR_WRITE_REPORT_FILE, STR_WRITE_CONFIG_FILE,
+    STR_WRITE_DB_FILE, STR_WRITE_REPORT_FILE, STR_WRITE_CONFIG_FILE, STR_OPEN_HASH_CACHE_FILE,
+    STR_WRITE_HASH_CACHE_FILE,
 
     STR_REPORT_TITLE, STR_R_GENERATED_BY, STR_R_CREATED_ON, STR_DB_CREATED_ON, STR_DB_LAST_UPDATE, STR_R_SUMMARY,
     STR_HOST_NAME, STR_HOST_IP, STR_HOST_ID, STR_POLICY_FILE_USED, STR_CONFIG_FILE_USED, STR_DB_FILE_USED,
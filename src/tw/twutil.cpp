@@ -65,6 +65,8 @@
 #include "core/ntmbs.h"
 #include "core/displayencoder.h"
 #include "core/tw_signal.h"
+#include "core/blake3.h"
+#include "fs/fshashcache.h"
 
 #ifdef TW_PROFILE
 #include "core/tasktimer.h"
@@ -72,6 +74,9 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/stat.h>
+#include <limits.h>
+#include <stdlib.h>
 #if SUPPORTS_TERMIOS
 #include <termios.h>
 #include <sys/ioctl.h>
@@ -83,8 +88,48 @@ int _getch(void);
 static const char*  POLICY_FILE_MAGIC_8BYTE = "#POLTXT\n";
 static const char*  CONFIG_FILE_MAGIC_8BYTE = "#CFGTXT\n";
 static const uint32 CURRENT_FIXED_VERSION   = 0x02020000;
+static const uint32 CHUNKED_DB_VERSION      = 0x02030000; // databases written in compressed chunks
+static const uint32 HASH_CACHE_VERSION      = 1;
 
 
+///////////////////////////////////////////////////////////////////////////////
+// WriteObjectBody -- writes what follows the file header, either signed or
+//      just compressed
+///////////////////////////////////////////////////////////////////////////////
+static void WriteObjectBody(cArchive&                    arch,
+                            const TCHAR*                 filename,
+                            const iTypedSerializable*    pObjHeader,
+                            const iTypedSerializable&    obj,
+                            bool                         bEncrypt,
+                            const cElGamalSigPrivateKey* pPrivateKey)
+{
+    if (bEncrypt)
+    {
+        cElGamalSigArchive cryptoArchive;
+        cryptoArchive.SetWrite(&arch, pPrivateKey);
+        cSerializerImpl ser(cryptoArchive, cSerializerImpl::S_WRITE, filename);
+        ser.Init();
+        if (pObjHeader)
+            ser.WriteObject(pObjHeader);
+        ser.WriteObject(&obj);
+        ser.Finit();
+        cryptoArchive.FlushWrite();
+    }
+    else
+    {
+        // not encrypted
+        cNullCryptoArchive cryptoArchive;
+        cryptoArchive.Start(&arch);
+        cSerializerImpl ser(cryptoArchive, cSerializerImpl::S_WRITE, filename);
+        ser.Init();
+        if (pObjHeader)
+            ser.WriteObject(pObjHeader);
+        ser.WriteObject(&obj);
+        ser.Finit();
+        cryptoArchive.Finish();
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // WriteObjectToArchive -- called from WriteObject, does most of the work
 ///////////////////////////////////////////////////////////////////////////////
@@ -110,31 +155,7 @@ static void WriteObjectToArchive(cArchive&                 arch,
             fileHeader.Write(&fhSer);
         }
 
-        if (bEncrypt)
-        {
-            cElGamalSigArchive cryptoArchive;
-            cryptoArchive.SetWrite(&arch, pPrivateKey);
-            cSerializerImpl ser(cryptoArchive, cSerializerImpl::S_WRITE, filename);
-            ser.Init();
-            if (pObjHeader)
-                ser.WriteObject(pObjHeader);
-            ser.WriteObject(&obj);
-            ser.Finit();
-            cryptoArchive.FlushWrite();
-        }
-        else
-        {
-            // not encrypted
-            cNullCryptoArchive cryptoArchive;
-            cryptoArchive.Start(&arch);
-            cSerializerImpl ser(cryptoArchive, cSerializerImpl::S_WRITE, filename);
-            ser.Init();
-            if (pObjHeader)
-                ser.WriteObject(pObjHeader);
-            ser.WriteObject(&obj);
-            ser.Finit();
-            cryptoArchive.Finish();
-        }
+        WriteObjectBody(arch, filename, pObjHeader, obj, bEncrypt, pPrivateKey);
     }
     catch (eError& e)
     {
@@ -187,33 +208,16 @@ static void WriteObject(const TCHAR*                 filename,
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// WriteObjectToArchive -- called from WriteObject, does most of the work
+// ReadObjectBody -- reads what WriteObjectBody() wrote
 ///////////////////////////////////////////////////////////////////////////////
-static void ReadObjectFromArchive(cArchive&                   arch,
-                                  const TCHAR*                objFileName,
-                                  iTypedSerializable*         pObjHeader,
-                                  iTypedSerializable&         obj,
-                                  const cFileHeaderID&        fhid,
-                                  const cElGamalSigPublicKey* pPublicKey,
-                                  bool&                       bEncrypted)
+static void ReadObjectBody(cArchive&                   arch,
+                           const TCHAR*                objFileName,
+                           const cFileHeader&          fileHeader,
+                           iTypedSerializable*         pObjHeader,
+                           iTypedSerializable&         obj,
+                           const cElGamalSigPublicKey* pPublicKey,
+                           bool&                       bEncrypted)
 {
-    cFileHeader fileHeader;
-
-    {
-        cSerializerImpl fhSer(arch, cSerializerImpl::S_READ, objFileName);
-        fileHeader.Read(&fhSer);
-    }
-
-    // check for a mismatched header
-    if (fileHeader.GetID() != fhid)
-        ThrowAndAssert(eSerializerInputStreamFmt(_T(""), objFileName, eSerializer::TY_FILE));
-
-    // Check file version.
-    // If we in the future we wish to support reading objects of different versions,
-    // we will have to move this check to outside ReadObject().
-    if (fileHeader.GetVersion() != CURRENT_FIXED_VERSION)
-        ThrowAndAssert(eSerializerVersionMismatch(_T(""), objFileName, eSerializer::TY_FILE));
-
     try
     {
         // switch on the type of encoding...
@@ -263,6 +267,37 @@ static void ReadObjectFromArchive(cArchive&                   arch,
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// ReadObjectFromArchive -- called from ReadObject, does most of the work
+///////////////////////////////////////////////////////////////////////////////
+static void ReadObjectFromArchive(cArchive&                   arch,
+                                  const TCHAR*                objFileName,
+                                  iTypedSerializable*         pObjHeader,
+                                  iTypedSerializable&         obj,
+                                  const cFileHeaderID&        fhid,
+                                  const cElGamalSigPublicKey* pPublicKey,
+                                  bool&                       bEncrypted)
+{
+    cFileHeader fileHeader;
+
+    {
+        cSerializerImpl fhSer(arch, cSerializerImpl::S_READ, objFileName);
+        fileHeader.Read(&fhSer);
+    }
+
+    // check for a mismatched header
+    if (fileHeader.GetID() != fhid)
+        ThrowAndAssert(eSerializerInputStreamFmt(_T(""), objFileName, eSerializer::TY_FILE));
+
+    // Check file version.
+    // If we in the future we wish to support reading objects of different versions,
+    // we will have to move this check to outside ReadObject().
+    if (fileHeader.GetVersion() != CURRENT_FIXED_VERSION)
+        ThrowAndAssert(eSerializerVersionMismatch(_T(""), objFileName, eSerializer::TY_FILE));
+
+    ReadObjectBody(arch, objFileName, fileHeader, pObjHeader, obj, pPublicKey, bEncrypted);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // ReadObject -- writes an object from disk, either encrypted or not, that was
 //      written using WriteObject above.
@@ -345,26 +380,141 @@ bool cTWUtil::IsObjectEncrypted(const TCHAR* objFileName, const cFileHeaderID& f
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// util_ResolvePath -- the file fileName really is, following any symbolic
+//      links, so that replacing it replaces that file and leaves the links
+//      alone; fileName itself if it can't be resolved (it may not exist yet)
+///////////////////////////////////////////////////////////////////////////////
+static TSTRING util_ResolvePath(const TCHAR* fileName)
+{
+    char path[PATH_MAX];
+    if (realpath(fileName, path) == 0)
+        return fileName;
+
+    return path;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_OpenTempFile -- opens a file no one else can have made beside fileName
+//      to write fileName's replacement in, and returns its name in tempName
+///////////////////////////////////////////////////////////////////////////////
+static void util_OpenTempFile(cFileArchive& arch, const TCHAR* fileName, TSTRING& tempName)
+{
+    tempName = fileName;
+    tempName += _T(".XXXXXX");
+
+    try
+    {
+        // mkstemp only picks the name; the file is opened again with O_EXCL
+        // below, so whatever is put there in between is never written through
+        iFSServices::GetInstance()->MakeTempFilename(tempName);
+        unlink(tempName.c_str());
+        arch.OpenReadWrite(tempName.c_str(), cFileArchive::FA_OPEN_EXCLUSIVE);
+    }
+    catch (eError&)
+    {
+        // probably better to rethrow this as a write failed exception
+        throw eArchiveWrite(fileName, iFSServices::GetInstance()->GetErrString());
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// util_ReplaceFile -- puts newName in fileName's place, with the permissions
+//      and owner fileName had, if it was there
+///////////////////////////////////////////////////////////////////////////////
+static void util_ReplaceFile(const TSTRING& newName, const TCHAR* fileName)
+{
+    struct stat oldStat;
+    if (stat(fileName, &oldStat) == 0)
+    {
+        // not being allowed to give it away is fine; the mode is still carried over
+        if (chown(newName.c_str(), oldStat.st_uid, oldStat.st_gid) != 0)
+        {
+            cDebug d("util_ReplaceFile");
+            d.TraceDetail(_T("Couldn't chown %s\n"), newName.c_str());
+        }
+        chmod(newName.c_str(), oldStat.st_mode & 07777);
+    }
+    else
+    {
+        // the temp file was made 0600; give a new file the mode it would
+        // have got being created in place
+        mode_t mask = umask(0);
+        umask(mask);
+        chmod(newName.c_str(), 0664 & ~mask);
+    }
+
+    if (rename(newName.c_str(), fileName) != 0)
+    {
+        TSTRING errStr = iFSServices::GetInstance()->GetErrString();
+        unlink(newName.c_str());
+        throw eArchiveWrite(fileName, errStr);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // WriteDatabase
+//
+// The file is a cFileHeader, then each genre's database in compressed chunks,
+// then the rest of the cFCODatabaseFile, with the index of the chunks, signed
+// or just compressed like any other object, and last of all where that
+// starts, so it can be found.
 ///////////////////////////////////////////////////////////////////////////////
 void cTWUtil::WriteDatabase(const TCHAR*                 filename,
                             cFCODatabaseFile&            db,
                             bool                         bEncrypt,
                             const cElGamalSigPrivateKey* pPrivateKey)
 {
+    ASSERT(pPrivateKey || (!bEncrypt));
+
     cFileHeader fileHeader;
     fileHeader.SetID(db.GetFileHeaderID());
-
-    // I am almost positive that this does nothing, WriteObject() sets the version in the cFileHeader - Jun 8, 1999 - dmb
-    //fileHeader.SetVersion(1);
+    fileHeader.SetVersion(CHUNKED_DB_VERSION);
+    fileHeader.SetEncoding(bEncrypt ? cFileHeader::ASYM_ENCRYPTION : cFileHeader::COMPRESSED);
 
 #ifdef TW_PROFILE
     cTaskTimer timer(_T("Write Database"));
     timer.Start();
 #endif
 
-    WriteObject(filename, 0, db, fileHeader, bEncrypt, pPrivateKey);
+    // a symbolic link is left alone, and the file it points to replaced
+    TSTRING target = util_ResolvePath(filename);
+    if (!cFileUtil::IsRegularFile(target) && cFileUtil::FileExists(target))
+        throw eArchiveNotRegularFile(filename);
+
+    // the database being written may still be reading its chunks out of the file, so the new
+    // one is put in place only once it is complete. That takes being able to write
+    // to the directory the file is in.
+    TSTRING      tempName;
+    cFileArchive arch;
+    util_OpenTempFile(arch, target.c_str(), tempName);
+
+    try
+    {
+        {
+            cSerializerImpl fhSer(arch, cSerializerImpl::S_WRITE, filename);
+            fileHeader.Write(&fhSer);
+        }
+
+        db.WriteChunks(arch);
+
+        int64 objOffset = arch.CurrentPos();
+        WriteObjectBody(arch, filename, 0, db, bEncrypt, pPrivateKey);
+        arch.WriteInt64(objOffset);
+        arch.Close();
+    }
+    catch (eError& e)
+    {
+        unlink(tempName.c_str());
+        throw ePoly(e.GetID(), cErrorUtil::MakeFileError(e.GetMsg(), filename), e.GetFlags());
+    }
+    catch (...)
+    {
+        unlink(tempName.c_str());
+        throw;
+    }
+
+    util_ReplaceFile(tempName, target.c_str());
 
 #ifdef TW_PROFILE
     timer.Stop();
@@ -378,6 +528,9 @@ void cTWUtil::WriteDatabase(const TCHAR*                 filename,
 
 ///////////////////////////////////////////////////////////////////////////////
 // ReadDatabase
+//
+// Databases written before they were kept in chunks are read as well; each
+// genre's database is then copied out to a temporary file, as it used to be.
 ///////////////////////////////////////////////////////////////////////////////
 void cTWUtil::ReadDatabase(const TCHAR*                filename,
                            cFCODatabaseFile&           db,
@@ -394,13 +547,58 @@ void cTWUtil::ReadDatabase(const TCHAR*                filename,
     timer.Start();
 #endif
 
-    ReadObject(filename, 0, db, cFCODatabaseFile::GetFileHeaderID(), pPublicKey, bEncrypted);
+    cDebug d("ReadDatabase");
+    d.TraceDebug(_T("Reading %s from file %s\n"), db.GetType().AsString(), filename);
+
+    cFileArchive arch;
+    arch.OpenRead(filename);
+
+    cFileHeader fileHeader;
+    {
+        cSerializerImpl fhSer(arch, cSerializerImpl::S_READ, filename);
+        fileHeader.Read(&fhSer);
+    }
+
+    // check for a mismatched header
+    if (fileHeader.GetID() != cFCODatabaseFile::GetFileHeaderID())
+        ThrowAndAssert(eSerializerInputStreamFmt(_T(""), filename, eSerializer::TY_FILE));
+
+    if (fileHeader.GetVersion() == CHUNKED_DB_VERSION)
+    {
+        // skip over the chunks; the database reads them itself
+        int64 chunksStart = arch.CurrentPos();
+        int64 objOffset   = -1;
+        if (arch.Length() >= chunksStart + (int64)sizeof(int64))
+        {
+            arch.Seek(arch.Length() - sizeof(int64), cBidirArchive::BEGINNING);
+            arch.ReadInt64(objOffset);
+        }
+
+        if (objOffset < chunksStart || objOffset > arch.Length() - (int64)sizeof(int64))
+            ThrowAndAssert(eSerializerInputStreamFmt(_T(""), filename, eSerializer::TY_FILE));
+
+        arch.Seek(objOffset, cBidirArchive::BEGINNING);
+        db.SetChunkRegion(chunksStart, objOffset);
+    }
+    else if (fileHeader.GetVersion() != CURRENT_FIXED_VERSION)
+        ThrowAndAssert(eSerializerVersionMismatch(_T(""), filename, eSerializer::TY_FILE));
+
+    db.SetFileName(filename);
+    ReadObjectBody(arch, filename, fileHeader, 0, db, pPublicKey, bEncrypted);
 
 #ifdef TW_PROFILE
     timer.Stop();
 #endif
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// IsDatabaseInPlace
+///////////////////////////////////////////////////////////////////////////////
+bool cTWUtil::IsDatabaseInPlace(uint32 fileVersion)
+{
+    return fileVersion == CHUNKED_DB_VERSION;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // WriteReport
 ///////////////////////////////////////////////////////////////////////////////
@@ -726,6 +924,219 @@ void cTWUtil::ReadPolicyText(const TCHAR* filename, std::string& polText, const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// cBLAKE3WriteArchive -- passes everything written to it on to another
+//      archive, keeping a BLAKE3 digest of it along the way
+///////////////////////////////////////////////////////////////////////////////
+class cBLAKE3WriteArchive : public cArchive
+{
+public:
+    explicit cBLAKE3WriteArchive(cArchive* pDest) : mpDest(pDest), mLength(0)
+    {
+        blake3Init(&mInfo);
+    }
+
+    void GetDigest(uint8 digest[BLAKE3_DIGESTSIZE]) const
+    {
+        blake3Final(&mInfo, digest);
+    }
+
+    int64 Length() const
+    {
+        return mLength;
+    }
+
+    virtual bool EndOfFile()
+    {
+        return true;
+    }
+
+protected:
+    virtual int Read(void* pDest, int count)
+    {
+        ThrowAndAssert(eArchiveInvalidOp());
+        return 0;
+    }
+
+    virtual int Write(const void* pSrc, int count)
+    {
+        mpDest->WriteBlob(pSrc, count);
+        blake3Update(&mInfo, static_cast<const uint8*>(pSrc), count);
+        mLength += count;
+        return count;
+    }
+
+private:
+    cArchive*   mpDest;
+    BLAKE3_INFO mInfo;
+    int64       mLength;
+};
+
+static const cFileHeaderID& util_HashCacheHeaderID()
+{
+    static cFileHeaderID id(_T("cFSHashCache"));
+    return id;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WriteHashCache
+//
+// The file is a cFileHeader, the cache's table, padded out to start on an
+// 8 byte boundary, then the table's length and digest, signed with the local
+// key, and last of all the table's length again, so it can be found.
+///////////////////////////////////////////////////////////////////////////////
+void cTWUtil::WriteHashCache(const TCHAR* filename, const cFSHashCache& cache, const cElGamalSigPrivateKey* pPrivateKey)
+{
+    ASSERT(pPrivateKey);
+
+    // the cache being written may still be using the file, so the new one is
+    // put in place only once it is complete. That takes being able to write to
+    // the directory the file is in.
+    TSTRING      target = util_ResolvePath(filename);
+    TSTRING      tempName;
+    cFileArchive arch;
+    util_OpenTempFile(arch, target.c_str(), tempName);
+
+    try
+    {
+        cFileHeader fileHeader;
+        fileHeader.SetID(util_HashCacheHeaderID());
+        fileHeader.SetVersion(CURRENT_FIXED_VERSION);
+        fileHeader.SetEncoding(cFileHeader::ASYM_ENCRYPTION);
+        {
+            cSerializerImpl fhSer(arch, cSerializerImpl::S_WRITE, tempName.c_str());
+            fileHeader.Write(&fhSer);
+        }
+
+        static const int8 padding[8] = { 0 };
+        arch.WriteBlob(padding, (int)(-arch.CurrentPos() & 7));
+
+        cBLAKE3WriteArchive tableArch(&arch);
+        cache.Write(tableArch);
+
+        uint8 digest[BLAKE3_DIGESTSIZE];
+        tableArch.GetDigest(digest);
+
+        cElGamalSigArchive cryptoArchive;
+        cryptoArchive.SetWrite(&arch, pPrivateKey);
+        cryptoArchive.WriteInt32(HASH_CACHE_VERSION);
+        cryptoArchive.WriteInt64(tableArch.Length());
+        cryptoArchive.WriteBlob(digest, sizeof(digest));
+        cryptoArchive.FlushWrite();
+
+        arch.WriteInt64(tableArch.Length());
+        arch.Close();
+    }
+    catch (eError& e)
+    {
+        unlink(tempName.c_str());
+        throw ePoly(e.GetID(), cErrorUtil::MakeFileError(e.GetMsg(), filename), e.GetFlags());
+    }
+    catch (...)
+    {
+        unlink(tempName.c_str());
+        throw;
+    }
+
+    util_ReplaceFile(tempName, target.c_str());
+
+    iUserNotify::GetInstance()->Notify(iUserNotify::V_VERBOSE,
+                                       _T("%s%s\n"),
+                                       TSS_GetString(cTW, tw::STR_WRITE_HASH_CACHE_FILE).c_str(),
+                                       cDisplayEncoder::EncodeInline(filename).c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ReadHashCache
+///////////////////////////////////////////////////////////////////////////////
+void cTWUtil::ReadHashCache(const TCHAR* filename, cFSHashCache& cache, const cElGamalSigPublicKey* pPublicKey)
+{
+    ASSERT(pPublicKey);
+
+    iUserNotify::GetInstance()->Notify(iUserNotify::V_VERBOSE,
+                                       _T("%s%s\n"),
+                                       TSS_GetString(cTW, tw::STR_OPEN_HASH_CACHE_FILE).c_str(),
+                                       cDisplayEncoder::EncodeInline(filename).c_str());
+
+    int64        tableOffset, tableLen;
+    uint8        digest[BLAKE3_DIGESTSIZE];
+    cFileArchive arch; // the table is read from the same open file as its signature
+
+    try
+    {
+        arch.OpenRead(filename);
+
+        cFileHeader fileHeader;
+        {
+            cSerializerImpl fhSer(arch, cSerializerImpl::S_READ, filename);
+            fileHeader.Read(&fhSer);
+        }
+
+        if (fileHeader.GetID() != util_HashCacheHeaderID() || fileHeader.GetEncoding() != cFileHeader::ASYM_ENCRYPTION)
+            ThrowAndAssert(eSerializerInputStreamFmt(_T(""), filename, eSerializer::TY_FILE));
+
+        if (fileHeader.GetVersion() != CURRENT_FIXED_VERSION)
+            ThrowAndAssert(eSerializerVersionMismatch(_T(""), filename, eSerializer::TY_FILE));
+
+        tableOffset = (arch.CurrentPos() + 7) & ~(int64)7;
+        if (arch.Length() < tableOffset + (int64)sizeof(int64))
+            ThrowAndAssert(eSerializerInputStreamFmt(_T(""), filename, eSerializer::TY_FILE));
+
+        arch.Seek(arch.Length() - sizeof(int64), cBidirArchive::BEGINNING);
+        arch.ReadInt64(tableLen);
+        if (tableLen < 0 || tableLen > arch.Length() - tableOffset - (int64)sizeof(int64))
+            ThrowAndAssert(eSerializerInputStreamFmt(_T(""), filename, eSerializer::TY_FILE));
+
+        // the signed part says how long the table really is, and what is in it
+        int32 version;
+        int64 signedLen;
+        arch.Seek(tableOffset + tableLen, cBidirArchive::BEGINNING);
+
+        cElGamalSigArchive cryptoArchive;
+        cryptoArchive.SetRead(&arch, pPublicKey);
+        cryptoArchive.ReadInt32(version);
+        cryptoArchive.ReadInt64(signedLen);
+        if (cryptoArchive.ReadBlob(digest, sizeof(digest)) != sizeof(digest))
+            ThrowAndAssert(eSerializerInputStreamFmt(_T(""), filename, eSerializer::TY_FILE));
+
+        if (version != (int32)HASH_CACHE_VERSION)
+            ThrowAndAssert(eSerializerVersionMismatch(_T(""), filename, eSerializer::TY_FILE));
+        if (signedLen != tableLen)
+            throw eTWUtilCorruptedFile(cErrorUtil::MakeFileError(_T(""), filename));
+    }
+    catch (eTWUtilCorruptedFile&)
+    {
+        throw;
+    }
+    catch (eError& e)
+    {
+        throw ePoly(e.GetID(), cErrorUtil::MakeFileError(e.GetMsg(), filename), e.GetFlags());
+    }
+
+    cache.Load(arch, tableOffset, tableLen);
+    arch.Close();
+
+    // see that the table is the one that was signed
+    BLAKE3_INFO  info;
+    const uint8* pTable = static_cast<const uint8*>(cache.GetImage());
+    blake3Init(&info);
+    for (int64 done = 0; done < tableLen;)
+    {
+        int n = (int)std::min<int64>(tableLen - done, 0x1000000);
+        blake3Update(&info, pTable + done, n);
+        done += n;
+    }
+
+    uint8 tableDigest[BLAKE3_DIGESTSIZE];
+    blake3Final(&info, tableDigest);
+    if (memcmp(tableDigest, digest, sizeof(digest)) != 0)
+    {
+        cache.Clear();
+        throw eTWUtilCorruptedFile(cErrorUtil::MakeFileError(_T(""), filename));
+    }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // OpenKeyFile
 ///////////////////////////////////////////////////////////////////////////////
@@ -75,6 +75,7 @@ class cFCOName;
 class cFCODatabaseFile;
 class cArchive;
 class cMemoryArchive;
+class cFSHashCache;
 
 TSS_EXCEPTION(eTWUtil, eError)
 TSS_EXCEPTION(eTWUtilNotFullPath, eTWUtil)
@@ -110,6 +111,9 @@ public:
     // set bEncrypted to true; otherwise keyFile is not modified and bEncrypted is set to false.
     // if keyFile is already open, then the currently loaded keys are used and keyFileName is ignored.
     // if an error occurs, this will print the error message to stderr and throw eError.
+    static bool IsDatabaseInPlace(uint32 fileVersion);
+    // returns true if a database file with this cFileHeader version is read in place. Older ones
+    // are copied out to a temporary file when they are read, until they are written again.
 
     static void WriteReport(const TCHAR*                 filename,
                             const cFCOReportHeader&      reportHeader,
@@ -150,6 +154,16 @@ public:
     // read and write policy file to and from disk
     // eError() will be thrown on error
 
+    static void WriteHashCache(const TCHAR* filename, const cFSHashCache& cache, const cElGamalSigPrivateKey* pPrivateKey);
+
+    static void ReadHashCache(const TCHAR* filename, cFSHashCache& cache, const cElGamalSigPublicKey* pPublicKey);
+
+    // write the hash cache to disk, and load it back into an empty cache. The cache
+    // is used straight out of the file, so rather than being encrypted itself it is
+    // followed by a signed digest of it, which is checked when it is loaded; a cache
+    // that was not written with the same local key is never used.
+    // eError() will be thrown on error
+
     //-------------------------------------------------------------------------
     // Higher level manipulation of Tripwire file objects
     //-------------------------------------------------------------------------
@@ -2402,6 +2402,184 @@ int cTWAModeChangePassphrases::Execute(cErrorQueue* pQueue)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// cTWAModeUpgradeDb -- rewrites databases in the older formats so that
+//      tripwire can read them in place.
+
+class cTWAModeUpgradeDb : public cTWAModeCommon
+{
+public:
+    cTWAModeUpgradeDb();
+    virtual ~cTWAModeUpgradeDb();
+
+    virtual void    InitCmdLineParser(cCmdLineParser& parser);
+    virtual bool    Init(const cConfigFile* cf, const cCmdLineParser& parser);
+    virtual int     Execute(cErrorQueue* pQueue);
+    virtual TSTRING GetModeUsage()
+    {
+        return TSS_GetString(cTWAdmin, twadmin::STR_TWADMIN_HELP_UPGRADE_DATABASE);
+    }
+    virtual bool LoadConfigFile()
+    {
+        return true;
+    }
+    virtual cTWAdminCmdLine::CmdLineArgs GetModeID() const
+    {
+        return cTWAdminCmdLine::MODE_UPGRADE_DATABASE;
+    }
+
+private:
+    std::list<TSTRING> mFileList;
+    wc16_string        mLocalPassphrase;
+    bool               mLocalPassphraseProvided;
+};
+
+cTWAModeUpgradeDb::cTWAModeUpgradeDb()
+{
+    mLocalPassphraseProvided = false;
+}
+
+cTWAModeUpgradeDb::~cTWAModeUpgradeDb()
+{
+}
+
+void cTWAModeUpgradeDb::InitCmdLineParser(cCmdLineParser& parser)
+{
+    InitCmdLineCommon(parser);
+
+    parser.AddArg(cTWAdminCmdLine::MODE_UPGRADE_DATABASE,
+                  TSTRING(_T("")),
+                  TSTRING(_T("upgrade-database")),
+                  cCmdLineParser::PARAM_NONE);
+    parser.AddArg(
+        cTWAdminCmdLine::LOCAL_KEY_FILE, TSTRING(_T("L")), TSTRING(_T("local-keyfile")), cCmdLineParser::PARAM_ONE);
+    parser.AddArg(
+        cTWAdminCmdLine::LOCALPASSPHRASE, TSTRING(_T("P")), TSTRING(_T("local-passphrase")), cCmdLineParser::PARAM_ONE);
+    parser.AddArg(cTWAdminCmdLine::PARAMS, TSTRING(_T("")), TSTRING(_T("")), cCmdLineParser::PARAM_MANY);
+}
+
+bool cTWAModeUpgradeDb::Init(const cConfigFile* cf, const cCmdLineParser& parser)
+{
+    int i;
+
+    FillOutConfigInfo(cf);
+    FillOutCmdLineInfo(parser);
+
+    cCmdLineIter iter(parser);
+    for (iter.SeekBegin(); !iter.Done(); iter.Next())
+    {
+        switch (iter.ArgId())
+        {
+        case cTWAdminCmdLine::PARAMS:
+            for (i = 0; i < iter.NumParams(); ++i)
+            {
+                TSTRING strFullPath;
+                if (iFSServices::GetInstance()->FullPath(strFullPath, iter.ParamAt(i)))
+                    mFileList.push_back(strFullPath);
+                else
+                    mFileList.push_back(iter.ParamAt(i));
+            }
+            break;
+        case cTWAdminCmdLine::LOCALPASSPHRASE:
+            ASSERT(iter.NumParams() == 1);
+            mLocalPassphraseProvided = true;
+            mLocalPassphrase         = cStringUtil::TstrToWstr(iter.ParamAt(0));
+            break;
+        }
+    }
+
+    // with no files on the command line, upgrade the database the config file names
+    TSTRING str;
+    if (mFileList.empty() && cf != 0 && cf->Lookup(TSTRING(_T("DBFILE")), str))
+    {
+        TSTRING fullPath;
+        if (iFSServices::GetInstance()->FullPath(fullPath, str, cSystemInfo::GetExeDir()))
+            str = fullPath;
+        mFileList.push_back(str);
+    }
+
+    return true;
+}
+
+int cTWAModeUpgradeDb::Execute(cErrorQueue* pQueue)
+{
+    if (mFileList.empty())
+    {
+        cTWUtil::PrintErrorMsg(eBadCmdLine(TSS_GetString(cTWAdmin, twadmin::STR_ERR2_NO_FILES_SPECIFIED)));
+        return 1;
+    }
+
+    bool             bResult = true;
+    cKeyFile         localKeyFile;
+    cPrivateKeyProxy localKey;
+
+    std::list<TSTRING>::iterator i;
+    for (i = mFileList.begin(); i != mFileList.end(); ++i)
+    {
+        try
+        {
+            if (cFileUtil::IsDir(i->c_str()))
+            {
+                // Note: We don't throw here because we don't want to set bResult to false
+                cTWUtil::PrintErrorMsg(eTWASkippingDirectory(*i, eError::NON_FATAL));
+                TCERR << std::endl; // extra newline to separate filenames
+                continue;
+            }
+            else if (!cFileUtil::FileExists(i->c_str()))
+            {
+                throw eTWAFileNotFound(*i, eError::NON_FATAL);
+            }
+
+            cFileManipulator manip(i->c_str());
+            manip.Init();
+
+            if (*manip.GetHeaderID() != cFCODatabaseFile::GetFileHeaderID())
+            {
+                throw eTWAFileNotADatabase(manip.GetFileName(), eError::NON_FATAL);
+            }
+
+            if (cTWUtil::IsDatabaseInPlace(manip.GetFileVersion()))
+            {
+                iUserNotify::GetInstance()->Notify(
+                    iUserNotify::V_NORMAL,
+                    TSS_GetString(cTWAdmin, twadmin::STR_DATABASE_ALREADY_CURRENT).c_str(),
+                    cDisplayEncoder::EncodeInline(manip.GetFileName()).c_str());
+                continue;
+            }
+
+            bool bEncrypted = (manip.GetEncoding() == cFileHeader::ASYM_ENCRYPTION);
+            if (bEncrypted && !localKey.Valid())
+            {
+                cTWUtil::OpenKeyFile(localKeyFile, mLocalKeyFile);
+                cTWUtil::CreatePrivateKey(localKey,
+                                          localKeyFile,
+                                          mLocalPassphraseProvided ? mLocalPassphrase.c_str() : 0,
+                                          cTWUtil::KEY_LOCAL);
+            }
+
+            // the old format is copied out to a temporary file as it is read, and
+            // WriteDatabase() replaces the original only once the new one is complete.
+            cFCODatabaseFile db;
+            cTWUtil::ReadDatabase(i->c_str(), db, bEncrypted ? localKeyFile.GetPublicKey() : 0, bEncrypted);
+            cTWUtil::WriteDatabase(i->c_str(), db, bEncrypted, bEncrypted ? localKey.GetKey() : 0);
+
+            iUserNotify::GetInstance()->Notify(iUserNotify::V_NORMAL,
+                                               TSS_GetString(cTWAdmin, twadmin::STR_DATABASE_UPGRADED).c_str(),
+                                               cDisplayEncoder::EncodeInline(manip.GetFileName()).c_str());
+        }
+        catch (eError& e)
+        {
+            e.SetFatality(false);
+            cTWUtil::PrintErrorMsg(e);
+            TCERR << std::endl; // extra newline to separate filenames
+            bResult = false;
+        }
+    }
+
+    return bResult == false;
+}
+
+
 //#############################################################################
 // cTWAModeHelp : A mode for supplying mode specific usage statements
 //#############################################################################
@@ -2475,6 +2653,10 @@ void cTWAModeHelp::InitCmdLineParser(cCmdLineParser& cmdLine)
                    TSTRING(_T("C")),
                    TSTRING(_T("change-passphrases")),
                    cCmdLineParser::PARAM_MANY);
+    cmdLine.AddArg(cTWAdminCmdLine::MODE_UPGRADE_DATABASE,
+                   TSTRING(_T("U")),
+                   TSTRING(_T("upgrade-database")),
+                   cCmdLineParser::PARAM_MANY);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -2517,6 +2699,7 @@ bool cTWAModeHelp::Init(const cConfigFile* cf, const cCmdLineParser& cmdLine)
         case cTWAdminCmdLine::MODE_EXAMINE:           //fall through
         case cTWAdminCmdLine::MODE_GENERATE_KEYS:
         case cTWAdminCmdLine::MODE_CHANGE_PASSPHRASES:
+        case cTWAdminCmdLine::MODE_UPGRADE_DATABASE:
         {
             int     i;
             TSTRING str = iter.ActualParam();
@@ -2580,6 +2763,7 @@ int cTWAModeHelp::Execute(cErrorQueue* pQueue)
             TCOUT << TSS_GetString(cTWAdmin, twadmin::STR_TWADMIN_HELP_EXAMINE);
             TCOUT << TSS_GetString(cTWAdmin, twadmin::STR_TWADMIN_HELP_GENERATE_KEYS);
             TCOUT << TSS_GetString(cTWAdmin, twadmin::STR_TWADMIN_HELP_CHANGE_PASSPHRASES);
+            TCOUT << TSS_GetString(cTWAdmin, twadmin::STR_TWADMIN_HELP_UPGRADE_DATABASE);
 
             //We're done, return
             return 1;
@@ -2664,6 +2848,14 @@ int cTWAModeHelp::Execute(cErrorQueue* pQueue)
                 mPrinted.insert(_T("change-passphrases"));
             }
         }
+        else if (_tcscmp((*it).c_str(), _T("upgrade-database")) == 0 || _tcscmp((*it).c_str(), _T("U")) == 0)
+        {
+            if (mPrinted.find(_T("upgrade-database")) == mPrinted.end())
+            {
+                TCOUT << TSS_GetString(cTWAdmin, twadmin::STR_TWADMIN_HELP_UPGRADE_DATABASE);
+                mPrinted.insert(_T("upgrade-database"));
+            }
+        }
         else
         {
             cTWUtil::PrintErrorMsg(eTWAInvalidHelpMode((*it), eError::NON_FATAL));
@@ -2780,6 +2972,8 @@ iTWAMode* cTWAdminCmdLine::GetMode(int argc, const TCHAR* const* argv)
             mode = MODE_GENERATE_KEYS;
         else if (_tcscmp(argv[2], _T("C")) == 0)
             mode = MODE_CHANGE_PASSPHRASES;
+        else if (_tcscmp(argv[2], _T("U")) == 0)
+            mode = MODE_UPGRADE_DATABASE;
     }
     else
     {
@@ -2802,6 +2996,8 @@ iTWAMode* cTWAdminCmdLine::GetMode(int argc, const TCHAR* const* argv)
             mode = MODE_GENERATE_KEYS;
         else if (_tcscmp(argv[1], _T("--change-passphrases")) == 0)
             mode = MODE_CHANGE_PASSPHRASES;
+        else if (_tcscmp(argv[1], _T("--upgrade-database")) == 0)
+            mode = MODE_UPGRADE_DATABASE;
         else if (_tcscmp(argv[1], _T("--version")) == 0)
             mode = MODE_VERSION;
     }
@@ -2862,6 +3058,9 @@ iTWAMode* cTWAdminCmdLine::GetMode(int argc, const TCHAR* const* argv)
     case MODE_CHANGE_PASSPHRASES:
         pRtn = new cTWAModeChangePassphrases;
         break;
+    case MODE_UPGRADE_DATABASE:
+        pRtn = new cTWAModeUpgradeDb;
+        break;
     case MODE_HELP:
         pRtn = new cTWAModeHelp;
         break;
@@ -47,6 +47,7 @@ TSS_EXCEPTION(eTWASkippingDirectory, eTWA)
 TSS_EXCEPTION(eTWAFileNotFound, eTWA)
 TSS_EXCEPTION(eTWAFileAccess, eTWA)
 TSS_EXCEPTION(eTWAFileTypeUnknown, eTWA)
+TSS_EXCEPTION(eTWAFileNotADatabase, eTWA)
 TSS_EXCEPTION(eTWAInvalidHelpMode, eTWA)
 TSS_EXCEPTION(eTWADecrypt, eTWA)
 TSS_EXCEPTION(eTWADecryptCorrupt, eTWA)
@@ -101,6 +102,7 @@ public:
         MODE_EXAMINE,
         MODE_GENERATE_KEYS,
         MODE_CHANGE_PASSPHRASES,
+        MODE_UPGRADE_DATABASE,
         MODE_HELP,
         MODE_HELP_ALL,
         MODE_VERSION,
@@ -46,6 +46,7 @@ TSS_REGISTER_ERROR(eTWASkippingDirectory(), _T("Skipping Directory."))
 TSS_REGISTER_ERROR(eTWAFileNotFound(), _T("File not found."))
 TSS_REGISTER_ERROR(eTWAFileAccess(), _T("File Access."))
 TSS_REGISTER_ERROR(eTWAFileTypeUnknown(), _T("File Type Unknown."))
+TSS_REGISTER_ERROR(eTWAFileNotADatabase(), _T("File is not a database."))
 TSS_REGISTER_ERROR(eTWAEncryptionChange(), _T("Encryption change."))
 TSS_REGISTER_ERROR(eTWAInvalidHelpMode(), _T("Invalid mode parameter to help:"))
 TSS_REGISTER_ERROR(eTWADecrypt(), _T("Remove encryption failed.\nFilename: "))
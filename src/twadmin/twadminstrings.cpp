@@ -62,6 +62,7 @@ TSS_BeginStringtable(cTWAdmin)
                     _T("Examine Encryption: twadmin [-m e|--examine] [options] [file1...]\n")
                     _T("Generate Keys: twadmin [-m G|--generate-keys] [options]\n")
                     _T("Change Passphrases: twadmin [-m C|--change-passphrases] [options]\n")
+                    _T("Upgrade Database: twadmin [-m U|--upgrade-database] [options] [file1...]\n")
                     _T("\n")
                     _T("Type 'twadmin [mode] --help' OR\n")
                     _T("'twadmin --help mode [mode...]' OR\n")
@@ -196,6 +197,20 @@ TSS_BeginStringtable(cTWAdmin)
                     _T("At least one of -S or -L must be specified.\n")
                     _T("\n")),
 
+    TSS_StringEntry(twadmin::STR_TWADMIN_HELP_UPGRADE_DATABASE,
+                    _T("Upgrade Database mode:\n")
+                    _T("  -m U                 --upgrade-database\n")
+                    _T("  -v                   --verbose\n")
+                    _T("  -s                   --silent, --quiet\n")
+                    _T("  -c cfgfile           --cfgfile cfgfile\n")
+                    _T("  -L localkey          --local-keyfile localkey\n")
+                    _T("  -P passphrase        --local-passphrase passphrase\n")
+                    _T("[file1 file2 ...]\n")
+                    _T("\n")
+                    _T("The -v and -s options are mutually exclusive.\n")
+                    _T("If no files are given, the database named in the config file is upgraded.\n")
+                    _T("\n")),
+
     TSS_StringEntry(twadmin::STR_KEYGEN_VERBOSE_OUTPUT_FILES,
                     _T("Using site keyfile: \"%s\" and local keyfile: \"%s\"\n")),
     TSS_StringEntry(twadmin::STR_KEYGEN_VERBOSE_PASSPHRASES, _T("Using supplied passphrases.\n")),
@@ -243,6 +258,8 @@ TSS_BeginStringtable(cTWAdmin)
                     _T("NOTE: Removing encryption on a file leaves it open to tampering!\n")),
     TSS_StringEntry(twadmin::STR_ENCRYPTION_REMOVED, _T("Encryption removed from \"%s\" successfully.\n")),
     TSS_StringEntry(twadmin::STR_ENCRYPTION_SUCCEEDED, _T("\"%s\" encrypted successfully.\n")),
+    TSS_StringEntry(twadmin::STR_DATABASE_UPGRADED, _T("\"%s\" upgraded successfully.\n")),
+    TSS_StringEntry(twadmin::STR_DATABASE_ALREADY_CURRENT, _T("\"%s\" is already in the current format.\n")),
     TSS_StringEntry(twadmin::STR_FILE, _T("File: \"")), TSS_StringEntry(twadmin::STR_ENDQUOTE_NEWLINE, _T("\"\n")),
 
     TSS_StringEntry(twadmin::STR_ERR2_NO_PT_CONFIG, _T("No plaintext config file specified.\n")),
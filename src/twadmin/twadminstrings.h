@@ -59,6 +59,9 @@ TSS_BeginStringIds(twadmin)
     STR_ENTER_SITE_PASS_OLD, STR_ENTER_LOCAL_PASS_OLD, STR_REMOVE_ENCRYPTION_WARNING, STR_ENCRYPTION_REMOVED,
     STR_ENCRYPTION_SUCCEEDED, STR_FILE, STR_ENDQUOTE_NEWLINE,
 
+    // database upgrade
+    STR_TWADMIN_HELP_UPGRADE_DATABASE, STR_DATABASE_UPGRADED, STR_DATABASE_ALREADY_CURRENT,
+
     // key generation
     STR_GENERATING_KEYS, STR_GENERATION_COMPLETE,
 
@@ -0,0 +1,480 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+// chunkedarchive.cpp
+
+#include "stdtwcrypto.h"
+
+#include "chunkedarchive.h"
+#include "bytequeue.h"
+#include "core/serializer.h"
+
+#include "cryptlib/zinflate.h"
+#include "cryptlib/zdeflate.h"
+
+const int CHUNK_COMPRESSION_LEVEL = 6;
+
+// anything bigger than this in an index is taken to be garbage
+const int32 MAX_CHUNK_SIZE = 16 * 1024 * 1024;
+
+// the most a chunk of chunkSize can take up once deflated; incompressible data goes into
+// stored blocks, which cost 5 bytes each, so this leaves plenty of room
+static int32 util_MaxStoredLen(int32 chunkSize)
+{
+    return chunkSize + chunkSize / 64 + 64;
+}
+
+static void util_Digest(const uint8* pData, int len, uint8 digest[BLAKE3_DIGESTSIZE])
+{
+    BLAKE3_INFO info;
+    blake3Init(&info);
+    blake3Update(&info, pData, len);
+    blake3Final(&info, digest);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cChunkIndex
+///////////////////////////////////////////////////////////////////////////////
+cChunkIndex::cChunkIndex() : mLength(0), mChunkSize(CHUNK_SIZE)
+{
+}
+
+cChunkIndex::~cChunkIndex()
+{
+}
+
+void cChunkIndex::Clear()
+{
+    mLength = 0;
+    mvChunks.clear();
+}
+
+int64 cChunkIndex::GetLength() const
+{
+    return mLength;
+}
+
+int cChunkIndex::GetChunkSize() const
+{
+    return mChunkSize;
+}
+
+int cChunkIndex::GetNumChunks() const
+{
+    return (int)mvChunks.size();
+}
+
+int cChunkIndex::GetChunkLen(int i) const
+{
+    ASSERT(i >= 0 && i < GetNumChunks());
+    return (int)std::min<int64>(mChunkSize, mLength - (int64)i * mChunkSize);
+}
+
+const cChunkIndex::tChunk& cChunkIndex::GetChunk(int i) const
+{
+    ASSERT(i >= 0 && i < GetNumChunks());
+    return mvChunks[i];
+}
+
+bool cChunkIndex::IsWithin(int64 start, int64 end) const
+{
+    // Read() made sure neither of these can overflow
+    for (std::vector<tChunk>::const_iterator i = mvChunks.begin(); i != mvChunks.end(); ++i)
+    {
+        if (i->mOffset < start || i->mOffset + i->mStoredLen > end)
+            return false;
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Build
+///////////////////////////////////////////////////////////////////////////////
+void cChunkIndex::Build(cBidirArchive& dest, cBidirArchive& src, int chunkSize) //throw (eArchive)
+{
+    ASSERT(chunkSize > 0 && chunkSize <= MAX_CHUNK_SIZE);
+
+    Clear();
+    mChunkSize = chunkSize;
+    mLength    = src.Length();
+    mvChunks.reserve((size_t)((mLength + chunkSize - 1) / chunkSize));
+
+    std::vector<uint8> plain(chunkSize), stored;
+    src.Seek(0, cBidirArchive::BEGINNING);
+    for (int64 done = 0; done < mLength;)
+    {
+        int len = (int)std::min<int64>(chunkSize, mLength - done);
+        if (src.ReadBlob(&plain[0], len) != len)
+            throw eArchiveEOF(TSTRING(), TSTRING());
+
+        Deflator deflator(CHUNK_COMPRESSION_LEVEL, new cByteQueue);
+        deflator.Put(&plain[0], len);
+        deflator.InputFinished();
+
+        tChunk chunk;
+        chunk.mOffset    = dest.CurrentPos();
+        chunk.mStoredLen = (int32)deflator.MaxRetrieveable();
+        stored.resize(chunk.mStoredLen);
+        deflator.Get(&stored[0], chunk.mStoredLen);
+        util_Digest(&stored[0], chunk.mStoredLen, chunk.mDigest);
+
+        dest.WriteBlob(&stored[0], chunk.mStoredLen);
+        mvChunks.push_back(chunk);
+        done += len;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Read
+///////////////////////////////////////////////////////////////////////////////
+void cChunkIndex::Read(iSerializer* pSerializer, int32 version) //throw (eSerializer, eArchive)
+{
+    Clear();
+
+    int32 chunkSize;
+    int64 length;
+    pSerializer->ReadInt32(chunkSize);
+    pSerializer->ReadInt64(length);
+    if (chunkSize <= 0 || chunkSize > MAX_CHUNK_SIZE || length < 0)
+        throw eSerializerInputStreamFmt(_T("Bad chunk index"));
+
+    int64 numChunks = (length + chunkSize - 1) / chunkSize;
+    if (numChunks > TSS_INT32_MAX)
+        throw eSerializerInputStreamFmt(_T("Bad chunk index"));
+
+    // the chunks are added as they are read, so a bad length runs out of input
+    // rather than allocating an index for it
+    mChunkSize = chunkSize;
+    mLength    = length;
+    for (int64 n = 0; n < numChunks; n++)
+    {
+        tChunk chunk;
+        pSerializer->ReadInt64(chunk.mOffset);
+        pSerializer->ReadInt32(chunk.mStoredLen);
+        if (pSerializer->ReadBlob(chunk.mDigest, sizeof(chunk.mDigest)) != sizeof(chunk.mDigest) ||
+            chunk.mStoredLen <= 0 || chunk.mStoredLen > util_MaxStoredLen(chunkSize) ||
+            chunk.mOffset < 0 || chunk.mOffset > TSS_INT64_MAX - chunk.mStoredLen)
+            throw eSerializerInputStreamFmt(_T("Bad chunk index"));
+
+        mvChunks.push_back(chunk);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Write
+///////////////////////////////////////////////////////////////////////////////
+void cChunkIndex::Write(iSerializer* pSerializer) const //throw (eSerializer, eArchive)
+{
+    pSerializer->WriteInt32(mChunkSize);
+    pSerializer->WriteInt64(mLength);
+    for (std::vector<tChunk>::const_iterator i = mvChunks.begin(); i != mvChunks.end(); ++i)
+    {
+        pSerializer->WriteInt64(i->mOffset);
+        pSerializer->WriteInt32(i->mStoredLen);
+        pSerializer->WriteBlob(i->mDigest, sizeof(i->mDigest));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cChunkedArchive
+///////////////////////////////////////////////////////////////////////////////
+cChunkedArchive::cChunkedArchive() : mPos(0), mUseCount(0), mpInflated(0)
+{
+    mvCache.reserve(CACHED_CHUNKS);
+}
+
+cChunkedArchive::~cChunkedArchive()
+{
+    Close();
+}
+
+void cChunkedArchive::Open(const TSTRING& fileName, const cChunkIndex& index) //throw (eArchive)
+{
+    Close();
+
+    mFile.OpenRead(fileName.c_str());
+    mFileName = fileName;
+    if (!index.IsWithin(0, mFile.Length()))
+    {
+        mFile.Close();
+        throw eChunkedArchive(fileName, TSTRING());
+    }
+
+    mIndex = index;
+}
+
+void cChunkedArchive::Close()
+{
+    mFile.Close();
+    mvCache.clear();
+    mIndex.Clear();
+    mPos = 0;
+
+    if (mpInflated)
+    {
+        mpInflated->Close();
+        delete mpInflated;
+        mpInflated = 0;
+    }
+}
+
+bool cChunkedArchive::IsInPlace() const
+{
+    return mpInflated == 0;
+}
+
+const cChunkIndex& cChunkedArchive::GetIndex() const
+{
+    return mIndex;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ReadStored -- reads a chunk as it was stored, and makes sure it is what the
+//      index says it should be
+///////////////////////////////////////////////////////////////////////////////
+void cChunkedArchive::ReadStored(int chunk, std::vector<uint8>& stored) //throw (eArchive)
+{
+    const cChunkIndex::tChunk& c = mIndex.GetChunk(chunk);
+
+    stored.resize(c.mStoredLen);
+    if (mFile.ReadAt(c.mOffset, &stored[0], c.mStoredLen) != c.mStoredLen)
+        throw eArchiveEOF(mFileName, TSTRING());
+
+    uint8 digest[BLAKE3_DIGESTSIZE];
+    util_Digest(&stored[0], c.mStoredLen, digest);
+    if (memcmp(digest, c.mDigest, sizeof(digest)) != 0)
+        throw eChunkedArchiveDigest(mFileName, TSTRING());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// GetChunk -- returns the chunk inflated, from the cache if it is there
+///////////////////////////////////////////////////////////////////////////////
+const uint8* cChunkedArchive::GetChunk(int chunk) //throw (eArchive)
+{
+    ++mUseCount;
+
+    tCachedChunk* pOldest = 0;
+    for (std::vector<tCachedChunk>::iterator i = mvCache.begin(); i != mvCache.end(); ++i)
+    {
+        if (i->mChunk == chunk)
+        {
+            i->mLastUsed = mUseCount;
+            return &i->mData[0];
+        }
+        if (!pOldest || i->mLastUsed < pOldest->mLastUsed)
+            pOldest = &(*i);
+    }
+
+    tCachedChunk* pSlot = pOldest;
+    if (mvCache.size() < CACHED_CHUNKS)
+    {
+        mvCache.push_back(tCachedChunk());
+        pSlot = &mvCache.back();
+    }
+    pSlot->mChunk = -1; // until it has been filled in
+
+    std::vector<uint8> stored;
+    ReadStored(chunk, stored);
+
+    int len = mIndex.GetChunkLen(chunk);
+    pSlot->mData.resize(len);
+    try
+    {
+        Inflator inflator(new cByteQueue);
+        inflator.Put(&stored[0], stored.size());
+        inflator.InputFinished();
+        if (inflator.MaxRetrieveable() != (unsigned long)len)
+            throw eChunkedArchive(mFileName, TSTRING());
+
+        inflator.Get(&pSlot->mData[0], len);
+    }
+    catch (const Inflator::Err&)
+    {
+        throw eChunkedArchive(mFileName, TSTRING());
+    }
+
+    pSlot->mChunk    = chunk;
+    pSlot->mLastUsed = mUseCount;
+    return &pSlot->mData[0];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Inflate -- stops working in place; everything is inflated into a temporary
+//      file, which is read and written from then on
+///////////////////////////////////////////////////////////////////////////////
+void cChunkedArchive::Inflate() //throw (eArchive)
+{
+    ASSERT(IsInPlace());
+    cDebug d("cChunkedArchive::Inflate");
+    d.TraceDetail("Inflating %s to a temporary file\n", mFileName.c_str());
+
+    cLockedTemporaryFileArchive* pArch = new cLockedTemporaryFileArchive();
+    try
+    {
+        pArch->OpenReadWrite();
+        for (int i = 0; i < mIndex.GetNumChunks(); i++)
+            pArch->WriteBlob(GetChunk(i), mIndex.GetChunkLen(i));
+        pArch->Seek(mPos, cBidirArchive::BEGINNING);
+    }
+    catch (eError&)
+    {
+        delete pArch;
+        throw;
+    }
+
+    mpInflated = pArch;
+    mvCache.clear();
+    mFile.Close();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CopyChunks
+///////////////////////////////////////////////////////////////////////////////
+void cChunkedArchive::CopyChunks(cBidirArchive& dest, cChunkIndex& index) //throw (eArchive)
+{
+    ASSERT(IsInPlace());
+
+    index.Clear();
+    index.mChunkSize = mIndex.mChunkSize;
+    index.mLength    = mIndex.mLength;
+    index.mvChunks.reserve(mIndex.mvChunks.size());
+
+    std::vector<uint8> stored;
+    for (int i = 0; i < mIndex.GetNumChunks(); i++)
+    {
+        // the digests go along with the chunks, so each one is checked before it is passed on
+        ReadStored(i, stored);
+
+        cChunkIndex::tChunk chunk = mIndex.GetChunk(i);
+        chunk.mOffset             = dest.CurrentPos();
+        dest.WriteBlob(&stored[0], chunk.mStoredLen);
+        index.mvChunks.push_back(chunk);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// VerifyChunks
+///////////////////////////////////////////////////////////////////////////////
+void cChunkedArchive::VerifyChunks() //throw (eArchive)
+{
+    if (!IsInPlace())
+        return;
+
+    std::vector<uint8> stored;
+    for (int i = 0; i < mIndex.GetNumChunks(); i++)
+        ReadStored(i, stored);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cBidirArchive interface
+///////////////////////////////////////////////////////////////////////////////
+bool cChunkedArchive::EndOfFile()
+{
+    if (mpInflated)
+        return mpInflated->EndOfFile();
+
+    return mPos >= mIndex.GetLength();
+}
+
+void cChunkedArchive::Seek(int64 offset, SeekFrom from) //throw(eArchive)
+{
+    if (mpInflated)
+    {
+        mpInflated->Seek(offset, from);
+        return;
+    }
+
+    switch (from)
+    {
+    case cBidirArchive::CURRENT:
+        offset += mPos;
+        break;
+    case cBidirArchive::END:
+        offset += mIndex.GetLength();
+        break;
+    default:
+        break;
+    }
+
+    if (offset < 0)
+        throw eArchiveSeek(mFileName, TSTRING());
+
+    mPos = offset;
+}
+
+int64 cChunkedArchive::CurrentPos() const
+{
+    if (mpInflated)
+        return mpInflated->CurrentPos();
+
+    return mPos;
+}
+
+int64 cChunkedArchive::Length() const
+{
+    if (mpInflated)
+        return mpInflated->Length();
+
+    return mIndex.GetLength();
+}
+
+int cChunkedArchive::Read(void* pDest, int count) //throw(eArchive)
+{
+    if (mpInflated)
+        return mpInflated->ReadBlob(pDest, count);
+
+    int done = 0;
+    while (done < count && mPos < mIndex.GetLength())
+    {
+        int chunk = (int)(mPos / mIndex.GetChunkSize());
+        int off   = (int)(mPos % mIndex.GetChunkSize());
+        int len   = std::min(count - done, mIndex.GetChunkLen(chunk) - off);
+
+        // ReadBlob() can be used to skip ahead
+        if (pDest)
+            memcpy(static_cast<int8*>(pDest) + done, GetChunk(chunk) + off, len);
+
+        done += len;
+        mPos += len;
+    }
+
+    return done;
+}
+
+int cChunkedArchive::Write(const void* pSrc, int count) //throw(eArchive)
+{
+    if (!mpInflated)
+        Inflate();
+
+    mpInflated->WriteBlob(pSrc, count);
+    return count;
+}
@@ -0,0 +1,170 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+// chunkedarchive.h
+//
+// cChunkedArchive -- reads an archive that was stored as separately
+//      compressed chunks, inflating only the chunks that are asked for
+#ifndef __CHUNKEDARCHIVE_H
+#define __CHUNKEDARCHIVE_H
+
+#ifndef __ARCHIVE_H
+#include "core/archive.h"
+#endif
+#ifndef __SERIALIZABLE_H
+#include "core/serializable.h"
+#endif
+
+#include "core/blake3.h"
+
+TSS_FILE_EXCEPTION(eChunkedArchive, eArchiveIntegrity)
+TSS_FILE_EXCEPTION(eChunkedArchiveDigest, eChunkedArchive)
+
+///////////////////////////////////////////////////////////////////////////////
+// cChunkIndex -- says where each chunk of a chunked archive is stored, and
+//      what its stored bytes hash to. Whoever keeps the index is responsible
+//      for keeping it from being tampered with; as long as it is, the chunks
+//      it describes can't be either.
+///////////////////////////////////////////////////////////////////////////////
+class cChunkIndex : public iSerializable
+{
+public:
+    enum
+    {
+        CHUNK_SIZE = 256 * 1024 // the default; a whole number of db blocks
+    };
+
+    struct tChunk
+    {
+        int64 mOffset;    // where the compressed chunk starts in the file
+        int32 mStoredLen; // and how many bytes it takes up there
+        uint8 mDigest[BLAKE3_DIGESTSIZE];
+    };
+
+    cChunkIndex();
+    virtual ~cChunkIndex();
+
+    void Clear();
+
+    int64         GetLength() const;       // of the archive once it is all inflated
+    int           GetChunkSize() const;    // inflated; every chunk but the last is this long
+    int           GetNumChunks() const;
+    int           GetChunkLen(int i) const; // inflated
+    const tChunk& GetChunk(int i) const;
+    bool          IsWithin(int64 start, int64 end) const; // true if every chunk is stored in [start, end)
+
+    void Build(cBidirArchive& dest, cBidirArchive& src, int chunkSize = CHUNK_SIZE); // throw (eArchive)
+        // compresses all of src into dest, starting at dest's current position, and
+        // makes this the index of what was written
+
+    virtual void Read(iSerializer* pSerializer, int32 version = 0); // throw (eSerializer, eArchive)
+    virtual void Write(iSerializer* pSerializer) const;             // throw (eSerializer, eArchive)
+        // Read() rejects a chunk stored longer than deflate could have made it, but only the keeper
+        // knows where the chunks should be, so it has to check that with IsWithin().
+
+private:
+    friend class cChunkedArchive;
+
+    int64               mLength;
+    int32               mChunkSize;
+    std::vector<tChunk> mvChunks;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// cChunkedArchive -- presents the archive a cChunkIndex describes, reading it
+//      in place out of the file it was stored in.  A chunk is read, checked
+//      against its digest, and inflated the first time it is touched, and the
+//      last few are kept around.
+//
+//      The first write turns it into an ordinary archive: everything is
+//      inflated into a locked temporary file, which is used from then on, so
+//      an archive that is only read never costs more than its cache.
+///////////////////////////////////////////////////////////////////////////////
+class cChunkedArchive : public cBidirArchive
+{
+public:
+    enum
+    {
+        CACHED_CHUNKS = 16
+    };
+
+    cChunkedArchive();
+    virtual ~cChunkedArchive();
+
+    void Open(const TSTRING& fileName, const cChunkIndex& index); // throw (eArchive)
+        // throws eChunkedArchive if the index has chunks past the end of the file
+    void Close();
+
+    bool IsInPlace() const;
+    // true until the first write
+    const cChunkIndex& GetIndex() const;
+
+    void CopyChunks(cBidirArchive& dest, cChunkIndex& index); // throw (eArchive)
+        // while the archive is still in place, this copies its chunks as they are into dest,
+        // starting at dest's current position, and makes index the index of the copy
+    void VerifyChunks(); // throw (eArchive)
+        // checks every chunk against its digest, rather than waiting for it to be read
+
+    //-----------------------------------
+    // cBidirArchive interface
+    //-----------------------------------
+    virtual bool  EndOfFile();
+    virtual void  Seek(int64 offset, SeekFrom from); // throw(eArchive)
+    virtual int64 CurrentPos() const;
+    virtual int64 Length() const;
+
+protected:
+    virtual int Read(void* pDest, int count);        // throw(eArchive)
+    virtual int Write(const void* pDest, int count); // throw(eArchive)
+
+private:
+    struct tCachedChunk
+    {
+        int                mChunk;
+        uint32             mLastUsed;
+        std::vector<uint8> mData;
+    };
+
+    void         ReadStored(int chunk, std::vector<uint8>& stored); // throw(eArchive)
+    const uint8* GetChunk(int chunk);                               // throw(eArchive)
+    void         Inflate();                                         // throw(eArchive)
+
+    TSTRING                      mFileName;
+    cFileArchive                 mFile;
+    cChunkIndex                  mIndex;
+    int64                        mPos;
+    std::vector<tCachedChunk>    mvCache;
+    uint32                       mUseCount;
+    cLockedTemporaryFileArchive* mpInflated; // everything, once it has been written to
+};
+
+#endif //__CHUNKEDARCHIVE_H
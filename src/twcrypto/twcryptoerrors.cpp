@@ -38,6 +38,7 @@
 #include "twcryptoerrors.h"
 
 #include "keyfile.h"
+#include "chunkedarchive.h"
 
 TSS_BEGIN_ERROR_REGISTRATION(twcrypto)
 
@@ -50,4 +51,10 @@ TSS_REGISTER_ERROR(eKeyFileBadPassphrase(), _T("Keyfile passphrase incorrect."))
 TSS_REGISTER_ERROR(eKeyFileArchive(), _T("Keyfile Read/Write error."));
 TSS_REGISTER_ERROR(eKeyFileUninitialized(), _T("Internal Keyfile error."));
 
+//
+// Chunked archive
+//
+TSS_REGISTER_ERROR(eChunkedArchive(), _T("Compressed file chunk could not be read."));
+TSS_REGISTER_ERROR(eChunkedArchiveDigest(), _T("File chunk does not match its digest."));
+
 TSS_END_ERROR_REGISTRATION()
@@ -36,6 +36,7 @@
 #include "core/archive.h"
 #include "test.h"
 #include "core/debug.h"
+#include <unistd.h>
 
 void TestBlockFile()
 {
@@ -110,7 +111,146 @@ void TestBlockFile()
     bf.Close();
 }
 
+void TestBlockFileLRU()
+{
+    std::string fileName = TwTestPath("test_lru.bf");
+
+    cBlockFile bf;
+    bf.Open(fileName, 3, true);
+    TEST(bf.GetNumPages() == 3);
+
+    // fill ten blocks, each with its own number...
+    for (int i = 1; i < 10; i++)
+        bf.CreateBlock();
+    for (int i = 0; i < 10; i++)
+    {
+        cBlockFile::Block* pB = bf.GetBlock(i);
+        *pB->GetData() = (int8)i;
+        pB->SetDirty();
+    }
+
+    // ...blocks 7, 8 and 9 are in memory now, so these are all hits
+    int faults = bf.GetNumPageFaults();
+    bf.GetBlock(9);
+    bf.GetBlock(7);
+    bf.GetBlock(8);
+    TEST(bf.GetNumPageFaults() == faults);
+
+    // 9 was used least recently, so 0 takes its place and 7 and 8 stay
+    TEST(*bf.GetBlock(0)->GetData() == 0);
+    TEST(bf.GetNumPageFaults() == faults + 1);
+    bf.GetBlock(7);
+    bf.GetBlock(8);
+    TEST(bf.GetNumPageFaults() == faults + 1);
+
+    // and every block that was paged out was written back
+    for (int i = 0; i < 10; i++)
+    {
+        TEST(*bf.GetBlock(i)->GetData() == (int8)i);
+    }
+    TEST(bf.GetNumPageRequests() >= bf.GetNumPageFaults());
+    bf.Close();
+
+    // with no page count, the cache size is used
+    cBlockFile::SetCacheSize(64 * 1024);
+    bf.Open(fileName, 0);
+    TEST(bf.GetNumPages() == 16);
+    TEST(bf.GetNumBlocks() == 10);
+    TEST(*bf.GetBlock(5)->GetData() == 5);
+    bf.Close();
+    cBlockFile::SetCacheSize(8 * 1024 * 1024);
+}
+
+void TestBlockFileMapped()
+{
+#if SUPPORTS_MAPPED_DATABASE
+    std::string fileName = TwTestPath("test_mapped.bf");
+
+    // write 600 blocks through a mapping, which has to grow twice to hold them...
+    cBlockFile bf;
+    bf.Open(fileName, 0, true);
+    TEST(bf.IsMapped());
+    TEST(bf.GetNumPages() == cBlockFile::MAX_MAPPED_PAGES);
+    for (int i = 1; i < 600; i++)
+    {
+        cBlockFile::Block* pB = bf.CreateBlock();
+        memcpy(pB->GetData(), &i, sizeof(i));
+        pB->SetDirty();
+    }
+    for (int i = 1; i < 600; i += 7)
+    {
+        int n = 0;
+        memcpy(&n, bf.GetBlock(i)->GetData(), sizeof(n));
+        TEST(n == i);
+    }
+    TEST(bf.GetNumBlockReads() == 0);
+    TEST(bf.GetNumBlockWrites() == 0);
+
+    // ...and everything that reads the archive sees them once it is flushed
+    bf.Flush();
+    int n = 0;
+    bf.GetArchive()->Seek(599 * cBlockFile::BLOCK_SIZE, cBidirArchive::BEGINNING);
+    bf.GetArchive()->ReadBlob(&n, sizeof(n));
+    TEST(n == 599);
+    bf.Close();
+
+    // so does paging the file in the old way
+    cBlockFile::SetUseMapping(false);
+    bf.Open(fileName, 4);
+    TEST(!bf.IsMapped());
+    TEST(bf.GetNumBlocks() == 600);
+    memcpy(&n, bf.GetBlock(300)->GetData(), sizeof(n));
+    TEST(n == 300);
+    bf.Close();
+    cBlockFile::SetUseMapping(true);
+#else
+    skip("mapped databases not supported on this platform");
+#endif
+}
+
+void TestBlockFileLargeOffsets()
+{
+    typedef cBlockImpl<cBlockFile::BLOCK_SIZE> tBlock;
+
+    // a block past 2 GB, in a sparse file so it doesn't take up the space
+    std::string fileName = TwTestPath("test_large.bf");
+    const int   blockNum = TSS_INT32_MAX / cBlockFile::BLOCK_SIZE + 2;
+    const int64 offset   = (int64)blockNum * cBlockFile::BLOCK_SIZE;
+    TEST(offset > TSS_INT32_MAX);
+
+    cFileArchive a;
+    a.OpenReadWrite(fileName.c_str());
+    a.Close();
+    if (truncate(fileName.c_str(), offset + cBlockFile::BLOCK_SIZE) != 0)
+    {
+        unlink(fileName.c_str());
+        skip("can't make a file past 2 GB here");
+    }
+    a.OpenReadWrite(fileName.c_str(), 0);
+
+    tBlock out;
+    out.SetBlockNum(blockNum);
+    memcpy(out.GetData(), "past 2 GB", 10);
+    out.SetDirty();
+    out.Write(a);
+
+    char buf[10] = { 0 };
+    a.Seek(offset, cBidirArchive::BEGINNING);
+    a.ReadBlob(buf, sizeof(buf));
+    TEST(memcmp(buf, "past 2 GB", 10) == 0);
+
+    tBlock in;
+    in.Read(a, blockNum);
+    TEST(memcmp(in.GetData(), "past 2 GB", 10) == 0);
+
+    a.Close();
+    unlink(fileName.c_str());
+}
+
 void RegisterSuite_BlockFile()
 {
     RegisterTest("BlockFile", "Basic", TestBlockFile);
+    RegisterTest("BlockFile", "LRU", TestBlockFileLRU);
+    RegisterTest("BlockFile", "Mapped", TestBlockFileMapped);
+    RegisterTest("BlockFile", "LargeOffsets", TestBlockFileLargeOffsets);
 }
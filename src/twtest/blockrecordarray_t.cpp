@@ -33,6 +33,7 @@
 
 #include "db/stddb.h"
 #include "db/blockrecordarray.h"
+#include "db/blockrecordfile.h"
 #include "test.h"
 #include "core/debug.h"
 #include "core/error.h"
@@ -148,7 +149,51 @@ void TestBlockRecordArray()
     TEST(ra3.IsClassValid());
 }
 
+void TestBlockRecordFileFreeSpace()
+{
+    std::string fileName = TwTestPath("test3.bf");
+
+    int8 data[1200];
+    memset(data, 'x', sizeof(data));
+
+    // three of these fit in a block, so this fills about a hundred of them
+    std::vector<cBlockRecordFile::tAddr> addrs;
+    {
+        cFileArchive* pArch = new cFileArchive;
+        pArch->OpenReadWrite(fileName.c_str(), cFileArchive::FA_OPEN_TRUNCATE);
+
+        cBlockRecordFile rf;
+        rf.Open(pArch, 4);
+        for (int i = 0; i < 300; i++)
+            addrs.push_back(rf.AddItem(data, sizeof(data)));
+        TEST(addrs.back().mBlockNum >= 99);
+
+        // room made in an early block is used before any later one...
+        int64 length = rf.GetArchive()->Length();
+        rf.RemoveItem(addrs[10]);
+        rf.RemoveItem(addrs[200]);
+        TEST(rf.AddItem(data, sizeof(data)).mBlockNum == addrs[10].mBlockNum);
+        TEST(rf.AddItem(data, sizeof(data)).mBlockNum == addrs[200].mBlockNum);
+        TEST(rf.GetArchive()->Length() == length);
+        rf.RemoveItem(addrs[50]);
+        rf.Close();
+    }
+
+    // ...and is found again once the file is reopened
+    cFileArchive* pArch = new cFileArchive;
+    pArch->OpenReadWrite(fileName.c_str(), 0);
+
+    cBlockRecordFile rf;
+    rf.Open(pArch, 4);
+    TEST(rf.AddItem(data, sizeof(data)).mBlockNum == addrs[50].mBlockNum);
+
+    int32 size = 0;
+    TEST(rf.IsValidAddr(addrs[299]));
+    TEST(rf.GetDataForReading(addrs[299], size) && size == sizeof(data));
+}
+
 void RegisterSuite_BlockRecordArray()
 {
     RegisterTest("BlockRecordArray", "Basic", TestBlockRecordArray);
+    RegisterTest("BlockRecordArray", "FileFreeSpace", TestBlockRecordFileFreeSpace);
 }
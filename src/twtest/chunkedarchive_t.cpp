@@ -0,0 +1,204 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+//
+// chunkedarchive_t.cpp
+#include "twcrypto/stdtwcrypto.h"
+#include "twcrypto/chunkedarchive.h"
+#include "core/archive.h"
+#include "core/serializerimpl.h"
+#include "twcrypto/crypto.h"
+#include "test.h"
+#include <unistd.h>
+
+static const int TEST_CHUNK_SIZE = 64 * 1024;
+
+// an index written out field by field so it can say anything; each chunk is
+// stored right after the one before, and its digest is its number
+static void WriteRawIndex(
+    cMemoryArchive& arch, int32 chunkSize, int64 length, int64 offset, int32 storedLen, int numChunks = 1)
+{
+    cSerializerImpl ser(arch, cSerializerImpl::S_WRITE);
+    ser.Init();
+    ser.WriteInt32(chunkSize);
+    ser.WriteInt64(length);
+    for (int i = 0; i < numChunks; i++)
+    {
+        uint8 digest[BLAKE3_DIGESTSIZE] = { 0 };
+        memcpy(digest, &i, sizeof(i));
+
+        ser.WriteInt64(offset + (int64)i * storedLen);
+        ser.WriteInt32(storedLen);
+        ser.WriteBlob(digest, sizeof(digest));
+    }
+    ser.Finit();
+}
+
+static bool ReadIndex(cMemoryArchive& arch, cChunkIndex& index)
+{
+    arch.Seek(0, cBidirArchive::BEGINNING);
+    try
+    {
+        cSerializerImpl ser(arch, cSerializerImpl::S_READ);
+        ser.Init();
+        index.Read(&ser);
+        ser.Finit();
+    }
+    catch (eSerializer&)
+    {
+        return false;
+    }
+    catch (eArchive&)
+    {
+        return false;
+    }
+    return true;
+}
+
+static bool ReadRawIndex(int32 chunkSize, int64 length, int64 offset, int32 storedLen, int numChunks = 1)
+{
+    cMemoryArchive arch;
+    WriteRawIndex(arch, chunkSize, length, offset, storedLen, numChunks);
+
+    cChunkIndex index;
+    return ReadIndex(arch, index);
+}
+
+static void TestChunkIndexBounds()
+{
+    TSTRING fileName = TwTestPath("chunks.bin");
+
+    // random data doesn't compress, so every chunk is stored as long as it can be
+    cMemoryArchive src;
+    {
+        std::vector<int8> data(3 * TEST_CHUNK_SIZE + 100);
+        RandomizeBytes(&data[0], (int)data.size());
+        src.WriteBlob(&data[0], (int)data.size());
+    }
+
+    cChunkIndex built;
+    int64       fileLen;
+    {
+        cFileArchive file;
+        file.OpenReadWrite(fileName.c_str());
+        built.Build(file, src, TEST_CHUNK_SIZE);
+        fileLen = file.Length();
+    }
+    TEST(built.GetNumChunks() == 4);
+    TEST(built.IsWithin(0, fileLen));
+    TEST(!built.IsWithin(0, fileLen - 1));
+    TEST(!built.IsWithin(1, fileLen));
+
+    // so an index of the longest chunks there are still has to be read back
+    cMemoryArchive indexArch;
+    {
+        cSerializerImpl ser(indexArch, cSerializerImpl::S_WRITE);
+        ser.Init();
+        built.Write(&ser);
+        ser.Finit();
+    }
+    cChunkIndex index;
+    TEST(ReadIndex(indexArch, index));
+    TEST(index.GetLength() == src.Length());
+    TEST(index.GetChunk(3).mStoredLen == built.GetChunk(3).mStoredLen);
+
+    // but not one with a chunk longer than deflate could have made it
+    TEST(!ReadRawIndex(TEST_CHUNK_SIZE, TEST_CHUNK_SIZE, 0, 2 * TEST_CHUNK_SIZE));
+
+    // or one whose end doesn't fit in an offset
+    TEST(!ReadRawIndex(TEST_CHUNK_SIZE, TEST_CHUNK_SIZE, TSS_INT64_MAX - 10, 100));
+    TEST(ReadRawIndex(TEST_CHUNK_SIZE, TEST_CHUNK_SIZE, TSS_INT64_MAX - 100, 100));
+
+    // and a file too short for its chunks can't be opened
+    {
+        cChunkedArchive arch;
+        arch.Open(fileName, built);
+        TEST(arch.GetIndex().GetNumChunks() == 4);
+    }
+    {
+        cFileArchive file;
+        file.OpenReadWrite(fileName.c_str());
+        file.WriteBlob(src.GetMemory(), (int)(fileLen / 2));
+    }
+    bool bThrew = false;
+    try
+    {
+        cChunkedArchive arch;
+        arch.Open(fileName, built);
+    }
+    catch (eChunkedArchive&)
+    {
+        bThrew = true;
+    }
+    TEST(bThrew);
+
+    unlink(fileName.c_str());
+}
+
+static void TestChunkIndexLargeLength()
+{
+    // an index of a database past 4 GB, without the database
+    const int32 chunkSize = 16 * 1024 * 1024;
+    const int64 length    = (int64)TSS_INT32_MAX * 2 + 5;
+    const int   numChunks = (int)((length + chunkSize - 1) / chunkSize);
+
+    cMemoryArchive indexArch;
+    WriteRawIndex(indexArch, chunkSize, length, 1000, 4096, numChunks);
+
+    cChunkIndex index;
+    TEST(ReadIndex(indexArch, index));
+    TEST(index.GetLength() == length);
+    TEST(index.GetNumChunks() == numChunks);
+    TEST(index.GetChunkLen(0) == chunkSize);
+    TEST(index.GetChunkLen(numChunks - 1) == (int)(length - (int64)(numChunks - 1) * chunkSize));
+    TEST(index.GetChunk(numChunks - 1).mOffset == 1000 + (int64)(numChunks - 1) * 4096);
+    TEST(index.IsWithin(1000, 1000 + (int64)numChunks * 4096));
+
+    // and it is written back out just as it was read
+    cMemoryArchive copyArch;
+    {
+        cSerializerImpl ser(copyArch, cSerializerImpl::S_WRITE);
+        ser.Init();
+        index.Write(&ser);
+        ser.Finit();
+    }
+    TEST(copyArch.Length() == indexArch.Length());
+    TEST(memcmp(copyArch.GetMemory(), indexArch.GetMemory(), (size_t)indexArch.Length()) == 0);
+
+    // while a length too long for the chunks there are runs out of input
+    TEST(!ReadRawIndex(chunkSize, length, 1000, 4096, numChunks - 1));
+}
+
+void RegisterSuite_ChunkedArchive()
+{
+    RegisterTest("ChunkedArchive", "IndexBounds", TestChunkIndexBounds);
+    RegisterTest("ChunkedArchive", "LargeLength", TestChunkIndexLargeLength);
+}
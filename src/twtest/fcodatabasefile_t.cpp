@@ -32,13 +32,148 @@
 // fcodatabasefile.cpp
 #include "tw/stdtw.h"
 #include "tw/fcodatabasefile.h"
+#include "tw/twutil.h"
+#include "tw/filemanipulator.h"
+#include "core/archive.h"
+#include "db/hierdatabase.h"
+#include "fs/fs.h"
 #include "test.h"
+#include <sstream>
+#include <unistd.h>
 
-void TestFCODatabaseFile()
+static const int NUM_ENTRIES = 1000;
+static const int DATA_LEN    = 1000;
+
+// the data has to be unique enough per entry that the database doesn't
+// compress down to a single chunk
+static void FillData(int8* pData, int n)
+{
+    uint32 x = n * 2654435761u + 1;
+    for (int i = 0; i < DATA_LEN; ++i)
+    {
+        x        = x * 1103515245 + 12345;
+        pData[i] = (int8)(x >> 16);
+    }
+}
+
+static std::string EntryName(int n)
+{
+    std::stringstream ss;
+    ss << "file" << n;
+    return ss.str();
+}
+
+static void AddEntries(cFCODatabaseFile& dbFile)
+{
+    cFCODatabaseFileIter dbIter(dbFile);
+    dbFile.AddGenre(cFS::GenreID(), &dbIter);
+
+    cHierDatabase::iterator iter(&dbIter.GetDb());
+    int8                    data[DATA_LEN];
+    for (int n = 0; n < NUM_ENTRIES; ++n)
+    {
+        FillData(data, n);
+        iter.CreateEntry(EntryName(n));
+        iter.SetData(data, DATA_LEN);
+    }
+}
+
+static bool EntriesMatch(cFCODatabaseFile& dbFile)
 {
-    cDebug d("TestFCODatabaseFile");
-    d.TraceError("Implement this!\n");
-    skip("TestFCODatabaseFile not implemented");
+    cFCODatabaseFileIter dbIter(dbFile);
+    dbIter.SeekToGenre(cFS::GenreID());
+    if (dbIter.Done())
+        return false;
+
+    cHierDatabase::iterator iter(&dbIter.GetDb());
+    int8                    data[DATA_LEN];
+    for (int n = 0; n < NUM_ENTRIES; ++n)
+    {
+        FillData(data, n);
+
+        int32 length;
+        if (!iter.SeekTo(EntryName(n).c_str()) || !iter.HasData())
+            return false;
+        int8* pData = iter.GetData(length);
+        if (length != DATA_LEN || memcmp(pData, data, DATA_LEN) != 0)
+            return false;
+    }
+    return true;
+}
+
+static void TestFCODatabaseFile()
+{
+    TSTRING fileName = TwTestPath("chunked.twd");
+    TSTRING copyName = TwTestPath("chunked_copy.twd");
+    bool    bEncrypted;
+
+    {
+        cFCODatabaseFile dbFile;
+        AddEntries(dbFile);
+        cTWUtil::WriteDatabase(fileName.c_str(), dbFile, false, 0);
+    }
+
+    cFileManipulator manip(fileName.c_str());
+    manip.Init();
+    TEST(cTWUtil::IsDatabaseInPlace(manip.GetFileVersion()));
+
+    // read it in place, then write it back out unchanged, which copies the chunks
+    {
+        cFCODatabaseFile dbFile;
+        cTWUtil::ReadDatabase(fileName.c_str(), dbFile, 0, bEncrypted);
+        TEST(!bEncrypted);
+        TEST(EntriesMatch(dbFile));
+        cTWUtil::WriteDatabase(copyName.c_str(), dbFile, false, 0);
+    }
+    {
+        cFCODatabaseFile dbFile;
+        cTWUtil::ReadDatabase(copyName.c_str(), dbFile, 0, bEncrypted);
+        TEST(EntriesMatch(dbFile));
+    }
+
+    // a damaged chunk is only found when it is read, and has to stop whoever is reading
+    {
+        cFileArchive arch;
+        arch.OpenReadWrite(copyName.c_str(), 0);
+        int64 pos = arch.Length() / 3;
+        int8  b;
+        arch.Seek(pos, cBidirArchive::BEGINNING);
+        arch.ReadBlob(&b, 1);
+        b ^= 0x5a;
+        arch.Seek(pos, cBidirArchive::BEGINNING);
+        arch.WriteBlob(&b, 1);
+        arch.Close();
+    }
+
+    bool bThrew = false;
+    try
+    {
+        cFCODatabaseFile dbFile;
+        cTWUtil::ReadDatabase(copyName.c_str(), dbFile, 0, bEncrypted);
+        EntriesMatch(dbFile);
+    }
+    catch (eArchiveIntegrity&)
+    {
+        bThrew = true;
+    }
+    TEST(bThrew);
+
+    // and VerifyChunks() finds it without reading any entries
+    bThrew = false;
+    try
+    {
+        cFCODatabaseFile dbFile;
+        cTWUtil::ReadDatabase(copyName.c_str(), dbFile, 0, bEncrypted);
+        dbFile.VerifyChunks();
+    }
+    catch (eArchiveIntegrity&)
+    {
+        bThrew = true;
+    }
+    TEST(bThrew);
+
+    unlink(fileName.c_str());
+    unlink(copyName.c_str());
 }
 
 void RegisterSuite_FCODatabaseFile()
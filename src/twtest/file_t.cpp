@@ -58,6 +58,39 @@ void TestFile()
     TEST(testStream);
 }
 
+void TestFileScanning()
+{
+    TSTRING fileName = TwTestPath("file_scan.bin");
+
+    cFile out;
+    out.Open(fileName, cFile::OPEN_WRITE | cFile::OPEN_TRUNCATE);
+    out.Write("0123456789abcdef", 16);
+    out.Close();
+
+    // scanning reads go straight to the file descriptor
+    cFile in;
+    in.Open(fileName, cFile::OPEN_READ | cFile::OPEN_SCANNING);
+    TEST(in.IsOpen());
+    TEST(in.GetSize() == 16);
+
+    char buf[32];
+    TEST(in.Read(buf, 4) == 4);
+    TEST(memcmp(buf, "0123", 4) == 0);
+    TEST(in.Tell() == 4);
+
+    TEST(in.Seek(10, cFile::SEEK_BEGIN) == 10);
+    TEST(in.Read(buf, sizeof(buf)) == 6);
+    TEST(memcmp(buf, "abcdef", 6) == 0);
+    TEST(in.Read(buf, sizeof(buf)) == 0);
+
+    in.Rewind();
+    TEST(in.Read(buf, sizeof(buf)) == 16);
+    TEST(memcmp(buf, "0123456789abcdef", 16) == 0);
+
+    in.Close();
+    TEST(!in.IsOpen());
+}
+
 ////////////////////////////////////////////////////////////////////////
 
 void testDosAsPosix(const std::string& in, const std::string& expected)
@@ -242,6 +275,7 @@ void TestRedoxIsAbsolute()
 void RegisterSuite_File()
 {
     RegisterTest("File", "Basic", TestFile);
+    RegisterTest("File", "Scanning", TestFileScanning);
     RegisterTest("File", "DosAsPosix", TestDosAsPosix);
     RegisterTest("File", "DosAsNative", TestDosAsNative);
     RegisterTest("File", "DosIsAbsolute", TestDosIsAbsolute);
@@ -38,6 +38,17 @@
 #include "fco/fco.h"
 #include "fco/twfactory.h"
 #include "core/errorbucketimpl.h"
+#include "core/workerpool.h"
+#include "fs/fspropset.h"
+#include "fs/fsobject.h"
+#include "fco/signature.h"
+
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace
 {
@@ -107,6 +118,198 @@ void util_ProcessDir(const cFCOName& name)
 }
 
 
+// lists everything under the iterator's current directory into names, handing
+// each subdirectory to Prefetch() before visiting any of them, as tripwire does
+void util_ListTree(iFCODataSourceIter* pIter, std::vector<TSTRING>& names)
+{
+    pIter->Descend();
+
+    for (pIter->SeekBegin(); !pIter->Done(); pIter->Next())
+    {
+        iFCO* pFCO = pIter->CreateFCO();
+        pFCO->Release();
+        if (pIter->CanDescend())
+            pIter->Prefetch();
+    }
+
+    for (pIter->SeekBegin(); !pIter->Done(); pIter->Next())
+    {
+        iFCO* pFCO = pIter->CreateFCO();
+        names.push_back(pFCO->GetName().AsString() + _T(" ") +
+                        pFCO->GetPropSet()->GetPropAt(cFSPropSet::PROP_SIZE)->AsString());
+        pFCO->Release();
+
+        if (pIter->CanDescend())
+        {
+            TW_UNIQUE_PTR<iFCODataSourceIter> pCopy(pIter->CreateCopy());
+            util_ListTree(pCopy.get(), names);
+        }
+    }
+}
+
+void util_ListTree(const TSTRING& root, cWorkerPool* pPool, cErrorBucket* pBucket, std::vector<TSTRING>& names)
+{
+    TW_UNIQUE_PTR<iFCODataSourceIter> pDSIter(iTWFactory::GetInstance()->CreateDataSourceIter());
+    pDSIter->SetErrorBucket(pBucket);
+    pDSIter->SetWorkerPool(pPool);
+
+    pDSIter->SeekToFCO(cFCOName(root), false);
+    TEST(!pDSIter->Done());
+    TEST(pDSIter->CanDescend());
+
+    util_ListTree(pDSIter.get(), names);
+}
+
+// walks the tree under the iterator's current directory like util_ListTree(),
+// counting the files and how many of them were never stat()ed
+void util_CountLeaves(iFCODataSourceIter* pIter, int& nFiles, int& nNoStat)
+{
+    pIter->Descend();
+
+    for (pIter->SeekBegin(); !pIter->Done(); pIter->Next())
+    {
+        cFSObject* pObj = static_cast<cFSObject*>(pIter->CreateFCO());
+        TEST(pObj);
+        if (pIter->CanDescend())
+        {
+            TEST(pObj->GetFSPropSet().GetValidVector().ContainsItem(cFSPropSet::PROP_SIZE));
+            pIter->Prefetch();
+        }
+        else
+        {
+            TEST(pObj->GetFSPropSet().GetFileType() == cFSPropSet::FT_FILE);
+            nFiles++;
+            if (pObj->GetStatCount() == 0)
+            {
+                TEST(!pObj->GetFSPropSet().GetValidVector().ContainsItem(cFSPropSet::PROP_SIZE));
+                nNoStat++;
+            }
+        }
+        pObj->Release();
+    }
+
+    for (pIter->SeekBegin(); !pIter->Done(); pIter->Next())
+    {
+        if (pIter->CanDescend())
+        {
+            TW_UNIQUE_PTR<iFCODataSourceIter> pCopy(pIter->CreateCopy());
+            util_CountLeaves(pCopy.get(), nFiles, nNoStat);
+        }
+    }
+}
+
+void util_MakeFile(const std::string& path, int size)
+{
+    std::ofstream out(path.c_str());
+    out << std::string(size, 'x');
+    TEST(out.good());
+}
+
+// makes a small tree: root/{d0..d3}/{f0..f3}, with another level under d1
+std::string util_MakeTree()
+{
+    std::string root = TwTestPath("prefetch");
+    mkdir(root.c_str(), 0777);
+
+    for (int i = 0; i < 4; i++)
+    {
+        std::string dir = root + "/d" + (char)('0' + i);
+        mkdir(dir.c_str(), 0777);
+
+        for (int j = 0; j < 4; j++)
+            util_MakeFile(dir + "/f" + (char)('0' + j), i * 10 + j);
+    }
+
+    mkdir((root + "/d1/sub").c_str(), 0777);
+    util_MakeFile(root + "/d1/sub/leaf", 42);
+
+    return root;
+}
+
+// puts the read-ahead and hashing thread settings back, and removes what the
+// test made, however the test ends
+class cReadAheadRestorer
+{
+public:
+    cReadAheadRestorer() : mHashThreads(cArchiveSigGen::GetHashThreads())
+    {
+        cFSDataSourceIter::GetReadAhead(mNumFiles, mNumBytes);
+    }
+
+    ~cReadAheadRestorer()
+    {
+        cFSDataSourceIter::SetReadAhead(mNumFiles, mNumBytes);
+        cArchiveSigGen::SetHashThreads(mHashThreads);
+
+        for (size_t i = mPaths.size(); i > 0; i--)
+        {
+            if (0 != rmdir(mPaths[i - 1].c_str()))
+                unlink(mPaths[i - 1].c_str());
+        }
+    }
+
+    void Remove(const std::string& path)
+    {
+        mPaths.push_back(path);
+    }
+    // path is removed when the test ends; directories after what's in them
+
+private:
+    int                      mNumFiles;
+    int64                    mNumBytes;
+    int                      mHashThreads;
+    std::vector<std::string> mPaths;
+};
+
+#if HAVE_POSIX_FADVISE
+// writes the file's pages out, then asks for them to be dropped from the page cache
+void util_DropCache(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    TEST(fd >= 0);
+    fsync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// whether any of the file is in the page cache
+bool util_IsCached(const std::string& path)
+{
+    struct stat st;
+    TEST(0 == stat(path.c_str(), &st));
+
+    int fd = open(path.c_str(), O_RDONLY);
+    TEST(fd >= 0);
+    void* p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    TEST(p != MAP_FAILED);
+
+    size_t                     page = sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> resident((st.st_size + page - 1) / page);
+    TEST(0 == mincore(p, st.st_size, (unsigned char*)&resident[0]));
+    munmap(p, st.st_size);
+
+    for (size_t i = 0; i < resident.size(); i++)
+    {
+        if (resident[i] & 1)
+            return true;
+    }
+    return false;
+}
+
+// the read ahead happens in the background, so this gives it a second to start
+bool util_WaitCached(const std::string& path)
+{
+    for (int i = 0; i < 100; i++)
+    {
+        if (util_IsCached(path))
+            return true;
+        usleep(10000);
+    }
+    return false;
+}
+#endif
+
 } // namespace
 
 
@@ -121,7 +324,215 @@ void TestFSDataSourceIter()
     util_ProcessDir(base);
 }
 
+void TestFSDataSourceIterPrefetch()
+{
+    std::string root = util_MakeTree();
+
+    std::vector<TSTRING> expected;
+    cErrorQueue          errors;
+    util_ListTree(root, 0, &errors, expected);
+    TEST(expected.size() == 22);
+
+    // a prefetching walk has to come up with exactly the same thing
+    cWorkerPool          pool(4);
+    std::vector<TSTRING> names;
+    util_ListTree(root, &pool, &errors, names);
+    TEST(names == expected);
+    TEST(errors.GetNumErrors() == 0);
+}
+
+void TestFSDataSourceIterPrefetchErrors()
+{
+    std::string root = util_MakeTree();
+
+    // with no threads, a listing is only read when it is picked up, so we can
+    // pull a directory out from under it
+    cWorkerPool pool(0);
+    cErrorQueue errors;
+
+    TW_UNIQUE_PTR<iFCODataSourceIter> pIter(iTWFactory::GetInstance()->CreateDataSourceIter());
+    pIter->SetErrorBucket(&errors);
+    pIter->SetWorkerPool(&pool);
+    pIter->SeekToFCO(cFCOName(root + "/d3"), true);
+    TEST(pIter->SeekTo(_T("d3")));
+    iFCO* pFCO = pIter->CreateFCO();
+    pFCO->Release();
+    pIter->Prefetch();
+
+    for (int j = 0; j < 4; j++)
+        unlink((root + "/d3/f" + (char)('0' + j)).c_str());
+    rmdir((root + "/d3").c_str());
+
+    // the error shows up when the directory is descended into, not before
+    TEST(errors.GetNumErrors() == 0);
+    pIter->Descend();
+    TEST(errors.GetNumErrors() == 1);
+    TEST(pIter->Done());
+}
+
+void TestFSDataSourceIterDirFds()
+{
+#if SUPPORTS_DIR_FDS
+    std::string root = util_MakeTree();
+    cErrorQueue errors;
+
+    TW_UNIQUE_PTR<iFCODataSourceIter> pIter(iTWFactory::GetInstance()->CreateDataSourceIter());
+    pIter->SetErrorBucket(&errors);
+    pIter->SeekToFCO(cFCOName(root + "/d1"), false);
+    pIter->Descend();
+
+    // once we are in the directory, what it is called doesn't matter any more
+    std::string moved = root + "/d1_moved";
+    TEST(0 == rename((root + "/d1").c_str(), moved.c_str()));
+
+    int nFiles = 0;
+    for (pIter->SeekBegin(); !pIter->Done(); pIter->Next())
+    {
+        iFCO* pFCO = pIter->CreateFCO();
+        if (pIter->CanDescend())
+        {
+            TW_UNIQUE_PTR<iFCODataSourceIter> pChild(pIter->CreateCopy());
+            pChild->Descend();
+            TEST(!pChild->Done());
+        }
+        else
+            nFiles++;
+        pFCO->Release();
+    }
+
+    TEST(nFiles == 4);
+    TEST(errors.GetNumErrors() == 0);
+
+    TEST(0 == rename(moved.c_str(), (root + "/d1").c_str()));
+#else
+    skip("directory descriptors not supported on this platform");
+#endif
+}
+
+void TestFSDataSourceIterLeafTypes()
+{
+    std::string root = util_MakeTree();
+
+    cFCOPropVector typeOnly;
+    typeOnly.AddItem(cFSPropSet::PROP_FILETYPE);
+
+    cWorkerPool pool(4);
+    for (int i = 0; i < 2; i++)
+    {
+        cErrorQueue errors;
+
+        TW_UNIQUE_PTR<iFCODataSourceIter> pIter(iTWFactory::GetInstance()->CreateDataSourceIter());
+        pIter->SetErrorBucket(&errors);
+        pIter->SetWorkerPool(i ? &pool : 0);
+        pIter->SetLeafProps(typeOnly);
+        pIter->SeekToFCO(cFCOName(root), false);
+        iFCO* pFCO = pIter->CreateFCO();
+        pFCO->Release();
+
+        int nFiles = 0, nNoStat = 0;
+        util_CountLeaves(pIter.get(), nFiles, nNoStat);
+        TEST(nFiles == 17);
+        TEST(errors.GetNumErrors() == 0);
+
+#if SUPPORTS_DIR_FDS && HAVE_STRUCT_DIRENT_D_TYPE
+        // every file system we test on records the types in the directory
+        TEST(nNoStat == nFiles);
+#endif
+    }
+}
+
+void TestFSDataSourceIterReadAhead()
+{
+    cReadAheadRestorer restorer;
+    std::string        root = util_MakeTree();
+
+    // a FIFO would block anyone who opened it, so it mustn't be read ahead
+    std::string fifo = root + "/d2/fifo";
+    unlink(fifo.c_str());
+    TEST(0 == mkfifo(fifo.c_str(), 0600));
+    restorer.Remove(fifo);
+
+    cFCOPropVector hashes;
+    hashes.AddItem(cFSPropSet::PROP_FILETYPE);
+    hashes.AddItem(cFSPropSet::PROP_SIZE);
+    hashes.AddItem(cFSPropSet::PROP_MD5);
+
+    // walks the tree with no read-ahead, then with a budget smaller than a
+    // directory's worth of files, then with plenty
+    std::vector<TSTRING> expected;
+    const int            budgets[] = {0, 2, 8};
+    for (int i = 0; i < 3; i++)
+    {
+        cFSDataSourceIter::SetReadAhead(budgets[i], budgets[i] ? 64 : 0);
+
+        cErrorQueue errors;
+        TW_UNIQUE_PTR<iFCODataSourceIter> pIter(iTWFactory::GetInstance()->CreateDataSourceIter());
+        pIter->SetErrorBucket(&errors);
+        pIter->SetLeafProps(hashes);
+        pIter->SeekToFCO(cFCOName(root), false);
+        TEST(pIter->CanDescend());
+
+        std::vector<TSTRING> names;
+        util_ListTree(pIter.get(), names);
+        TEST(errors.GetNumErrors() == 0);
+
+        if (i == 0)
+        {
+            TEST(names.size() == 23);
+            expected = names;
+        }
+        else
+            TEST(names == expected);
+    }
+
+#if HAVE_POSIX_FADVISE
+    // reaching the first file of a directory must leave the second one in the
+    // page cache: read in, if it had been dropped from it, and not dropped, if
+    // it was there already. The last time round it is read in on a hashing thread.
+    std::string dir = TwTestPath("readahead");
+    mkdir(dir.c_str(), 0777);
+    restorer.Remove(dir);
+    std::string first = dir + "/a", second = dir + "/b";
+    util_MakeFile(first, 1);
+    restorer.Remove(first);
+    util_MakeFile(second, 1024 * 1024);
+    restorer.Remove(second);
+
+    for (int i = 0; i < 4; i++)
+    {
+        cFSDataSourceIter::SetReadAhead(i ? 8 : 0, 32 * 1024 * 1024);
+        cArchiveSigGen::SetHashThreads(i == 3 ? 2 : 1);
+
+        util_DropCache(first);
+        util_DropCache(second);
+        if (util_IsCached(second))
+            skip("this file system doesn't let files be dropped from the page cache");
+        if (i == 2)
+        {
+            std::ifstream in(second.c_str(), std::ios::binary);
+            std::string   contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            TEST(contents.size() == 1024 * 1024);
+            TEST(util_IsCached(second));
+        }
+
+        TW_UNIQUE_PTR<iFCODataSourceIter> pIter(iTWFactory::GetInstance()->CreateDataSourceIter());
+        pIter->SetLeafProps(hashes);
+        pIter->SeekToFCO(cFCOName(dir), false);
+        pIter->Descend();
+        pIter->SeekBegin();
+        TEST(!pIter->Done());
+        TEST(TSTRING(pIter->GetShortName()) == _T("a"));
+        TEST(i == 2 ? util_IsCached(second) : util_WaitCached(second) == (i != 0));
+    }
+#endif
+}
+
 void RegisterSuite_FSDataSourceIter()
 {
     RegisterTest("FSDataSourceIter", "Basic", TestFSDataSourceIter);
+    RegisterTest("FSDataSourceIter", "Prefetch", TestFSDataSourceIterPrefetch);
+    RegisterTest("FSDataSourceIter", "PrefetchErrors", TestFSDataSourceIterPrefetchErrors);
+    RegisterTest("FSDataSourceIter", "DirFds", TestFSDataSourceIterDirFds);
+    RegisterTest("FSDataSourceIter", "LeafTypes", TestFSDataSourceIterLeafTypes);
+    RegisterTest("FSDataSourceIter", "ReadAhead", TestFSDataSourceIterReadAhead);
 }
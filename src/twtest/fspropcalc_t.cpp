@@ -32,19 +32,30 @@
 // fspropcalc_t.cpp -- the fs property calculator test driver
 #include "fs/stdfs.h"
 #include "fs/fspropcalc.h"
+#include "fs/fshashcache.h"
 #include "core/debug.h"
 #include "core/archive.h"
 #include "core/fsservices.h"
 #include "fco/fcopropset.h"
 #include "fs/fspropset.h"
 #include "fs/fsdatasourceiter.h"
+#include "fs/fsobject.h"
+#include "fco/fcoundefprop.h"
+#include "fco/fcoquickcheck.h"
+#include "fco/fcospecimpl.h"
+#include "fco/fcospechelper.h"
+#include "core/workerpool.h"
+#include "core/errorbucketimpl.h"
 #include "twtest/test.h"
 #include "fco/fco.h"
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <time.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // PrintProps -- prints out all the valid property names and values as pairs...
@@ -157,8 +168,606 @@ void TestGetSymLinkStr()
     TEST(arch.Length() == (int64)file.size());
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// TestDeferredHashes -- hashes computed on the worker pool must match the ones
+//      computed inline, and their errors must not show up until collected
+///////////////////////////////////////////////////////////////////////////////
+static cFSObject* CreateTestObject(cFSDataSourceIter& ds, const TSTRING& path)
+{
+    ds.SeekToFCO(cFCOName(path), false);
+    iFCO* pFCO = ds.CreateFCO();
+    TEST(pFCO);
+    return static_cast<cFSObject*>(pFCO);
+}
+
+void TestDeferredHashes()
+{
+    cFSDataSourceIter ds;
+    TSTRING           path = TwTestPath("deferred.bin");
+
+    std::ofstream fstr(path.c_str());
+    TEST(!fstr.bad());
+    fstr.close();
+
+    cFileArchive arch;
+    arch.OpenReadWrite(path.c_str(), true);
+    arch.WriteBlob("\x1\x2\x3\x4\x5\x6\x7\x8\x9\x0", 10);
+    arch.Close();
+
+    cFSObject* pInline   = CreateTestObject(ds, path);
+    cFSObject* pDeferred = CreateTestObject(ds, path);
+
+    cFCOPropVector v(pInline->GetPropSet()->GetValidVector().GetSize());
+    v.AddItem(cFSPropSet::PROP_CRC32);
+    v.AddItem(cFSPropSet::PROP_MD5);
+
+    cErrorQueue errors;
+    cWorkerPool pool(2);
+
+    cFSPropCalc inlineCalc;
+    inlineCalc.SetPropVector(v);
+    inlineCalc.SetErrorBucket(&errors);
+    pInline->AcceptVisitor(&inlineCalc);
+
+    cFSPropCalc deferredCalc;
+    deferredCalc.SetPropVector(v);
+    deferredCalc.SetErrorBucket(&errors);
+    deferredCalc.SetWorkerPool(&pool);
+    deferredCalc.SetCalcFlags(iFCOPropCalc::DEFER_HASHES);
+    pDeferred->AcceptVisitor(&deferredCalc);
+    deferredCalc.WaitForPending();
+
+    TEST(errors.GetNumErrors() == 0);
+    TEST(pInline->GetFSPropSet().GetMD5()->AsStringHex() == _T("7f63cb6d067972c3f34f094bb7e776a8"));
+    TEST(pDeferred->GetFSPropSet().GetMD5()->AsStringHex() == pInline->GetFSPropSet().GetMD5()->AsStringHex());
+    TEST(pDeferred->GetFSPropSet().GetCRC32()->AsStringHex() == pInline->GetFSPropSet().GetCRC32()->AsStringHex());
+
+    pInline->Release();
+    pDeferred->Release();
+
+    // a file that vanishes before it is hashed reports its error on collection
+    cFSObject* pGone = CreateTestObject(ds, path);
+    unlink(path.c_str());
+
+    pGone->AcceptVisitor(&deferredCalc);
+    TEST(errors.GetNumErrors() == 0);
+    deferredCalc.WaitForPending();
+    TEST(errors.GetNumErrors() == 1);
+    TEST(pGone->GetPropSet()->GetPropAt(cFSPropSet::PROP_MD5)->GetType() == cFCOUndefinedProp::GetInstance()->GetType());
+
+    pGone->Release();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestQuickCheckProps -- the quick check props must be cheap to calculate, i.e.
+//      not involve reading the file, and not overlap the content props
+///////////////////////////////////////////////////////////////////////////////
+void TestQuickCheckProps()
+{
+    cFSDataSourceIter ds;
+    TSTRING           path = TwTestPath("quickcheck.bin");
+
+    std::ofstream fstr(path.c_str());
+    TEST(!fstr.bad());
+    fstr << "quick check";
+    fstr.close();
+
+    cFSPropCalc           calc;
+    const cFCOPropVector& content = calc.GetContentProps();
+    const cFCOPropVector& quick   = calc.GetQuickCheckProps();
+    const cFCOPropVector  none(content.GetSize());
+
+    TEST(content.ContainsItem(cFSPropSet::PROP_MD5));
+    TEST(!content.ContainsItem(cFSPropSet::PROP_SIZE));
+    TEST(quick.ContainsItem(cFSPropSet::PROP_SIZE));
+    TEST(quick.ContainsItem(cFSPropSet::PROP_MTIME));
+    TEST((content & quick) == none);
+
+    cFSObject* pObj = CreateTestObject(ds, path);
+    calc.SetPropVector(quick);
+    pObj->AcceptVisitor(&calc);
+
+    const cFCOPropVector& valid = pObj->GetPropSet()->GetValidVector();
+    TEST((valid & quick) == quick);
+    TEST((valid & content) == none);
+    TEST(pObj->GetFSPropSet().GetSize() == 11);
+
+    pObj->Release();
+    unlink(path.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// the quick check tests use a spec asking for the quick check props and MD5, and
+// a database object whose MD5 is some other file's, so a hash that is reused can
+// be told apart from one that is calculated
+///////////////////////////////////////////////////////////////////////////////
+static void WriteTestFile(const TSTRING& path, const char* contents)
+{
+    std::ofstream fstr(path.c_str());
+    TEST(!fstr.bad());
+    fstr << contents;
+    fstr.close();
+}
+
+static iFCOSpec* CreateQuickCheckSpec(bool bNsec = false)
+{
+    cFCOPropVector v(cFSPropSet::PROP_NUMITEMS);
+    v.AddItem(cFSPropSet::PROP_SIZE);
+    v.AddItem(cFSPropSet::PROP_MTIME);
+    v.AddItem(cFSPropSet::PROP_CTIME);
+    v.AddItem(cFSPropSet::PROP_INODE);
+    v.AddItem(cFSPropSet::PROP_UID);
+    v.AddItem(cFSPropSet::PROP_MD5);
+    if (bNsec)
+    {
+        v.AddItem(cFSPropSet::PROP_MTIME_NSEC);
+        v.AddItem(cFSPropSet::PROP_CTIME_NSEC);
+    }
+
+    cFCOSpecImpl* pSpec = new cFCOSpecImpl(_T("quick"), NULL, new cFCOSpecStopPointSet);
+    pSpec->SetPropVector(iFCOSpecMask::GetDefaultMask(), v);
+    return pSpec;
+}
+
+static cFSObject* CreateDbObject(cFSDataSourceIter& ds, const TSTRING& path, const iFCOSpec* pSpec, const iFCO* pOther)
+{
+    cFSPropCalc calc;
+    cFSObject*  pObj = CreateTestObject(ds, path);
+    calc.SetPropVector(pSpec->GetPropVector(iFCOSpecMask::GetDefaultMask()));
+    pObj->AcceptVisitor(&calc);
+
+    cFCOPropVector md5(cFSPropSet::PROP_NUMITEMS);
+    md5.AddItem(cFSPropSet::PROP_MD5);
+    pObj->GetPropSet()->CopyProps(pOther->GetPropSet(), md5);
+    return pObj;
+}
+
+static bool SameMD5(const iFCO* pLhs, const iFCO* pRhs)
+{
+    const iFCOProp* pL = pLhs->GetPropSet()->GetPropAt(cFSPropSet::PROP_MD5);
+    return pLhs->GetPropSet()->GetValidVector().ContainsItem(cFSPropSet::PROP_MD5) &&
+           pRhs->GetPropSet()->GetValidVector().ContainsItem(cFSPropSet::PROP_MD5) &&
+           pL->Compare(pRhs->GetPropSet()->GetPropAt(cFSPropSet::PROP_MD5), iFCOProp::OP_EQ) == iFCOProp::CMP_TRUE;
+}
+
+// checks pOld against the file as it is now, then calculates what the spec asks for
+// as an integrity check would, with the one stat() the iterator did; returns
+// whether the hash was reused
+static bool CheckAgainst(cFSDataSourceIter& ds,
+                         const TSTRING&     path,
+                         const cQuickCheck& quick,
+                         const iFCO*        pOld,
+                         const iFCOSpec*    pSpec,
+                         cFSPropCalc&       calc)
+{
+    cFSObject* pNew    = CreateTestObject(ds, path);
+    bool       bReused = quick.ReuseContentProps(pOld, pNew, pSpec, &calc);
+    TEST(bReused == SameMD5(pOld, pNew));
+
+    calc.SetPropVector(pSpec->GetPropVector(iFCOSpecMask::GetDefaultMask()));
+    pNew->AcceptVisitor(&calc);
+    TEST(bReused == SameMD5(pOld, pNew));
+    TEST(pNew->GetStatCount() == 1);
+
+    pNew->Release();
+    return bReused;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestQuickCheckReuse -- the database's hashes are reused only when all of the
+//      quick check props and the spec's other metadata match
+///////////////////////////////////////////////////////////////////////////////
+void TestQuickCheckReuse()
+{
+    cFSDataSourceIter ds;
+    TSTRING           path      = TwTestPath("quickreuse.bin");
+    TSTRING           otherPath = TwTestPath("quickother.bin");
+    WriteTestFile(path, "quick check");
+    WriteTestFile(otherPath, "something else");
+
+    cFSPropCalc calc;
+    iFCOSpec*   pSpec  = CreateQuickCheckSpec(true);
+    cFSObject*  pOther = CreateTestObject(ds, otherPath);
+    calc.SetPropVector(pSpec->GetPropVector(iFCOSpecMask::GetDefaultMask()));
+    pOther->AcceptVisitor(&calc);
+
+    // the nanoseconds are stored when the spec asks for them
+    cFSObject* pOld = CreateDbObject(ds, path, pSpec, pOther);
+    TEST(pOld->GetPropSet()->GetValidVector().ContainsItem(cFSPropSet::PROP_MTIME_NSEC));
+    TEST(pOld->GetPropSet()->GetValidVector().ContainsItem(cFSPropSet::PROP_CTIME_NSEC));
+
+    cQuickCheck quick;
+    TEST(CheckAgainst(ds, path, quick, pOld, pSpec, calc));
+
+    // a difference in any of the quick check props or the spec's other metadata
+    // means hashing the file again
+    const int changes[] = { cFSPropSet::PROP_SIZE,
+                            cFSPropSet::PROP_MTIME,
+                            cFSPropSet::PROP_MTIME_NSEC,
+                            cFSPropSet::PROP_CTIME,
+                            cFSPropSet::PROP_CTIME_NSEC,
+                            cFSPropSet::PROP_INODE,
+                            cFSPropSet::PROP_UID };
+    for (size_t i = 0; i < sizeof(changes) / sizeof(changes[0]); i++)
+    {
+        cFSObject*  pChanged = CreateDbObject(ds, path, pSpec, pOther);
+        cFSPropSet& props    = pChanged->GetFSPropSet();
+        switch (changes[i])
+        {
+        case cFSPropSet::PROP_SIZE:
+            props.SetSize(props.GetSize() + 1);
+            break;
+        case cFSPropSet::PROP_MTIME:
+            props.SetModifyTime(props.GetModifyTime() - 1);
+            break;
+        case cFSPropSet::PROP_MTIME_NSEC:
+            props.SetModifyTimeNsec((props.GetModifyTimeNsec() + 1) % 1000000000);
+            break;
+        case cFSPropSet::PROP_CTIME:
+            props.SetCreateTime(props.GetCreateTime() - 1);
+            break;
+        case cFSPropSet::PROP_CTIME_NSEC:
+            props.SetCreateTimeNsec((props.GetCreateTimeNsec() + 1) % 1000000000);
+            break;
+        case cFSPropSet::PROP_INODE:
+            props.SetInode(props.GetInode() + 1);
+            break;
+        case cFSPropSet::PROP_UID:
+            props.SetUID(props.GetUID() + 1);
+            break;
+        }
+
+        TEST(!CheckAgainst(ds, path, quick, pChanged, pSpec, calc));
+        pChanged->Release();
+    }
+
+    // without them in the spec, the nanoseconds are neither stored nor compared
+    iFCOSpec*  pNoNsecSpec = CreateQuickCheckSpec();
+    cFSObject* pNoNsec     = CreateDbObject(ds, path, pNoNsecSpec, pOther);
+    TEST(!pNoNsec->GetPropSet()->GetValidVector().ContainsItem(cFSPropSet::PROP_MTIME_NSEC));
+    TEST(!pNoNsec->GetPropSet()->GetValidVector().ContainsItem(cFSPropSet::PROP_CTIME_NSEC));
+    TEST(CheckAgainst(ds, path, quick, pNoNsec, pNoNsecSpec, calc));
+    TEST(CheckAgainst(ds, path, quick, pOld, pNoNsecSpec, calc));
+    pNoNsec->Release();
+    pNoNsecSpec->Release();
+
+    // and so does changing the file
+    WriteTestFile(path, "quick change");
+    TEST(!CheckAgainst(ds, path, quick, pOld, pSpec, calc));
+
+    pOld->Release();
+    pOther->Release();
+    pSpec->Release();
+    unlink(path.c_str());
+    unlink(otherPath.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestQuickCheckSample -- about one in every rate unchanged objects is hashed
+//      anyway; the same ones for the same seed, and others for another seed
+///////////////////////////////////////////////////////////////////////////////
+void TestQuickCheckSample()
+{
+    const int NUM_FILES = 200;
+    const int RATE      = 4;
+
+    cFSDataSourceIter ds;
+    TSTRING           dir       = TwTestPath("quicksample");
+    TSTRING           otherPath = TwTestPath("quickother.bin");
+    mkdir(dir.c_str(), 0777);
+    WriteTestFile(otherPath, "something else");
+
+    cFSPropCalc calc;
+    iFCOSpec*   pSpec  = CreateQuickCheckSpec();
+    cFSObject*  pOther = CreateTestObject(ds, otherPath);
+    calc.SetPropVector(pSpec->GetPropVector(iFCOSpecMask::GetDefaultMask()));
+    pOther->AcceptVisitor(&calc);
+
+    std::vector<TSTRING>    paths;
+    std::vector<cFSObject*> olds;
+    for (int i = 0; i < NUM_FILES; i++)
+    {
+        std::stringstream ss;
+        ss << dir << "/f" << i;
+        paths.push_back(ss.str());
+        WriteTestFile(paths.back(), "sample");
+        olds.push_back(CreateDbObject(ds, paths.back(), pSpec, pOther));
+    }
+
+    cQuickCheck       quick;
+    std::vector<bool> sampled[3];
+    const uint32      seeds[3] = { 1, 1, 2 };
+    for (int s = 0; s < 3; s++)
+    {
+        quick.SetSampleRate(RATE, seeds[s]);
+        int numSampled = 0;
+        for (int i = 0; i < NUM_FILES; i++)
+        {
+            sampled[s].push_back(!CheckAgainst(ds, paths[i], quick, olds[i], pSpec, calc));
+            numSampled += sampled[s].back() ? 1 : 0;
+        }
+        TEST(numSampled > NUM_FILES / RATE / 2 && numSampled < NUM_FILES / RATE * 2);
+    }
+    TEST(sampled[0] == sampled[1]);
+    TEST(sampled[0] != sampled[2]);
+
+    // a rate of 1 hashes everything, and 0 nothing
+    quick.SetSampleRate(1, 1);
+    TEST(!CheckAgainst(ds, paths[0], quick, olds[0], pSpec, calc));
+    quick.SetSampleRate(0, 1);
+    for (int i = 0; i < NUM_FILES; i++)
+    {
+        TEST(CheckAgainst(ds, paths[i], quick, olds[i], pSpec, calc));
+    }
+
+    for (int i = 0; i < NUM_FILES; i++)
+    {
+        olds[i]->Release();
+        unlink(paths[i].c_str());
+    }
+    rmdir(dir.c_str());
+    pOther->Release();
+    pSpec->Release();
+    unlink(otherPath.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestStatReuse -- the stat() the data source iterator does when it creates an
+//      object should be the only one, but only the first calculation may use it
+///////////////////////////////////////////////////////////////////////////////
+void TestStatReuse()
+{
+    cFSDataSourceIter ds;
+    TSTRING           path = TwTestPath("statreuse.bin");
+
+    std::ofstream fstr(path.c_str());
+    TEST(!fstr.bad());
+    fstr << "stat";
+    fstr.close();
+
+    cFSObject* pObj = CreateTestObject(ds, path);
+    TEST(pObj->GetStatCount() == 1);
+
+    cFCOPropVector v(pObj->GetPropSet()->GetValidVector().GetSize());
+    v.AddItem(cFSPropSet::PROP_SIZE);
+    v.AddItem(cFSPropSet::PROP_MTIME);
+    v.AddItem(cFSPropSet::PROP_MD5);
+
+    cFSPropCalc calc;
+    calc.SetPropVector(v);
+    calc.SetCollisionAction(iFCOPropCalc::PROP_OVERWRITE);
+    pObj->AcceptVisitor(&calc);
+    TEST(pObj->GetStatCount() == 1);
+    TEST(pObj->GetFSPropSet().GetSize() == 4);
+
+    // the file has changed since, so a second calculation has to look again
+    fstr.open(path.c_str(), std::ios::app);
+    fstr << "reuse";
+    fstr.close();
+
+    pObj->AcceptVisitor(&calc);
+    TEST(pObj->GetStatCount() == 2);
+    TEST(pObj->GetFSPropSet().GetSize() == 9);
+
+    pObj->Release();
+    unlink(path.c_str());
+}
+
+static void util_LoadCache(cFSHashCache& cache, const TSTRING& path)
+{
+    cFileArchive arch;
+    arch.OpenRead(path.c_str());
+    cache.Load(arch, 0, arch.Length());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestHashCache -- signatures calculated with a hash cache in place are found
+//      in it again, by the prop calc or after the cache is written out and
+//      loaded back, but only under exactly the same key
+///////////////////////////////////////////////////////////////////////////////
+void TestHashCache()
+{
+    cFSDataSourceIter ds;
+    TSTRING           path      = TwTestPath("hashcache.bin");
+    TSTRING           cachePath = TwTestPath("hashcache.dat");
+    TSTRING           stalePath = TwTestPath("hashcache.old");
+
+    std::ofstream fstr(path.c_str());
+    TEST(!fstr.bad());
+    fstr << "hash cache";
+    fstr.close();
+
+    // the file has only just been written, so the cache has to think it is later
+    // than it is, or the file is too new to be cached
+    cFSHashCache cache;
+    cache.SetTime(time(0) + 60);
+
+    cFCOPropVector v(cFSPropSet::PROP_NUMITEMS);
+    v.AddItem(cFSPropSet::PROP_MD5);
+    v.AddItem(cFSPropSet::PROP_SHA);
+
+    cFSPropCalc calc;
+    calc.SetPropVector(v);
+    calc.SetHashCache(&cache);
+    cFSObject* pObj = CreateTestObject(ds, path);
+    pObj->AcceptVisitor(&calc);
+    TEST(cache.GetNumEntries() == 1);
+
+    cFSStatArgs ss;
+    iFSServices::GetInstance()->Stat(path, ss, cFSHashCache::GetKeyFields());
+    cFSHashCache::Key key;
+    cFSHashCache::MakeKey(ss, key);
+
+    cFCOPropVector md5(cFSPropSet::PROP_NUMITEMS);
+    md5.AddItem(cFSPropSet::PROP_MD5);
+
+    cFSPropSet found;
+    TEST(cache.Lookup(key, md5, found));
+    TEST(found.GetMD5()->AsStringHex() == pObj->GetFSPropSet().GetMD5()->AsStringHex());
+
+    // signatures that weren't calculated aren't there to be found
+    cFCOPropVector crc(cFSPropSet::PROP_NUMITEMS);
+    crc.AddItem(cFSPropSet::PROP_CRC32);
+    TEST(!cache.Lookup(key, crc, found));
+
+    // and nothing is found once the file looks different
+    cFSHashCache::Key changed = key;
+    changed.ctime++;
+    TEST(!cache.Lookup(changed, md5, found));
+
+    // the same goes after a round trip through a file
+    {
+        cFileArchive arch;
+        arch.OpenReadWrite(cachePath.c_str());
+        cache.Write(arch);
+        arch.Close();
+    }
+
+    cFSHashCache loaded;
+    util_LoadCache(loaded, cachePath);
+    TEST(loaded.GetNumEntries() == 1);
+
+    cFSHashCache kept;
+    util_LoadCache(kept, cachePath);
+
+    cFSPropSet reloaded;
+    TEST(loaded.Lookup(key, v, reloaded));
+    TEST(reloaded.GetSHA()->AsStringHex() == pObj->GetFSPropSet().GetSHA()->AsStringHex());
+    TEST(!loaded.Lookup(changed, md5, reloaded));
+
+    // storing more signatures for the same key keeps the ones already there
+    loaded.SetTime(time(0) + 60);
+    reloaded.SetDefinedCRC32(true);
+    loaded.Store(key, crc, reloaded);
+    TEST(loaded.Lookup(key, crc, found));
+    TEST(loaded.Lookup(key, v, found));
+
+    // entries that go unused for long enough are dropped when it is written out
+    {
+        cFSHashCache stale;
+        util_LoadCache(stale, cachePath);
+        stale.SetTime(time(0) + (cFSHashCache::EXPIRY_DAYS + 1) * 24 * 60 * 60);
+
+        cFileArchive arch;
+        arch.OpenReadWrite(stalePath.c_str());
+        stale.Write(arch);
+        arch.Close();
+
+        util_LoadCache(loaded, stalePath);
+        TEST(loaded.GetNumEntries() == 0);
+    }
+
+    // once it is loaded, the cache doesn't depend on the file any more
+    {
+        cFileArchive arch;
+        arch.OpenReadWrite(cachePath.c_str());
+        arch.Close();
+    }
+    TEST(kept.Lookup(key, v, found));
+
+    // a file that isn't a cache is turned away
+    bool bThrown = false;
+    try
+    {
+        util_LoadCache(loaded, path);
+    }
+    catch (eFSHashCache&)
+    {
+        bThrown = true;
+    }
+    TEST(bThrown);
+
+    pObj->Release();
+    unlink(path.c_str());
+    unlink(cachePath.c_str());
+    unlink(stalePath.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestHardLinks -- the second link to a file gets the signatures calculated for
+//      the first, without the file being opened again, but only while sharing
+//      them is turned on
+///////////////////////////////////////////////////////////////////////////////
+void TestHardLinks()
+{
+    cFSDataSourceIter ds;
+    TSTRING           path     = TwTestPath("hardlink.bin");
+    TSTRING           linkPath = TwTestPath("hardlink.lnk");
+
+    std::ofstream fstr(path.c_str());
+    TEST(!fstr.bad());
+    fstr << "hard link";
+    fstr.close();
+    unlink(linkPath.c_str());
+    TEST(link(path.c_str(), linkPath.c_str()) == 0);
+
+    cFCOPropVector v(cFSPropSet::PROP_NUMITEMS);
+    v.AddItem(cFSPropSet::PROP_MD5);
+    v.AddItem(cFSPropSet::PROP_CRC32);
+
+    cErrorQueue errors;
+    for (int deferred = 0; deferred < 2; deferred++)
+    {
+        cWorkerPool pool(2);
+        cFSPropCalc calc;
+        calc.SetPropVector(v);
+        calc.SetErrorBucket(&errors);
+        if (deferred)
+        {
+            calc.SetWorkerPool(&pool);
+            calc.SetCalcFlags(iFCOPropCalc::DEFER_HASHES);
+        }
+
+        // the objects remember what the file looked like when they were created,
+        // so the second one can only be hashed if the first one's signatures are used
+        cFSObject* pFirst  = CreateTestObject(ds, path);
+        cFSObject* pSecond = CreateTestObject(ds, linkPath);
+
+        pFirst->AcceptVisitor(&calc);
+        TEST(rename(linkPath.c_str(), (linkPath + _T(".moved")).c_str()) == 0);
+        pSecond->AcceptVisitor(&calc);
+        calc.WaitForPending();
+        TEST(rename((linkPath + _T(".moved")).c_str(), linkPath.c_str()) == 0);
+
+        TEST(errors.GetNumErrors() == 0);
+        TEST(pSecond->GetFSPropSet().GetMD5()->AsStringHex() == pFirst->GetFSPropSet().GetMD5()->AsStringHex());
+        TEST(pSecond->GetFSPropSet().GetCRC32()->AsStringHex() == pFirst->GetFSPropSet().GetCRC32()->AsStringHex());
+
+        pFirst->Release();
+        pSecond->Release();
+    }
+
+    // without sharing, the second link is opened, and isn't there any more
+    {
+        cFSPropCalc calc;
+        calc.SetPropVector(v);
+        calc.SetErrorBucket(&errors);
+        calc.SetCalcFlags(iFCOPropCalc::HASH_EVERY_LINK);
+
+        cFSObject* pFirst  = CreateTestObject(ds, path);
+        cFSObject* pSecond = CreateTestObject(ds, linkPath);
+
+        pFirst->AcceptVisitor(&calc);
+        unlink(linkPath.c_str());
+        pSecond->AcceptVisitor(&calc);
+        TEST(errors.GetNumErrors() == 1);
+
+        pFirst->Release();
+        pSecond->Release();
+    }
+
+    unlink(path.c_str());
+}
+
 void RegisterSuite_FSPropCalc()
 {
     RegisterTest("FSPropCalc", "Basic", TestFSPropCalc);
     RegisterTest("FSPropCalc", "GetSymLinkStr", TestGetSymLinkStr);
+    RegisterTest("FSPropCalc", "Deferred", TestDeferredHashes);
+    RegisterTest("FSPropCalc", "QuickCheckProps", TestQuickCheckProps);
+    RegisterTest("FSPropCalc", "QuickCheckReuse", TestQuickCheckReuse);
+    RegisterTest("FSPropCalc", "QuickCheckSample", TestQuickCheckSample);
+    RegisterTest("FSPropCalc", "StatReuse", TestStatReuse);
+    RegisterTest("FSPropCalc", "HashCache", TestHashCache);
+    RegisterTest("FSPropCalc", "HardLinks", TestHardLinks);
 }
@@ -0,0 +1,236 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// sha_t.cpp
+//
+// test the built in SHA-1 and SHA-256 and their kernels
+
+#include "core/stdcore.h"
+#include "core/sha.h"
+#include "core/sha2.h"
+#include "twtest/test.h"
+#include <algorithm>
+#include <vector>
+#include <sys/time.h>
+
+#ifndef HAVE_OPENSSL_SHA_H
+namespace
+{
+// the built in SHA-1 of len bytes of pData, fed to shsUpdate in pieces of at most chunk bytes
+std::vector<uint32> util_SHS(const uint8* pData, int len, int chunk)
+{
+    SHS_INFO shs;
+    shsInit(&shs);
+    for (int done = 0; done < len; done += chunk)
+        shsUpdate(&shs, const_cast<uint8*>(pData) + done, std::min(chunk, len - done));
+    shsFinal(&shs);
+    return std::vector<uint32>(shs.digest, shs.digest + 5);
+}
+
+// the built in SHA-256 of len bytes of pData, in hex, fed in pieces of at most chunk bytes
+std::string util_SHA256(const uint8* pData, int len, int chunk)
+{
+    SHA256_INFO sha;
+    sha256Init(&sha);
+    for (int done = 0; done < len; done += chunk)
+        sha256Update(&sha, pData + done, std::min(chunk, len - done));
+
+    uint8 out[SHA256_DIGESTSIZE];
+    sha256Final(&sha, out);
+
+    static const char hexDigits[] = "0123456789abcdef";
+    std::string       hex;
+    for (int i = 0; i < SHA256_DIGESTSIZE; i++)
+    {
+        hex += hexDigits[out[i] >> 4];
+        hex += hexDigits[out[i] & 0xf];
+    }
+    return hex;
+}
+} // namespace
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// TestSHAKernels -- the built in SHA-1, used when there's no OpenSSL, gets the
+//      known answers with every kernel this cpu can run, however the data is
+//      split up
+///////////////////////////////////////////////////////////////////////////////
+void TestSHAKernels()
+{
+#ifndef HAVE_OPENSSL_SHA_H
+    const uint32 abc[5] = { 0xa9993e36, 0x4706816a, 0xba3e2571, 0x7850c26c, 0x9cd0d89d };
+    const uint32 empty[5] = { 0xda39a3ee, 0x5e6b4b0d, 0x3255bfef, 0x95601890, 0xafd80709 };
+
+    std::vector<uint8> data(100000);
+    uint32             x = 12345;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        x       = x * 1103515245 + 12345;
+        data[i] = (uint8)(x >> 16);
+    }
+
+    const int lengths[] = { 0, 55, 56, 64, 119, 120, 1000, 100000 };
+    const int chunks[]  = { 1, 13, 64, 4096, 100000 };
+
+    SHS_KERNEL oldKernel = shsGetKernel();
+    TEST(shsSetKernel(SHS_KERNEL_GENERIC));
+
+    std::vector<std::vector<uint32> > expected;
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+        expected.push_back(util_SHS(&data[0], lengths[l], 100000));
+
+    for (int k = SHS_KERNEL_GENERIC; k < SHS_KERNEL_NUMITEMS; k++)
+    {
+        if (!shsSetKernel((SHS_KERNEL)k))
+            continue;
+
+        TEST(util_SHS((const uint8*)"abc", 3, 3) == std::vector<uint32>(abc, abc + 5));
+        TEST(util_SHS((const uint8*)"", 0, 1) == std::vector<uint32>(empty, empty + 5));
+
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+        {
+            for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+            {
+                TEST(util_SHS(&data[0], lengths[l], chunks[c]) == expected[l]);
+            }
+        }
+    }
+
+    TEST(!shsSetKernel(SHS_KERNEL_NUMITEMS));
+    shsSetKernel(oldKernel);
+#else
+    skip("The built in SHA-1 isn't compiled in; OpenSSL's is used");
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestSHABenchmark -- not a pass/fail test; reports how fast each built in
+//      SHA-1 kernel this cpu can run goes over a buffer that stays in cache
+///////////////////////////////////////////////////////////////////////////////
+void TestSHABenchmark()
+{
+#ifndef HAVE_OPENSSL_SHA_H
+    const int          bufSize = 256 * 1024;
+    const int          passes  = 100;
+    std::vector<uint8> data(bufSize, 0x5a);
+
+    SHS_KERNEL          oldKernel = shsGetKernel();
+    std::vector<uint32> expected;
+    for (int k = SHS_KERNEL_GENERIC; k < SHS_KERNEL_NUMITEMS; k++)
+    {
+        if (!shsSetKernel((SHS_KERNEL)k))
+        {
+            TCERR << _T("sha1, ") << shsKernelName((SHS_KERNEL)k) << _T(": not supported on this cpu") << std::endl;
+            continue;
+        }
+
+        SHS_INFO shs;
+        shsInit(&shs);
+
+        struct timeval start, end;
+        gettimeofday(&start, 0);
+        for (int i = 0; i < passes; i++)
+            shsUpdate(&shs, &data[0], bufSize);
+        gettimeofday(&end, 0);
+        shsFinal(&shs);
+
+        std::vector<uint32> digest(shs.digest, shs.digest + 5);
+        if (k == SHS_KERNEL_GENERIC)
+            expected = digest;
+        TEST(digest == expected);
+
+        double usecs    = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_usec - start.tv_usec);
+        double mbPerSec = usecs > 0 ? ((double)passes * bufSize / (1024 * 1024)) / (usecs / 1e6) : 0;
+        TCERR << _T("sha1, ") << shsKernelName((SHS_KERNEL)k) << _T(": ") << (int)mbPerSec << _T(" MB/s") << std::endl;
+    }
+    shsSetKernel(oldKernel);
+#else
+    skip("The built in SHA-1 isn't compiled in; OpenSSL's is used");
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestSHA256Kernels -- the same for the built in SHA-256
+///////////////////////////////////////////////////////////////////////////////
+void TestSHA256Kernels()
+{
+#ifndef HAVE_OPENSSL_SHA_H
+    std::vector<uint8> data(100000);
+    uint32             x = 12345;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        x       = x * 1103515245 + 12345;
+        data[i] = (uint8)(x >> 16);
+    }
+
+    const int lengths[] = { 0, 55, 56, 64, 119, 120, 1000, 100000 };
+    const int chunks[]  = { 1, 13, 64, 4096, 100000 };
+
+    SHA256_KERNEL oldKernel = sha256GetKernel();
+    TEST(sha256SetKernel(SHA256_KERNEL_GENERIC));
+
+    std::vector<std::string> expected;
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+        expected.push_back(util_SHA256(&data[0], lengths[l], 100000));
+
+    for (int k = SHA256_KERNEL_GENERIC; k < SHA256_KERNEL_NUMITEMS; k++)
+    {
+        if (!sha256SetKernel((SHA256_KERNEL)k))
+            continue;
+
+        TEST(util_SHA256((const uint8*)"abc", 3, 3) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+        {
+            for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+            {
+                TEST(util_SHA256(&data[0], lengths[l], chunks[c]) == expected[l]);
+            }
+        }
+    }
+
+    TEST(!sha256SetKernel(SHA256_KERNEL_NUMITEMS));
+    sha256SetKernel(oldKernel);
+#else
+    skip("The built in SHA-256 isn't compiled in; OpenSSL's is used");
+#endif
+}
+
+void RegisterSuite_SHA()
+{
+    RegisterTest("SHA", "Kernels", TestSHAKernels);
+    RegisterTest("SHA", "SHA256Kernels", TestSHA256Kernels);
+
+    // only reports timings, so "twtest all" leaves it out
+    RegisterTest("Benchmark", "SHA", TestSHABenchmark);
+}
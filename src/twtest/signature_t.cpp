@@ -40,6 +40,12 @@
 #include "core/serializerimpl.h"
 #include "core/crc32.h"
 #include "core/archive.h"
+#include "core/workerpool.h"
+#include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdexcept>
 
 using namespace std;
 
@@ -212,6 +218,106 @@ void TestCRC32()
     }
 }
 
+namespace
+{
+// the crc of len bytes of pData, fed to crcUpdate in pieces of at most chunk bytes
+uint32 util_CRC(const uint8* pData, int len, int chunk)
+{
+    CRC_INFO crc;
+    crcInit(crc);
+    for (int done = 0; done < len; done += chunk)
+        crcUpdate(crc, pData + done, std::min(chunk, len - done));
+    crcFinit(crc);
+    return crc.crc;
+}
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// TestCRC32Kernels -- every crc kernel this cpu can run agrees with the byte
+//      at a time one, whatever the length and however the data is split up
+///////////////////////////////////////////////////////////////////////////////
+void TestCRC32Kernels()
+{
+    // the POSIX cksum of "123456789"
+    TEST(util_CRC((const uint8*)"123456789", 9, 9) == 930766865);
+
+    std::vector<uint8> data(100000);
+    uint32             x = 12345;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        x       = x * 1103515245 + 12345;
+        data[i] = (uint8)(x >> 16);
+    }
+
+    const int lengths[] = { 0, 1, 7, 8, 63, 64, 255, 256, 257, 1000, 4096, 65537, 100000 };
+    const int chunks[]  = { 1, 13, 256, 4096, 100000 };
+
+    CRC_KERNEL oldKernel = crcGetKernel();
+    TEST(crcSetKernel(CRC_KERNEL_BYTE));
+
+    std::vector<uint32> expected;
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+        expected.push_back(util_CRC(&data[0], lengths[l], lengths[l] ? lengths[l] : 1));
+
+    for (int k = CRC_KERNEL_SLICE8; k < CRC_KERNEL_NUMITEMS; k++)
+    {
+        if (!crcSetKernel((CRC_KERNEL)k))
+            continue;
+
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+        {
+            for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+            {
+                TEST(util_CRC(&data[0], lengths[l], chunks[c]) == expected[l]);
+            }
+        }
+    }
+
+    TEST(!crcSetKernel(CRC_KERNEL_NUMITEMS));
+    crcSetKernel(oldKernel);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestCRC32Benchmark -- not a pass/fail test; reports how fast each crc
+//      kernel this cpu can run goes over a buffer that stays in cache
+///////////////////////////////////////////////////////////////////////////////
+void TestCRC32Benchmark()
+{
+    const int          bufSize = 256 * 1024;
+    const int          passes  = 400;
+    std::vector<uint8> data(bufSize, 0x5a);
+
+    CRC_KERNEL oldKernel = crcGetKernel();
+    uint32     expected  = 0;
+    for (int k = CRC_KERNEL_BYTE; k < CRC_KERNEL_NUMITEMS; k++)
+    {
+        if (!crcSetKernel((CRC_KERNEL)k))
+        {
+            TCERR << _T("crc32, ") << crcKernelName((CRC_KERNEL)k) << _T(": not supported on this cpu") << std::endl;
+            continue;
+        }
+
+        CRC_INFO crc;
+        crcInit(crc);
+
+        struct timeval start, end;
+        gettimeofday(&start, 0);
+        for (int i = 0; i < passes; i++)
+            crcUpdate(crc, &data[0], bufSize);
+        gettimeofday(&end, 0);
+        crcFinit(crc);
+
+        if (k == CRC_KERNEL_BYTE)
+            expected = crc.crc;
+        TEST(crc.crc == expected);
+
+        double usecs    = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_usec - start.tv_usec);
+        double gbPerSec  = usecs > 0 ? ((double)passes * bufSize / (1024 * 1024 * 1024)) / (usecs / 1e6) : 0;
+        TCERR << _T("crc32, ") << crcKernelName((CRC_KERNEL)k) << _T(": ") << gbPerSec << _T(" GB/s") << std::endl;
+    }
+    crcSetKernel(oldKernel);
+}
+
 void TestMD5()
 {
     TSTRING      sigFileName = getTestFile();
@@ -374,6 +480,94 @@ void TestHAVAL()
     }
 }
 
+namespace
+{
+// the hex signature of len bytes of pData, fed to sig in pieces of at most chunk bytes
+TSTRING util_SigHex(iSignature& sig, const uint8* pData, int len, int chunk)
+{
+    sig.Init();
+    for (int done = 0; done < len; done += chunk)
+        sig.Update(pData + done, std::min(chunk, len - done));
+    sig.Finit();
+    return sig.AsStringHex();
+}
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// TestHAVALBlocks -- HAVAL gets the answers existing databases hold, and the
+//      same answer however the data is split across block boundaries
+///////////////////////////////////////////////////////////////////////////////
+void TestHAVALBlocks()
+{
+    cHAVALSignature haval;
+
+    // these aren't the published HAVAL-128/3 vectors; tripwire's HAVAL has
+    // always differed from them, and databases depend on it staying that way
+    TEST(util_SigHex(haval, (const uint8*)"", 0, 1) == _T("1bdc556b29ad02ec09af8c66477f2a87"));
+    TEST(util_SigHex(haval, (const uint8*)"a", 1, 1) == _T("24d2bc955a219e3e06462c91b555cfa1"));
+
+    std::vector<uint8> data(10000);
+    uint32             x = 12345;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        x       = x * 1103515245 + 12345;
+        data[i] = (uint8)(x >> 16);
+    }
+
+    const int lengths[] = { 117, 118, 127, 128, 129, 245, 246, 256, 10000 };
+    const int chunks[]  = { 1, 3, 127, 128, 129, 4096 };
+
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+    {
+        TSTRING expected = util_SigHex(haval, &data[0], lengths[l], lengths[l]);
+        for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+        {
+            TEST(util_SigHex(haval, &data[0], lengths[l], chunks[c]) == expected);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestHAVALBenchmark -- not a pass/fail test; reports how fast HAVAL goes over
+//      a buffer that stays in cache, next to MD5 and SHA-1 for scale
+///////////////////////////////////////////////////////////////////////////////
+void TestHAVALBenchmark()
+{
+    const int          bufSize = 256 * 1024;
+    const int          passes  = 100;
+    std::vector<uint8> data(bufSize, 0x5a);
+
+    cHAVALSignature haval;
+    cMD5Signature   md5;
+    cSHASignature   sha;
+
+    const struct
+    {
+        iSignature*   pSig;
+        const TCHAR*  name;
+    } runs[] = { { &haval, _T("haval") }, { &md5, _T("md5") }, { &sha, _T("sha1") } };
+
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++)
+    {
+        iSignature& sig = *runs[i].pSig;
+        sig.Init();
+
+        struct timeval start, end;
+        gettimeofday(&start, 0);
+        for (int pass = 0; pass < passes; pass++)
+            sig.Update(&data[0], bufSize);
+        gettimeofday(&end, 0);
+        sig.Finit();
+        TSTRING hex    = sig.AsStringHex();
+        TSTRING empty  = util_SigHex(sig, &data[0], 0, 1);
+        TEST(hex != empty);
+
+        double usecs    = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_usec - start.tv_usec);
+        double mbPerSec = usecs > 0 ? ((double)passes * bufSize / (1024 * 1024)) / (usecs / 1e6) : 0;
+        TCERR << runs[i].name << _T(": ") << (int)mbPerSec << _T(" MB/s") << std::endl;
+    }
+}
+
 void TestArchiveSigGen()
 {
     TSTRING      sigFileName = getTestFile();
@@ -412,6 +606,478 @@ void TestArchiveSigGen()
     fileArc.Close();
 }
 
+namespace
+{
+// writes a file of the given size full of bytes that don't repeat too soon
+std::string util_MakeBigFile(const std::string& name, int size)
+{
+    std::string path = TwTestPath(name);
+
+    cFileArchive arch;
+    arch.OpenReadWrite(path.c_str(), cFileArchive::FA_OPEN_TRUNCATE);
+
+    byte   block[0x1000];
+    uint32 x = 12345;
+    for (int written = 0; written < size; written += sizeof(block))
+    {
+        for (size_t i = 0; i < sizeof(block); i++)
+        {
+            x        = x * 1103515245 + 12345;
+            block[i] = (byte)(x >> 16);
+        }
+        arch.WriteBlob(block, std::min((int)sizeof(block), size - written));
+    }
+    arch.Close();
+
+    return path;
+}
+
+// hashes the file with the given read settings, returning the md5 and sha1
+// and adding the time it took, in microseconds, to usecs
+TSTRING util_HashFile(const std::string& path, int readSize, bool bReadAhead, double& usecs, bool bParallel = false)
+{
+    int  oldSize      = cArchiveSigGen::GetReadSize();
+    bool oldReadAhead = cArchiveSigGen::ReadAhead();
+    bool oldParallel  = cArchiveSigGen::ParallelSigs();
+    int  oldThreads   = cArchiveSigGen::GetHashThreads();
+    cArchiveSigGen::SetReadSize(readSize);
+    cArchiveSigGen::SetReadAhead(bReadAhead);
+    cArchiveSigGen::SetParallelSigs(bParallel);
+    cArchiveSigGen::SetHashThreads((bReadAhead || bParallel) ? 2 : 1);
+
+    cArchiveSigGen sigGen;
+    cMD5Signature  md5;
+    cSHASignature  sha;
+    sigGen.AddSig(&md5);
+    sigGen.AddSig(&sha);
+
+    cFileArchive arch;
+    arch.OpenRead(path.c_str(), cFileArchive::FA_SCANNING);
+
+    struct timeval start, end;
+    gettimeofday(&start, 0);
+    sigGen.CalculateSignatures(arch);
+    gettimeofday(&end, 0);
+    arch.Close();
+
+    usecs += (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_usec - start.tv_usec);
+
+    cArchiveSigGen::SetReadSize(oldSize);
+    cArchiveSigGen::SetReadAhead(oldReadAhead);
+    cArchiveSigGen::SetParallelSigs(oldParallel);
+    cArchiveSigGen::SetHashThreads(oldThreads);
+
+    return md5.AsStringHex() + _T(" ") + sha.AsStringHex();
+}
+
+// hashes the file through a mapping, truncating it first if bTruncate is set
+class cMappedHashTask : public iWorkerTask
+{
+public:
+    cMappedHashTask(const std::string& path, bool bTruncate)
+        : mPath(path), mbTruncate(bTruncate), mbMapped(false), mbOK(false)
+    {
+    }
+
+    virtual void Run()
+    {
+        cArchiveSigGen sigGen;
+        cMD5Signature  md5;
+        cSHASignature  sha;
+        sigGen.AddSig(&md5);
+        sigGen.AddSig(&sha);
+
+        cFileArchive arch;
+        arch.OpenRead(mPath.c_str(), cFileArchive::FA_SCANNING);
+        int64       len  = arch.Length();
+        const void* pMap = arch.Map(len);
+        mbMapped         = (pMap != 0);
+        if (mbMapped)
+        {
+            if (mbTruncate && truncate(mPath.c_str(), 0) != 0)
+                mbMapped = false;
+            else
+                mbOK = sigGen.CalculateSignatures(static_cast<const byte*>(pMap), len);
+        }
+        arch.Close();
+
+        if (mbOK)
+            mSigs = md5.AsStringHex() + _T(" ") + sha.AsStringHex();
+    }
+
+    std::string mPath;
+    bool        mbTruncate;
+    bool        mbMapped;
+    bool        mbOK;
+    TSTRING     mSigs;
+};
+} // namespace
+
+void TestArchiveSigGenReadSizes()
+{
+    // sizes either side of, and exactly on, the read size boundaries
+    const int sizes[] = { 0, 100, 0x1000, 0x10000, 0x10001, 3 * 0x10000 - 1, 0x100000 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        std::string path  = util_MakeBigFile("readsizes.bin", sizes[i]);
+        double      usecs = 0;
+
+        TSTRING expected = util_HashFile(path, 0x1000, false, usecs);
+        TEST(util_HashFile(path, 0x1000, true, usecs) == expected);
+        TEST(util_HashFile(path, 0x10000, false, usecs) == expected);
+        TEST(util_HashFile(path, 0x10000, true, usecs) == expected);
+        TEST(util_HashFile(path, 0x12345, true, usecs) == expected);
+        TEST(util_HashFile(path, 0x1000, false, usecs, true) == expected);
+        TEST(util_HashFile(path, 0x10000, true, usecs, true) == expected);
+    }
+
+    // odd sizes are rounded up to something direct i/o can use
+    int oldSize = cArchiveSigGen::GetReadSize();
+    cArchiveSigGen::SetReadSize(0x12345);
+    TEST(cArchiveSigGen::GetReadSize() == 0x13000);
+    cArchiveSigGen::SetReadSize(1);
+    TEST(cArchiveSigGen::GetReadSize() == iSignature::SUGGESTED_BLOCK_SIZE);
+    cArchiveSigGen::SetReadSize(oldSize);
+}
+
+namespace
+{
+// gives back one block of zeros, then fails the way a read from a device that
+// has gone away might
+class cFailingArchive : public cArchive
+{
+public:
+    cFailingArchive() : mbRead(false)
+    {
+    }
+
+    virtual bool EndOfFile()
+    {
+        return false;
+    }
+
+protected:
+    virtual int Read(void* pDest, int count)
+    {
+        if (mbRead)
+            throw std::runtime_error("device went away");
+
+        mbRead = true;
+        if (pDest)
+            memset(pDest, 0, count);
+        return count;
+    }
+
+    virtual int Write(const void*, int)
+    {
+        return 0;
+    }
+
+private:
+    bool mbRead;
+};
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// TestArchiveSigGenReadError -- a read that fails on the read-ahead thread is
+//      reported against the file being hashed, though the thread doesn't know it
+///////////////////////////////////////////////////////////////////////////////
+void TestArchiveSigGenReadError()
+{
+    bool oldReadAhead = cArchiveSigGen::ReadAhead();
+    int  oldThreads   = cArchiveSigGen::GetHashThreads();
+    cArchiveSigGen::SetReadAhead(true);
+    cArchiveSigGen::SetHashThreads(2);
+
+    cArchiveSigGen sigGen;
+    cMD5Signature  md5;
+    sigGen.AddSig(&md5);
+
+    cFailingArchive arch;
+    bool            bThrew = false;
+    try
+    {
+        sigGen.CalculateSignatures(arch, _T("failing.bin"));
+    }
+    catch (eError& e)
+    {
+        bThrew = true;
+        TEST(e.GetMsg().find(_T("failing.bin")) != TSTRING::npos);
+    }
+    TEST(bThrew);
+
+    cArchiveSigGen::SetReadAhead(oldReadAhead);
+    cArchiveSigGen::SetHashThreads(oldThreads);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestArchiveSigGenMapped -- hashing a mapped file gives the same answer as
+//      reading it, and a file that shrinks underneath the mapping makes it
+//      fail rather than kill us, on this thread or a worker.
+///////////////////////////////////////////////////////////////////////////////
+void TestArchiveSigGenMapped()
+{
+#if SUPPORTS_MAPPED_HASHING
+    const int sizes[] = { 1, 0x1000, 0x10001, 0x100000 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        std::string path  = util_MakeBigFile("mapped.bin", sizes[i]);
+        double      usecs = 0;
+
+        cMappedHashTask task(path, false);
+        task.Run();
+        TEST(task.mbMapped);
+        TEST(task.mbOK);
+        TEST(task.mSigs == util_HashFile(path, 0x1000, false, usecs));
+
+        cArchiveSigGen::SetParallelSigs(true);
+        cArchiveSigGen::SetHashThreads(2);
+        cMappedHashTask parallelTask(path, false);
+        parallelTask.Run();
+        cArchiveSigGen::SetHashThreads(1);
+        cArchiveSigGen::SetParallelSigs(false);
+        TEST(parallelTask.mSigs == task.mSigs);
+    }
+
+    std::string     path = util_MakeBigFile("mapped.bin", 0x100000);
+    cMappedHashTask shrunk(path, true);
+    shrunk.Run();
+    TEST(shrunk.mbMapped);
+    TEST(!shrunk.mbOK);
+
+    // worker threads block signals, so this checks SIGBUS gets through there too
+    path = util_MakeBigFile("mapped.bin", 0x100000);
+    cMappedHashTask shrunkOnWorker(path, true);
+    {
+        cWorkerPool pool(1);
+        pool.Submit(&shrunkOnWorker);
+        pool.Wait(&shrunkOnWorker);
+    }
+    TEST(shrunkOnWorker.mbMapped);
+    TEST(!shrunkOnWorker.mbOK);
+
+    unlink(path.c_str());
+#else
+    skip("Mapped hashing is not supported on this platform");
+#endif
+}
+
+namespace
+{
+// the BLAKE3 of the file, read straight through, or split into pieces
+// hashed on numThreads threads with the length taken to be len
+TSTRING util_BLAKE3File(const std::string& path, int numThreads, int64 len, bool& bOK)
+{
+    cArchiveSigGen   sigGen;
+    cBLAKE3Signature blake3;
+    sigGen.AddSig(&blake3);
+
+    cFileArchive arch;
+    arch.OpenRead(path.c_str(), cFileArchive::FA_SCANNING);
+    if (numThreads == 0)
+    {
+        sigGen.CalculateSignatures(arch);
+        bOK = true;
+    }
+    else
+    {
+        cArchiveSigGen::SetHashThreads(numThreads);
+        bOK = sigGen.CalculateSignatures(arch, len);
+        cArchiveSigGen::SetHashThreads(0);
+    }
+    arch.Close();
+
+    return blake3.AsStringHex();
+}
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// TestArchiveSigGenSplit -- a file hashed in pieces on several threads comes
+//      out the same as one read straight through, wherever it ends relative
+//      to the pieces, and one that turns out shorter than it should be fails
+///////////////////////////////////////////////////////////////////////////////
+void TestArchiveSigGenSplit()
+{
+    const int range   = cArchiveSigGen::RANGE_SIZE;
+    const int sizes[] = { 0, 1, range - 1, range, range + 1, 2 * range, 3 * range + 5000 };
+    const int threads[] = { 1, 3 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        std::string path = util_MakeBigFile("split.bin", sizes[i]);
+        bool        bOK;
+        TSTRING     expected = util_BLAKE3File(path, 0, sizes[i], bOK);
+
+        for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+        {
+            TEST(util_BLAKE3File(path, threads[t], sizes[i], bOK) == expected);
+            TEST(bOK);
+        }
+        unlink(path.c_str());
+    }
+
+    std::string path = util_MakeBigFile("split.bin", range + 1);
+    bool        bOK;
+    util_BLAKE3File(path, 2, 3 * range + 1, bOK);
+    TEST(!bOK);
+    unlink(path.c_str());
+
+    // only signatures that can be put together from pieces allow it
+    cArchiveSigGen   sigGen;
+    cBLAKE3Signature blake3;
+    cMD5Signature    md5;
+    TEST(!sigGen.CanSplit());
+    sigGen.AddSig(&blake3);
+    TEST(sigGen.CanSplit());
+    sigGen.AddSig(&md5);
+    TEST(!sigGen.CanSplit());
+}
+
+namespace
+{
+// the CRC32, MD5 and BLAKE3 of the file, read straight through, or with its holes
+// skipped if bSparse
+TSTRING util_SparseHashFile(const std::string& path, bool bSparse, bool& bOK)
+{
+    cArchiveSigGen   sigGen;
+    cCRC32Signature  crc;
+    cMD5Signature    md5;
+    cBLAKE3Signature blake3;
+    sigGen.AddSig(&crc);
+    sigGen.AddSig(&md5);
+    sigGen.AddSig(&blake3);
+
+    cFileArchive arch;
+    arch.OpenRead(path.c_str(), cFileArchive::FA_SCANNING);
+    bOK = true;
+    if (bSparse)
+        bOK = sigGen.CalculateSparseSignatures(arch, arch.Length());
+    else
+        sigGen.CalculateSignatures(arch);
+    arch.Close();
+
+    return crc.AsStringHex() + _T(" ") + md5.AsStringHex() + _T(" ") + blake3.AsStringHex();
+}
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// TestArchiveSigGenSparse -- holes hashed as zeros, without being read, give
+//      the same signatures as reading them does, as does a CRC32 that skips
+//      over zeros without looking at them
+///////////////////////////////////////////////////////////////////////////////
+void TestArchiveSigGenSparse()
+{
+    const int64 zeroRuns[] = { 0, 1, 7, 4096, 100001, 0x1000000 };
+    std::vector<byte> zeros(0x1000000);
+
+    for (size_t i = 0; i < sizeof(zeroRuns) / sizeof(zeroRuns[0]); i++)
+    {
+        cCRC32Signature read, skipped;
+        read.Init();
+        skipped.Init();
+        read.Update((const byte*)"prefix", 6);
+        skipped.Update((const byte*)"prefix", 6);
+        read.Update(&zeros[0], static_cast<int>(zeroRuns[i]));
+        skipped.UpdateZeros(zeroRuns[i]);
+        read.Update((const byte*)"suffix", 6);
+        skipped.Update((const byte*)"suffix", 6);
+        read.Finit();
+        skipped.Finit();
+        TEST(read.AsStringHex() == skipped.AsStringHex());
+    }
+
+    // data, a hole, more data, and a hole at the end; and one that is all hole
+    std::string path  = TwTestPath("sparse.bin");
+    const char* chunk = "sparse file data";
+    for (int pass = 0; pass < 2; pass++)
+    {
+        unlink(path.c_str());
+        int fd = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+        TEST(fd >= 0);
+        if (pass == 0)
+        {
+            TEST(pwrite(fd, chunk, strlen(chunk), 1000) == (ssize_t)strlen(chunk));
+            TEST(pwrite(fd, chunk, strlen(chunk), 5 * 0x100000 + 3) == (ssize_t)strlen(chunk));
+        }
+        TEST(ftruncate(fd, 9 * 0x100000 + 11) == 0);
+        close(fd);
+
+        bool    bOK;
+        TSTRING expected = util_SparseHashFile(path, false, bOK);
+        TEST(util_SparseHashFile(path, true, bOK) == expected);
+        TEST(bOK);
+
+        // not every file system keeps track of holes, but this one ought to
+        cFileArchive arch;
+        arch.OpenRead(path.c_str());
+        if (!cArchiveSigGen::HasHoles(arch, arch.Length()))
+            TCERR << _T("File system doesn't report holes; sparse hashing read them instead") << std::endl;
+        arch.Close();
+    }
+
+    // as do pieces of a sparse file hashed on several threads
+    bool    bOK;
+    TSTRING expected = util_BLAKE3File(path, 0, 9 * 0x100000 + 11, bOK);
+    TEST(util_BLAKE3File(path, 2, 9 * 0x100000 + 11, bOK) == expected);
+    TEST(bOK);
+
+    // and a sparse file that is cut short fails like a mapped one does
+    cArchiveSigGen  sigGen;
+    cCRC32Signature crc;
+    sigGen.AddSig(&crc);
+    cFileArchive arch;
+    arch.OpenRead(path.c_str());
+    TEST(!sigGen.CalculateSparseSignatures(arch, 10 * 0x100000));
+    arch.Close();
+
+    unlink(path.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestArchiveSigGenBenchmark -- not a pass/fail test; reports how fast a file
+//      is hashed with the old 4 KiB reads and with larger, overlapped ones.
+//      The file will mostly be in the page cache, so this shows the syscall
+//      savings more than the effect of overlapping disk reads.
+///////////////////////////////////////////////////////////////////////////////
+void TestArchiveSigGenBenchmark()
+{
+    const int   fileSize = 32 * 1024 * 1024;
+    std::string path     = util_MakeBigFile("readbench.bin", fileSize);
+
+    const struct
+    {
+        int  readSize;
+        bool bReadAhead;
+        bool bParallel;
+    } runs[] = { { 0x1000, false, false },
+                 { 0x40000, false, false },
+                 { 0x40000, true, false },
+                 { 0x400000, true, false },
+                 { 0x40000, true, true } };
+
+    TSTRING expected;
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++)
+    {
+        double  usecs = 0;
+        TSTRING sigs;
+        for (int pass = 0; pass < 3; pass++)
+            sigs = util_HashFile(path, runs[i].readSize, runs[i].bReadAhead, usecs, runs[i].bParallel);
+
+        if (expected.empty())
+            expected = sigs;
+        TEST(sigs == expected);
+
+        double mbPerSec = usecs > 0 ? (3.0 * fileSize / (1024 * 1024)) / (usecs / 1e6) : 0;
+        TCERR << _T("md5+sha1, ") << runs[i].readSize / 1024 << _T(" KiB reads")
+              << (runs[i].bReadAhead ? _T(", read-ahead") : _T(""))
+              << (runs[i].bParallel ? _T(", parallel: ") : _T(": ")) << (int)mbPerSec << _T(" MB/s") << std::endl;
+    }
+
+    unlink(path.c_str());
+}
+
 void assertMD5(const std::string& source, const std::string& expectedHex)
 {
     // Signature usage example (?)
@@ -480,15 +1146,227 @@ void TestRFC3174()
 }
 
 
+void assertDigest(iSignature& sig, const std::string& source, const std::string& expectedHex)
+{
+    TEST(util_SigHex(sig, (const uint8*)source.c_str(), source.length(), std::max((int)source.length(), 1)) ==
+         expectedHex);
+}
+
+void TestSHA2()
+{
+    // FIPS 180-4 examples
+    cSHA256Signature sha256;
+    assertDigest(sha256, "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    assertDigest(sha256, "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    assertDigest(sha256,
+                 "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                 "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    cSHA512Signature sha512;
+    assertDigest(sha512,
+                 "abc",
+                 "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+                 "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+    assertDigest(sha512,
+                 "",
+                 "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce"
+                 "47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e");
+
+    // the digest survives a trip through a serializer and a copy
+    cSHA256Signature sha256b, sha256c;
+    {
+        cMemoryArchive  sigArchive;
+        cSerializerImpl writeSer(sigArchive, cSerializerImpl::S_WRITE);
+        sha256.Write(&writeSer);
+        sigArchive.Seek(0, cBidirArchive::BEGINNING);
+        cSerializerImpl readSer(sigArchive, cSerializerImpl::S_READ);
+        sha256b.Read(&readSer);
+    }
+    TEST(sha256.Compare(&sha256b, iFCOProp::OP_EQ) == iFCOProp::CMP_TRUE);
+    sha256c.Copy(&sha256b);
+    TEST(sha256c.AsStringHex() == _T("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+    TEST(sha256c.AsString().length() == 43); // 256 bits, 6 to a character
+}
+
+void TestBLAKE2()
+{
+    // RFC 7693 appendix A, and the empty string
+    cBLAKE2Signature blake2;
+    assertDigest(blake2,
+                 "abc",
+                 "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d1"
+                 "7d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923");
+    assertDigest(blake2,
+                 "",
+                 "786a02f742015903c6c6fd852552d272912f4740e15847618a86e217f71f5419"
+                 "d25e1031afee585313896444934eb04b903a685b1448b755d56f701afe9be2ce");
+}
+
+namespace
+{
+// the input the BLAKE3 test vectors are computed over
+std::vector<uint8> util_BLAKE3Input(int len)
+{
+    std::vector<uint8> data(len + 1);
+    for (int i = 0; i < len; i++)
+        data[i] = (uint8)(i % 251);
+    return data;
+}
+} // namespace
+
+void TestBLAKE3()
+{
+    cBLAKE3Signature blake3;
+    assertDigest(blake3, "", "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262");
+    assertDigest(blake3, "abc", "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85");
+
+    // from the BLAKE3 test vectors, which straddle chunk and subtree boundaries
+    const struct
+    {
+        int         len;
+        const char* hex;
+    } vectors[] = { { 1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11" },
+                    { 1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7" },
+                    { 1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444" },
+                    { 8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b" },
+                    { 31744, "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47" },
+                    { 102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085" } };
+
+    for (size_t v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++)
+    {
+        std::vector<uint8> data = util_BLAKE3Input(vectors[v].len);
+        TEST(util_SigHex(blake3, &data[0], vectors[v].len, vectors[v].len) == vectors[v].hex);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestBLAKE3Kernels -- every BLAKE3 kernel this cpu can run agrees with the
+//      portable one, whatever the length and however the data is split up
+///////////////////////////////////////////////////////////////////////////////
+void TestBLAKE3Kernels()
+{
+    const int          maxLen = 70000;
+    std::vector<uint8> data   = util_BLAKE3Input(maxLen);
+
+    const int lengths[] = { 0, 1, 64, 1024, 1025, 8192, 8193, 16385, 17408, 33792, maxLen };
+    const int chunks[]  = { 1, 1000, 1024, 8192, 16384, 65536 };
+
+    cBLAKE3Signature blake3;
+    BLAKE3_KERNEL    oldKernel = blake3GetKernel();
+    TEST(blake3SetKernel(BLAKE3_KERNEL_GENERIC));
+
+    std::vector<TSTRING> expected;
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+        expected.push_back(util_SigHex(blake3, &data[0], lengths[l], std::max(lengths[l], 1)));
+
+    for (int k = BLAKE3_KERNEL_GENERIC; k < BLAKE3_KERNEL_NUMITEMS; k++)
+    {
+        if (!blake3SetKernel((BLAKE3_KERNEL)k))
+            continue;
+
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+        {
+            for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+            {
+                if (lengths[l] / chunks[c] > 2000)
+                    continue; // slow, and the small chunks are covered by the shorter lengths
+                TEST(util_SigHex(blake3, &data[0], lengths[l], chunks[c]) == expected[l]);
+            }
+        }
+    }
+
+    TEST(!blake3SetKernel(BLAKE3_KERNEL_NUMITEMS));
+    blake3SetKernel(oldKernel);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// TestDigestBenchmark -- not a pass/fail test; reports how fast the newer
+//      hashes, and each BLAKE3 kernel this cpu can run, go over a buffer that
+//      stays in cache
+///////////////////////////////////////////////////////////////////////////////
+void TestDigestBenchmark()
+{
+    const int          bufSize = 256 * 1024;
+    const int          passes  = 100;
+    std::vector<uint8> data(bufSize, 0x5a);
+
+    cSHA256Signature sha256;
+    cSHA512Signature sha512;
+    cBLAKE2Signature blake2;
+    cBLAKE3Signature blake3;
+
+    BLAKE3_KERNEL oldKernel = blake3GetKernel();
+    const struct
+    {
+        iSignature*   pSig;
+        const TCHAR*  name;
+        BLAKE3_KERNEL kernel;
+    } runs[] = { { &sha256, _T("sha256"), oldKernel },
+                 { &sha512, _T("sha512"), oldKernel },
+                 { &blake2, _T("blake2b"), oldKernel },
+                 { &blake3, _T("blake3, generic"), BLAKE3_KERNEL_GENERIC },
+                 { &blake3, _T("blake3, avx2"), BLAKE3_KERNEL_AVX2 } };
+
+    TSTRING blake3Hex;
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++)
+    {
+        if (!blake3SetKernel(runs[i].kernel))
+        {
+            TCERR << runs[i].name << _T(": not supported on this cpu") << std::endl;
+            continue;
+        }
+
+        iSignature& sig = *runs[i].pSig;
+        sig.Init();
+
+        struct timeval start, end;
+        gettimeofday(&start, 0);
+        for (int pass = 0; pass < passes; pass++)
+            sig.Update(&data[0], bufSize);
+        gettimeofday(&end, 0);
+        sig.Finit();
+
+        if (&sig == &blake3)
+        {
+            if (blake3Hex.empty())
+                blake3Hex = sig.AsStringHex();
+            TEST(sig.AsStringHex() == blake3Hex);
+        }
+
+        double usecs    = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_usec - start.tv_usec);
+        double mbPerSec = usecs > 0 ? ((double)passes * bufSize / (1024 * 1024)) / (usecs / 1e6) : 0;
+        TCERR << runs[i].name << _T(": ") << (int)mbPerSec << _T(" MB/s") << std::endl;
+    }
+    blake3SetKernel(oldKernel);
+}
+
+
 void RegisterSuite_Signature()
 {
     RegisterTest("Signature", "Basic", TestSignatureBasic);
     RegisterTest("Signature", "Checksum", TestChecksum);
     RegisterTest("Signature", "CRC32", TestCRC32);
+    RegisterTest("Signature", "CRC32Kernels", TestCRC32Kernels);
     RegisterTest("Signature", "MD5", TestMD5);
     RegisterTest("Signature", "SHA1", TestSHA1);
     RegisterTest("Signature", "HAVAL", TestHAVAL);
+    RegisterTest("Signature", "HAVALBlocks", TestHAVALBlocks);
     RegisterTest("Signature", "ArchiveSigGen", TestArchiveSigGen);
+    RegisterTest("Signature", "ArchiveSigGenReadSizes", TestArchiveSigGenReadSizes);
+    RegisterTest("Signature", "ArchiveSigGenReadError", TestArchiveSigGenReadError);
+    RegisterTest("Signature", "ArchiveSigGenMapped", TestArchiveSigGenMapped);
+    RegisterTest("Signature", "ArchiveSigGenSplit", TestArchiveSigGenSplit);
+    RegisterTest("Signature", "ArchiveSigGenSparse", TestArchiveSigGenSparse);
     RegisterTest("Signature", "RFC1321", TestRFC1321);
     RegisterTest("Signature", "RFC3174", TestRFC3174);
+    RegisterTest("Signature", "SHA2", TestSHA2);
+    RegisterTest("Signature", "BLAKE2", TestBLAKE2);
+    RegisterTest("Signature", "BLAKE3", TestBLAKE3);
+    RegisterTest("Signature", "BLAKE3Kernels", TestBLAKE3Kernels);
+
+    // these only report timings, so "twtest all" leaves them out
+    RegisterTest("Benchmark", "CRC32", TestCRC32Benchmark);
+    RegisterTest("Benchmark", "HAVAL", TestHAVALBenchmark);
+    RegisterTest("Benchmark", "ArchiveSigGen", TestArchiveSigGenBenchmark);
+    RegisterTest("Benchmark", "Digest", TestDigestBenchmark);
 }
@@ -70,6 +70,7 @@ void RegisterSuite_Archive();
 void RegisterSuite_BlockFile();
 void RegisterSuite_BlockRecordArray();
 void RegisterSuite_CharUtil();
+void RegisterSuite_ChunkedArchive();
 void RegisterSuite_CmdLineParser();
 void RegisterSuite_CodeConvert();
 void RegisterSuite_ConfigFile();
@@ -116,6 +117,7 @@ void RegisterSuite_RefCountObj();
 void RegisterSuite_Resources();
 void RegisterSuite_Serializer();
 void RegisterSuite_SerializerImpl();
+void RegisterSuite_SHA();
 void RegisterSuite_Signature();
 void RegisterSuite_SerRefCountObj();
 void RegisterSuite_StringEncoder();
@@ -129,6 +131,7 @@ void RegisterSuite_Types();
 void RegisterSuite_UnixFSServices();
 void RegisterSuite_UserNotifyStdout();
 void RegisterSuite_Wchar16();
+void RegisterSuite_WorkerPool();
 
 /// This is easier than all the (cpp) files and declarations
 #include "stringutil_t.h"
@@ -147,7 +150,10 @@ void Usage()
     TCERR << _T("Usage: twtest {all | list | help | version | testid [testid ...]}\n")
              _T("\n")
              _T("Ex: twtest foo bar/baz\n")
-             _T("(runs suite foo and test bar/baz)\n\n");
+             _T("(runs suite foo and test bar/baz)\n")
+             _T("\n")
+             _T("The Benchmark suite only reports timings, and isn't part of all.\n")
+             _T("Ex: twtest Benchmark\n\n");
 }
 
 void Version()
@@ -190,6 +196,9 @@ void CountMacro()
 
 static TestMap tests;
 
+// the suite that only measures things, and so is left out of "all"
+static const std::string BENCHMARK_SUITE = "Benchmark";
+
 void RegisterTest(const std::string& suite, const std::string testName, TestPtr testPtr)
 {
     tests[suite][testName] = testPtr;
@@ -270,6 +279,9 @@ static void RunAllTests()
     TestMap::const_iterator itr;
     for (itr = tests.begin(); itr != tests.end(); ++itr)
     {
+        if (itr->first == BENCHMARK_SUITE)
+            continue;
+
         TCERR << std::endl << "===== Starting test suite: " << itr->first << " =====" << std::endl;
         RunTestSuite(itr->first, itr->second);
         TCERR << "===== Finished test suite: " << itr->first << " =====" << std::endl;
@@ -314,6 +326,7 @@ static void RegisterSuites()
     RegisterSuite_BlockFile();
     RegisterSuite_BlockRecordArray();
     RegisterSuite_CharUtil();
+    RegisterSuite_ChunkedArchive();
     RegisterSuite_CmdLineParser();
     RegisterSuite_CodeConvert();
     RegisterSuite_ConfigFile();
@@ -360,6 +373,7 @@ static void RegisterSuites()
     RegisterSuite_Resources();
     RegisterSuite_Serializer();
     RegisterSuite_SerializerImpl();
+    RegisterSuite_SHA();
     RegisterSuite_Signature();
     RegisterSuite_SerRefCountObj();
     RegisterSuite_StringEncoder();
@@ -373,6 +387,7 @@ static void RegisterSuites()
     RegisterSuite_UnixFSServices();
     RegisterSuite_UserNotifyStdout();
     RegisterSuite_Wchar16();
+    RegisterSuite_WorkerPool();
 }
 
 
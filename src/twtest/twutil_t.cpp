@@ -35,8 +35,13 @@
 #include "tw/stdtw.h"
 #include "tw/twutil.h"
 #include "util/fileutil.h"
+#include "fs/fshashcache.h"
+#include "fs/fspropset.h"
+#include "twcrypto/keyfile.h"
+#include "twcrypto/crypto.h"
 #include "twtest/test.h"
 #include <fstream>
+#include <sstream>
 
 //#include <statbuf.h>
 #include <unistd.h>
@@ -112,7 +117,92 @@ std::string WideToNarrow(const TSTRING& strWide)
     return strWide;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// TestHashCacheFile -- a hash cache written with a local key is only loaded
+//      back with the same key, and only if it hasn't been changed since
+///////////////////////////////////////////////////////////////////////////////
+void TestHashCacheFile()
+{
+    TSTRING path = TwTestPath("hashcache.twc");
+
+    // the passphrases get scribbled over, so each use has its own copy
+    cKeyFile    keyfile, otherKeyfile;
+    std::string pass = "hashcache", otherPass = "hashcache";
+    keyfile.GenerateKeys(cElGamalSig::KEY512, (int8*)pass.data(), pass.size());
+    otherKeyfile.GenerateKeys(cElGamalSig::KEY512, (int8*)otherPass.data(), otherPass.size());
+
+    cFSHashCache::Key key = { 1, 2, 10, 1000000000, 1000000000 };
+    cFCOPropVector    v(cFSPropSet::PROP_NUMITEMS);
+    v.AddItem(cFSPropSet::PROP_MD5);
+
+    cFSPropSet propSet;
+    propSet.SetDefinedMD5(true);
+
+    cFSHashCache cache;
+    cache.Store(key, v, propSet);
+    TEST(cache.GetNumEntries() == 1);
+
+    {
+        std::string      pass = "hashcache";
+        cPrivateKeyProxy privateKey;
+        TEST(privateKey.AquireKey(keyfile, (int8*)pass.data(), pass.size()));
+        cTWUtil::WriteHashCache(path.c_str(), cache, privateKey.GetKey());
+    }
+
+    cFSHashCache loaded;
+    cTWUtil::ReadHashCache(path.c_str(), loaded, keyfile.GetPublicKey());
+    TEST(loaded.GetNumEntries() == 1);
+
+    cFSPropSet found;
+    TEST(loaded.Lookup(key, v, found));
+    loaded.Clear();
+
+    // someone else's key won't do
+    bool bThrown = false;
+    try
+    {
+        cTWUtil::ReadHashCache(path.c_str(), loaded, otherKeyfile.GetPublicKey());
+    }
+    catch (eError&)
+    {
+        bThrown = true;
+    }
+    TEST(bThrown);
+
+    // nor will a table that has been changed since it was signed
+    std::string contents;
+    {
+        std::ifstream     in(path.c_str(), std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        contents = ss.str();
+    }
+
+    size_t table = contents.find("TWHC");
+    TEST(table != std::string::npos);
+    contents[table + 40] ^= 1;
+    {
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        out << contents;
+    }
+
+    bThrown = false;
+    try
+    {
+        cTWUtil::ReadHashCache(path.c_str(), loaded, keyfile.GetPublicKey());
+    }
+    catch (eTWUtilCorruptedFile&)
+    {
+        bThrown = true;
+    }
+    TEST(bThrown);
+    TEST(loaded.GetNumEntries() == 0);
+
+    unlink(path.c_str());
+}
+
 void RegisterSuite_TWUtil()
 {
     RegisterTest("TWUtil", "Basic", TestTWUtil);
+    RegisterTest("TWUtil", "HashCacheFile", TestHashCacheFile);
 }
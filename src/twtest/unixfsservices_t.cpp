@@ -43,6 +43,7 @@
 #endif
 
 #include <unistd.h>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -120,6 +121,93 @@ void TestStat()
 */
 }
 
+void TestStatFields()
+{
+    cFSStatArgs stat;
+    std::string testfile = makeTestFile("statfields.tmp");
+
+    // the file type is always fetched along with whatever was asked for
+    const uint32 fields = cFSStatArgs::FIELD_TYPE | cFSStatArgs::FIELD_SIZE;
+    iFSServices::GetInstance()->Stat(testfile, stat, cFSStatArgs::FIELD_SIZE);
+    TEST((stat.mRequested & fields) == fields);
+    TEST((stat.mFields & fields) == fields);
+    TEST(stat.mFileType == cFSStatArgs::TY_FILE);
+
+    cFSStatArgs all;
+    iFSServices::GetInstance()->Stat(testfile, all, cFSStatArgs::FIELD_ALL);
+    TEST(all.mRequested == cFSStatArgs::FIELD_ALL);
+    TEST(all.ino == stat.ino);
+    TEST(all.size == stat.size);
+
+    // btime is only filled in where the file system keeps one
+    if (all.mFields & cFSStatArgs::FIELD_BTIME)
+    {
+        TEST(all.btime != 0);
+    }
+    else
+    {
+        TEST(all.btime == 0);
+    }
+}
+
+void TestDirHandle()
+{
+    iFSServices* pFSServices = iFSServices::GetInstance();
+
+    TSTRING dir = TwTestPath("dirhandle");
+    mkdir(dir.c_str(), 0777);
+    cFSStatArgs fileStat;
+    pFSServices->Stat(makeTestFile("dirhandle/file"), fileStat);
+
+    cFSDirHandle* pDir = pFSServices->OpenDir(dir);
+    pDir->Hold();
+    pDir->Release();
+    TEST(pDir->GetPath() == dir);
+    TEST(pDir->GetPath("file") == dir + "/file");
+
+    std::vector<TSTRING> v;
+    pFSServices->ReadDir(*pDir, v);
+    TEST(v.size() == 1 && v[0] == "file");
+
+    cFSStatArgs stat;
+    pFSServices->Stat(*pDir, "file", stat);
+    TEST(stat.mFileType == cFSStatArgs::TY_FILE);
+    TEST(stat.ino == fileStat.ino);
+
+#if SUPPORTS_DIR_FDS
+    // names are looked up through the open directory, so it doesn't matter if it moves
+    TSTRING moved = TwTestPath("dirhandle_moved");
+    TEST(0 == rename(dir.c_str(), moved.c_str()));
+
+    cFileArchive arch;
+    arch.OpenRead(pDir, "file");
+    TEST(arch.Length() == fileStat.size);
+    TEST(arch.GetCurrentFilename() == dir + "/file");
+    arch.Close();
+
+    // once nobody holds it, it's back to full paths
+    pDir->AddRef();
+    pDir->Unhold();
+    TEST(pDir->GetFd() == -1);
+
+    bool bThrew = false;
+    try
+    {
+        pFSServices->Stat(*pDir, "file", stat);
+    }
+    catch (eFSServices&)
+    {
+        bThrew = true;
+    }
+    TEST(bThrew);
+    pDir->Release();
+
+    TEST(0 == rename(moved.c_str(), dir.c_str()));
+#else
+    pDir->Unhold();
+#endif
+}
+
 void TestGetCurrentDir()
 {
     TSTRING currpath;
@@ -210,6 +298,8 @@ void RegisterSuite_UnixFSServices()
 {
     RegisterTest("UnixFSServices", "ReadDir", TestReadDir);
     RegisterTest("UnixFSServices", "Stat", TestStat);
+    RegisterTest("UnixFSServices", "StatFields", TestStatFields);
+    RegisterTest("UnixFSServices", "DirHandle", TestDirHandle);
     RegisterTest("UnixFSServices", "GetCurrentDir", TestGetCurrentDir);
     RegisterTest("UnixFSServices", "MakeTempFilename", TestMakeTempFilename);
     RegisterTest("UnixFSServices", "GetMachineName", TestGetMachineName);
@@ -0,0 +1,117 @@
+//
+// The developer of the original code and/or files is Tripwire, Inc.
+// Portions created by Tripwire, Inc. are copyright (C) 2000-2018 Tripwire,
+// Inc. Tripwire is a registered trademark of Tripwire, Inc.  All rights
+// reserved.
+//
+// This program is free software.  The contents of this file are subject
+// to the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 2 of the License, or (at your
+// option) any later version.  You may redistribute it and/or modify it
+// only in compliance with the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful.
+// However, this program is distributed AS-IS WITHOUT ANY
+// WARRANTY; INCLUDING THE IMPLIED WARRANTY OF MERCHANTABILITY OR FITNESS
+// FOR A PARTICULAR PURPOSE.  Please see the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307,
+// USA.
+//
+// Nothing in the GNU General Public License or any other license to use
+// the code or files shall permit you to use Tripwire's trademarks,
+// service marks, or other intellectual property without Tripwire's
+// prior written consent.
+//
+// If you have any questions, please contact Tripwire, Inc. at either
+// info@tripwire.org or www.tripwire.org.
+//
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// workerpool_t.cpp
+//
+// test the worker pool component
+
+#include "core/stdcore.h"
+#include "core/workerpool.h"
+#include "twtest/test.h"
+
+class cSumTask : public iWorkerTask
+{
+public:
+    cSumTask() : mLimit(0), mSum(0)
+    {
+    }
+
+    virtual void Run()
+    {
+        mSum = 0;
+        for (uint32 i = 1; i <= mLimit; ++i)
+            mSum += i;
+    }
+
+    uint32 mLimit;
+    uint64 mSum;
+};
+
+static void RunSumTasks(cWorkerPool& pool)
+{
+    const uint32          numTasks = 200;
+    std::vector<cSumTask> tasks(numTasks);
+
+    for (uint32 i = 0; i < numTasks; ++i)
+    {
+        tasks[i].mLimit = i * 1000;
+        pool.Submit(&tasks[i]);
+    }
+
+    // wait for the first half one at a time, and the rest all at once
+    for (uint32 i = 0; i < numTasks / 2; ++i)
+    {
+        pool.Wait(&tasks[i]);
+        TEST(tasks[i].mSum == (uint64)tasks[i].mLimit * (tasks[i].mLimit + 1) / 2);
+    }
+
+    pool.WaitAll();
+    for (uint32 i = numTasks / 2; i < numTasks; ++i)
+    {
+        TEST(tasks[i].mSum == (uint64)tasks[i].mLimit * (tasks[i].mLimit + 1) / 2);
+    }
+}
+
+void TestWorkerPool()
+{
+    cWorkerPool pool(4);
+#if SUPPORTS_WORKER_THREADS
+    TEST(pool.GetNumThreads() == 4);
+#endif
+    RunSumTasks(pool);
+
+    // a pool can be reused once it has drained
+    RunSumTasks(pool);
+}
+
+void TestWorkerPoolInline()
+{
+    // with no threads everything should run on this thread when it is waited for
+    cWorkerPool pool(0);
+    TEST(pool.GetNumThreads() == 0);
+
+    cSumTask task;
+    task.mLimit = 10;
+    pool.Submit(&task);
+    TEST(task.mSum == 0);
+    pool.Wait(&task);
+    TEST(task.mSum == 55);
+
+    RunSumTasks(pool);
+}
+
+void RegisterSuite_WorkerPool()
+{
+    RegisterTest("WorkerPool", "Basic", TestWorkerPool);
+    RegisterTest("WorkerPool", "Inline", TestWorkerPoolInline);
+}